@@ -0,0 +1,779 @@
+/**
+ * @file bench_replay.c
+ * @brief Replay voltage/temperature traces through the controller logic
+ *
+ * Feeds every sample of a recorded (CSV) or synthetic multi-day trace through
+ * channel_logic and the dimming decision exactly as the firmware does, and
+ * reports per-sample cost, state changes, dimming changes and the decision
+ * latency in samples: how long the raw input had continuously been past the
+ * active threshold when the output finally switched.
+ *
+ * CSV format, one sample per line (lines starting with '#' are skipped):
+ *   timestamp_ms,battery_mv,temp_raw_mv
+ *
+ * A capture of the firmware sample log ("samplelog -d", raw pages as defined
+ * in samplelog_format.h) can be replayed with --samplelog; the channel 0
+ * state recorded on the device is then compared with the replayed one.
+ *
+ * With --adaptive the replay follows the firmware's adaptive sample cadence
+ * (cadence_logic.h, CONFIG_SOLAR_ADAPTIVE_SAMPLING). Trace samples that
+ * fall between two slow-cadence readings are skipped, as adc_task would
+ * not take them. The filter is rescaled to each interval, and the number
+ * of readings taken is reported.
+ *
+ * The sensor conversions (divider, TMP36, compensation term) are timed
+ * separately. Build with SOLAR_FIXED_POINT=0 (bench_replay_float) to compare
+ * the float path.
+ *
+ * Exit status is non-zero if --expect-changes, --expect-mismatches or
+ * --max-ns-per-sample fail.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "cadence_logic.h"
+#include "channel_logic.h"
+#include "control_logic.h"
+#include "samplelog_format.h"
+#include "sensor_math.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Firmware sampling interval and configuration defaults
+#define SAMPLE_INTERVAL_MS  100
+#define SAMPLES_PER_DAY     (24u * 3600u * 1000u / SAMPLE_INTERVAL_MS)
+#define DEFAULT_TH_ON       12500
+#define DEFAULT_TH_OFF      11800
+#define DEFAULT_TEMP_COEFF  -0.02f
+#define DEFAULT_PWM_FULL    100
+#define DEFAULT_PWM_HALF    50
+#define LEDC_MAX_DUTY       8191    // 13-bit PWM
+
+// CONFIG_SOLAR_ADAPTIVE_* defaults
+#define DEFAULT_SETTLE_MS   60000
+#define DEFAULT_BAND_MV     100
+#define DEFAULT_SLOPE_MV_S  20
+#define DEFAULT_MARGIN_MV   300
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * @brief One trace sample
+ */
+typedef struct {
+    uint32_t timestamp_ms;
+    uint32_t battery_mv;
+    uint32_t temp_raw;
+    bool recorded_on;           // Channel 0 state on the device (samplelog only)
+} trace_sample_t;
+
+typedef struct {
+    trace_sample_t *samples;
+    size_t count;
+    size_t capacity;
+    bool has_state;             // recorded_on is valid
+} trace_t;
+
+/**
+ * @brief Replay results
+ */
+typedef struct {
+    uint32_t state_changes;
+    uint32_t blocked;
+    uint32_t duty_changes;
+    uint64_t latency_total;
+    uint32_t latency_min;
+    uint32_t latency_max;
+    uint32_t on_samples;
+    uint32_t state_mismatches;  // Replayed state differs from the recorded one
+    uint32_t readings;          // Samples run through the logic
+} replay_result_t;
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [trace.csv] [options]\n"
+            "  --synthetic DAYS          Generate a deterministic DAYS-long trace\n"
+            "  --seed N                  Synthetic trace seed (default 1)\n"
+            "  --samplelog FILE          Replay a captured samplelog dump\n"
+            "  --write-trace FILE        Save the trace as CSV and continue\n"
+            "  --write-samplelog FILE    Save the trace as samplelog pages and continue\n"
+            "  --repeat N                Replay N times for timing (default 1)\n"
+            "  --th-on MV --th-off MV    Thresholds at 25 C (default %d/%d)\n"
+            "  --temp-coeff V            Temperature coefficient (default %.3f)\n"
+            "  --curve linear|lead-acid|lithium  Compensation curve (default linear)\n"
+            "  --dimming MV:DUTY,...     Dimming curve points (default: battery bands)\n"
+            "  --dimming-hyst MV         Dimming curve hysteresis (default 0)\n"
+            "  --filter boxcar|ema       Input smoothing filter (default boxcar)\n"
+            "  --filter-length N         Boxcar taps / EMA span (default %d)\n"
+            "  --median N                Median-of-N spike rejection (odd, 0 = off)\n"
+            "  --adaptive SLOW_MS        Adaptive cadence, SLOW_MS while settled\n"
+            "  --expect-changes N        Fail unless the trace switches N times\n"
+            "  --expect-mismatches N     Fail unless N samples disagree with the log\n"
+            "  --max-ns-per-sample NS    Fail if the per-sample cost exceeds NS\n",
+            prog, DEFAULT_TH_ON, DEFAULT_TH_OFF, DEFAULT_TEMP_COEFF, FILTER_DEFAULT_LENGTH);
+}
+
+/**
+ * @brief Parse a dimming curve given as "mv:duty,mv:duty,..."
+ */
+static int parse_dimming_curve(const char *spec, dimming_curve_t *curve)
+{
+    memset(curve, 0, sizeof(*curve));
+    
+    while (*spec != '\0') {
+        unsigned int mv, duty;
+        int used = 0;
+        if (curve->count == DIMMING_MAX_POINTS ||
+            sscanf(spec, "%u:%u%n", &mv, &duty, &used) != 2 || mv > UINT16_MAX) {
+            return -1;
+        }
+        curve->point[curve->count].mv = (uint16_t)mv;
+        curve->point[curve->count].duty = (uint8_t)(duty > 100 ? 101 : duty);
+        curve->count++;
+        spec += used;
+        if (*spec == ',') {
+            spec++;
+        } else if (*spec != '\0') {
+            return -1;
+        }
+    }
+    
+    return control_logic_curve_valid(curve) ? 0 : -1;
+}
+
+static int trace_push(trace_t *trace, const trace_sample_t *sample)
+{
+    if (trace->count == trace->capacity) {
+        size_t capacity = trace->capacity ? trace->capacity * 2 : 65536;
+        trace_sample_t *samples = realloc(trace->samples, capacity * sizeof(*samples));
+        if (samples == NULL) {
+            return -1;
+        }
+        trace->samples = samples;
+        trace->capacity = capacity;
+    }
+    
+    trace->samples[trace->count++] = *sample;
+    return 0;
+}
+
+static int trace_load(trace_t *trace, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    
+    char line[128];
+    unsigned long lineno = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+            continue;
+        }
+        
+        unsigned long ts, battery, temp;
+        if (sscanf(line, "%lu,%lu,%lu", &ts, &battery, &temp) != 3) {
+            // Tolerate a column header on the first line
+            if (lineno == 1) {
+                continue;
+            }
+            fprintf(stderr, "%s:%lu: malformed sample\n", path, lineno);
+            fclose(f);
+            return -1;
+        }
+        
+        trace_sample_t sample = {
+            .timestamp_ms = (uint32_t)ts,
+            .battery_mv = (uint32_t)battery,
+            .temp_raw = (uint32_t)temp,
+        };
+        if (trace_push(trace, &sample) != 0) {
+            fclose(f);
+            return -1;
+        }
+    }
+    
+    fclose(f);
+    return 0;
+}
+
+static int trace_save(const trace_t *trace, const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    
+    fprintf(f, "# timestamp_ms,battery_mv,temp_raw_mv\n");
+    for (size_t i = 0; i < trace->count; i++) {
+        const trace_sample_t *s = &trace->samples[i];
+        fprintf(f, "%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n",
+                s->timestamp_ms, s->battery_mv, s->temp_raw);
+    }
+    
+    return fclose(f);
+}
+
+static int page_compare(const void *a, const void *b)
+{
+    const samplelog_page_header_t *ha = a;
+    const samplelog_page_header_t *hb = b;
+    int32_t diff = (int32_t)(ha->sequence - hb->sequence);
+    
+    if (diff != 0) {
+        return diff < 0 ? -1 : 1;
+    }
+    // Same page seen twice (flushed during the dump): fuller copy first
+    return (int)hb->count - (int)ha->count;
+}
+
+/**
+ * @brief Load a samplelog capture: raw pages in any order
+ *
+ * Pages are ordered by sequence number; erased or torn pages are skipped.
+ */
+static int trace_load_samplelog(trace_t *trace, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    
+    samplelog_page_t *pages = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t skipped = 0;
+    samplelog_page_t page;
+    
+    while (fread(&page, 1, sizeof(page), f) == sizeof(page)) {
+        if (!samplelog_header_valid(&page.header)) {
+            skipped++;
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            samplelog_page_t *grown = realloc(pages, capacity * sizeof(*pages));
+            if (grown == NULL) {
+                free(pages);
+                fclose(f);
+                return -1;
+            }
+            pages = grown;
+        }
+        pages[count++] = page;
+    }
+    fclose(f);
+    
+    qsort(pages, count, sizeof(*pages), page_compare);
+    
+    int err = 0;
+    for (size_t p = 0; p < count && err == 0; p++) {
+        const samplelog_page_header_t *header = &pages[p].header;
+        if (p > 0 && header->sequence == pages[p - 1].header.sequence) {
+            continue;
+        }
+        
+        samplelog_codec_t codec = {0};
+        samplelog_codec_reset(&codec, header->base_mv, header->base_temp_raw);
+        
+        for (uint32_t i = 0; i < header->count && err == 0; i++) {
+            trace_sample_t sample = {
+                .timestamp_ms = header->start_ms + i * header->interval_ms,
+            };
+            uint16_t state;
+            samplelog_page_decode(&pages[p], i, &codec, &sample.battery_mv, &sample.temp_raw, &state);
+            sample.recorded_on = (state & 0x01) != 0;
+            err = trace_push(trace, &sample);
+        }
+    }
+    
+    if (skipped > 0) {
+        fprintf(stderr, "%s: skipped %zu invalid page(s)\n", path, skipped);
+    }
+    
+    free(pages);
+    trace->has_state = true;
+    return err;
+}
+
+/**
+ * @brief Write the trace as samplelog pages, splitting at sampling gaps like
+ *        the recorder does
+ *
+ * Channel 0 state bits come from the default-parameter logic so that a
+ * round trip replays without mismatches.
+ */
+static int trace_save_samplelog(const trace_t *trace, const channel_logic_params_t *params,
+                                const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    
+    channel_logic_t logic;
+    channel_logic_init(&logic, params);
+    
+    samplelog_page_t page;
+    samplelog_codec_t codec = {0};
+    memset(&page, 0xFF, sizeof(page));
+    page.header.count = 0;
+    uint32_t sequence = 0;
+    int err = 0;
+    
+    for (size_t i = 0; i <= trace->count && err == 0; i++) {
+        const trace_sample_t *s = (i < trace->count) ? &trace->samples[i] : NULL;
+        samplelog_page_header_t *header = &page.header;
+        
+        bool close = (s == NULL) || header->count == samplelog_records_per_page(SAMPLELOG_MAGIC);
+        if (!close && header->count > 0) {
+            uint32_t expected = header->start_ms + (uint32_t)header->count * header->interval_ms;
+            int32_t skew = (int32_t)(s->timestamp_ms - expected);
+            close = skew > SAMPLE_INTERVAL_MS / 2 || skew < -SAMPLE_INTERVAL_MS / 2;
+        }
+        if (close && header->count > 0) {
+            header->sequence = sequence++;
+            if (fwrite(&page, sizeof(page), 1, f) != 1) {
+                err = -1;
+            }
+            header->count = 0;
+        }
+        if (s == NULL) {
+            break;
+        }
+        
+        channel_logic_step(&logic, params, i == 0, s->battery_mv, s->temp_raw, s->timestamp_ms);
+        
+        uint32_t mv = s->battery_mv > UINT16_MAX ? UINT16_MAX : s->battery_mv;
+        uint32_t temp_raw = s->temp_raw > UINT16_MAX ? UINT16_MAX : s->temp_raw;
+        if (header->count == 0) {
+            header->magic = SAMPLELOG_MAGIC;
+            header->start_ms = s->timestamp_ms;
+            header->base_mv = (uint16_t)mv;
+            header->base_temp_raw = (uint16_t)temp_raw;
+            header->interval_ms = SAMPLE_INTERVAL_MS;
+            samplelog_codec_reset(&codec, mv, temp_raw);
+        }
+        samplelog_page_append(&page, &codec, mv, temp_raw, logic.output_state ? 0x01 : 0x00);
+    }
+    
+    if (fclose(f) != 0) {
+        err = -1;
+    }
+    return err;
+}
+
+/**
+ * @brief Small deterministic PRNG so synthetic traces match on every host
+ */
+static uint32_t lcg_next(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/**
+ * @brief Generate a solar day/night cycle with clouds, sensor noise and a
+ *        daily temperature swing
+ */
+static int trace_synthesize(trace_t *trace, unsigned int days, uint32_t seed)
+{
+    uint32_t rng = seed;
+    
+    for (unsigned int day = 0; day < days; day++) {
+        // Each day gets its own irradiance (overcast days peak lower)
+        double clear_sky = 0.55 + 0.45 * (double)(lcg_next(&rng) % 1000) / 1000.0;
+        
+        for (uint32_t i = 0; i < SAMPLES_PER_DAY; i++) {
+            double phase = (double)i / SAMPLES_PER_DAY;
+            double sun = sin(2.0 * M_PI * (phase - 0.25));
+            if (sun < 0.0) {
+                sun = 0.0;
+            }
+            
+            // Battery: resting near 11.7 V at night, charging towards 14.3 V
+            double battery = 11700.0 + 2600.0 * sun * clear_sky;
+            double noise_mv = (double)(lcg_next(&rng) % 161) - 80.0;
+            
+            // Temperature: 15-35 C, peaking mid-afternoon
+            double temp_c = 25.0 + 10.0 * sin(2.0 * M_PI * (phase - 0.375));
+            double temp_noise = (double)(lcg_next(&rng) % 5) - 2.0;
+            
+            trace_sample_t sample = {
+                .timestamp_ms = (uint32_t)((uint64_t)(day * SAMPLES_PER_DAY + i) * SAMPLE_INTERVAL_MS),
+                .battery_mv = (uint32_t)(battery + noise_mv),
+                .temp_raw = (uint32_t)(500.0 + temp_c * 10.0 + temp_noise),
+            };
+            if (trace_push(trace, &sample) != 0) {
+                return -1;
+            }
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Run the whole trace through the logic once
+ * @param cadence_params Settled-input cadence, NULL to take every sample
+ */
+static void replay(const trace_t *trace, const channel_logic_params_t *params,
+                   const dimming_table_t *dimming, const cadence_params_t *cadence_params,
+                   replay_result_t *result)
+{
+    channel_logic_t logic;
+    channel_logic_init(&logic, params);
+    cadence_t cadence;
+    cadence_init(&cadence);
+    memset(result, 0, sizeof(*result));
+    result->latency_min = UINT32_MAX;
+    
+    // Index where the raw input started to call for the opposite state
+    size_t want_since = 0;
+    bool wanting = false;
+    dimming_state_t dimming_state = {0};
+    uint32_t last_duty = 0;
+    bool params_changed = true;
+    uint32_t next_reading_ms = 0;
+    uint32_t last_reading_ms = 0;
+    
+    for (size_t i = 0; i < trace->count; i++) {
+        const trace_sample_t *s = &trace->samples[i];
+        
+        channel_logic_result_t r = CHANNEL_LOGIC_STEADY;
+        if (cadence_params == NULL || i == 0 ||
+            (int32_t)(s->timestamp_ms - next_reading_ms) >= 0) {
+            if (i != 0) {
+                channel_logic_set_interval(&logic, s->timestamp_ms - last_reading_ms);
+            }
+            last_reading_ms = s->timestamp_ms;
+            r = channel_logic_step(&logic, params, params_changed,
+                                   s->battery_mv, s->temp_raw, s->timestamp_ms);
+            params_changed = false;
+            result->readings++;
+            
+            if (cadence_params != NULL) {
+                next_reading_ms = s->timestamp_ms +
+                    cadence_update(&cadence, cadence_params, logic.filtered_mv,
+                                   channel_logic_threshold_margin(&logic), s->timestamp_ms);
+            }
+        }
+        
+        // Raw (unfiltered) input versus the thresholds that were applied
+        bool raw_wants = channel_logic_hysteresis(logic.output_state, (int32_t)s->battery_mv,
+                                                  logic.th_on_mv, logic.th_off_mv)
+                         != logic.output_state;
+        
+        if (r == CHANNEL_LOGIC_CHANGED) {
+            uint32_t latency = wanting ? (uint32_t)(i - want_since) : 0;
+            result->state_changes++;
+            result->latency_total += latency;
+            if (latency < result->latency_min) {
+                result->latency_min = latency;
+            }
+            if (latency > result->latency_max) {
+                result->latency_max = latency;
+            }
+            wanting = false;
+        } else if (r == CHANNEL_LOGIC_BLOCKED) {
+            result->blocked++;
+        }
+        
+        if (raw_wants && !wanting) {
+            want_since = i;
+            wanting = true;
+        } else if (!raw_wants) {
+            wanting = false;
+        }
+        
+        // Dimming decision as control_task takes it (no motion override)
+        uint32_t duty = control_logic_dimming_duty(dimming, &dimming_state, s->battery_mv, false);
+        if (!logic.output_state) {
+            duty = 0;
+        }
+        if (duty != last_duty) {
+            result->duty_changes++;
+            last_duty = duty;
+        }
+        
+        if (logic.output_state) {
+            result->on_samples++;
+        }
+        if (trace->has_state && logic.output_state != s->recorded_on) {
+            result->state_mismatches++;
+        }
+    }
+    
+    if (result->state_changes == 0) {
+        result->latency_min = 0;
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Time the per-sample sensor conversions over the trace
+ * @return Cost in ns per sample
+ *
+ * Runs what adc_task and the channel processor compute for every reading:
+ * battery voltage from the divider tap, TMP36 temperature and the
+ * compensated threshold lookup.
+ */
+static double bench_sensor_math(const trace_t *trace, const channel_logic_params_t *params,
+                                unsigned int repeat)
+{
+    // Divider tap voltages that reproduce the trace's battery readings
+    uint32_t *tap_mv = malloc(trace->count * sizeof(*tap_mv));
+    comp_table_t *table = malloc(sizeof(*table));
+    if (tap_mv == NULL || table == NULL) {
+        free(tap_mv);
+        free(table);
+        return 0.0;
+    }
+    comp_table_build(table, params->base_th_on_mv, params->base_th_off_mv,
+                     params->temp_coeff, (comp_curve_t)params->comp_curve);
+    for (size_t i = 0; i < trace->count; i++) {
+        tap_mv[i] = (uint32_t)((uint64_t)trace->samples[i].battery_mv * SENSOR_DIVIDER_R_BOT /
+                               (SENSOR_DIVIDER_R_TOP + SENSOR_DIVIDER_R_BOT));
+    }
+    
+    volatile int64_t sink = 0;
+    double start = now_ns();
+    for (unsigned int r = 0; r < repeat; r++) {
+        int64_t acc = 0;
+        for (size_t i = 0; i < trace->count; i++) {
+            sensor_temp_t temp = sensor_temperature(trace->samples[i].temp_raw, NULL);
+            acc += sensor_battery_mv(tap_mv[i]);
+            acc += table->pair[comp_table_index(temp)].on_mv;
+        }
+        sink += acc;
+    }
+    double elapsed = now_ns() - start;
+    (void)sink;
+    
+    free(tap_mv);
+    free(table);
+    return elapsed / ((double)trace->count * repeat);
+}
+
+int main(int argc, char **argv)
+{
+    const char *trace_path = NULL;
+    const char *samplelog_path = NULL;
+    const char *write_path = NULL;
+    const char *write_samplelog_path = NULL;
+    unsigned int synthetic_days = 0;
+    uint32_t seed = 1;
+    unsigned int repeat = 1;
+    long expect_changes = -1;
+    long expect_mismatches = -1;
+    double max_ns = 0.0;
+    uint32_t adaptive_ms = 0;
+    
+    channel_logic_params_t params = {
+        .base_th_on_mv = DEFAULT_TH_ON,
+        .base_th_off_mv = DEFAULT_TH_OFF,
+        .temp_coeff = SENSOR_COEFF(DEFAULT_TEMP_COEFF),
+    };
+    const dimming_params_t bands = {
+        .full_duty = DEFAULT_PWM_FULL,
+        .half_duty = DEFAULT_PWM_HALF,
+        .quarter_duty = DEFAULT_PWM_HALF / 2,
+    };
+    dimming_curve_t curve;
+    control_logic_default_curve(&bands, &curve);
+    int hysteresis_mv = -1;
+    
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        
+        if (arg[0] != '-') {
+            trace_path = arg;
+            continue;
+        }
+        if (val == NULL) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+        
+        if (strcmp(arg, "--synthetic") == 0) {
+            synthetic_days = (unsigned int)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--seed") == 0) {
+            seed = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--samplelog") == 0) {
+            samplelog_path = val;
+        } else if (strcmp(arg, "--write-trace") == 0) {
+            write_path = val;
+        } else if (strcmp(arg, "--write-samplelog") == 0) {
+            write_samplelog_path = val;
+        } else if (strcmp(arg, "--repeat") == 0) {
+            repeat = (unsigned int)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--th-on") == 0) {
+            params.base_th_on_mv = (int32_t)strtol(val, NULL, 0);
+        } else if (strcmp(arg, "--th-off") == 0) {
+            params.base_th_off_mv = (int32_t)strtol(val, NULL, 0);
+        } else if (strcmp(arg, "--temp-coeff") == 0) {
+            params.temp_coeff = sensor_coeff(strtof(val, NULL));
+        } else if (strcmp(arg, "--curve") == 0) {
+            params.comp_curve = COMP_CURVE_COUNT;
+            for (int c = 0; c < COMP_CURVE_COUNT; c++) {
+                if (strcmp(val, comp_curve_name((comp_curve_t)c)) == 0) {
+                    params.comp_curve = (uint8_t)c;
+                }
+            }
+            if (params.comp_curve == COMP_CURVE_COUNT) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--dimming") == 0) {
+            if (parse_dimming_curve(val, &curve) != 0) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--dimming-hyst") == 0) {
+            hysteresis_mv = (int)strtol(val, NULL, 0);
+        } else if (strcmp(arg, "--filter") == 0) {
+            if (strcmp(val, filter_type_name(FILTER_BOXCAR)) == 0) {
+                params.filter.type = FILTER_BOXCAR;
+            } else if (strcmp(val, filter_type_name(FILTER_EMA)) == 0) {
+                params.filter.type = FILTER_EMA;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--filter-length") == 0) {
+            params.filter.length = (uint8_t)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--median") == 0) {
+            params.filter.median = (uint8_t)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--adaptive") == 0) {
+            adaptive_ms = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--expect-changes") == 0) {
+            expect_changes = strtol(val, NULL, 0);
+        } else if (strcmp(arg, "--expect-mismatches") == 0) {
+            expect_mismatches = strtol(val, NULL, 0);
+        } else if (strcmp(arg, "--max-ns-per-sample") == 0) {
+            max_ns = strtod(val, NULL);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    
+    int sources = (trace_path != NULL) + (samplelog_path != NULL) + (synthetic_days != 0);
+    if (hysteresis_mv >= 0) {
+        curve.hysteresis_mv = (uint16_t)hysteresis_mv;
+    }
+    if (sources != 1 || repeat == 0 || !filter_config_normalize(&params.filter) ||
+        !control_logic_curve_valid(&curve)) {
+        usage(argv[0]);
+        return 2;
+    }
+    dimming_table_t dimming;
+    control_logic_dimming_compile(&dimming, &curve, DEFAULT_PWM_FULL, LEDC_MAX_DUTY);
+    
+    trace_t trace = {0};
+    int err = trace_path ? trace_load(&trace, trace_path)
+            : samplelog_path ? trace_load_samplelog(&trace, samplelog_path)
+            : trace_synthesize(&trace, synthetic_days, seed);
+    if (err != 0 || trace.count == 0) {
+        fprintf(stderr, "No samples to replay\n");
+        free(trace.samples);
+        return 2;
+    }
+    if (write_path != NULL && trace_save(&trace, write_path) != 0) {
+        free(trace.samples);
+        return 2;
+    }
+    if (write_samplelog_path != NULL &&
+        trace_save_samplelog(&trace, &params, write_samplelog_path) != 0) {
+        free(trace.samples);
+        return 2;
+    }
+    
+    const cadence_params_t cadence = {
+        .fast_ms = SAMPLE_INTERVAL_MS,
+        .slow_ms = adaptive_ms,
+        .settle_ms = DEFAULT_SETTLE_MS,
+        .band_mv = DEFAULT_BAND_MV,
+        .slope_mv_s = DEFAULT_SLOPE_MV_S,
+        .margin_mv = DEFAULT_MARGIN_MV,
+    };
+    
+    replay_result_t result;
+    double start = now_ns();
+    for (unsigned int r = 0; r < repeat; r++) {
+        replay(&trace, &params, &dimming, adaptive_ms ? &cadence : NULL, &result);
+    }
+    double elapsed = now_ns() - start;
+    
+    double samples = (double)result.readings * repeat;
+    double ns_per_sample = elapsed / samples;
+    double span_h = (double)trace.count * SAMPLE_INTERVAL_MS / 3600000.0;
+    double convert_ns = bench_sensor_math(&trace, &params, repeat);
+    
+    printf("Trace:          %zu samples (%.1f h at %d ms)\n",
+           trace.count, span_h, SAMPLE_INTERVAL_MS);
+    printf("Filter:         %s %u", filter_type_name(params.filter.type), params.filter.length);
+    if (params.filter.median > 1) {
+        printf(" after median-of-%u", params.filter.median);
+    }
+    printf("\n");
+    if (adaptive_ms != 0) {
+        printf("Adaptive:       %" PRIu32 " readings (%.1f%% of samples, %" PRIu32 " ms settled)\n",
+               result.readings, 100.0 * result.readings / trace.count, adaptive_ms);
+    }
+    printf("Cost:           %.1f ns/sample, %.2f Msamples/s (%u pass%s)\n",
+           ns_per_sample, 1e3 / ns_per_sample, repeat, repeat == 1 ? "" : "es");
+    printf("Sensor math:    %.1f ns/sample (%s)\n",
+           convert_ns, SOLAR_FIXED_POINT ? "Q16 fixed-point" : "float");
+    printf("State changes:  %" PRIu32 " (%" PRIu32 " blocked by debounce)\n",
+           result.state_changes, result.blocked);
+    printf("Duty changes:   %" PRIu32 "\n", result.duty_changes);
+    printf("Output ON:      %.1f%% of samples\n", 100.0 * result.on_samples / trace.count);
+    printf("Decision latency (samples): min=%" PRIu32 " avg=%.1f max=%" PRIu32 "\n",
+           result.latency_min,
+           result.state_changes ? (double)result.latency_total / result.state_changes : 0.0,
+           result.latency_max);
+    if (trace.has_state) {
+        printf("Recorded state: %" PRIu32 " mismatching samples\n", result.state_mismatches);
+    }
+    
+    int status = 0;
+    if (expect_changes >= 0 && (long)result.state_changes != expect_changes) {
+        fprintf(stderr, "FAIL: expected %ld state changes, got %" PRIu32 "\n",
+                expect_changes, result.state_changes);
+        status = 1;
+    }
+    if (expect_mismatches >= 0 && (long)result.state_mismatches != expect_mismatches) {
+        fprintf(stderr, "FAIL: expected %ld recorded state mismatches, got %" PRIu32 "\n",
+                expect_mismatches, result.state_mismatches);
+        status = 1;
+    }
+    if (max_ns > 0.0 && ns_per_sample > max_ns) {
+        fprintf(stderr, "FAIL: %.1f ns/sample exceeds the %.1f ns budget\n",
+                ns_per_sample, max_ns);
+        status = 1;
+    }
+    
+    free(trace.samples);
+    return status;
+}
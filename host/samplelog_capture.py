@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Capture the controller's flash sample log over the console UART.
+
+Sends ``samplelog -d`` and saves the raw pages between the
+``SAMPLELOG BEGIN <pages> <page_size>`` and ``SAMPLELOG END`` markers, ready
+for ``bench_replay --samplelog FILE``. Close ``idf.py monitor`` first.
+
+    python3 host/samplelog_capture.py /dev/ttyUSB0 capture.bin
+"""
+import argparse
+import re
+import sys
+
+import serial
+
+BEGIN = re.compile(rb'SAMPLELOG BEGIN (\d+) (\d+)\r?\n')
+
+
+def capture(port: serial.Serial, timeout: float) -> bytes:
+    port.reset_input_buffer()
+    port.write(b'samplelog -d\r\n')
+
+    # Skip the echoed command line and prompt up to the header
+    buffered = b''
+    while True:
+        chunk = port.read(256)
+        if not chunk:
+            raise RuntimeError('no SAMPLELOG BEGIN within %.0f s' % timeout)
+        buffered += chunk
+        match = BEGIN.search(buffered)
+        if match:
+            break
+
+    pages, page_size = int(match.group(1)), int(match.group(2))
+    expected = pages * page_size
+    data = buffered[match.end():]
+    while len(data) < expected:
+        chunk = port.read(expected - len(data))
+        if not chunk:
+            raise RuntimeError('dump stalled at %d of %d bytes' % (len(data), expected))
+        data += chunk
+
+    trailer = data[expected:] + port.read_until(b'SAMPLELOG END\n')
+    if b'SAMPLELOG END' not in trailer:
+        raise RuntimeError('missing SAMPLELOG END marker')
+
+    print('captured %d pages of %d bytes' % (pages, page_size), file=sys.stderr)
+    return data[:expected]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('port', help='console serial port, e.g. /dev/ttyUSB0')
+    parser.add_argument('output', help='file to write the raw pages to')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--timeout', type=float, default=5.0, help='per-read timeout in seconds')
+    args = parser.parse_args()
+
+    with serial.Serial(args.port, args.baud, timeout=args.timeout) as port:
+        data = capture(port, args.timeout)
+
+    with open(args.output, 'wb') as f:
+        f.write(data)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
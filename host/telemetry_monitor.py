@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Decode the controller's binary telemetry stream to CSV.
+
+Sends ``stream on -r RATE``, then prints one CSV line per valid status frame
+(see main/telemetry_format.h) until interrupted, and sends ``stream off`` on
+exit. Bytes that do not form a frame with a valid CRC (console text, a
+frame cut by a reconnect) are skipped.
+
+    python3 host/telemetry_monitor.py /dev/ttyUSB0 --rate 10 > telemetry.csv
+"""
+import argparse
+import struct
+import sys
+
+import serial
+
+SYNC = b'\xa5\x5a'
+TYPE_STATUS = 0x01
+HEADER = 4
+CHANNEL_SLOTS = 8
+STATUS = struct.Struct('<IIIHHh%dhBBBBBIIII' % CHANNEL_SLOTS)
+FIELDS = ('sequence', 'uptime_ms', 'sample_ms', 'battery_mv', 'temp_raw', 'temperature_dc',
+          'channel_count', 'channel_states', 'output_states', 'pwm_duty', 'flags',
+          'boot_count', 'ring_overruns', 'drops', 'config_generation')
+
+
+def crc16(data: bytes) -> int:
+    """CRC-16/CCITT-FALSE, as telemetry_crc16()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def frames(port: serial.Serial):
+    """Yield (type, payload) for every frame with a valid CRC."""
+    buffered = b''
+    while True:
+        buffered += port.read(max(1, port.in_waiting))
+        while True:
+            start = buffered.find(SYNC)
+            if start < 0:
+                buffered = buffered[-1:]
+                break
+            if len(buffered) < start + HEADER:
+                buffered = buffered[start:]
+                break
+            length = buffered[start + 3]
+            end = start + HEADER + length + 2
+            if len(buffered) < end:
+                buffered = buffered[start:]
+                break
+            body = buffered[start + 2:end - 2]
+            crc = buffered[end - 2] | (buffered[end - 1] << 8)
+            if crc16(body) == crc:
+                yield body[0], body[2:]
+                buffered = buffered[end:]
+            else:
+                # Not a frame: resume the search one byte later
+                buffered = buffered[start + 1:]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('port', help='console serial port, e.g. /dev/ttyUSB0')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--rate', type=int, default=10, help='frames per second (1-10)')
+    args = parser.parse_args()
+
+    with serial.Serial(args.port, args.baud, timeout=1.0) as port:
+        port.write(b'stream on -r %d\r\n' % args.rate)
+        header = None
+        last_sequence = None
+        lost = 0
+        try:
+            for frame_type, payload in frames(port):
+                if frame_type != TYPE_STATUS or len(payload) != STATUS.size:
+                    continue
+                values = STATUS.unpack(payload)
+                # One filtered-voltage column per channel the firmware has
+                count = values[6 + CHANNEL_SLOTS]
+                row = values[:6] + values[6 + CHANNEL_SLOTS:] + values[6:6 + count]
+                if header is None:
+                    header = FIELDS + tuple('filtered%d_mv' % ch for ch in range(count))
+                    print(','.join(header))
+                if last_sequence is not None and values[0] != last_sequence + 1:
+                    lost += (values[0] - last_sequence - 1) & 0xFFFFFFFF
+                last_sequence = values[0]
+                print(','.join(str(v) for v in row), flush=True)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            port.write(b'stream off\r\n')
+
+    print('lost frames: %d' % lost, file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,848 @@
+/**
+ * @file test_logic.c
+ * @brief Host unit checks for channel_logic, the filter engine, the sensor
+ *        conversions, the unit calibration profile, the dimming decision,
+ *        the night schedule, resuming after a reset, the state-of-charge
+ *        estimator, the sample cadence, the sample log codec and telemetry
+ *        framing
+ */
+
+#include "adc_cal.h"
+#include "cadence_logic.h"
+#include "channel_logic.h"
+#include "control_logic.h"
+#include "fleet_format.h"
+#include "samplelog_format.h"
+#include "schedule_logic.h"
+#include "soc_logic.h"
+#include "telemetry_format.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static const channel_logic_params_t params = {
+    .base_th_on_mv = 12500,
+    .base_th_off_mv = 11800,
+    .temp_coeff = SENSOR_COEFF(-0.02),
+};
+
+// TMP36 output at 25 C
+#define TEMP_RAW_25C    750
+
+static void test_moving_average(void)
+{
+    const filter_config_t config = {0};
+    filter_t filter;
+    filter_init(&filter, &config);
+    CHECK(filter_output(&filter) == 0);
+    CHECK(filter.config.type == FILTER_BOXCAR && filter.config.length == FILTER_DEFAULT_LENGTH);
+    
+    // First sample fills the whole window
+    CHECK(filter_push(&filter, 12000) == 12000);
+    
+    // A step settles after exactly FILTER_DEFAULT_LENGTH samples
+    for (int i = 0; i < FILTER_DEFAULT_LENGTH - 1; i++) {
+        CHECK(filter_push(&filter, 13600) < 13600);
+    }
+    CHECK(filter_push(&filter, 13600) == 13600);
+}
+
+static void test_ema(void)
+{
+    const filter_config_t config = { .type = FILTER_EMA, .length = 7 };
+    filter_t filter;
+    filter_init(&filter, &config);
+    
+    // alpha = 2 / (7 + 1): a 1000 mV step moves 250 mV on the first sample
+    CHECK(filter_push(&filter, 12000) == 12000);
+    CHECK(filter_push(&filter, 13000) == 12250);
+    
+    // Converges without a steady-state offset
+    for (int i = 0; i < 200; i++) {
+        filter_push(&filter, 13000);
+    }
+    CHECK(filter_output(&filter) == 13000);
+    
+    // Switching continues from the given value instead of refilling
+    const filter_config_t boxcar = { .type = FILTER_BOXCAR, .length = 4 };
+    filter_reconfigure(&filter, &boxcar, 13000);
+    CHECK(filter_push(&filter, 12000) == 12750);
+}
+
+static void test_median(void)
+{
+    const filter_config_t config = { .type = FILTER_BOXCAR, .length = 1, .median = 3 };
+    filter_t filter;
+    filter_init(&filter, &config);
+    
+    // A single-sample spike in either direction never reaches the output
+    CHECK(filter_push(&filter, 12000) == 12000);
+    CHECK(filter_push(&filter, 9000) == 12000);
+    CHECK(filter_push(&filter, 12010) == 12000);
+    CHECK(filter_push(&filter, 15000) == 12010);
+    CHECK(filter_push(&filter, 12020) == 12020);
+    CHECK(filter_push(&filter, 12030) == 12030);
+    CHECK(filter_push(&filter, 12040) == 12030);
+    
+    // A sustained step passes after (N + 1) / 2 samples
+    CHECK(filter_push(&filter, 13000) == 12040);
+    CHECK(filter_push(&filter, 13000) == 13000);
+    
+    // Invalid selections are rejected
+    filter_config_t bad = { .type = FILTER_EMA, .median = 4 };
+    CHECK(!filter_config_normalize(&bad));
+    bad = (filter_config_t){ .type = FILTER_TYPE_COUNT };
+    CHECK(!filter_config_normalize(&bad));
+    bad = (filter_config_t){ .length = FILTER_MAX_LENGTH + 1 };
+    CHECK(!filter_config_normalize(&bad));
+}
+
+static void test_cic(void)
+{
+    uint32_t out = 0;
+    
+    // Order 1 is the block average
+    cic_t cic;
+    cic_init(&cic, 1, 4);
+    for (uint32_t v = 1; v <= 4; v++) {
+        cic_push(&cic, v * 1000);
+    }
+    CHECK(cic_decimate(&cic, &out) && out == 2500);
+    
+    // Order 3 settles after three blocks, then tracks a constant exactly
+    cic_init(&cic, 3, 1000);
+    for (int block = 0; block < 5; block++) {
+        for (int i = 0; i < 1000; i++) {
+            cic_push(&cic, 4095);
+        }
+        bool ok = cic_decimate(&cic, &out);
+        CHECK(ok == (block >= 2));
+    }
+    CHECK(out == 4095);
+    
+    // Ripple at the block rate (alternating halves) averages out
+    cic_init(&cic, 2, 100);
+    for (int block = 0; block < 6; block++) {
+        for (int i = 0; i < 100; i++) {
+            cic_push(&cic, (i < 50) ? 2000 : 1000);
+        }
+        cic_decimate(&cic, &out);
+    }
+    CHECK(out == 1500);
+    
+    // A short block resets and reports failure
+    for (int i = 0; i < 99; i++) {
+        cic_push(&cic, 1000);
+    }
+    CHECK(!cic_decimate(&cic, &out));
+}
+
+static void test_hysteresis(void)
+{
+    // Between the thresholds the current state is kept
+    CHECK(!channel_logic_hysteresis(false, 12000, 12500, 11800));
+    CHECK(channel_logic_hysteresis(true, 12000, 12500, 11800));
+    
+    CHECK(channel_logic_hysteresis(false, 12500, 12500, 11800));
+    CHECK(!channel_logic_hysteresis(true, 11799, 12500, 11800));
+}
+
+static void test_temperature(void)
+{
+    bool in_range = false;
+    CHECK(sensor_temperature(TEMP_RAW_25C, &in_range) == SENSOR_TEMP_C(25));
+    CHECK(in_range);
+    CHECK(sensor_temperature(850, NULL) == SENSOR_TEMP_C(35));
+    CHECK(sensor_temp_dc(sensor_temperature(745, NULL)) == 245);
+    CHECK(sensor_temp_dc(sensor_temperature(100, NULL)) == -400);
+    
+    // Out of sensor range falls back to 25 C
+    CHECK(sensor_temperature(0, &in_range) == SENSOR_TEMP_C(25));
+    CHECK(!in_range);
+    CHECK(sensor_temperature(3000, NULL) == SENSOR_TEMP_C(25));
+}
+
+static void test_battery_divider(void)
+{
+    // 47k/10k: exact battery voltage is tap * 5.7; float truncates, Q16 rounds
+    static const uint32_t taps[] = { 0, 1, 1000, 2184, 2500, 3300 };
+    for (size_t i = 0; i < sizeof(taps) / sizeof(taps[0]); i++) {
+        uint32_t exact_x10 = taps[i] * 57;
+        int32_t error_x10 = (int32_t)(sensor_battery_mv(taps[i]) * 10) - (int32_t)exact_x10;
+        CHECK(error_x10 >= -10 && error_x10 <= 10);
+    }
+#if SOLAR_FIXED_POINT
+    CHECK(sensor_battery_mv(2000) == 11400);
+#endif
+}
+
+static void test_adc_cal(void)
+{
+    // Two points of a 5.7 divider: exact at both, linear between them
+    const adc_cal_point_t low = { .raw = 2000, .mv = 11400 };
+    const adc_cal_point_t high = { .raw = 2600, .mv = 14820 };
+    adc_cal_line_t line;
+    CHECK(adc_cal_fit_two(&line, &low, &high));
+    CHECK(adc_cal_apply(&line, 2000) == 11400);
+    CHECK(adc_cal_apply(&line, 2600) == 14820);
+    CHECK(adc_cal_apply(&line, 2300) == 13110);
+    
+    adc_cal_line_t reversed;
+    CHECK(adc_cal_fit_two(&reversed, &high, &low));
+    CHECK(reversed.gain_q16 == line.gain_q16 && reversed.offset_q16 == line.offset_q16);
+    
+    // Too close together, or falling, is no gain measurement
+    const adc_cal_point_t near = { .raw = 2100, .mv = 11970 };
+    const adc_cal_point_t falling = { .raw = 2600, .mv = 10000 };
+    CHECK(!adc_cal_fit_two(&line, &low, &near));
+    CHECK(!adc_cal_fit_two(&line, &low, &falling));
+    
+    // One point keeps the slope and moves the offset
+    const adc_cal_point_t offset = { .raw = 2000, .mv = 11500 };
+    CHECK(adc_cal_fit_one(&line, SENSOR_DIVIDER_Q16, &offset));
+    CHECK(adc_cal_apply(&line, 2000) == 11500);
+    CHECK(adc_cal_apply(&line, 2100) == 12070);
+    CHECK(adc_cal_apply(&line, ADC_CAL_RAW_MAX + 100) == adc_cal_apply(&line, ADC_CAL_RAW_MAX));
+    
+    // Out of limits, or below zero
+    const adc_cal_point_t far = { .raw = 100, .mv = 30000 };
+    CHECK(!adc_cal_fit_one(&line, SENSOR_DIVIDER_Q16, &far));
+    const adc_cal_line_t negative = { .gain_q16 = 1 << 16, .offset_q16 = -(100 << 16) };
+    CHECK(adc_cal_apply(&negative, 50) == 0);
+    CHECK(adc_cal_apply(&negative, 150) == 50);
+    
+    adc_cal_profile_t profile;
+    memset(&profile, 0, sizeof(profile));
+    CHECK(adc_cal_profile_valid(&profile));
+    profile.line[ADC_CAL_TEMP] = negative;
+    CHECK(!adc_cal_profile_valid(&profile));
+    profile.points[ADC_CAL_TEMP] = 2;
+    CHECK(adc_cal_profile_valid(&profile));
+    profile.points[ADC_CAL_TEMP] = 3;
+    CHECK(!adc_cal_profile_valid(&profile));
+    
+    CHECK(adc_cal_divider_q16(11400, 2000) == SENSOR_DIVIDER_Q16);
+    CHECK(adc_cal_divider_q16(11400, 0) == 0);
+}
+
+static void test_compensation(void)
+{
+    channel_logic_t logic;
+    channel_logic_init(&logic, &params);
+    
+    // +10 C at -0.02 V/C lowers both thresholds by 200 mV (float product
+    // truncates, so allow 1 mV; Q16 is exact)
+    CHECK(channel_logic_compensate(&logic, &params, true, SENSOR_TEMP_C(35)));
+    CHECK(logic.compensation_mv <= -199 && logic.compensation_mv >= -200);
+#if SOLAR_FIXED_POINT
+    CHECK(logic.compensation_mv == -200);
+    CHECK(sensor_compensation_mv(SENSOR_COEFF(-0.02), SENSOR_TEMP_C(-20)) == 400);
+    CHECK(sensor_compensation_mv(sensor_coeff(-0.0175f), 1) == -2);   // -1.75 mV rounds away
+#endif
+    CHECK(logic.th_on_mv - params.base_th_on_mv == logic.compensation_mv);
+    CHECK(logic.th_off_mv - params.base_th_off_mv == logic.compensation_mv);
+    
+    // Drift within the 0.5 C bucket keeps the thresholds
+    CHECK(!channel_logic_compensate(&logic, &params, false, SENSOR_TEMP_C(35.2)));
+    CHECK(channel_logic_compensate(&logic, &params, false, SENSOR_TEMP_C(35.3)));
+    CHECK(logic.comp_temperature == SENSOR_TEMP_C(35.5));
+    
+    // A parameter change always rebuilds
+    CHECK(channel_logic_compensate(&logic, &params, true, SENSOR_TEMP_C(35.3)));
+}
+
+static void test_comp_table(void)
+{
+    static comp_table_t table;
+    
+    // Every bucket matches the direct computation at its centre
+    comp_table_build(&table, 12500, 11800, SENSOR_COEFF(-0.02), COMP_CURVE_LINEAR);
+    for (int i = 0; i < COMP_TABLE_SIZE; i++) {
+        int32_t mv = sensor_compensation_mv(SENSOR_COEFF(-0.02), comp_table_temp(i) - COMP_REF_TEMP);
+        CHECK(table.pair[i].on_mv == 12500 + mv && table.pair[i].off_mv == 11800 + mv);
+    }
+    CHECK(comp_table_index(SENSOR_TEMP_C(SENSOR_TEMP_MIN_C)) == 0);
+    CHECK(comp_table_index(SENSOR_TEMP_C(SENSOR_TEMP_MAX_C)) == COMP_TABLE_SIZE - 1);
+    CHECK(comp_table_index(SENSOR_TEMP_C(SENSOR_TEMP_MAX_C + 10)) == COMP_TABLE_SIZE - 1);
+    CHECK(comp_table_temp(comp_table_index(SENSOR_TEMP_C(24.8))) == SENSOR_TEMP_C(25));
+    
+    // Lead-acid holds the offset outside 0 to 50 C
+    comp_table_build(&table, 12500, 11800, SENSOR_COEFF(-0.02), COMP_CURVE_LEAD_ACID);
+    const comp_pair_t *cold = &table.pair[comp_table_index(SENSOR_TEMP_C(-20))];
+    const comp_pair_t *hot = &table.pair[comp_table_index(SENSOR_TEMP_C(60))];
+    CHECK(cold->on_mv == table.pair[comp_table_index(SENSOR_TEMP_C(0))].on_mv);
+    CHECK(hot->off_mv == table.pair[comp_table_index(SENSOR_TEMP_C(50))].off_mv);
+    CHECK(cold->on_mv >= 12999 && cold->on_mv <= 13000);
+    
+    // Lithium compensates only below 25 C
+    comp_table_build(&table, 12500, 11800, SENSOR_COEFF(-0.02), COMP_CURVE_LITHIUM);
+    CHECK(table.pair[comp_table_index(SENSOR_TEMP_C(40))].on_mv == 12500);
+    CHECK(table.pair[comp_table_index(SENSOR_TEMP_C(10))].on_mv > 12500);
+    
+    // Out-of-range thresholds saturate instead of wrapping
+    comp_table_build(&table, 40000, -40000, SENSOR_COEFF(0), COMP_CURVE_LINEAR);
+    CHECK(table.pair[0].on_mv == INT16_MAX && table.pair[0].off_mv == INT16_MIN);
+    CHECK(strcmp(comp_curve_name(COMP_CURVE_LEAD_ACID), "lead-acid") == 0);
+}
+
+static void test_debounce(void)
+{
+    channel_logic_t logic;
+    channel_logic_init(&logic, &params);
+    
+    // No change within MIN_STATE_CHANGE_MS of boot
+    CHECK(channel_logic_step(&logic, &params, true, 13000, TEMP_RAW_25C, 100) == CHANNEL_LOGIC_BLOCKED);
+    CHECK(!logic.output_state);
+    
+    CHECK(channel_logic_step(&logic, &params, false, 13000, TEMP_RAW_25C, MIN_STATE_CHANGE_MS) == CHANNEL_LOGIC_CHANGED);
+    CHECK(logic.output_state);
+    
+    // Steady while above OFF threshold
+    CHECK(channel_logic_step(&logic, &params, false, 13000, TEMP_RAW_25C, 6000) == CHANNEL_LOGIC_STEADY);
+    
+    // Drive the filter below OFF: blocked until 5 s after the last change
+    uint32_t t = 6000;
+    channel_logic_result_t r = CHANNEL_LOGIC_STEADY;
+    for (int i = 0; i < FILTER_DEFAULT_LENGTH; i++) {
+        t += 100;
+        r = channel_logic_step(&logic, &params, false, 11000, TEMP_RAW_25C, t);
+    }
+    CHECK(r == CHANNEL_LOGIC_BLOCKED);
+    CHECK(logic.output_state);
+    
+    r = channel_logic_step(&logic, &params, false, 11000, TEMP_RAW_25C, 2 * MIN_STATE_CHANGE_MS);
+    CHECK(r == CHANNEL_LOGIC_CHANGED);
+    CHECK(!logic.output_state);
+}
+
+static void test_resume(void)
+{
+    // A channel resumed ON inside the hysteresis band stays ON
+    channel_logic_t logic;
+    channel_logic_init(&logic, &params);
+    channel_logic_resume(&logic, true, 12200, 300);
+    CHECK(logic.output_state && logic.filtered_mv == 12200);
+    CHECK(channel_logic_step(&logic, &params, true, 12200, TEMP_RAW_25C, 400) == CHANNEL_LOGIC_STEADY);
+    CHECK(logic.output_state);
+    
+    // The seeded window averages in the next reading instead of jumping to it
+    channel_logic_step(&logic, &params, false, 11000, TEMP_RAW_25C, 500);
+    CHECK(logic.filtered_mv > 12000 && logic.filtered_mv < 12200);
+    
+    // The resumed state counts as a change: a real crossing waits out the debounce
+    for (int i = 0; i < FILTER_DEFAULT_LENGTH; i++) {
+        channel_logic_step(&logic, &params, false, 11000, TEMP_RAW_25C, 600);
+    }
+    CHECK(logic.output_state);
+    CHECK(channel_logic_step(&logic, &params, false, 11000, TEMP_RAW_25C, 300 + MIN_STATE_CHANGE_MS) == CHANNEL_LOGIC_CHANGED);
+    CHECK(!logic.output_state);
+    
+    // The night continues where it was: 4 h in, the 5 h segment is 1 h away
+    const uint32_t min = 60000;
+    schedule_config_t config;
+    schedule_default_config(&config);
+    config.enabled = 1;
+    schedule_t schedule;
+    uint32_t next_ms;
+    schedule_resume(&schedule, true, 240 * min, 500);
+    CHECK(schedule.started && schedule.night);
+    CHECK(schedule_level(&schedule, &config, 500, &next_ms) == 100 && next_ms == 60 * min);
+    
+    // Resumed by day: the next dusk still needs its confirmation
+    schedule_resume(&schedule, false, 0, 500);
+    CHECK(!schedule.night);
+    CHECK(!schedule_update(&schedule, &config, 12000, 1000));
+    CHECK(!schedule.night);
+}
+
+static void test_cadence(void)
+{
+    const cadence_params_t cp = {
+        .fast_ms = 100,
+        .slow_ms = 1000,
+        .settle_ms = 60000,
+        .band_mv = 100,
+        .slope_mv_s = 20,
+        .margin_mv = 300,
+    };
+    cadence_t cadence;
+    cadence_init(&cadence);
+    
+    // Fast until the input has stayed in band for settle_ms
+    CHECK(cadence_update(&cadence, &cp, 13000, 500, 0) == 100);
+    CHECK(cadence_update(&cadence, &cp, 13050, 500, 59900) == 100);
+    CHECK(cadence_update(&cadence, &cp, 12950, 500, 60000) == 1000);
+    CHECK(cadence_update(&cadence, &cp, 13000, 500, 61000) == 1000);
+    
+    // Leaving the band restarts the settle time
+    CHECK(cadence_update(&cadence, &cp, 13200, 500, 62000) == 100);
+    CHECK(cadence_update(&cadence, &cp, 13200, 500, 121900) == 100);
+    CHECK(cadence_update(&cadence, &cp, 13200, 500, 122000) == 1000);
+    
+    // Closing in on the threshold returns to fast even in band
+    CHECK(cadence_update(&cadence, &cp, 13200, 299, 123000) == 100);
+    CHECK(cadence_update(&cadence, &cp, 13200, 300, 124000) == 100);
+    
+    // A fast move inside the band also restarts it (slope over 5 s windows)
+    cadence_init(&cadence);
+    CHECK(cadence_update(&cadence, &cp, 13000, 500, 0) == 100);
+    CHECK(cadence_update(&cadence, &cp, 12910, 500, 60000) == 1000);
+    CHECK(cadence_update(&cadence, &cp, 13020, 500, 65000) == 100);     // 22 mV/s
+    
+    // The margin must hold for one slow interval at the current slope
+    cadence_init(&cadence);
+    CHECK(cadence_update(&cadence, &cp, 13000, 500, 0) == 100);
+    CHECK(cadence_update(&cadence, &cp, 12960, 500, 55000) == 100);
+    CHECK(cadence_update(&cadence, &cp, 13060, 340, 60000) == 1000);    // 20 mV/s
+    CHECK(cadence_update(&cadence, &cp, 13060, 315, 61000) == 100);     // 315 - 20 < 300
+    
+    // Margin follows the output state
+    channel_logic_t logic;
+    channel_logic_init(&logic, &params);
+    logic.filtered_mv = 12000;
+    CHECK(channel_logic_threshold_margin(&logic) == 500);
+    logic.output_state = true;
+    CHECK(channel_logic_threshold_margin(&logic) == 200);
+}
+
+static void test_filter_rescale(void)
+{
+    // The window keeps its time span: 16 x 100 ms = 2 x 800 ms
+    filter_config_t config = { .type = FILTER_BOXCAR };
+    CHECK(filter_config_normalize(&config));
+    filter_config_rescale(&config, 800);
+    CHECK(config.length == 2);
+    config.length = 4;
+    filter_config_rescale(&config, 10000);
+    CHECK(config.length == 1);
+    
+    channel_logic_t logic;
+    channel_logic_init(&logic, &params);
+    CHECK(logic.interval_ms == FILTER_BASE_INTERVAL_MS);
+    channel_logic_filter(&logic, 13000);
+    CHECK(channel_logic_set_interval(&logic, 1000));
+    CHECK(!channel_logic_set_interval(&logic, 1000));
+    CHECK(logic.filter.config.length == 2);
+    CHECK(channel_logic_filter(&logic, 13000) == 13000);
+    CHECK(channel_logic_filter(&logic, 14000) == 13500);
+    
+    // A new filter selection is rescaled too; returning restores the configured window
+    filter_config_t ema = { .type = FILTER_EMA, .length = 8 };
+    channel_logic_set_filter(&logic, &ema);
+    CHECK(logic.filter.config.type == FILTER_EMA && logic.filter.config.length == 1);
+    CHECK(channel_logic_set_interval(&logic, FILTER_BASE_INTERVAL_MS));
+    CHECK(logic.filter.config.length == 8);
+}
+
+static void test_dimming(void)
+{
+    const dimming_params_t bands = { .full_duty = 100, .half_duty = 50, .quarter_duty = 25 };
+    dimming_curve_t curve;
+    control_logic_default_curve(&bands, &curve);
+    CHECK(control_logic_curve_valid(&curve));
+    
+    // 100 counts full scale: counts read as percent
+    dimming_table_t dimming;
+    dimming_state_t state = {0};
+    control_logic_dimming_compile(&dimming, &curve, 100, 100);
+    
+    // The default curve keeps the battery bands' steps
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_FULL_THRESHOLD, false) == 100);
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_FULL_THRESHOLD - 1, false) == 50);
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_HALF_THRESHOLD, false) == 50);
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_HALF_THRESHOLD - 1, false) == 25);
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_CRITICAL_THRESHOLD - 1, false) == 0);
+    CHECK(control_logic_dimming_duty(&dimming, &state, 15000, false) == 100);
+    
+    // Motion forces full brightness at any voltage
+    CHECK(control_logic_dimming_duty(&dimming, &state, 10000, true) == 100);
+    
+    // Linear between points, flat beyond them, in LEDC counts
+    const dimming_curve_t ramp = {
+        .count = 3,
+        .hysteresis_mv = 50,
+        .point = { { 11000, 0, 0 }, { 12000, 40, 0 }, { 13000, 100, 0 } },
+    };
+    CHECK(control_logic_curve_valid(&ramp));
+    control_logic_dimming_compile(&dimming, &ramp, 100, 8191);
+    memset(&state, 0, sizeof(state));
+    CHECK(control_logic_dimming_duty(&dimming, &state, 10000, false) == 0);
+    CHECK(control_logic_dimming_duty(&dimming, &state, 11500, false) == 8191 * 40 / 100 / 2);
+    CHECK(control_logic_dimming_duty(&dimming, &state, 12500, false) == 5733);
+    CHECK(control_logic_dimming_duty(&dimming, &state, 13000, false) == 8191);
+    
+    // Moves smaller than the hysteresis keep the evaluated voltage
+    CHECK(control_logic_dimming_duty(&dimming, &state, 12960, false) == 8191);
+    CHECK(control_logic_dimming_duty(&dimming, &state, 13040, false) == 8191);
+    CHECK(control_logic_dimming_duty(&dimming, &state, 12950, false) < 8191);
+    CHECK(state.input_mv == 12950);
+    
+    // Out-of-order points are rejected and compile to outputs off
+    dimming_curve_t bad = ramp;
+    bad.point[2].mv = 12000;
+    CHECK(!control_logic_curve_valid(&bad));
+    control_logic_dimming_compile(&dimming, &bad, 100, 8191);
+    CHECK(control_logic_dimming_duty(&dimming, &state, 13000, false) == 0);
+    bad = ramp;
+    bad.point[1].duty = 101;
+    CHECK(!control_logic_curve_valid(&bad));
+    
+    // State of charge bands: the same steps at 20/50/80 %, in 0.1 % units
+    control_logic_default_soc_curve(&bands, &curve);
+    CHECK(control_logic_curve_valid(&curve) && curve.input == DIMMING_INPUT_SOC);
+    control_logic_dimming_compile(&dimming, &curve, 100, 100);
+    CHECK(dimming.input == DIMMING_INPUT_SOC);
+    memset(&state, 0, sizeof(state));
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_FULL_SOC, false) == 100);
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_HALF_SOC, false) == 50);
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_CRITICAL_SOC, false) == 25);
+    CHECK(control_logic_dimming_duty(&dimming, &state, BATTERY_CRITICAL_SOC - 1, false) == 0);
+    bad = curve;
+    bad.point[bad.count - 1].mv = SOC_PERMILLE_FULL + 1;
+    CHECK(!control_logic_curve_valid(&bad));
+    bad = curve;
+    bad.input = DIMMING_INPUT_COUNT;
+    CHECK(!control_logic_curve_valid(&bad));
+    
+    // Ramps run at the full-scale rate in either direction
+    CHECK(control_logic_fade_ms(1000, 0, 8191, 8191) == 1000);
+    CHECK(control_logic_fade_ms(1000, 8191, 4095, 8191) == 500);
+    CHECK(control_logic_fade_ms(1000, 100, 104, 8191) == 0);
+    CHECK(control_logic_fade_ms(0, 0, 8191, 8191) == 0);
+}
+
+static void test_schedule(void)
+{
+    const uint32_t min = 60000;
+    schedule_config_t config;
+    schedule_default_config(&config);
+    CHECK(schedule_config_valid(&config));
+    config.enabled = 1;
+    
+    // The first voltage decides the phase; the night counts from boot
+    schedule_t schedule;
+    uint32_t next_ms;
+    schedule_init(&schedule);
+    CHECK(schedule_level(&schedule, &config, 0, &next_ms) == 100 && next_ms == 0);
+    CHECK(schedule_update(&schedule, &config, 14000, 1000));
+    CHECK(!schedule.night);
+    CHECK(schedule_level(&schedule, &config, 1000, &next_ms) == 0 && next_ms == 0);
+    
+    // Dusk needs the voltage below dusk_mv for confirm_min without a break
+    uint32_t dusk = 10 * min;
+    CHECK(!schedule_update(&schedule, &config, 12900, dusk));
+    CHECK(!schedule_update(&schedule, &config, 13100, dusk + 5 * min));
+    CHECK(!schedule_update(&schedule, &config, 12900, dusk + 6 * min));
+    CHECK(!schedule_update(&schedule, &config, 12900, dusk + 20 * min));
+    CHECK(schedule_update(&schedule, &config, 12900, dusk + 21 * min));
+    CHECK(schedule.night && schedule.dusk_ms == dusk + 6 * min);
+    dusk += 6 * min;
+    
+    // Segments count from the first crossing, with the timer set to the next one
+    CHECK(schedule_level(&schedule, &config, dusk + 15 * min, &next_ms) == 100);
+    CHECK(next_ms == 285 * min);
+    CHECK(schedule_level(&schedule, &config, dusk + 300 * min - 1, NULL) == 100);
+    CHECK(schedule_level(&schedule, &config, dusk + 300 * min, &next_ms) == 40 && next_ms == 0);
+    
+    // Dawn ends the night after the same confirmation
+    CHECK(!schedule_update(&schedule, &config, 13500, dusk + 600 * min));
+    CHECK(schedule_update(&schedule, &config, 13500, dusk + 615 * min));
+    CHECK(!schedule.night);
+    CHECK(schedule_level(&schedule, &config, dusk + 615 * min, NULL) == config.day_level);
+    
+    // Boot in the dark starts the night at once; the clock may wrap
+    schedule_init(&schedule);
+    CHECK(schedule_update(&schedule, &config, 12000, UINT32_MAX - min));
+    CHECK(schedule.night);
+    CHECK(schedule_level(&schedule, &config, 298 * min, NULL) == 100);
+    CHECK(schedule_level(&schedule, &config, 299 * min + 1, NULL) == 40);
+    
+    // Disabled: the dimming curve alone
+    config.enabled = 0;
+    CHECK(schedule_level(&schedule, &config, 300 * min, &next_ms) == 100 && next_ms == 0);
+    
+    // Segments must start at dusk and ascend, dawn must be above dusk
+    schedule_config_t bad = config;
+    bad.segment[0].start_min = 10;
+    CHECK(!schedule_config_valid(&bad));
+    bad = config;
+    bad.segment[1].start_min = 0;
+    CHECK(!schedule_config_valid(&bad));
+    bad = config;
+    bad.segment[1].level = 101;
+    CHECK(!schedule_config_valid(&bad));
+    bad = config;
+    bad.dawn_mv = bad.dusk_mv;
+    CHECK(!schedule_config_valid(&bad));
+    bad = config;
+    bad.count = 0;
+    CHECK(!schedule_config_valid(&bad));
+}
+
+static void test_soc(void)
+{
+    // Resting voltage to charge, linear between the 10 % points
+    CHECK(soc_ocv_permille(11000) == 0);
+    CHECK(soc_ocv_permille(11300) == 0);
+    CHECK(soc_ocv_permille(12100) == 500);
+    CHECK(soc_ocv_permille(12170) == 550);
+    CHECK(soc_ocv_permille(12730) == SOC_PERMILLE_FULL);
+    CHECK(soc_ocv_permille(14000) == SOC_PERMILLE_FULL);
+    
+    const soc_params_t params = {
+        .capacity_mah = 10000,
+        .charge_efficiency_pct = 90,
+        .rest_ma = 100,
+        .rest_ms = 30 * 60000,
+    };
+    soc_t soc;
+    soc_init(&soc, &params);
+    
+    // The first sample anchors to the voltage, even under load
+    uint32_t now = 0;
+    soc_update(&soc, -2000, 12100, now);
+    CHECK(soc_permille(&soc) == 500);
+    
+    // 1 A out for an hour of 100 ms samples takes 10 % of 10 Ah
+    for (int i = 0; i < 36000; i++) {
+        now += 100;
+        soc_update(&soc, -1000, 11500, now);
+    }
+    CHECK(soc_permille(&soc) == 400);
+    
+    // Charging stores 90 % of the current
+    for (int i = 0; i < 36000; i++) {
+        now += 100;
+        soc_update(&soc, 1000, 13800, now);
+    }
+    CHECK(soc_permille(&soc) == 490);
+    
+    // A stalled sampler integrates at most SOC_MAX_STEP_MS
+    int64_t before = soc.charge_q32;
+    now += 3600000;
+    soc_update(&soc, -1000, 12000, now);
+    int64_t step = -(int64_t)1000 * SOC_MAX_STEP_MS * soc.discharge_gain_q24 >> 24;
+    CHECK(soc.charge_q32 - before == step);
+    
+    // The estimate saturates at empty and full
+    for (int i = 0; i < 600; i++) {
+        now += 10000;
+        soc_update(&soc, -10000, 11000, now);
+    }
+    CHECK(soc_permille(&soc) == 0);
+    for (int i = 0; i < 600; i++) {
+        now += 10000;
+        soc_update(&soc, 10000, 14400, now);
+    }
+    CHECK(soc_permille(&soc) == SOC_PERMILLE_FULL);
+    
+    // Each capacity discharged is one cycle, however it was spread:
+    // four 5.5 Ah discharges of a 10 Ah battery
+    soc_init(&soc, &params);
+    now = 0;
+    soc_update(&soc, 0, 12730, now);
+    for (int cycle = 0; cycle < 4; cycle++) {
+        for (int i = 0; i < 1980; i++) {
+            now += 10000;
+            soc_update(&soc, -1000, 12000, now);
+        }
+        CHECK(soc_permille(&soc) == 450);
+        for (int i = 0; i < 2200; i++) {
+            now += 10000;
+            soc_update(&soc, 1000, 13800, now);
+        }
+    }
+    CHECK(soc.cycles == 2);
+    
+    // Rest re-anchors after the rest time, once per rest
+    soc_init(&soc, &params);
+    now = 0;
+    soc_update(&soc, 0, 12730, now);
+    for (int i = 0; i <= 180; i++) {
+        now += 10000;
+        soc_update(&soc, 50, 12100, now);
+        CHECK(soc_permille(&soc) == (i < 180 ? SOC_PERMILLE_FULL : 500));
+    }
+    for (int i = 0; i < 10; i++) {
+        now += 10000;
+        soc_update(&soc, 50, 12370, now);
+    }
+    CHECK(soc_permille(&soc) == 500);
+    now += 10000;
+    soc_update(&soc, -500, 12000, now);
+    uint16_t loaded = soc_permille(&soc);
+    for (int i = 0; i <= 180; i++) {
+        now += 10000;
+        soc_update(&soc, 0, 12370, now);
+        CHECK(soc_permille(&soc) == (i < 180 ? loaded : 700));
+    }
+}
+
+static void test_samplelog_codec(void)
+{
+    samplelog_codec_t enc, dec;
+    samplelog_codec_reset(&enc, 12000, TEMP_RAW_25C);
+    samplelog_codec_reset(&dec, 12000, TEMP_RAW_25C);
+    
+    // Small steps are exact, state bits pass through
+    uint32_t mv, temp;
+    uint8_t state;
+    samplelog_decode(&dec, samplelog_encode(&enc, 11873, TEMP_RAW_25C - 8, 0x3), &mv, &temp, &state);
+    CHECK(mv == 11873 && temp == TEMP_RAW_25C - 8 && state == 0x3);
+    
+    // A step past the field range saturates, then catches up without drift
+    uint32_t target = 13000;
+    int records = 0;
+    do {
+        samplelog_decode(&dec, samplelog_encode(&enc, target, TEMP_RAW_25C + 20, 0), &mv, &temp, &state);
+        records++;
+    } while ((mv != target || temp != TEMP_RAW_25C + 20) && records < 100);
+    CHECK(mv == target);
+    CHECK(temp == TEMP_RAW_25C + 20);
+    CHECK(records == (int)((target - 11873 + 126) / 127));
+    CHECK(enc.mv == dec.mv && enc.temp_raw == dec.temp_raw);
+    
+    samplelog_page_header_t header = { .magic = SAMPLELOG_MAGIC, .count = 1, .interval_ms = 100 };
+    CHECK(samplelog_header_valid(&header));
+    header.count = SAMPLELOG_WORDS_PER_PAGE + 1;
+    CHECK(!samplelog_header_valid(&header));
+    header.count = 0;
+    CHECK(!samplelog_header_valid(&header));
+    
+    // Wide records carry the states of channels 4 and up in a second word
+    static samplelog_page_t page;
+    memset(&page, 0xFF, sizeof(page));
+    page.header = (samplelog_page_header_t){ .magic = SAMPLELOG_MAGIC_WIDE, .base_mv = 12000,
+                                             .base_temp_raw = TEMP_RAW_25C, .interval_ms = 100 };
+    samplelog_codec_reset(&enc, 12000, TEMP_RAW_25C);
+    samplelog_page_append(&page, &enc, 12010, TEMP_RAW_25C + 1, 0x0A5);
+    samplelog_page_append(&page, &enc, 11990, TEMP_RAW_25C, 0x081);
+    CHECK(page.header.count == 2 && page.records[1] == 0x0A && page.records[3] == 0x08);
+    CHECK(samplelog_header_valid(&page.header));
+    CHECK(fleet_page_size(&page.header) == sizeof(samplelog_page_header_t) + 8);
+    
+    uint16_t wide_state;
+    samplelog_codec_reset(&dec, 12000, TEMP_RAW_25C);
+    samplelog_page_decode(&page, 0, &dec, &mv, &temp, &wide_state);
+    CHECK(mv == 12010 && temp == TEMP_RAW_25C + 1 && wide_state == 0x0A5);
+    samplelog_page_decode(&page, 1, &dec, &mv, &temp, &wide_state);
+    CHECK(mv == 11990 && temp == TEMP_RAW_25C && wide_state == 0x081);
+    
+    page.header.count = SAMPLELOG_WORDS_PER_PAGE / 2 + 1;
+    CHECK(!samplelog_header_valid(&page.header));
+}
+
+static void test_telemetry_frame(void)
+{
+    // CRC-16/CCITT-FALSE check value
+    CHECK(telemetry_crc16(0xFFFF, (const uint8_t *)"123456789", 9) == 0x29B1);
+    
+    telemetry_status_t status = { .sequence = 7, .battery_mv = 12800, .filtered_mv = { 12750, -1 },
+                                  .channel_count = 2 };
+    uint8_t frame[TELEMETRY_STATUS_FRAME_SIZE + 1];
+    size_t size = telemetry_frame_encode(frame, TELEMETRY_TYPE_STATUS, &status, sizeof(status));
+    CHECK(size == TELEMETRY_STATUS_FRAME_SIZE);
+    CHECK(frame[0] == TELEMETRY_SYNC0 && frame[1] == TELEMETRY_SYNC1);
+    
+    const uint8_t *payload = telemetry_frame_check(frame, size);
+    CHECK(payload != NULL);
+    if (payload != NULL) {
+        telemetry_status_t decoded;
+        memcpy(&decoded, payload, sizeof(decoded));
+        CHECK(decoded.sequence == 7 && decoded.battery_mv == 12800 && decoded.filtered_mv[1] == -1);
+        CHECK(decoded.channel_count == 2);
+    }
+    
+    // Truncated or corrupted frames are rejected
+    CHECK(telemetry_frame_check(frame, size - 1) == NULL);
+    frame[10] ^= 0x01;
+    CHECK(telemetry_frame_check(frame, size) == NULL);
+}
+
+static void test_fleet_message(void)
+{
+    static samplelog_page_t pages[3];
+    static uint8_t buf[sizeof(fleet_header_t) + 2 * SAMPLELOG_PAGE_SIZE];
+    const uint8_t unit[FLEET_UNIT_ID_LEN] = { 0x24, 0x0a, 0xc4, 0x01, 0x02, 0x03 };
+    
+    for (int i = 0; i < 3; i++) {
+        memset(&pages[i], 0, sizeof(pages[i]));
+        pages[i].header = (samplelog_page_header_t){ .magic = SAMPLELOG_MAGIC, .sequence = 40 + i,
+                                                     .count = 10, .interval_ms = 100 };
+        for (int r = 0; r < 10; r++) {
+            pages[i].records[r] = (uint16_t)(i * 100 + r);
+        }
+    }
+    pages[1].header.count = SAMPLELOG_WORDS_PER_PAGE;
+    pages[2].header.count = SAMPLELOG_WORDS_PER_PAGE;
+    
+    // Only used records are copied; a page that does not fit is left out
+    fleet_header_init((fleet_header_t *)buf, FLEET_TYPE_SAMPLES, unit, 5);
+    CHECK(fleet_append_page(buf, sizeof(buf), &pages[0]));
+    CHECK(fleet_append_page(buf, sizeof(buf), &pages[1]));
+    CHECK(!fleet_append_page(buf, sizeof(buf), &pages[2]));
+    fleet_header_t header;
+    memcpy(&header, buf, sizeof(header));
+    CHECK(header.magic == FLEET_MAGIC && header.count == 2 && header.burst == 5);
+    CHECK(header.length == fleet_page_size(&pages[0].header) + fleet_page_size(&pages[1].header));
+    CHECK(fleet_page_size(&pages[0].header) == sizeof(samplelog_page_header_t) + 20);
+    
+    // Decoding walks the pages back out
+    size_t len = sizeof(header) + header.length;
+    size_t offset = 0;
+    samplelog_page_header_t page;
+    const uint8_t *records;
+    CHECK(fleet_next_page(buf, len, &offset, &page, &records));
+    CHECK(page.sequence == 40 && page.count == 10);
+    uint16_t record;
+    memcpy(&record, records + 9 * sizeof(record), sizeof(record));
+    CHECK(record == 9);
+    CHECK(fleet_next_page(buf, len, &offset, &page, &records));
+    CHECK(page.sequence == 41 && page.count == SAMPLELOG_WORDS_PER_PAGE);
+    CHECK(!fleet_next_page(buf, len, &offset, &page, &records));
+    
+    // A truncated message ends the walk instead of reading past it
+    offset = 0;
+    CHECK(fleet_next_page(buf, len - 1, &offset, &page, &records));
+    CHECK(!fleet_next_page(buf, len - 1, &offset, &page, &records));
+}
+
+int main(void)
+{
+    test_moving_average();
+    test_ema();
+    test_median();
+    test_cic();
+    test_hysteresis();
+    test_temperature();
+    test_battery_divider();
+    test_adc_cal();
+    test_compensation();
+    test_comp_table();
+    test_debounce();
+    test_resume();
+    test_dimming();
+    test_schedule();
+    test_soc();
+    test_cadence();
+    test_filter_rescale();
+    test_samplelog_codec();
+    test_telemetry_frame();
+    test_fleet_message();
+    
+    if (failures != 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    
+    printf("All logic checks passed\n");
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "adc_cal.h"
+
+/**
+ * @brief Name of an input for the console
+ */
+const char *adc_cal_input_name(adc_cal_input_t input)
+{
+    switch (input) {
+    case ADC_CAL_BATTERY:
+        return "battery";
+    case ADC_CAL_TEMP:
+        return "temp";
+    case ADC_CAL_CURRENT:
+        return "current";
+    default:
+        return "?";
+    }
+}
+
+/**
+ * @brief Check a line against the gain and offset limits
+ */
+bool adc_cal_line_valid(const adc_cal_line_t *line)
+{
+    const int32_t offset_max = ADC_CAL_OFFSET_MAX_MV << 16;
+    
+    return line->gain_q16 > 0 && line->gain_q16 <= ADC_CAL_GAIN_MAX_Q16 &&
+           line->offset_q16 >= -offset_max && line->offset_q16 <= offset_max;
+}
+
+/**
+ * @brief Check a stored profile
+ */
+bool adc_cal_profile_valid(const adc_cal_profile_t *profile)
+{
+    if (profile->reserved != 0) {
+        return false;
+    }
+    
+    for (int i = 0; i < ADC_CAL_INPUT_COUNT; i++) {
+        const adc_cal_line_t *line = &profile->line[i];
+        if (profile->points[i] > 2) {
+            return false;
+        }
+        if (profile->points[i] == 0 ? (line->gain_q16 != 0 || line->offset_q16 != 0)
+                                    : !adc_cal_line_valid(line)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Offset that puts a line of the given slope through a point
+ */
+static bool fit_offset(adc_cal_line_t *line, int32_t gain_q16, const adc_cal_point_t *point)
+{
+    int64_t offset = ((int64_t)point->mv << 16) - (int64_t)gain_q16 * point->raw;
+    if (offset < INT32_MIN || offset > INT32_MAX) {
+        return false;
+    }
+    
+    adc_cal_line_t fitted = { .gain_q16 = gain_q16, .offset_q16 = (int32_t)offset };
+    if (!adc_cal_line_valid(&fitted)) {
+        return false;
+    }
+    *line = fitted;
+    return true;
+}
+
+/**
+ * @brief Fit a line through one point with a given slope
+ */
+bool adc_cal_fit_one(adc_cal_line_t *line, int32_t gain_q16, const adc_cal_point_t *point)
+{
+    if (point->raw > ADC_CAL_RAW_MAX) {
+        return false;
+    }
+    return fit_offset(line, gain_q16, point);
+}
+
+/**
+ * @brief Fit a line through two points
+ */
+bool adc_cal_fit_two(adc_cal_line_t *line, const adc_cal_point_t *a, const adc_cal_point_t *b)
+{
+    if (a->raw > ADC_CAL_RAW_MAX || b->raw > ADC_CAL_RAW_MAX) {
+        return false;
+    }
+    
+    int64_t span = (int64_t)b->raw - a->raw;
+    int64_t rise = ((int64_t)b->mv - a->mv) * 65536;
+    if (span < 0) {
+        span = -span;
+        rise = -rise;
+    }
+    if (span < ADC_CAL_MIN_SPAN_RAW || rise <= 0) {
+        return false;
+    }
+    
+    int64_t gain = (rise + span / 2) / span;
+    if (gain > ADC_CAL_GAIN_MAX_Q16) {
+        return false;
+    }
+    
+    // Through the midpoint, so rounding the slope splits the error
+    int64_t offset = ((((int64_t)a->mv + b->mv) << 16) - gain * ((int64_t)a->raw + b->raw)) / 2;
+    if (offset < INT32_MIN || offset > INT32_MAX) {
+        return false;
+    }
+    
+    adc_cal_line_t fitted = { .gain_q16 = (int32_t)gain, .offset_q16 = (int32_t)offset };
+    if (!adc_cal_line_valid(&fitted)) {
+        return false;
+    }
+    *line = fitted;
+    return true;
+}
+
+/**
+ * @brief Divider ratio from a battery reference and the pin voltage it gave
+ */
+uint32_t adc_cal_divider_q16(uint32_t battery_mv, uint32_t pin_mv)
+{
+    if (pin_mv == 0) {
+        return 0;
+    }
+    return (uint32_t)((((uint64_t)battery_mv << 16) + pin_mv / 2) / pin_mv);
+}
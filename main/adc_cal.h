@@ -0,0 +1,140 @@
+/**
+ * @file adc_cal.h
+ * @brief Per-unit ADC calibration profile
+ *
+ * The eFuse characterisation of the ADC and the nominal divider resistors
+ * leave a few percent of error on a given board. The profile replaces them,
+ * per input, with a straight line fitted to reference measurements taken on
+ * that unit ('calibrate' CLI command): the averaged raw count maps to the
+ * input's value with one multiply, one add and one shift, and no call into
+ * adc_cali_raw_to_voltage() at all.
+ *
+ * Each line yields the value the rest of the pipeline works in: battery mV
+ * at the terminals for the battery input (divider included), pin mV for the
+ * TMP36 and the current sensor, so the TMP36 and current conversions still
+ * apply on top. Two reference points give gain and offset; a single point
+ * keeps the slope of the uncalibrated conversion and corrects the offset.
+ *
+ * Integer only in both math builds. The profile is saved in NVS.
+ */
+
+#ifndef ADC_CAL_H
+#define ADC_CAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Full-scale raw count of the 12-bit ADC
+#define ADC_CAL_RAW_MAX         4095
+
+// Line limits; they keep raw * gain + offset inside 32 bits
+#define ADC_CAL_GAIN_MAX_Q16    (6 << 16)   // mV per count
+#define ADC_CAL_OFFSET_MAX_MV   4000
+
+// Two points closer than this (about 1/20 of full scale) only fit an offset
+#define ADC_CAL_MIN_SPAN_RAW    200
+
+_Static_assert((int64_t)ADC_CAL_RAW_MAX * ADC_CAL_GAIN_MAX_Q16 +
+               ((int64_t)ADC_CAL_OFFSET_MAX_MV << 16) + 0x8000 <= INT32_MAX,
+               "calibration line overflows 32 bits");
+
+/**
+ * @brief Calibrated ADC inputs
+ */
+typedef enum {
+    ADC_CAL_BATTERY = 0,        // Battery terminals (mV), through the divider
+    ADC_CAL_TEMP,               // TMP36 output (pin mV)
+    ADC_CAL_CURRENT,            // Current sensor output (pin mV)
+    ADC_CAL_INPUT_COUNT
+} adc_cal_input_t;
+
+/**
+ * @struct adc_cal_line_t
+ * @brief value = (raw * gain_q16 + offset_q16 + 0.5) >> 16
+ */
+typedef struct {
+    int32_t gain_q16;           // mV per raw count, Q16
+    int32_t offset_q16;         // mV at raw count 0, Q16
+} adc_cal_line_t;
+
+/**
+ * @struct adc_cal_point_t
+ * @brief One reference measurement
+ */
+typedef struct {
+    uint32_t raw;               // Averaged raw count
+    uint32_t mv;                // Reference value in the input's unit (mV)
+} adc_cal_point_t;
+
+/**
+ * @struct adc_cal_profile_t
+ * @brief Calibration of one unit, stored as one NVS blob
+ */
+typedef struct {
+    adc_cal_line_t line[ADC_CAL_INPUT_COUNT];
+    uint8_t points[ADC_CAL_INPUT_COUNT];    // Points behind each line, 0 = uncalibrated
+    uint8_t reserved;                       // Zero
+    uint32_t divider_q16;                   // Measured battery divider ratio, 0 = not measured
+} adc_cal_profile_t;
+
+/**
+ * @brief Convert an averaged raw count through a calibration line
+ * @return Value in mV, 0 for a line that would go negative
+ */
+static inline uint32_t adc_cal_apply(const adc_cal_line_t *line, uint32_t raw)
+{
+    if (raw > ADC_CAL_RAW_MAX) {
+        raw = ADC_CAL_RAW_MAX;
+    }
+    int32_t value = (int32_t)raw * line->gain_q16 + line->offset_q16 + 0x8000;
+    return value > 0 ? (uint32_t)value >> 16 : 0;
+}
+
+/**
+ * @brief Check whether an input has a calibration line
+ */
+static inline bool adc_cal_active(const adc_cal_profile_t *profile, adc_cal_input_t input)
+{
+    return profile->points[input] != 0;
+}
+
+/**
+ * @brief Name of an input for the console ("battery", "temp", "current")
+ */
+const char *adc_cal_input_name(adc_cal_input_t input);
+
+/**
+ * @brief Check a line against the gain and offset limits
+ */
+bool adc_cal_line_valid(const adc_cal_line_t *line);
+
+/**
+ * @brief Check a stored profile
+ * @return false for a point count above 2, an invalid line, or a nonzero
+ *         line or reserved byte where there should be none
+ */
+bool adc_cal_profile_valid(const adc_cal_profile_t *profile);
+
+/**
+ * @brief Fit a line through one point with a given slope
+ * @param line Output line
+ * @param gain_q16 Slope to keep (the uncalibrated conversion's, mV per count)
+ * @param point Reference measurement
+ * @return false if the line is out of limits
+ */
+bool adc_cal_fit_one(adc_cal_line_t *line, int32_t gain_q16, const adc_cal_point_t *point);
+
+/**
+ * @brief Fit a line through two points
+ * @return false if the points are less than ADC_CAL_MIN_SPAN_RAW apart or
+ *         the line is out of limits
+ */
+bool adc_cal_fit_two(adc_cal_line_t *line, const adc_cal_point_t *a, const adc_cal_point_t *b);
+
+/**
+ * @brief Divider ratio from a battery reference and the pin voltage it gave
+ * @return Ratio in Q16, 0 if pin_mv is 0
+ */
+uint32_t adc_cal_divider_q16(uint32_t battery_mv, uint32_t pin_mv);
+
+#endif
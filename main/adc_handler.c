@@ -1,41 +1,130 @@
 #include "adc_handler.h"
+#include "sdkconfig.h"
 #include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
+#include "seqlock.h"
+#include "sample_ring.h"
+#include "nvs_storage.h"
+#include "task_stats.h"
+#include "perf_stats.h"
+#include "rtlog.h"
+#include "adc_cal.h"
+#include "sensor_math.h"
+#include "signal_filter.h"
+#include "soc_logic.h"
+#include "channel_processor.h"
+#include "esp_timer.h"
+#include "rtos_alloc.h"
+#include <string.h>
 
 static const char *TAG = "ADC_HANDLER";
 
 // Hardware configuration
 #define ADC_BATTERY_CHANNEL     ADC_CHANNEL_6  // GPIO34
 #define ADC_TEMP_CHANNEL        ADC_CHANNEL_7  // GPIO35
+#define ADC_CURRENT_CHANNEL     ADC_CHANNEL_0  // GPIO36
 #define ADC_ATTEN               ADC_ATTEN_DB_12
 #define ADC_WIDTH               ADC_BITWIDTH_12
 
-// Voltage divider resistor values (in ohms)
-#define R_TOP    47000.0f  // 47kΩ
-#define R_BOT    10000.0f  // 10kΩ
-#define DIVIDER_RATIO  ((R_TOP + R_BOT) / R_BOT)  // ~5.7
-
-// Sampling configuration
-#define ADC_SAMPLE_INTERVAL_MS  100   // Sample every 100ms
-#define QUEUE_SIZE              10
-
 // Oversampling for noise reduction
 #define OVERSAMPLE_COUNT        8
 
+// Readings averaged into one calibration point
+#define ADC_CAL_CAPTURE_READINGS    16
+
+// Half-width of the raw span the uncalibrated slope is measured over
+#define ADC_CAL_SLOPE_SPAN      64
+
+// Sampled inputs: battery, temperature and optionally the current sensor
+#if CONFIG_SOLAR_CURRENT_SENSE
+#define ADC_INPUT_COUNT         3
+#else
+#define ADC_INPUT_COUNT         2
+#endif
+
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+// Continuous (DMA) sampling configuration
+// One conversion frame spans one sample interval, so the task wakes once per
+// interval and the whole frame is decimated into a single reading.
+#define ADC_CONV_FREQ_HZ        CONFIG_SOLAR_ADC_CONV_FREQ_HZ
+#define ADC_CONV_PER_FRAME      ((ADC_CONV_FREQ_HZ / 1000) * ADC_SAMPLE_INTERVAL_MS)
+#define ADC_CONV_FRAME_SIZE     (ADC_CONV_PER_FRAME * SOC_ADC_DIGI_RESULT_BYTES)
+#define ADC_CONV_POOL_SIZE      (ADC_CONV_FRAME_SIZE * 2)
+
+// Frame decimation: CIC stages, each conversion of an input is one CIC sample
+#define ADC_CIC_ORDER           CONFIG_SOLAR_ADC_CIC_ORDER
+#define ADC_CIC_RATIO           (ADC_CONV_PER_FRAME / ADC_INPUT_COUNT)
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_OUTPUT_TYPE         ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_GET_CHANNEL(p)      ((p)->type1.channel)
+#define ADC_GET_DATA(p)         ((p)->type1.data)
+#else
+#define ADC_OUTPUT_TYPE         ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_GET_CHANNEL(p)      ((p)->type2.channel)
+#define ADC_GET_DATA(p)         ((p)->type2.data)
+#endif
+#endif
+
 // ADC handles
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+static adc_continuous_handle_t adc1_cont_handle = NULL;
+static TaskHandle_t adc_task_handle = NULL;
+static uint8_t adc_frame_buf[ADC_CONV_FRAME_SIZE];
+// Completion time of the most recent DMA frame, stamped in the ISR
+static volatile int64_t frame_done_us = 0;
+// Decimators for the scanned inputs (adc_task only)
+static cic_t battery_cic;
+static cic_t temp_cic;
+#if CONFIG_SOLAR_CURRENT_SENSE
+static cic_t current_cic;
+#endif
+// Scanning stopped between readings at a stretched interval
+static volatile bool adc_idle = false;
+#else
 static adc_oneshot_unit_handle_t adc1_handle = NULL;
+// Serializes adc_task and forced reads on the shared oneshot handle
+static SemaphoreHandle_t adc1_lock = NULL;
+RTOS_MUTEX_STORAGE(adc1_lock);
+#endif
 static adc_cali_handle_t adc1_cali_handle = NULL;
 static bool calibration_available = false;
 
-// Queues for each channel
-QueueHandle_t adc_queue_ch0 = NULL;
-QueueHandle_t adc_queue_ch1 = NULL;
+// Interval adc_task currently samples at (written by adc_task only)
+static volatile uint32_t sample_interval_ms = ADC_SAMPLE_INTERVAL_MS;
+
+/**
+ * @brief Latest published sample, written only by adc_task
+ */
+typedef struct {
+    adc_reading_t reading;
+    sensor_temp_t temperature;
+    uint32_t raw[ADC_CAL_INPUT_COUNT];  // Averaged raw counts behind the reading
+    bool valid;
+} adc_snapshot_t;
+
+static adc_snapshot_t latest_snapshot = {0};
+static seqlock_t latest_lock = SEQLOCK_INITIALIZER;
+
+#if CONFIG_SOLAR_CURRENT_SENSE
+// State-of-charge integrator (adc_task only)
+static soc_t soc;
+#endif
+// Equivalent full cycles counted since boot (written by adc_task only)
+static volatile uint32_t charge_cycles = 0;
+
+// Calibration profile in use and its configuration generation (adc_task only)
+static adc_cal_profile_t cal_profile = {0};
+static uint32_t cal_generation = 0;
+static bool cal_loaded = false;
 
 /**
  * @brief Initialize ADC calibration
@@ -45,9 +134,9 @@ static bool adc_calibration_init(adc_unit_t unit, adc_atten_t atten, adc_cali_ha
     adc_cali_handle_t handle = NULL;
     esp_err_t ret = ESP_FAIL;
     bool calibrated = false;
-
-    ESP_LOGI(TAG, "Calibration scheme version: Curve Fitting");
     
+    ESP_LOGI(TAG, "Calibration scheme version: Curve Fitting");
+
 #if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
     adc_cali_curve_fitting_config_t cali_config = {
         .unit_id = unit,
@@ -76,7 +165,7 @@ static bool adc_calibration_init(adc_unit_t unit, adc_atten_t atten, adc_cali_ha
         }
     }
 #endif
-
+    
     *out_handle = handle;
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Calibration failed: %s. Using raw values.", esp_err_to_name(ret));
@@ -85,81 +174,276 @@ static bool adc_calibration_init(adc_unit_t unit, adc_atten_t atten, adc_cali_ha
 }
 
 /**
- * @brief Read ADC with oversampling and return voltage in mV
+ * @brief Convert an averaged raw count to pin voltage in mV
+ */
+static uint32_t adc_raw_to_mv(int raw)
+{
+    if (calibration_available) {
+        int voltage = 0;
+        if (adc_cali_raw_to_voltage(adc1_cali_handle, raw, &voltage) == ESP_OK) {
+            return (uint32_t)voltage;
+        }
+    }
+    
+    // Fallback: approximate conversion for 12-bit ADC with 12dB attenuation
+    // Max voltage ~3300mV at 4095 counts (rough approximation)
+    return (uint32_t)((raw * 3300) / 4095);
+}
+
+/**
+ * @brief Value of an input for an averaged raw count
+ * One multiply-shift with a calibration line; otherwise the eFuse
+ * conversion, and the nominal divider for the battery
+ */
+static uint32_t adc_input_mv(const adc_cal_profile_t *profile, adc_cal_input_t input, uint32_t raw)
+{
+    if (adc_cal_active(profile, input)) {
+        return adc_cal_apply(&profile->line[input], raw);
+    }
+    
+    uint32_t pin_mv = adc_raw_to_mv((int)raw);
+    return input == ADC_CAL_BATTERY ? sensor_battery_mv(pin_mv) : pin_mv;
+}
+
+#if !CONFIG_SOLAR_ADC_CONTINUOUS
+/**
+ * @brief Read ADC with oversampling and return the averaged raw count
+ * Sub-samples are averaged raw and converted once by the caller
  */
-static uint32_t adc_read_voltage(adc_channel_t channel)
+static uint32_t adc_read_raw(adc_channel_t channel)
 {
-    int raw_sum = 0;
-    int voltage_sum = 0;
+    uint32_t raw_sum = 0;
+    uint32_t raw_count = 0;
     
     // Oversample to reduce noise
     for (int i = 0; i < OVERSAMPLE_COUNT; i++) {
         int raw = 0;
         esp_err_t ret = adc_oneshot_read(adc1_handle, channel, &raw);
         if (ret == ESP_OK) {
-            raw_sum += raw;
-            
-            if (calibration_available) {
-                int voltage = 0;
-                ret = adc_cali_raw_to_voltage(adc1_cali_handle, raw, &voltage);
-                if (ret == ESP_OK) {
-                    voltage_sum += voltage;
-                }
-            }
+            raw_sum += (uint32_t)raw;
+            raw_count++;
         } else {
-            ESP_LOGW(TAG, "ADC read failed on channel %d: %s", channel, esp_err_to_name(ret));
+            RTLOG(RTLOG_ADC_READ_FAILED, channel, RTLOG_S(esp_err_to_name(ret)));
         }
         vTaskDelay(pdMS_TO_TICKS(2)); // Small delay between samples
     }
     
-    // Average the readings
-    int avg_raw = raw_sum / OVERSAMPLE_COUNT;
+    // Average the readings, rounded
+    uint32_t avg_raw = raw_count ? (raw_sum + raw_count / 2) / raw_count : 0;
     
-    uint32_t voltage_mv;
-    if (calibration_available) {
-        voltage_mv = voltage_sum / OVERSAMPLE_COUNT;
-    } else {
-        // Fallback: approximate conversion for 12-bit ADC with 12dB attenuation
-        // Max voltage ~3300mV at 4095 counts (rough approximation)
-        voltage_mv = (avg_raw * 3300) / 4095;
+    ESP_LOGD(TAG, "ADC Ch%d: raw=%u", channel, (unsigned int)avg_raw);
+    
+    return avg_raw;
+}
+#endif
+
+/**
+ * @brief Read temperature sensor (if analog)
+ * TMP36 conversion is shared with channel_logic (sensor_math.h)
+ * For NTC thermistor, use Steinhart-Hart equation
+ */
+static sensor_temp_t calculate_temperature(uint32_t adc_mv)
+{
+    bool in_range;
+    sensor_temp_t temp = sensor_temperature(adc_mv, &in_range);
+    
+    if (!in_range) {
+        RTLOG(RTLOG_ADC_TEMP_RANGE, adc_mv);
     }
     
-    ESP_LOGD(TAG, "ADC Ch%d: raw=%d, mV=%u", channel, avg_raw, (unsigned int)voltage_mv);
+    return temp;
+}
+
+#if CONFIG_SOLAR_CURRENT_SENSE
+/**
+ * @brief Convert the current sensor's pin voltage to mA (positive = charging)
+ */
+static int32_t calculate_current(uint32_t adc_mv)
+{
+    return ((int32_t)adc_mv - CONFIG_SOLAR_CURRENT_ZERO_MV) * 1000 / CONFIG_SOLAR_CURRENT_MV_PER_A;
+}
+#endif
+
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+/**
+ * @brief DMA conversion-frame-done callback (ISR context)
+ * Wakes adc_task once per completed frame
+ */
+static bool IRAM_ATTR adc_conv_done_cb(adc_continuous_handle_t handle,
+                                       const adc_continuous_evt_data_t *edata,
+                                       void *user_data)
+{
+    BaseType_t must_yield = pdFALSE;
+    
+    frame_done_us = esp_timer_get_time();
     
-    return voltage_mv;
+    if (adc_task_handle != NULL) {
+        vTaskNotifyGiveFromISR(adc_task_handle, &must_yield);
+    }
+    
+    return must_yield == pdTRUE;
 }
 
 /**
- * @brief Convert ADC voltage back to actual battery voltage
+ * @brief DMA pool overflow callback (ISR context)
+ * adc_task fell a whole pool behind; the driver discards the oldest frame
  */
-static uint32_t calculate_battery_voltage(uint32_t adc_mv)
+static bool IRAM_ATTR adc_pool_ovf_cb(adc_continuous_handle_t handle,
+                                      const adc_continuous_evt_data_t *edata,
+                                      void *user_data)
 {
-    // Apply voltage divider ratio
-    float battery_v = ((float)adc_mv / 1000.0f) * DIVIDER_RATIO;
-    uint32_t battery_mv = (uint32_t)(battery_v * 1000.0f);
+    perf_drop(PERF_DROP_ADC_FRAME, 1);
+    return false;
+}
+
+/**
+ * @brief Initialize the decimators of the scanned inputs
+ */
+static void adc_cic_reset(void)
+{
+    cic_init(&battery_cic, ADC_CIC_ORDER, ADC_CIC_RATIO);
+    cic_init(&temp_cic, ADC_CIC_ORDER, ADC_CIC_RATIO);
+#if CONFIG_SOLAR_CURRENT_SENSE
+    cic_init(&current_cic, ADC_CIC_ORDER, ADC_CIC_RATIO);
+#endif
+}
+
+/**
+ * @brief Initialize continuous (DMA) ADC scanning of all inputs
+ */
+static esp_err_t adc_continuous_setup(void)
+{
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = ADC_CONV_POOL_SIZE,
+        .conv_frame_size = ADC_CONV_FRAME_SIZE,
+    };
     
-    return battery_mv;
+    esp_err_t ret = adc_continuous_new_handle(&handle_config, &adc1_cont_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create continuous ADC handle: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    // Scan pattern: battery, temperature[, current], battery, temperature, ...
+    adc_digi_pattern_config_t pattern[ADC_INPUT_COUNT] = {
+        {
+            .atten = ADC_ATTEN,
+            .channel = ADC_BATTERY_CHANNEL,
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        },
+        {
+            .atten = ADC_ATTEN,
+            .channel = ADC_TEMP_CHANNEL,
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        },
+#if CONFIG_SOLAR_CURRENT_SENSE
+        {
+            .atten = ADC_ATTEN,
+            .channel = ADC_CURRENT_CHANNEL,
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        },
+#endif
+    };
+    
+    adc_continuous_config_t dig_cfg = {
+        .pattern_num = ADC_INPUT_COUNT,
+        .adc_pattern = pattern,
+        .sample_freq_hz = ADC_CONV_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_OUTPUT_TYPE,
+    };
+    
+    ret = adc_continuous_config(adc1_cont_handle, &dig_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure continuous ADC: %s", esp_err_to_name(ret));
+        adc_continuous_deinit(adc1_cont_handle);
+        adc1_cont_handle = NULL;
+        return ret;
+    }
+    
+    adc_cic_reset();
+    
+    return ESP_OK;
 }
 
 /**
- * @brief Read temperature sensor (if analog)
- * For TMP36: Vout = (Temp°C * 10mV) + 500mV
- * For NTC thermistor, use Steinhart-Hart equation
+ * @brief Decimate one DMA frame into averaged raw counts
+ * Returns false if the frame held no valid conversions for any input
+ * Uses the CIC output once it has settled and the frame was complete,
+ * the plain frame average otherwise (identical for order 1)
  */
-static float calculate_temperature(uint32_t adc_mv)
+static bool adc_decimate_frame(const uint8_t *frame, uint32_t length,
+                               uint32_t raw[ADC_CAL_INPUT_COUNT])
 {
-    // Example for TMP36 sensor
-    // TMP36: 10mV per degree, 500mV at 0°C
-    float temp_c = ((float)adc_mv - 500.0f) / 10.0f;
+    uint32_t battery_sum = 0, battery_count = 0;
+    uint32_t temp_sum = 0, temp_count = 0;
+#if CONFIG_SOLAR_CURRENT_SENSE
+    uint32_t current_sum = 0, current_count = 0;
+#endif
+    
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&frame[i];
+        uint32_t channel = ADC_GET_CHANNEL(p);
+        uint32_t data = ADC_GET_DATA(p);
+        
+        if (channel == ADC_BATTERY_CHANNEL) {
+            battery_sum += data;
+            battery_count++;
+            cic_push(&battery_cic, data);
+        } else if (channel == ADC_TEMP_CHANNEL) {
+            temp_sum += data;
+            temp_count++;
+            cic_push(&temp_cic, data);
+        }
+#if CONFIG_SOLAR_CURRENT_SENSE
+        if (channel == ADC_CURRENT_CHANNEL) {
+            current_sum += data;
+            current_count++;
+            cic_push(&current_cic, data);
+        }
+#endif
+    }
+    
+    uint32_t battery_raw, temp_raw;
+    bool battery_cic_ok = cic_decimate(&battery_cic, &battery_raw);
+    bool temp_cic_ok = cic_decimate(&temp_cic, &temp_raw);
     
-    // Sanity check
-    if (temp_c < -40.0f || temp_c > 125.0f) {
-        ESP_LOGW(TAG, "Temperature out of range: %.1f°C, using 25°C", temp_c);
-        temp_c = 25.0f;
+    if (battery_count == 0 || temp_count == 0) {
+        return false;
+    }
+    if (!battery_cic_ok) {
+        battery_raw = battery_sum / battery_count;
+    }
+    if (!temp_cic_ok) {
+        temp_raw = temp_sum / temp_count;
     }
     
-    return temp_c;
+    // Calibrated once per decimated value by the caller
+    raw[ADC_CAL_BATTERY] = battery_raw;
+    raw[ADC_CAL_TEMP] = temp_raw;
+    raw[ADC_CAL_CURRENT] = 0;
+    
+#if CONFIG_SOLAR_CURRENT_SENSE
+    uint32_t current_raw;
+    bool current_cic_ok = cic_decimate(&current_cic, &current_raw);
+    if (current_count == 0) {
+        return false;
+    }
+    if (!current_cic_ok) {
+        current_raw = current_sum / current_count;
+    }
+    raw[ADC_CAL_CURRENT] = current_raw;
+#endif
+    
+    ESP_LOGD(TAG, "Frame: %u bytes, battery n=%u, temp n=%u",
+             (unsigned int)length, (unsigned int)battery_count, (unsigned int)temp_count);
+    
+    return true;
 }
+#endif
 
 /**
  * @brief Initialize ADC subsystem
@@ -168,12 +452,17 @@ void adc_init(void)
 {
     ESP_LOGI(TAG, "Initializing ADC");
     
-    // Create queues
-    adc_queue_ch0 = xQueueCreate(QUEUE_SIZE, sizeof(adc_reading_t));
-    adc_queue_ch1 = xQueueCreate(QUEUE_SIZE, sizeof(adc_reading_t));
-    
-    if (adc_queue_ch0 == NULL || adc_queue_ch1 == NULL) {
-        ESP_LOGE(TAG, "Failed to create ADC queues");
+    // Broadcast ring for distributing readings to consumers
+    sample_ring_init();
+
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+    if (adc_continuous_setup() != ESP_OK) {
+        return;
+    }
+#else
+    adc1_lock = RTOS_MUTEX_CREATE(adc1_lock);
+    if (adc1_lock == NULL) {
+        ESP_LOGE(TAG, "Failed to create ADC lock");
         return;
     }
     
@@ -208,96 +497,506 @@ void adc_init(void)
         return;
     }
     
+#if CONFIG_SOLAR_CURRENT_SENSE
+    // Configure current sensor channel
+    ret = adc_oneshot_config_channel(adc1_handle, ADC_CURRENT_CHANNEL, &config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to config current channel: %s", esp_err_to_name(ret));
+        return;
+    }
+#endif
+#endif
+    
+#if CONFIG_SOLAR_CURRENT_SENSE
+    const soc_params_t soc_params = {
+        .capacity_mah = CONFIG_SOLAR_BATTERY_CAPACITY_AH * 1000U,
+        .charge_efficiency_pct = CONFIG_SOLAR_CHARGE_EFFICIENCY,
+        .rest_ma = CONFIG_SOLAR_BATTERY_CAPACITY_AH * 10U,     // C/100
+        .rest_ms = CONFIG_SOLAR_SOC_REST_MIN * 60000U,
+    };
+    soc_init(&soc, &soc_params);
+#endif
+    
     // Initialize calibration
     calibration_available = adc_calibration_init(ADC_UNIT_1, ADC_ATTEN, &adc1_cali_handle);
     
     ESP_LOGI(TAG, "ADC initialized successfully");
     ESP_LOGI(TAG, "Battery channel: ADC1_CH%d (GPIO34)", ADC_BATTERY_CHANNEL);
     ESP_LOGI(TAG, "Temperature channel: ADC1_CH%d (GPIO35)", ADC_TEMP_CHANNEL);
-    ESP_LOGI(TAG, "Voltage divider ratio: %.2f", DIVIDER_RATIO);
+#if CONFIG_SOLAR_CURRENT_SENSE
+    ESP_LOGI(TAG, "Current channel: ADC1_CH%d (GPIO36), %d mV/A, %d Ah battery",
+             ADC_CURRENT_CHANNEL, CONFIG_SOLAR_CURRENT_MV_PER_A, CONFIG_SOLAR_BATTERY_CAPACITY_AH);
+#endif
+    ESP_LOGI(TAG, "Voltage divider ratio: %.2f (%s math)", SENSOR_DIVIDER_RATIO,
+             SOLAR_FIXED_POINT ? "Q16 fixed-point" : "float");
+    
+    adc_cal_profile_t profile;
+    nvs_get_adc_cal(&profile);
+    for (int i = 0; i < ADC_CAL_INPUT_COUNT; i++) {
+        if (adc_cal_active(&profile, (adc_cal_input_t)i)) {
+            ESP_LOGI(TAG, "Unit calibration: %s from %u point(s)",
+                     adc_cal_input_name((adc_cal_input_t)i), profile.points[i]);
+        }
+    }
+    if (profile.divider_q16 != 0) {
+        ESP_LOGI(TAG, "Measured divider ratio: %.3f", (double)profile.divider_q16 / 65536.0);
+    }
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+    ESP_LOGI(TAG, "Continuous mode: %d Hz, frame=%d bytes (%d conversions), CIC order %d",
+             ADC_CONV_FREQ_HZ, ADC_CONV_FRAME_SIZE, ADC_CONV_PER_FRAME, ADC_CIC_ORDER);
+#endif
 }
 
+/**
+ * @brief Copy the latest snapshot without locking
+ * @return Sequence value of the copied snapshot
+ */
+static unsigned int adc_snapshot_read(adc_snapshot_t *out)
+{
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&latest_lock);
+        *out = latest_snapshot;
+    } while (seqlock_read_retry(&latest_lock, seq));
+    
+    return seq;
+}
+
+/**
+ * @brief Check a snapshot against a maximum age
+ */
+static bool adc_snapshot_fresh(const adc_snapshot_t *snap, uint32_t max_age_ms)
+{
+    if (!snap->valid) {
+        return false;
+    }
+    
+    // A stretched interval makes every reading older by the extra wait
+    uint32_t slack = sample_interval_ms - ADC_SAMPLE_INTERVAL_MS;
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    return (now - snap->reading.timestamp_ms) <= max_age_ms + slack;
+}
+
+/**
+ * @brief Pick up a changed calibration profile
+ */
+static void adc_refresh_calibration(void)
+{
+    if (cal_loaded && nvs_config_generation() == cal_generation) {
+        return;
+    }
+    
+    app_config_t config;
+    cal_generation = nvs_config_snapshot(&config);
+    cal_profile = config.adc_cal;
+    cal_loaded = true;
+}
+
+/**
+ * @brief Publish one reading to the snapshot and the channel processors
+ */
+static void adc_publish_reading(const uint32_t raw[ADC_CAL_INPUT_COUNT], int64_t sample_us,
+                                uint32_t sample_count)
+{
+    adc_refresh_calibration();
+    
+    uint32_t battery_voltage_mv = adc_input_mv(&cal_profile, ADC_CAL_BATTERY, raw[ADC_CAL_BATTERY]);
+    uint32_t adc_temp_mv = adc_input_mv(&cal_profile, ADC_CAL_TEMP, raw[ADC_CAL_TEMP]);
+    sensor_temp_t temperature = calculate_temperature(adc_temp_mv);
+    
+    // Get current timestamp
+    uint32_t timestamp_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    
+    // Create reading structure
+    adc_reading_t reading;
+    reading.battery_voltage_mv = battery_voltage_mv;
+    reading.temperature_raw = adc_temp_mv;
+    reading.timestamp_ms = timestamp_ms;
+    reading.interval_ms = sample_interval_ms;
+    reading.sample_us = sample_us;
+    
+#if CONFIG_SOLAR_CURRENT_SENSE
+    // Integrate the current over the interval up to this reading
+    reading.current_ma = calculate_current(adc_input_mv(&cal_profile, ADC_CAL_CURRENT,
+                                                        raw[ADC_CAL_CURRENT]));
+    soc_update(&soc, reading.current_ma, battery_voltage_mv, timestamp_ms);
+    reading.soc_permille = soc_permille(&soc);
+    charge_cycles = soc.cycles;
+#else
+    reading.current_ma = 0;
+    reading.soc_permille = ADC_SOC_UNKNOWN;
+#endif
+    
+    // Publish to the shared snapshot for non-blocking readers
+    seqlock_write_begin(&latest_lock);
+    latest_snapshot.reading = reading;
+    latest_snapshot.temperature = temperature;
+    memcpy(latest_snapshot.raw, raw, sizeof(latest_snapshot.raw));
+    latest_snapshot.valid = true;
+    seqlock_write_end(&latest_lock);
+    
+    // Log periodically (every 10 samples = ~1 second)
+    if (sample_count % 10 == 0) {
+        RTLOG(RTLOG_ADC_READING,
+              battery_voltage_mv,
+              battery_voltage_mv,
+              raw[ADC_CAL_BATTERY],
+              sensor_temp_dc(temperature));
+    }
+    
+    // Broadcast once to every consumer; slow consumers count their own overruns
+    sample_ring_publish(&reading);
+    perf_record(PERF_STAGE_SAMPLE, sample_us);
+}
+
+/**
+ * @brief Pick up the interval the channel processor asks for
+ * @return Interval until the next reading
+ */
+static uint32_t adc_update_interval(task_stats_t *stats)
+{
+    uint32_t interval = channel_sample_interval_ms();
+    
+    if (interval != sample_interval_ms) {
+        sample_interval_ms = interval;
+        task_stats_set_period(stats, interval);
+        ESP_LOGD(TAG, "Sample interval %u ms", (unsigned int)interval);
+    }
+    
+    return interval;
+}
+
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+/**
+ * @brief Stop scanning until the next reading is due
+ * A running DMA engine holds an APB frequency lock, which also rules out
+ * light sleep, so a stretched interval scans only the one frame it needs.
+ * A forced read (adc_wait_next_snapshot()) ends the wait early.
+ */
+static void adc_continuous_idle(uint32_t interval)
+{
+    if (interval <= ADC_SAMPLE_INTERVAL_MS) {
+        return;
+    }
+    
+    adc_continuous_stop(adc1_cont_handle);
+    adc_continuous_flush_pool(adc1_cont_handle);
+    adc_idle = true;
+    // Drop a frame notification that raced with the stop
+    ulTaskNotifyTake(pdTRUE, 0);
+    
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(interval - ADC_SAMPLE_INTERVAL_MS));
+    
+    // The next frame does not continue the previous one
+    adc_cic_reset();
+    adc_idle = false;
+    ESP_ERROR_CHECK(adc_continuous_start(adc1_cont_handle));
+}
+#endif
+
 /**
  * @brief ADC sampling task
- * Reads ADC channels periodically and pushes to queues
+ * Reads ADC channels periodically and publishes to the sample ring
  */
 void adc_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "ADC task started");
     
-    TickType_t last_wake_time = xTaskGetTickCount();
     uint32_t sample_count = 0;
+
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+    if (adc1_cont_handle == NULL) {
+        ESP_LOGE(TAG, "Continuous ADC not initialized");
+        vTaskDelete(NULL);
+        return;
+    }
+    
+    adc_task_handle = xTaskGetCurrentTaskHandle();
+    
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = adc_conv_done_cb,
+        .on_pool_ovf = adc_pool_ovf_cb,
+    };
+    ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(adc1_cont_handle, &cbs, NULL));
+    ESP_ERROR_CHECK(adc_continuous_start(adc1_cont_handle));
+    
+    task_stats_t *stats = task_stats_register(pcTaskGetName(NULL), ADC_SAMPLE_INTERVAL_MS);
     
     while (1) {
-        // Read battery voltage
-        uint32_t adc_battery_mv = adc_read_voltage(ADC_BATTERY_CHANNEL);
-        uint32_t battery_voltage_mv = calculate_battery_voltage(adc_battery_mv);
-        
-        // Read temperature
-        uint32_t adc_temp_mv = adc_read_voltage(ADC_TEMP_CHANNEL);
-        float temperature_c = calculate_temperature(adc_temp_mv);
+        // Sleep until the DMA engine completes a frame
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        task_stats_begin(stats);
         
-        // Get current timestamp
-        uint32_t timestamp_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
-        
-        // Create reading structure
-        adc_reading_t reading;
-        reading.battery_voltage_mv = battery_voltage_mv;
-        reading.temperature_raw = adc_temp_mv;
-        reading.timestamp_ms = timestamp_ms;
-        
-        // Log periodically (every 10 samples = ~1 second)
-        if (sample_count % 10 == 0) {
-            ESP_LOGI(TAG, "Battery: %u mV (%.2fV), ADC: %u mV, Temp: %.1f°C", 
-                     (unsigned int)battery_voltage_mv, 
-                     battery_voltage_mv / 1000.0f,
-                     (unsigned int)adc_battery_mv,
-                     temperature_c);
+        // Drain every frame that is ready (normally exactly one)
+        uint32_t ret_num = 0;
+        while (adc_continuous_read(adc1_cont_handle, adc_frame_buf, ADC_CONV_FRAME_SIZE,
+                                   &ret_num, 0) == ESP_OK) {
+            uint32_t raw[ADC_CAL_INPUT_COUNT];
+            if (!adc_decimate_frame(adc_frame_buf, ret_num, raw)) {
+                RTLOG(RTLOG_ADC_EMPTY_FRAME, ret_num);
+                perf_drop(PERF_DROP_ADC_FRAME, 1);
+                continue;
+            }
+            
+            adc_publish_reading(raw, frame_done_us, sample_count);
+            sample_count++;
         }
         
-        // Push to both channel queues (they'll do their own processing)
-        if (xQueueSend(adc_queue_ch0, &reading, 0) != pdTRUE) {
-            ESP_LOGW(TAG, "CH0 queue full, dropping sample");
-        }
+        task_stats_end(stats);
         
-        if (xQueueSend(adc_queue_ch1, &reading, 0) != pdTRUE) {
-            ESP_LOGW(TAG, "CH1 queue full, dropping sample");
-        }
+        adc_continuous_idle(adc_update_interval(stats));
+    }
+#else
+    task_stats_t *stats = task_stats_register(pcTaskGetName(NULL), ADC_SAMPLE_INTERVAL_MS);
+    TickType_t last_wake_time = xTaskGetTickCount();
+    
+    while (1) {
+        task_stats_begin(stats);
         
+        // Read battery voltage and temperature
+        uint32_t raw[ADC_CAL_INPUT_COUNT] = {0};
+        xSemaphoreTake(adc1_lock, portMAX_DELAY);
+        raw[ADC_CAL_BATTERY] = adc_read_raw(ADC_BATTERY_CHANNEL);
+        raw[ADC_CAL_TEMP] = adc_read_raw(ADC_TEMP_CHANNEL);
+#if CONFIG_SOLAR_CURRENT_SENSE
+        raw[ADC_CAL_CURRENT] = adc_read_raw(ADC_CURRENT_CHANNEL);
+#endif
+        int64_t sample_us = esp_timer_get_time();
+        xSemaphoreGive(adc1_lock);
+        
+        adc_publish_reading(raw, sample_us, sample_count);
         sample_count++;
         
+        task_stats_end(stats);
+        
         // Wait for next sample interval
-        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(ADC_SAMPLE_INTERVAL_MS));
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(adc_update_interval(stats)));
+    }
+#endif
+}
+
+/**
+ * @brief Get the latest published reading (non-blocking)
+ */
+bool adc_get_latest_reading(adc_reading_t *reading, uint32_t max_age_ms)
+{
+    adc_snapshot_t snap;
+    adc_snapshot_read(&snap);
+    
+    if (reading != NULL) {
+        *reading = snap.reading;
+    }
+    
+    return adc_snapshot_fresh(&snap, max_age_ms);
+}
+
+/**
+ * @brief Get the latest published temperature (non-blocking)
+ */
+bool adc_get_latest_temperature(float *temp_c, uint32_t max_age_ms)
+{
+    adc_snapshot_t snap;
+    adc_snapshot_read(&snap);
+    
+    if (temp_c != NULL) {
+        *temp_c = snap.valid ? sensor_temp_to_c(snap.temperature) : 25.0f;
+    }
+    
+    return adc_snapshot_fresh(&snap, max_age_ms);
+}
+
+/**
+ * @brief Current sampling interval of adc_task
+ */
+uint32_t adc_get_sample_interval_ms(void)
+{
+    return sample_interval_ms;
+}
+
+/**
+ * @brief Equivalent full charge cycles counted since boot
+ */
+uint32_t adc_get_charge_cycles(void)
+{
+    return charge_cycles;
+}
+
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+/**
+ * @brief Wait for adc_task to publish a snapshot newer than the current one
+ */
+static bool adc_wait_next_snapshot(adc_snapshot_t *out)
+{
+    unsigned int start = seqlock_sequence(&latest_lock);
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(3 * ADC_SAMPLE_INTERVAL_MS);
+    
+    // Scanning is stopped at a stretched interval: take the next frame now
+    if (adc_idle && adc_task_handle != NULL) {
+        xTaskNotifyGive(adc_task_handle);
     }
+    
+    while (seqlock_sequence(&latest_lock) == start) {
+        if ((int32_t)(xTaskGetTickCount() - deadline) >= 0) {
+            ESP_LOGW(TAG, "Timed out waiting for a fresh ADC frame");
+            adc_snapshot_read(out);
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    
+    adc_snapshot_read(out);
+    return true;
 }
+#endif
 
 /**
  * @brief Get current battery voltage (blocking read)
- * Useful for immediate status queries
+ * Forces a fresh conversion; use adc_get_latest_reading() for routine queries
  */
 uint32_t adc_get_battery_voltage_now(void)
 {
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+    // ADC1 is owned by the DMA engine; wait for the next decimated frame
+    if (adc1_cont_handle == NULL) {
+        ESP_LOGE(TAG, "ADC not initialized");
+        return 0;
+    }
+    
+    adc_snapshot_t snap;
+    adc_wait_next_snapshot(&snap);
+    return snap.reading.battery_voltage_mv;
+#else
     if (adc1_handle == NULL) {
         ESP_LOGE(TAG, "ADC not initialized");
         return 0;
     }
     
-    uint32_t adc_mv = adc_read_voltage(ADC_BATTERY_CHANNEL);
-    return calculate_battery_voltage(adc_mv);
+    adc_cal_profile_t profile;
+    nvs_get_adc_cal(&profile);
+    
+    xSemaphoreTake(adc1_lock, portMAX_DELAY);
+    uint32_t raw = adc_read_raw(ADC_BATTERY_CHANNEL);
+    xSemaphoreGive(adc1_lock);
+    return adc_input_mv(&profile, ADC_CAL_BATTERY, raw);
+#endif
 }
 
 /**
  * @brief Get current temperature (blocking read)
+ * Forces a fresh conversion; use adc_get_latest_temperature() for routine queries
  */
 float adc_get_temperature_now(void)
 {
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+    if (adc1_cont_handle == NULL) {
+        ESP_LOGE(TAG, "ADC not initialized");
+        return 25.0f;
+    }
+    
+    adc_snapshot_t snap;
+    adc_wait_next_snapshot(&snap);
+    return snap.valid ? sensor_temp_to_c(snap.temperature) : 25.0f;
+#else
     if (adc1_handle == NULL) {
         ESP_LOGE(TAG, "ADC not initialized");
         return 25.0f;
     }
     
-    uint32_t adc_mv = adc_read_voltage(ADC_TEMP_CHANNEL);
-    return calculate_temperature(adc_mv);
+    adc_cal_profile_t profile;
+    nvs_get_adc_cal(&profile);
+    
+    xSemaphoreTake(adc1_lock, portMAX_DELAY);
+    uint32_t raw = adc_read_raw(ADC_TEMP_CHANNEL);
+    xSemaphoreGive(adc1_lock);
+    return sensor_temp_to_c(calculate_temperature(adc_input_mv(&profile, ADC_CAL_TEMP, raw)));
+#endif
+}
+
+/**
+ * @brief Uncalibrated value of an input (eFuse conversion, nominal divider)
+ */
+static uint32_t adc_nominal_mv(adc_cal_input_t input, uint32_t raw)
+{
+    static const adc_cal_profile_t uncalibrated = {0};
+    return adc_input_mv(&uncalibrated, input, raw);
+}
+
+/**
+ * @brief Average an input's raw count over ADC_CAL_CAPTURE_READINGS readings
+ */
+static bool adc_capture_raw(adc_cal_input_t input, uint32_t *raw)
+{
+    uint32_t sum = 0;
+    
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+    if (adc1_cont_handle == NULL) {
+        ESP_LOGE(TAG, "ADC not initialized");
+        return false;
+    }
+    
+    for (int i = 0; i < ADC_CAL_CAPTURE_READINGS; i++) {
+        adc_snapshot_t snap;
+        if (!adc_wait_next_snapshot(&snap)) {
+            return false;
+        }
+        sum += snap.raw[input];
+    }
+#else
+    if (adc1_handle == NULL) {
+        ESP_LOGE(TAG, "ADC not initialized");
+        return false;
+    }
+    
+    static const adc_channel_t channels[ADC_CAL_INPUT_COUNT] = {
+        [ADC_CAL_BATTERY] = ADC_BATTERY_CHANNEL,
+        [ADC_CAL_TEMP] = ADC_TEMP_CHANNEL,
+        [ADC_CAL_CURRENT] = ADC_CURRENT_CHANNEL,
+    };
+    for (int i = 0; i < ADC_CAL_CAPTURE_READINGS; i++) {
+        xSemaphoreTake(adc1_lock, portMAX_DELAY);
+        sum += adc_read_raw(channels[input]);
+        xSemaphoreGive(adc1_lock);
+    }
+#endif
+    
+    *raw = (sum + ADC_CAL_CAPTURE_READINGS / 2) / ADC_CAL_CAPTURE_READINGS;
+    return true;
+}
+
+/**
+ * @brief Measure one input for a calibration point (blocking)
+ */
+bool adc_calibration_capture(adc_cal_input_t input, adc_cal_sample_t *sample)
+{
+#if CONFIG_SOLAR_CURRENT_SENSE
+    bool present = input >= 0 && input < ADC_CAL_INPUT_COUNT;
+#else
+    bool present = input >= 0 && input < ADC_CAL_CURRENT;
+#endif
+    if (!present) {
+        ESP_LOGE(TAG, "Input %d is not sampled", (int)input);
+        return false;
+    }
+    
+    uint32_t raw;
+    if (!adc_capture_raw(input, &raw)) {
+        return false;
+    }
+    
+    // Slope of the uncalibrated conversion around the point
+    uint32_t lo = raw > ADC_CAL_SLOPE_SPAN ? raw - ADC_CAL_SLOPE_SPAN : 0;
+    uint32_t hi = raw + ADC_CAL_SLOPE_SPAN < ADC_CAL_RAW_MAX ? raw + ADC_CAL_SLOPE_SPAN : ADC_CAL_RAW_MAX;
+    int64_t rise = ((int64_t)adc_nominal_mv(input, hi) - adc_nominal_mv(input, lo)) * 65536;
+    
+    adc_cal_profile_t profile;
+    nvs_get_adc_cal(&profile);
+    
+    sample->raw = raw;
+    sample->pin_mv = adc_raw_to_mv((int)raw);
+    sample->nominal_mv = adc_nominal_mv(input, raw);
+    sample->nominal_gain_q16 = (int32_t)((rise + (hi - lo) / 2) / (hi - lo));
+    sample->calibrated_mv = adc_input_mv(&profile, input, raw);
+    return true;
 }
 
 /**
@@ -313,19 +1012,25 @@ void adc_deinit(void)
 #endif
         ESP_LOGI(TAG, "ADC calibration deleted");
     }
-    
+
+#if CONFIG_SOLAR_ADC_CONTINUOUS
+    if (adc1_cont_handle) {
+        adc_continuous_stop(adc1_cont_handle);
+        adc_continuous_deinit(adc1_cont_handle);
+        adc1_cont_handle = NULL;
+        ESP_LOGI(TAG, "Continuous ADC deleted");
+    }
+#else
     if (adc1_handle) {
         adc_oneshot_del_unit(adc1_handle);
         ESP_LOGI(TAG, "ADC unit deleted");
     }
     
-    if (adc_queue_ch0) {
-        vQueueDelete(adc_queue_ch0);
-    }
-    
-    if (adc_queue_ch1) {
-        vQueueDelete(adc_queue_ch1);
+    if (adc1_lock) {
+        vSemaphoreDelete(adc1_lock);
+        adc1_lock = NULL;
     }
+#endif
     
     ESP_LOGI(TAG, "ADC deinitialized");
-}
\ No newline at end of file
+}
@@ -4,35 +4,95 @@
  * 
  * Provides ADC sampling for battery voltage and temperature monitoring
  * with hardware calibration, oversampling, and voltage divider compensation.
+ * A per-unit calibration profile (adc_cal.h) replaces the eFuse conversion
+ * and the nominal divider for the inputs it covers.
  */
 #ifndef ADC_HANDLER_H
 #define ADC_HANDLER_H
 
+#include <stdbool.h>
+#include "adc_cal.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 
+/**
+ * @brief Default maximum age for cached readings (ms)
+ * 
+ * A few sample intervals: anything older means adc_task has stalled.
+ */
+#define ADC_READING_MAX_AGE_MS  500
+
+/**
+ * @brief Sampling interval: one published reading every 100 ms
+ *
+ * With CONFIG_SOLAR_ADAPTIVE_SAMPLING adc_task stretches the interval while
+ * the channel inputs are settled (see channel_sample_interval_ms()).
+ */
+#define ADC_SAMPLE_INTERVAL_MS  100
+
+/**
+ * @brief soc_permille of a reading without a state-of-charge estimate
+ */
+#define ADC_SOC_UNKNOWN         0xFFFF
+
+/**
+ * @brief Measured ADC inputs a channel can be evaluated on
+ */
+typedef enum {
+    ADC_SOURCE_BATTERY = 0,     // Battery voltage through divider (mV)
+    ADC_SOURCE_COUNT
+} adc_source_t;
+
 /**
  * @struct adc_reading_t
  * @brief ADC reading data structure
  * 
  * Contains battery voltage, temperature, and timestamp information
- * for a single ADC sampling event.
+ * for a single ADC sampling event. sample_us is the esp_timer time of the
+ * conversion and is carried down the pipeline for latency measurement.
+ * interval_ms is the sampling interval that led up to this reading.
+ * With CONFIG_SOLAR_CURRENT_SENSE the reading also carries the battery
+ * current and the state of charge integrated up to it; otherwise
+ * current_ma is 0 and soc_permille ADC_SOC_UNKNOWN.
  */
 typedef struct {
     uint32_t battery_voltage_mv;
     uint32_t temperature_raw;
     uint32_t timestamp_ms;
+    uint32_t interval_ms;
+    int32_t current_ma;         // Battery current, positive while charging
+    uint16_t soc_permille;      // State of charge in 0.1 %
+    int64_t sample_us;
 } adc_reading_t;
 
+/**
+ * @brief Get the value of one measured input from a reading
+ * @param reading ADC reading
+ * @param source Input selector
+ * @return Input value in millivolts (mV)
+ */
+static inline uint32_t adc_reading_source_mv(const adc_reading_t *reading, adc_source_t source)
+{
+    switch (source) {
+    case ADC_SOURCE_BATTERY:
+    default:
+        return reading->battery_voltage_mv;
+    }
+}
+
 /**
  * @brief Initialize ADC subsystem
  * 
  * Configures ADC1 with two channels:
  * - Channel 6 (GPIO34): Battery voltage through voltage divider
  * - Channel 7 (GPIO35): Temperature sensor (TMP36)
+ * - Channel 0 (GPIO36): Battery current sensor (CONFIG_SOLAR_CURRENT_SENSE)
+ * 
+ * Initializes hardware calibration if available and the sample ring
+ * that broadcasts readings to channel processors.
  * 
- * Initializes hardware calibration if available and creates queues
- * for distributing readings to channel processors.
+ * With CONFIG_SOLAR_ADC_CONTINUOUS all inputs are scanned by the
+ * adc_continuous driver into a DMA ring; otherwise the oneshot driver is used.
  */
 void adc_init(void);
 
@@ -41,23 +101,62 @@ void adc_init(void);
  * @param pvParameters Task parameters (unused)
  * 
  * Periodically samples battery voltage and temperature at 100ms intervals.
- * Applies oversampling for noise reduction and pushes readings to
- * per-channel queues for processing.
+ * Applies oversampling for noise reduction and publishes each reading
+ * once to the sample ring, where every consumer reads it. With current
+ * sensing, each reading also advances the state-of-charge integrator.
+ * 
+ * In continuous mode the task sleeps until the DMA engine signals a
+ * completed conversion frame (one sample interval) and decimates the
+ * whole frame into a single reading.
  * 
  * @note This task runs continuously and should be created with appropriate priority
  */
 void adc_task(void *pvParameters);
 
-// Queues for each channel
-extern QueueHandle_t adc_queue_ch0;
-extern QueueHandle_t adc_queue_ch1;
+/**
+ * @brief Get the latest reading published by adc_task (non-blocking)
+ * @param reading Filled with the most recent reading (may be NULL)
+ * @param max_age_ms Maximum acceptable age in milliseconds
+ * @return true if a reading exists and is no older than max_age_ms
+ * 
+ * Copies the shared snapshot without touching ADC hardware or taking
+ * a lock. The output is filled even when the reading is stale, so callers
+ * can still fall back to the last known value. While sampling at a
+ * stretched interval, max_age_ms is extended by the extra interval.
+ */
+bool adc_get_latest_reading(adc_reading_t *reading, uint32_t max_age_ms);
+
+/**
+ * @brief Get the latest temperature published by adc_task (non-blocking)
+ * @param temp_c Filled with the temperature in °C, 25.0 if none yet (may be NULL)
+ * @param max_age_ms Maximum acceptable age in milliseconds
+ * @return true if a reading exists and is no older than max_age_ms
+ */
+bool adc_get_latest_temperature(float *temp_c, uint32_t max_age_ms);
+
+/**
+ * @brief Current sampling interval of adc_task
+ * @return ADC_SAMPLE_INTERVAL_MS, or the slow cadence while inputs are settled
+ */
+uint32_t adc_get_sample_interval_ms(void);
+
+/**
+ * @brief Equivalent full charge cycles counted since boot
+ * @return Discharged charge in units of the battery capacity (0 without
+ *         CONFIG_SOLAR_CURRENT_SENSE)
+ */
+uint32_t adc_get_charge_cycles(void);
 
 /**
  * @brief Get current battery voltage (blocking read)
  * @return Battery voltage in millivolts (mV)
  * 
- * Performs immediate ADC read with oversampling and voltage divider
- * compensation. Useful for status queries and CLI commands.
+ * Forces a fresh ADC read with oversampling and voltage divider
+ * compensation. Reserve for explicit "force fresh read" cases; routine
+ * consumers should use adc_get_latest_reading().
+ * 
+ * @note In continuous mode ADC1 belongs to the DMA engine, so this blocks
+ *       until the next decimated frame is published (up to 3 intervals).
  */
 uint32_t adc_get_battery_voltage_now(void);
 
@@ -65,15 +164,43 @@ uint32_t adc_get_battery_voltage_now(void);
  * @brief Get current temperature (blocking read)
  * @return Temperature in degrees Celsius
  * 
- * Performs immediate ADC read and converts to temperature using
- * TMP36 sensor formula. Returns 25.0°C on error.
+ * Forces a fresh ADC read and converts to temperature using
+ * TMP36 sensor formula. Returns 25.0°C on error. Routine consumers
+ * should use adc_get_latest_temperature().
+ * 
+ * @note In continuous mode this blocks until the next decimated frame.
  */
 float adc_get_temperature_now(void);
 
+/**
+ * @struct adc_cal_sample_t
+ * @brief One input measured for a calibration point
+ */
+typedef struct {
+    uint32_t raw;               // Raw count averaged over 16 readings
+    uint32_t pin_mv;            // Pin voltage by the eFuse conversion
+    uint32_t nominal_mv;        // Input value without a profile (battery: nominal divider)
+    int32_t nominal_gain_q16;   // Slope of that conversion at raw, mV per count in Q16
+    uint32_t calibrated_mv;     // Input value with the current profile
+} adc_cal_sample_t;
+
+/**
+ * @brief Measure one input for a calibration point (blocking)
+ * @param input Input to measure
+ * @param sample Filled with the measurement
+ * @return false if the input is not sampled on this build or the ADC failed
+ * 
+ * Averages the raw count of 16 readings (about 1.6 s in continuous mode).
+ * The caller fits the profile from it (adc_cal_fit_one() with
+ * nominal_gain_q16, or adc_cal_fit_two()) and stores it with
+ * nvs_set_adc_cal().
+ */
+bool adc_calibration_capture(adc_cal_input_t input, adc_cal_sample_t *sample);
+
 /**
  * @brief Cleanup ADC resources
  * 
- * Releases ADC calibration handles, deletes ADC unit, and destroys queues.
+ * Releases ADC calibration handles and deletes the ADC unit.
  * Should be called before system shutdown or reset.
  */
 void adc_deinit(void);
@@ -0,0 +1,69 @@
+#include "cadence_logic.h"
+
+/**
+ * @brief Initialize a cadence state
+ */
+void cadence_init(cadence_t *cadence)
+{
+    cadence->ref_mv = 0;
+    cadence->since_ms = 0;
+    cadence->slope_ref_mv = 0;
+    cadence->slope_ref_ms = 0;
+    cadence->slope_mv_s = 0;
+    cadence->started = false;
+    cadence->slow = false;
+}
+
+/**
+ * @brief Track the slope over windows of at least CADENCE_SLOPE_WINDOW_MS
+ */
+static void cadence_track_slope(cadence_t *cadence, int32_t filtered_mv, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - cadence->slope_ref_ms;
+    
+    if (elapsed < CADENCE_SLOPE_WINDOW_MS) {
+        return;
+    }
+    
+    int64_t delta = (int64_t)filtered_mv - cadence->slope_ref_mv;
+    int64_t slope = delta * 1000 / (int64_t)elapsed;
+    if (slope < 0) {
+        slope = -slope;
+    }
+    cadence->slope_mv_s = (slope > INT32_MAX) ? INT32_MAX : (int32_t)slope;
+    cadence->slope_ref_mv = filtered_mv;
+    cadence->slope_ref_ms = now_ms;
+}
+
+/**
+ * @brief Update with one filtered sample
+ */
+uint32_t cadence_update(cadence_t *cadence, const cadence_params_t *params,
+                        int32_t filtered_mv, int32_t margin_mv, uint32_t now_ms)
+{
+    if (!cadence->started) {
+        cadence->slope_ref_mv = filtered_mv;
+        cadence->slope_ref_ms = now_ms;
+    } else {
+        cadence_track_slope(cadence, filtered_mv, now_ms);
+    }
+    
+    int32_t drift = filtered_mv - cadence->ref_mv;
+    bool in_band = cadence->started && drift <= params->band_mv && drift >= -params->band_mv;
+    
+    // Margin left after one slow interval at the current slope
+    int64_t reach = (int64_t)cadence->slope_mv_s * params->slow_ms / 1000;
+    bool clear = (int64_t)margin_mv - reach >= params->margin_mv;
+    
+    if (!in_band || cadence->slope_mv_s > params->slope_mv_s || !clear) {
+        // Restart the settle time from this sample
+        cadence->ref_mv = filtered_mv;
+        cadence->since_ms = now_ms;
+        cadence->started = true;
+        cadence->slow = false;
+    } else if (!cadence->slow && now_ms - cadence->since_ms >= params->settle_ms) {
+        cadence->slow = true;
+    }
+    
+    return cadence->slow ? params->slow_ms : params->fast_ms;
+}
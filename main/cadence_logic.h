@@ -0,0 +1,70 @@
+/**
+ * @file cadence_logic.h
+ * @brief Platform-independent sampling cadence decision
+ *
+ * Decides when a channel's input is quiet and far enough from a threshold
+ * for adc_task to sample at the slow cadence. The input counts as settled
+ * after its filtered value has stayed within a band for a settle time. It
+ * must also change slower than the slope limit. At that slope, it must
+ * stay a margin away from the switching threshold for one slow interval.
+ * Leaving the band, speeding up or closing the margin returns to the fast
+ * cadence at the next sample.
+ *
+ * channel_processor steps one cadence_t per channel on every reading.
+ */
+
+#ifndef CADENCE_LOGIC_H
+#define CADENCE_LOGIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Shortest time base of the slope estimate (averages out reading noise)
+#define CADENCE_SLOPE_WINDOW_MS     5000
+
+/**
+ * @struct cadence_params_t
+ * @brief Cadence selection parameters
+ */
+typedef struct {
+    uint32_t fast_ms;           // Normal sample interval
+    uint32_t slow_ms;           // Interval once the input has settled
+    uint32_t settle_ms;         // Time in band before slowing down
+    int32_t band_mv;            // Allowed drift of the filtered value
+    int32_t slope_mv_s;         // Fastest change tolerated at the slow cadence
+    int32_t margin_mv;          // Minimum distance to the switching threshold
+} cadence_params_t;
+
+/**
+ * @struct cadence_t
+ * @brief Cadence state of one channel
+ */
+typedef struct {
+    int32_t ref_mv;             // Filtered value the band is centred on
+    uint32_t since_ms;          // Time the input entered the band
+    int32_t slope_ref_mv;       // Start of the current slope window
+    uint32_t slope_ref_ms;
+    int32_t slope_mv_s;         // Last completed slope estimate
+    bool started;
+    bool slow;
+} cadence_t;
+
+/**
+ * @brief Initialize a cadence state (fast until the input settles)
+ */
+void cadence_init(cadence_t *cadence);
+
+/**
+ * @brief Update with one filtered sample
+ * @param cadence Cadence state
+ * @param params Cadence parameters
+ * @param filtered_mv Filtered input in mV
+ * @param margin_mv Distance from the filtered input to the switching threshold
+ *                  (channel_logic_threshold_margin())
+ * @param now_ms Sample time (ms, wraps)
+ * @return Interval until the next sample (params->fast_ms or params->slow_ms)
+ */
+uint32_t cadence_update(cadence_t *cadence, const cadence_params_t *params,
+                        int32_t filtered_mv, int32_t margin_mv, uint32_t now_ms);
+
+#endif
@@ -0,0 +1,168 @@
+#include "channel_logic.h"
+#include <string.h>
+
+/**
+ * @brief Apply hysteresis logic
+ * Returns true if output should be ON
+ */
+bool channel_logic_hysteresis(bool current_state, int32_t value, int32_t th_on, int32_t th_off)
+{
+    if (current_state) {
+        // Currently ON: turn OFF only if below OFF threshold
+        return value >= th_off;
+    } else {
+        // Currently OFF: turn ON only if above ON threshold
+        return value >= th_on;
+    }
+}
+
+/**
+ * @brief Distance to the threshold that would switch the output
+ */
+int32_t channel_logic_threshold_margin(const channel_logic_t *logic)
+{
+    return logic->output_state ? logic->filtered_mv - logic->th_off_mv
+                               : logic->th_on_mv - logic->filtered_mv;
+}
+
+/**
+ * @brief Apply temperature compensation to thresholds
+ * Lead-acid batteries need higher voltage at lower temps
+ */
+bool channel_logic_compensate(channel_logic_t *logic, const channel_logic_params_t *params,
+                              bool params_changed, sensor_temp_t temp)
+{
+    int index = comp_table_index(temp);
+    if (logic->comp_valid && !params_changed && index == logic->comp_index) {
+        return false;
+    }
+    
+    // Coefficient is typically negative (voltage decreases with temp increase)
+    // Example: -0.02 means voltage decreases 20mV per °C above 25°C
+    if (!logic->comp_valid || params_changed) {
+        comp_table_build(&logic->comp_table, params->base_th_on_mv, params->base_th_off_mv,
+                         params->temp_coeff, (comp_curve_t)params->comp_curve);
+        logic->comp_valid = true;
+    }
+    
+    const comp_pair_t *pair = &logic->comp_table.pair[index];
+    logic->comp_index = index;
+    logic->comp_temperature = comp_table_temp(index);
+    logic->th_on_mv = pair->on_mv;
+    logic->th_off_mv = pair->off_mv;
+    logic->compensation_mv = logic->th_on_mv - params->base_th_on_mv;
+    
+    return true;
+}
+
+/**
+ * @brief Initialize a channel's decision state
+ */
+void channel_logic_init(channel_logic_t *logic, const channel_logic_params_t *params)
+{
+    memset(logic, 0, sizeof(*logic));
+    filter_init(&logic->filter, &params->filter);
+    logic->filter_config = params->filter;
+    logic->interval_ms = FILTER_BASE_INTERVAL_MS;
+    
+    logic->th_on_mv = params->base_th_on_mv;
+    logic->th_off_mv = params->base_th_off_mv;
+    logic->comp_temperature = CHANNEL_LOGIC_REF_TEMP;
+    logic->temperature = CHANNEL_LOGIC_REF_TEMP;
+}
+
+/**
+ * @brief Resume a channel in the state it had before a reset
+ */
+void channel_logic_resume(channel_logic_t *logic, bool output_state, int32_t filtered_mv,
+                          uint32_t now_ms)
+{
+    filter_seed(&logic->filter, filtered_mv);
+    logic->filtered_mv = filtered_mv;
+    logic->output_state = output_state;
+    logic->last_change_ms = now_ms;
+}
+
+/**
+ * @brief Switch the input filter
+ */
+void channel_logic_set_filter(channel_logic_t *logic, const filter_config_t *config)
+{
+    filter_config_t scaled = *config;
+    
+    logic->filter_config = *config;
+    if (filter_config_normalize(&scaled)) {
+        filter_config_rescale(&scaled, logic->interval_ms);
+    }
+    filter_reconfigure(&logic->filter, &scaled, logic->filtered_mv);
+}
+
+/**
+ * @brief Rescale the filter window to a new sample interval
+ */
+bool channel_logic_set_interval(channel_logic_t *logic, uint32_t interval_ms)
+{
+    if (interval_ms == 0 || interval_ms == logic->interval_ms) {
+        return false;
+    }
+    
+    logic->interval_ms = interval_ms;
+    channel_logic_set_filter(logic, &logic->filter_config);
+    
+    return true;
+}
+
+/**
+ * @brief Add one input sample to the filter
+ */
+int32_t channel_logic_filter(channel_logic_t *logic, uint32_t input_mv)
+{
+    logic->filtered_mv = filter_push(&logic->filter, (int32_t)input_mv);
+    
+    return logic->filtered_mv;
+}
+
+/**
+ * @brief Take the output decision for the current filtered value
+ */
+channel_logic_result_t channel_logic_decide(channel_logic_t *logic,
+                                            const channel_logic_params_t *params,
+                                            bool params_changed,
+                                            uint32_t temp_raw,
+                                            uint32_t timestamp_ms)
+{
+    // Apply temperature compensation to thresholds
+    logic->temperature = sensor_temperature(temp_raw, NULL);
+    channel_logic_compensate(logic, params, params_changed, logic->temperature);
+    
+    bool new_state = channel_logic_hysteresis(logic->output_state, logic->filtered_mv,
+                                              logic->th_on_mv, logic->th_off_mv);
+    if (new_state == logic->output_state) {
+        return CHANNEL_LOGIC_STEADY;
+    }
+    
+    // Check debounce time
+    if (timestamp_ms - logic->last_change_ms < MIN_STATE_CHANGE_MS) {
+        return CHANNEL_LOGIC_BLOCKED;
+    }
+    
+    logic->output_state = new_state;
+    logic->last_change_ms = timestamp_ms;
+    
+    return CHANNEL_LOGIC_CHANGED;
+}
+
+/**
+ * @brief Process one sample
+ */
+channel_logic_result_t channel_logic_step(channel_logic_t *logic,
+                                          const channel_logic_params_t *params,
+                                          bool params_changed,
+                                          uint32_t input_mv,
+                                          uint32_t temp_raw,
+                                          uint32_t timestamp_ms)
+{
+    channel_logic_filter(logic, input_mv);
+    
+    return channel_logic_decide(logic, params, params_changed, temp_raw, timestamp_ms);
+}
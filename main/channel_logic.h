@@ -0,0 +1,177 @@
+/**
+ * @file channel_logic.h
+ * @brief Platform-independent channel decision logic
+ *
+ * Input filtering (signal_filter.h), temperature-compensated thresholds
+ * (comp_table.h), hysteresis and state-change debouncing for one channel.
+ * Nothing here touches FreeRTOS, ESP-IDF or hardware: time and inputs are
+ * passed in by the caller, results are returned, and logging is left to the
+ * caller. channel_processor is the firmware adapter; the host/ benchmark
+ * links the same source to replay recorded traces.
+ */
+
+#ifndef CHANNEL_LOGIC_H
+#define CHANNEL_LOGIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "comp_table.h"
+#include "sensor_math.h"
+#include "signal_filter.h"
+
+// Minimum time between state changes (debounce)
+#define MIN_STATE_CHANGE_MS  5000  // 5 seconds
+
+// Reference temperature of the configured thresholds
+#define CHANNEL_LOGIC_REF_TEMP      COMP_REF_TEMP
+
+/**
+ * @struct channel_logic_params_t
+ * @brief Configured thresholds (at 25 °C), compensation and filter
+ */
+typedef struct {
+    int32_t base_th_on_mv;
+    int32_t base_th_off_mv;
+    sensor_coeff_t temp_coeff;  // sensor_coeff() of V per °C (negative for lead-acid)
+    uint8_t comp_curve;         // comp_curve_t, zero = linear
+    filter_config_t filter;     // Zero = default boxcar
+} channel_logic_params_t;
+
+/**
+ * @struct channel_logic_t
+ * @brief Decision state of one channel
+ */
+typedef struct {
+    filter_t filter;
+    filter_config_t filter_config;  // As configured, before rescaling
+    uint32_t interval_ms;           // Sample interval the filter is scaled for
+    bool output_state;
+    int32_t filtered_mv;
+    uint32_t last_change_ms;
+    // Thresholds compensated for comp_temperature
+    int32_t th_on_mv;
+    int32_t th_off_mv;
+    int32_t compensation_mv;
+    sensor_temp_t comp_temperature; // Centre of the bucket in use
+    int comp_index;
+    bool comp_valid;                // comp_table built for the current params
+    comp_table_t comp_table;
+    sensor_temp_t temperature;  // Temperature of the last step
+} channel_logic_t;
+
+/**
+ * @brief Outcome of one channel_logic_step()
+ */
+typedef enum {
+    CHANNEL_LOGIC_STEADY = 0,   // Output unchanged
+    CHANNEL_LOGIC_CHANGED,      // Output toggled
+    CHANNEL_LOGIC_BLOCKED,      // Toggle wanted but held off by the debounce
+} channel_logic_result_t;
+
+/**
+ * @brief Apply hysteresis logic
+ * @return true if output should be ON
+ */
+bool channel_logic_hysteresis(bool current_state, int32_t value, int32_t th_on, int32_t th_off);
+
+/**
+ * @brief Distance from the filtered value to the threshold that would switch
+ *        the output (th_off_mv while ON, th_on_mv while OFF)
+ * @return Margin in mV, negative once the threshold has been crossed
+ */
+int32_t channel_logic_threshold_margin(const channel_logic_t *logic);
+
+/**
+ * @brief Look up the compensated thresholds for a temperature
+ * @param logic Channel state
+ * @param params Configured thresholds
+ * @param params_changed true if params differ from the previous call
+ * @param temp Current temperature
+ * @return true if the thresholds changed bucket or were rebuilt
+ *
+ * The table is rebuilt only when the parameters change; otherwise this is
+ * a bucket index and, when the bucket moved, one table load.
+ */
+bool channel_logic_compensate(channel_logic_t *logic, const channel_logic_params_t *params,
+                              bool params_changed, sensor_temp_t temp);
+
+/**
+ * @brief Initialize a channel's decision state (output OFF)
+ * @param logic Channel state
+ * @param params Initial thresholds (used uncompensated until the first step)
+ *               and filter
+ */
+void channel_logic_init(channel_logic_t *logic, const channel_logic_params_t *params);
+
+/**
+ * @brief Resume a channel in the state it had before a reset
+ * @param logic Channel state, freshly initialized
+ * @param output_state Output before the reset
+ * @param filtered_mv Filtered value before the reset (seeds the filter)
+ * @param now_ms Current time (ms, wraps)
+ *
+ * The resumed output counts as a change at now_ms, so the debounce holds it
+ * for MIN_STATE_CHANGE_MS against a noisy first reading.
+ */
+void channel_logic_resume(channel_logic_t *logic, bool output_state, int32_t filtered_mv,
+                          uint32_t now_ms);
+
+/**
+ * @brief Switch the input filter, continuing from the current filtered value
+ * @param logic Channel state
+ * @param config New filter selection
+ */
+void channel_logic_set_filter(channel_logic_t *logic, const filter_config_t *config);
+
+/**
+ * @brief Rescale the filter window to a new sample interval
+ * @param logic Channel state
+ * @param interval_ms Interval between the samples that follow
+ * @return true if the filter was rescaled
+ *
+ * Keeps the window's time span, and with it the filter lag, the same at
+ * any interval. The rescaled filter continues from the current value.
+ */
+bool channel_logic_set_interval(channel_logic_t *logic, uint32_t interval_ms);
+
+/**
+ * @brief Add one input sample to the channel's filter
+ * @param logic Channel state
+ * @param input_mv Channel input in mV
+ * @return Filtered value in mV
+ */
+int32_t channel_logic_filter(channel_logic_t *logic, uint32_t input_mv);
+
+/**
+ * @brief Take the output decision for the current filtered value
+ * @param logic Channel state
+ * @param params Configured thresholds
+ * @param params_changed true if params differ from the previous decision
+ * @param temp_raw Temperature sensor output in mV
+ * @param timestamp_ms Sample time (ms, wraps)
+ * @return Whether the output changed, stayed or was held by the debounce
+ */
+channel_logic_result_t channel_logic_decide(channel_logic_t *logic,
+                                            const channel_logic_params_t *params,
+                                            bool params_changed,
+                                            uint32_t temp_raw,
+                                            uint32_t timestamp_ms);
+
+/**
+ * @brief Process one sample (channel_logic_filter() then channel_logic_decide())
+ * @param logic Channel state
+ * @param params Configured thresholds
+ * @param params_changed true if params differ from the previous step
+ * @param input_mv Channel input in mV
+ * @param temp_raw Temperature sensor output in mV
+ * @param timestamp_ms Sample time (ms, wraps)
+ * @return Whether the output changed, stayed or was held by the debounce
+ */
+channel_logic_result_t channel_logic_step(channel_logic_t *logic,
+                                          const channel_logic_params_t *params,
+                                          bool params_changed,
+                                          uint32_t input_mv,
+                                          uint32_t temp_raw,
+                                          uint32_t timestamp_ms);
+
+#endif
@@ -1,285 +1,333 @@
 #include "channel_processor.h"
 #include "adc_handler.h"
+#include "sample_ring.h"
+#include "channel_table.h"
+#include "task_stats.h"
+#include "perf_stats.h"
+#include "control_handler.h"
 #include "nvs_storage.h"
+#include "channel_logic.h"
+#include "cadence_logic.h"
+#include "fastboot.h"
+#include "rtlog.h"
+#include "seqlock.h"
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "rtos_alloc.h"
 #include <string.h>
-#include <math.h>
 
 static const char *TAG = "CHAN_PROC";
 
-// Moving average configuration
-#define MA_SIZE 16  // Number of samples to average (16 * 100ms = 1.6s smoothing)
+// Command queue depth per channel
+#define COMMAND_QUEUE_DEPTH_PER_CHANNEL  5
 
-// Minimum time between state changes (debounce)
-#define MIN_STATE_CHANGE_MS  5000  // 5 seconds
+// Resend a command when the filtered voltage moves this far from the last one sent
+#define COMMAND_VOLTAGE_DEADBAND_MV      100
 
-// Queue for output commands (to control_task)
-QueueHandle_t ch0_command_queue = NULL;
-QueueHandle_t ch1_command_queue = NULL;
+// Periodic per-channel status log, independent of the sample interval
+#define STATUS_LOG_INTERVAL_MS           10000
 
-/**
- * @brief Moving average filter structure
- */
-typedef struct {
-    int32_t buffer[MA_SIZE];
-    int index;
-    int64_t sum;
-    int count;
-    bool initialized;
-} moving_average_t;
+// Queue for output commands (to control_task), shared by all channels
+QueueHandle_t channel_command_queue = NULL;
+RTOS_QUEUE_STORAGE(channel_command_queue, COMMAND_QUEUE_DEPTH_PER_CHANNEL * CHANNEL_COUNT,
+                   sizeof(channel_command_t));
+
+#if CONFIG_SOLAR_ADAPTIVE_SAMPLING
+// When a quiet input far from its thresholds lets adc_task stretch its interval
+static const cadence_params_t cadence_params = {
+    .fast_ms = ADC_SAMPLE_INTERVAL_MS,
+    .slow_ms = CONFIG_SOLAR_ADAPTIVE_INTERVAL_MS,
+    .settle_ms = CONFIG_SOLAR_ADAPTIVE_SETTLE_S * 1000,
+    .band_mv = CONFIG_SOLAR_ADAPTIVE_BAND_MV,
+    .slope_mv_s = CONFIG_SOLAR_ADAPTIVE_SLOPE_MV_S,
+    .margin_mv = CONFIG_SOLAR_ADAPTIVE_MARGIN_MV,
+};
+#endif
+
+// Interval every channel can tolerate, read by adc_task
+static volatile uint32_t requested_interval_ms = ADC_SAMPLE_INTERVAL_MS;
 
 /**
  * @brief Channel state structure
  */
 typedef struct {
     int channel_id;
-    moving_average_t ma_filter;
-    channel_state_t state;
-    int32_t th_on_mv;
-    int32_t th_off_mv;
-    float temp_coefficient;
-    float last_temperature;
+    const channel_desc_t *desc;
+    channel_logic_t logic;          // Filter, thresholds and output state
+    channel_logic_params_t params;  // Derived from the configuration snapshot
+    uint32_t config_gen;
+    bool config_valid;
+    sensor_temp_t last_temperature; // Temperature of the last compensation log
+    uint32_t last_status_ms;        // Time of the last periodic status log
+    // Last command handed to control_task
+    bool cmd_sent;
+    bool sent_output_state;
+    int32_t sent_voltage;
+    cadence_t cadence;              // Sample interval this channel tolerates
 } channel_context_t;
 
-/**
- * @brief Initialize moving average filter
- */
-static void ma_init(moving_average_t *ma)
-{
-    memset(ma->buffer, 0, sizeof(ma->buffer));
-    ma->index = 0;
-    ma->sum = 0;
-    ma->count = 0;
-    ma->initialized = false;
-}
+// Contiguous per-channel contexts, iterated by the single processing task
+static channel_context_t channel_contexts[CHANNEL_COUNT];
 
 /**
- * @brief Add sample to moving average
+ * @brief Published state of one channel (written only by channel_proc_task)
  */
-static void ma_add(moving_average_t *ma, int32_t value)
-{
-    if (!ma->initialized) {
-        // First fill: initialize all slots with first value
-        for (int i = 0; i < MA_SIZE; i++) {
-            ma->buffer[i] = value;
-        }
-        ma->sum = (int64_t)value * MA_SIZE;
-        ma->count = MA_SIZE;
-        ma->initialized = true;
-        return;
-    }
-    
-    // Remove old value, add new value
-    ma->sum -= ma->buffer[ma->index];
-    ma->buffer[ma->index] = value;
-    ma->sum += value;
-    
-    // Move to next position
-    ma->index = (ma->index + 1) % MA_SIZE;
-    
-    if (ma->count < MA_SIZE) {
-        ma->count++;
-    }
-}
+typedef struct {
+    seqlock_t lock;
+    channel_state_t state;
+} channel_slot_t;
 
-/**
- * @brief Get moving average value
- */
-static int32_t ma_get(moving_average_t *ma)
-{
-    if (ma->count == 0) {
-        return 0;
-    }
-    return (int32_t)(ma->sum / ma->count);
-}
+static channel_slot_t channel_slots[CHANNEL_COUNT];
 
 /**
- * @brief Apply hysteresis logic
- * Returns true if output should be ON
+ * @brief Publish a channel's state for lock-free readers
  */
-static bool apply_hysteresis(bool current_state, int32_t value, int32_t th_on, int32_t th_off)
+static void publish_channel_state(const channel_context_t *ctx, uint32_t timestamp_ms)
 {
-    if (current_state) {
-        // Currently ON: turn OFF only if below OFF threshold
-        return value >= th_off;
-    } else {
-        // Currently OFF: turn ON only if above ON threshold
-        return value >= th_on;
-    }
+    channel_slot_t *slot = &channel_slots[ctx->channel_id];
+    const channel_logic_t *logic = &ctx->logic;
+    
+    seqlock_write_begin(&slot->lock);
+    slot->state.output_state = logic->output_state;
+    slot->state.filtered_voltage = logic->filtered_mv;
+    slot->state.th_on_mv = logic->th_on_mv;
+    slot->state.th_off_mv = logic->th_off_mv;
+    slot->state.last_change_time = logic->last_change_ms;
+    slot->state.timestamp_ms = timestamp_ms;
+    seqlock_write_end(&slot->lock);
 }
 
 /**
- * @brief Apply temperature compensation to thresholds
- * Adjusts thresholds based on temperature
- * Lead-acid batteries need higher voltage at lower temps
+ * @brief Refresh cached configuration if a new snapshot was published
+ * @return true if the cached values changed
  */
-static void apply_temperature_compensation(channel_context_t *ctx, float temp_c)
+static bool refresh_channel_config(channel_context_t *ctx)
 {
-    // Get base thresholds from NVS
-    int32_t base_th_on, base_th_off;
-    
-    if (ctx->channel_id == 0) {
-        base_th_on = nvs_get_ch0_th_on();
-        base_th_off = nvs_get_ch0_th_off();
-    } else {
-        base_th_on = nvs_get_ch1_th_on();
-        base_th_off = nvs_get_ch1_th_off();
+    if (ctx->config_valid && nvs_config_generation() == ctx->config_gen) {
+        return false;
     }
     
-    // Temperature compensation
-    // Coefficient is typically negative (voltage decreases with temp increase)
-    // Example: -0.02 means voltage decreases 20mV per °C above 25°C
-    float temp_delta = temp_c - 25.0f;  // Reference temperature 25°C
-    int32_t compensation_mv = (int32_t)(ctx->temp_coefficient * temp_delta * 1000.0f);
+    app_config_t config;
+    ctx->config_gen = nvs_config_snapshot(&config);
+    ctx->params.base_th_on_mv = config.th_on_mv[ctx->channel_id];
+    ctx->params.base_th_off_mv = config.th_off_mv[ctx->channel_id];
+    ctx->params.temp_coeff = config.temp_comp;
+    ctx->params.comp_curve = config.comp_curve[ctx->channel_id];
+    ctx->config_valid = true;
     
-    ctx->th_on_mv = base_th_on + compensation_mv;
-    ctx->th_off_mv = base_th_off + compensation_mv;
-    
-    // Log if temperature changed significantly
-    if (fabsf(temp_c - ctx->last_temperature) > 2.0f) {
-        ESP_LOGI(TAG, "CH%d: Temp=%.1f°C, compensation=%dmV, TH_ON=%dmV, TH_OFF=%dmV",
-                 ctx->channel_id, temp_c, compensation_mv, ctx->th_on_mv, ctx->th_off_mv);
-        ctx->last_temperature = temp_c;
+    // A new filter starts from the current filtered value, not from scratch
+    const filter_config_t *filter = &config.filter[ctx->channel_id];
+    if (memcmp(filter, &ctx->params.filter, sizeof(*filter)) != 0) {
+        ctx->params.filter = *filter;
+        channel_logic_set_filter(&ctx->logic, filter);
     }
+    
+    return true;
 }
 
 /**
  * @brief Process channel logic
+ * Platform glue around channel_logic: inputs, timing stamps and logging
  */
 static void process_channel(channel_context_t *ctx, const adc_reading_t *reading)
 {
-    // Add to moving average
-    ma_add(&ctx->ma_filter, reading->battery_voltage_mv);
+    channel_logic_t *logic = &ctx->logic;
     
-    // Get filtered voltage
-    int32_t filtered_voltage = ma_get(&ctx->ma_filter);
-    ctx->state.filtered_voltage = filtered_voltage;
+    // Add this channel's input to its filter
+    uint32_t input_mv = adc_reading_source_mv(reading, ctx->desc->adc_source);
+    int32_t filtered_voltage = channel_logic_filter(logic, input_mv);
+    perf_record(PERF_STAGE_FILTER, reading->sample_us);
     
-    // Calculate temperature from raw ADC
-    // For TMP36: Vout = (Temp°C * 10mV) + 500mV
-    float temp_c = ((float)reading->temperature_raw - 500.0f) / 10.0f;
+    // Compensated hysteresis with debounce
+    bool config_changed = refresh_channel_config(ctx);
+    channel_logic_result_t result = channel_logic_decide(logic, &ctx->params, config_changed,
+                                                         reading->temperature_raw,
+                                                         reading->timestamp_ms);
+    perf_record(PERF_STAGE_DECISION, reading->sample_us);
     
-    // Sanity check temperature
-    if (temp_c < -40.0f || temp_c > 125.0f) {
-        temp_c = 25.0f;  // Default to room temp if invalid
+    // Log if temperature changed significantly
+    sensor_temp_t temp_moved = logic->comp_temperature - ctx->last_temperature;
+    if (temp_moved > SENSOR_TEMP_C(2) || temp_moved < -SENSOR_TEMP_C(2)) {
+        RTLOG(RTLOG_CH_COMPENSATION,
+              ctx->channel_id, sensor_temp_dc(logic->comp_temperature), logic->compensation_mv,
+              logic->th_on_mv, logic->th_off_mv);
+        ctx->last_temperature = logic->comp_temperature;
     }
     
-    // Apply temperature compensation to thresholds
-    apply_temperature_compensation(ctx, temp_c);
-    
-    // Apply hysteresis
-    bool new_state = apply_hysteresis(
-        ctx->state.output_state,
-        filtered_voltage,
-        ctx->th_on_mv,
-        ctx->th_off_mv
-    );
-    
-    // Check if state changed
-    if (new_state != ctx->state.output_state) {
-        // Check debounce time
-        uint32_t time_since_last_change = reading->timestamp_ms - ctx->state.last_change_time;
-        
-        if (time_since_last_change >= MIN_STATE_CHANGE_MS) {
-            // State change allowed
-            ctx->state.output_state = new_state;
-            ctx->state.last_change_time = reading->timestamp_ms;
-            
-            ESP_LOGI(TAG, "CH%d: State change to %s (voltage=%dmV, TH_ON=%dmV, TH_OFF=%dmV)",
-                     ctx->channel_id,
-                     new_state ? "ON" : "OFF",
-                     filtered_voltage,
-                     ctx->th_on_mv,
-                     ctx->th_off_mv);
-        } else {
-            ESP_LOGD(TAG, "CH%d: State change blocked by debounce (time=%ums < %ums)",
-                     ctx->channel_id,
-                     (unsigned int)time_since_last_change,
-                     MIN_STATE_CHANGE_MS);
-        }
+    if (result == CHANNEL_LOGIC_CHANGED) {
+        RTLOG(RTLOG_CH_STATE_CHANGE,
+              ctx->channel_id,
+              RTLOG_S(logic->output_state ? "ON" : "OFF"),
+              filtered_voltage,
+              logic->th_on_mv,
+              logic->th_off_mv);
+    } else if (result == CHANNEL_LOGIC_BLOCKED) {
+        ESP_LOGD(TAG, "CH%d: State change blocked by debounce (time=%ums < %ums)",
+                 ctx->channel_id,
+                 (unsigned int)(reading->timestamp_ms - logic->last_change_ms),
+                 MIN_STATE_CHANGE_MS);
     }
     
-    // Log periodic status (every ~10 seconds at 100ms sampling)
-    static uint32_t log_counter[2] = {0, 0};
-    log_counter[ctx->channel_id]++;
-    
-    if (log_counter[ctx->channel_id] % 100 == 0) {
-        ESP_LOGI(TAG, "CH%d: State=%s, Voltage=%dmV (raw=%umV), Temp=%.1f°C",
-                 ctx->channel_id,
-                 ctx->state.output_state ? "ON" : "OFF",
-                 filtered_voltage,
-                 (unsigned int)reading->battery_voltage_mv,
-                 temp_c);
+    // Log periodic status
+    if (reading->timestamp_ms - ctx->last_status_ms >= STATUS_LOG_INTERVAL_MS) {
+        ctx->last_status_ms = reading->timestamp_ms;
+        RTLOG(RTLOG_CH_STATUS,
+              ctx->channel_id,
+              RTLOG_S(logic->output_state ? "ON" : "OFF"),
+              filtered_voltage,
+              input_mv,
+              sensor_temp_dc(logic->temperature));
     }
 }
 
 /**
  * @brief Channel processing task
- * One instance runs per channel
+ * A single instance iterates every channel context per reading
  */
 void channel_proc_task(void *pvParameters)
 {
-    channel_config_t *config = (channel_config_t *)pvParameters;
+    const channel_config_t *configs = (const channel_config_t *)pvParameters;
     
-    if (config == NULL) {
+    if (configs == NULL) {
         ESP_LOGE(TAG, "NULL config passed to channel_proc_task");
         vTaskDelete(NULL);
         return;
     }
     
-    ESP_LOGI(TAG, "Channel %d processor started", config->channel_id);
-    
-    // Create channel context
-    channel_context_t ctx;
-    memset(&ctx, 0, sizeof(ctx));
-    ctx.channel_id = config->channel_id;
-    ctx.th_on_mv = config->th_on_mv;
-    ctx.th_off_mv = config->th_off_mv;
-    ctx.temp_coefficient = config->temp_coeff;
-    ctx.last_temperature = 25.0f;
+    ESP_LOGI(TAG, "Channel processor started for %d channels", CHANNEL_COUNT);
     
-    // Initialize moving average
-    ma_init(&ctx.ma_filter);
+    // After a warm reset each channel carries on with its previous output
+    fastboot_state_t resume;
+    bool resumed = fastboot_get(&resume);
+    uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
     
-    // Initialize state
-    ctx.state.output_state = false;
-    ctx.state.filtered_voltage = 0;
-    ctx.state.last_change_time = 0;
+    // Initialize channel contexts
+    memset(channel_contexts, 0, sizeof(channel_contexts));
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        channel_context_t *ctx = &channel_contexts[ch];
+        ctx->channel_id = configs[ch].channel_id;
+        ctx->desc = &channel_table[ch];
+        ctx->params.base_th_on_mv = configs[ch].th_on_mv;
+        ctx->params.base_th_off_mv = configs[ch].th_off_mv;
+        ctx->params.temp_coeff = sensor_coeff(configs[ch].temp_coeff);
+        ctx->last_temperature = CHANNEL_LOGIC_REF_TEMP;
+        
+        // Filter empty, output OFF, unless resuming
+        channel_logic_init(&ctx->logic, &ctx->params);
+        if (resumed) {
+            channel_logic_resume(&ctx->logic, (resume.output_mask >> ch) & 1,
+                                 resume.filtered_mv[ch], now_ms);
+        }
+        cadence_init(&ctx->cadence);
+    }
     
-    // Select appropriate queue based on channel
-    QueueHandle_t input_queue = (config->channel_id == 0) ? adc_queue_ch0 : adc_queue_ch1;
-    QueueHandle_t output_queue = (config->channel_id == 0) ? ch0_command_queue : ch1_command_queue;
+    // Register a cursor on the shared sample ring
+    sample_ring_reader_t *reader = sample_ring_reader_register(pcTaskGetName(NULL));
     
-    if (input_queue == NULL) {
-        ESP_LOGE(TAG, "CH%d: Input queue not initialized", config->channel_id);
+    if (reader == NULL) {
+        ESP_LOGE(TAG, "Input reader not available");
         vTaskDelete(NULL);
         return;
     }
     
+    // Activated once per published reading
+    task_stats_t *stats = task_stats_register(pcTaskGetName(NULL), ADC_SAMPLE_INTERVAL_MS);
+    
     adc_reading_t reading;
+    uint32_t reported_overruns = 0;
+    uint32_t period_ms = ADC_SAMPLE_INTERVAL_MS;
     
     while (1) {
         // Wait for ADC reading
-        if (xQueueReceive(input_queue, &reading, portMAX_DELAY) == pdTRUE) {
+        if (!sample_ring_read(reader, &reading, portMAX_DELAY)) {
+            continue;
+        }
+        
+        // Released by each reading, so the period follows the sampling interval
+        bool rescale = (reading.interval_ms != period_ms);
+        if (rescale) {
+            period_ms = reading.interval_ms;
+            task_stats_set_period(stats, period_ms);
+        }
+        task_stats_begin(stats);
+        
+        // Same filter time span, so the same lag, at the new interval
+        if (rescale) {
+            for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+                channel_logic_set_interval(&channel_contexts[ch].logic, period_ms);
+            }
+        }
+        
+        // Backlog still waiting behind this reading
+        perf_queue_depth(PERF_QUEUE_SAMPLE_RING, sample_ring_reader_backlog(reader));
+        
+        if (reader->overruns != reported_overruns) {
+            RTLOG(RTLOG_CH_OVERRUN, reader->overruns);
+            perf_drop(PERF_DROP_RING_OVERRUN, reader->overruns - reported_overruns);
+            reported_overruns = reader->overruns;
+        }
+        
+        bool notify = false;
+        uint32_t interval_ms = UINT32_MAX;
+        
+        for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+            channel_context_t *ctx = &channel_contexts[ch];
+            
             // Process the reading
-            process_channel(&ctx, &reading);
+            process_channel(ctx, &reading);
+            publish_channel_state(ctx, reading.timestamp_ms);
+            
+#if CONFIG_SOLAR_ADAPTIVE_SAMPLING
+            // The slowest interval every channel can tolerate
+            uint32_t channel_interval = cadence_update(&ctx->cadence, &cadence_params,
+                                                       ctx->logic.filtered_mv,
+                                                       channel_logic_threshold_margin(&ctx->logic),
+                                                       reading.timestamp_ms);
+            if (channel_interval < interval_ms) {
+                interval_ms = channel_interval;
+            }
+#endif
+            
+            // Only wake control_task when its inputs actually change
+            int32_t voltage_delta = ctx->logic.filtered_mv - ctx->sent_voltage;
+            bool send = !ctx->cmd_sent ||
+                        ctx->logic.output_state != ctx->sent_output_state ||
+                        voltage_delta >= COMMAND_VOLTAGE_DEADBAND_MV ||
+                        voltage_delta <= -COMMAND_VOLTAGE_DEADBAND_MV;
             
             // Send command to control task if output queue exists
-            if (output_queue != NULL) {
+            if (send && channel_command_queue != NULL) {
                 channel_command_t cmd;
-                cmd.channel_id = ctx.channel_id;
-                cmd.output_state = ctx.state.output_state;
-                cmd.filtered_voltage = ctx.state.filtered_voltage;
+                cmd.channel_id = ctx->channel_id;
+                cmd.output_state = ctx->logic.output_state;
+                cmd.filtered_voltage = ctx->logic.filtered_mv;
                 cmd.timestamp_ms = reading.timestamp_ms;
+                cmd.sample_us = reading.sample_us;
                 
-                if (xQueueSend(output_queue, &cmd, 0) != pdTRUE) {
-                    ESP_LOGW(TAG, "CH%d: Command queue full", config->channel_id);
+                if (xQueueSend(channel_command_queue, &cmd, 0) != pdTRUE) {
+                    // Not recorded as sent, so it is retried on the next reading
+                    RTLOG(RTLOG_CH_QUEUE_FULL, ctx->channel_id);
+                    perf_drop(PERF_DROP_COMMAND_FULL, 1);
+                } else {
+                    perf_queue_depth(PERF_QUEUE_COMMAND, uxQueueMessagesWaiting(channel_command_queue));
+                    ctx->cmd_sent = true;
+                    ctx->sent_output_state = cmd.output_state;
+                    ctx->sent_voltage = cmd.filtered_voltage;
+                    notify = true;
                 }
             }
         }
+        
+        if (notify) {
+            control_notify(CONTROL_EVT_COMMAND);
+        }
+        
+        requested_interval_ms = (interval_ms == UINT32_MAX) ? ADC_SAMPLE_INTERVAL_MS : interval_ms;
+        
+        task_stats_end(stats);
     }
 }
 
@@ -290,40 +338,63 @@ void channel_processor_init(void)
 {
     ESP_LOGI(TAG, "Initializing channel processor");
     
-    // Create command queues for control task
-    ch0_command_queue = xQueueCreate(5, sizeof(channel_command_t));
-    ch1_command_queue = xQueueCreate(5, sizeof(channel_command_t));
+    // Readers may query the slots before the first reading is processed
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        channel_slots[ch].lock = (seqlock_t)SEQLOCK_INITIALIZER;
+        memset(&channel_slots[ch].state, 0, sizeof(channel_slots[ch].state));
+    }
     
-    if (ch0_command_queue == NULL || ch1_command_queue == NULL) {
-        ESP_LOGE(TAG, "Failed to create command queues");
+    // Create the shared command queue for control task
+    channel_command_queue = RTOS_QUEUE_CREATE(channel_command_queue,
+                                              COMMAND_QUEUE_DEPTH_PER_CHANNEL * CHANNEL_COUNT,
+                                              sizeof(channel_command_t));
+    
+    if (channel_command_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create command queue");
         return;
     }
     
+    perf_queue_set_capacity(PERF_QUEUE_COMMAND, COMMAND_QUEUE_DEPTH_PER_CHANNEL * CHANNEL_COUNT);
+    perf_queue_set_capacity(PERF_QUEUE_SAMPLE_RING, SAMPLE_RING_SIZE);
+    
     ESP_LOGI(TAG, "Channel processor initialized");
 }
 
+/**
+ * @brief Get a consistent copy of a channel's published state
+ */
+bool channel_get_snapshot(int channel_id, channel_state_t *state)
+{
+    if (channel_id < 0 || channel_id >= CHANNEL_COUNT) {
+        return false;
+    }
+    
+    channel_slot_t *slot = &channel_slots[channel_id];
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&slot->lock);
+        *state = slot->state;
+    } while (seqlock_read_retry(&slot->lock, seq));
+    
+    return true;
+}
+
 /**
  * @brief Get current channel state (for status queries)
  */
 bool channel_get_state(int channel_id)
 {
-    // This is a simplified version
-    // In a real implementation, you might want to store state in a shared structure
-    // protected by a mutex
-    
-    if (channel_id == 0 && ch0_command_queue != NULL) {
-        channel_command_t cmd;
-        if (xQueuePeek(ch0_command_queue, &cmd, 0) == pdTRUE) {
-            return cmd.output_state;
-        }
-    } else if (channel_id == 1 && ch1_command_queue != NULL) {
-        channel_command_t cmd;
-        if (xQueuePeek(ch1_command_queue, &cmd, 0) == pdTRUE) {
-            return cmd.output_state;
-        }
-    }
+    channel_state_t state;
     
-    return false;
+    return channel_get_snapshot(channel_id, &state) && state.output_state;
+}
+
+/**
+ * @brief Sampling interval the channels can tolerate
+ */
+uint32_t channel_sample_interval_ms(void)
+{
+    return requested_interval_ms;
 }
 
 /**
@@ -331,17 +402,7 @@ bool channel_get_state(int channel_id)
  */
 int32_t channel_get_filtered_voltage(int channel_id)
 {
-    if (channel_id == 0 && ch0_command_queue != NULL) {
-        channel_command_t cmd;
-        if (xQueuePeek(ch0_command_queue, &cmd, 0) == pdTRUE) {
-            return cmd.filtered_voltage;
-        }
-    } else if (channel_id == 1 && ch1_command_queue != NULL) {
-        channel_command_t cmd;
-        if (xQueuePeek(ch1_command_queue, &cmd, 0) == pdTRUE) {
-            return cmd.filtered_voltage;
-        }
-    }
+    channel_state_t state;
     
-    return 0;
+    return channel_get_snapshot(channel_id, &state) ? state.filtered_voltage : 0;
 }
\ No newline at end of file
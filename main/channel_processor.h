@@ -2,7 +2,7 @@
  * @file channel_processor.h
  * @brief Channel processing logic with hysteresis and temperature compensation
  * 
- * Implements per-channel battery voltage monitoring with moving average filtering,
+ * Implements per-channel battery voltage monitoring with configurable input filtering,
  * hysteresis control, temperature compensation, and state debouncing.
  */
 
@@ -31,13 +31,17 @@ typedef struct {
  * @struct channel_state_t
  * @brief Current channel state
  * 
- * Tracks the current output state, filtered voltage reading,
- * and timestamp of the last state change for debouncing.
+ * Tracks the current output state, filtered voltage reading, the
+ * compensated thresholds and timestamp of the last state change for
+ * debouncing. Published by the channel processor after every reading.
  */
 typedef struct {
     bool output_state;
-    int filtered_voltage;
+    int32_t filtered_voltage;
+    int32_t th_on_mv;           // Temperature-compensated thresholds
+    int32_t th_off_mv;
     uint32_t last_change_time;
+    uint32_t timestamp_ms;      // Reading the state was computed from
 } channel_state_t;
 
 /**
@@ -45,60 +49,85 @@ typedef struct {
  * @brief Command structure sent to control task
  * 
  * Contains the desired output state and associated voltage information
- * to be applied by the hardware control task.
+ * to be applied by the hardware control task. sample_us is the conversion
+ * time of the reading that produced the command (latency accounting).
  */
 typedef struct {
     int channel_id;
     bool output_state;
     int32_t filtered_voltage;
     uint32_t timestamp_ms;
+    int64_t sample_us;
 } channel_command_t;
 
-// Command queues (one per channel)
-extern QueueHandle_t ch0_command_queue;
-extern QueueHandle_t ch1_command_queue;
+// Command queue shared by all channels (commands carry channel_id)
+extern QueueHandle_t channel_command_queue;
 
 /**
  * @brief Channel processing task
- * @param pvParameters Pointer to channel_config_t structure
+ * @param pvParameters Pointer to an array of CHANNEL_COUNT channel_config_t
  * 
- * Processes ADC readings for a single channel:
- * - Applies moving average filter (1.6s window)
+ * Processes each ADC reading for every channel in channel_table:
+ * - Applies the configured input filter (boxcar 1.6s window by default)
  * - Implements hysteresis logic
  * - Applies temperature compensation to thresholds
  * - Enforces minimum 5-second state change debounce
  * - Sends commands to control task
+ * - With CONFIG_SOLAR_ADAPTIVE_SAMPLING, picks the sample interval from how
+ *   quiet and how far from a threshold the inputs are, and rescales the
+ *   filter windows to it
  * 
- * @note One instance of this task should run per channel
+ * @note A single instance serves all channels, iterating contiguous
+ *       per-channel contexts
  */
 void channel_proc_task(void *pvParameters);
 
 /**
  * @brief Initialize channel processor subsystem
  * 
- * Creates command queues for communication with the control task.
- * Must be called before creating channel processing tasks.
+ * Creates the command queue for communication with the control task.
+ * Must be called before creating the channel processing task.
  */
 void channel_processor_init(void);
 
+/**
+ * @brief Get a consistent copy of a channel's published state
+ * @param channel_id Channel identifier (0 to CHANNEL_COUNT - 1)
+ * @param state Filled with the state of the latest processed reading
+ * @return false if channel_id is out of range (state untouched)
+ * 
+ * Lock-free: each channel publishes into its own slot through a seqlock,
+ * so readers never block the channel processor and the fields always
+ * belong to the same reading.
+ */
+bool channel_get_snapshot(int channel_id, channel_state_t *state);
+
 /**
  * @brief Get current channel state
- * @param channel_id Channel identifier (0 or 1)
+ * @param channel_id Channel identifier (0 to CHANNEL_COUNT - 1)
  * @return true if output is ON, false if OFF
  * 
- * Non-blocking query of current channel output state by peeking
- * at the most recent command in the queue.
+ * Non-blocking query of the processor's current channel output state.
  */
 bool channel_get_state(int channel_id);
 
 /**
  * @brief Get filtered voltage for a channel
- * @param channel_id Channel identifier (0 or 1)
+ * @param channel_id Channel identifier (0 to CHANNEL_COUNT - 1)
  * @return Filtered voltage in millivolts (mV), or 0 if unavailable
  * 
  * Non-blocking query of the current filtered voltage value
- * after moving average processing.
+ * after input filtering.
  */
 int32_t channel_get_filtered_voltage(int channel_id);
 
+/**
+ * @brief Sampling interval the channels can tolerate
+ * @return ADC_SAMPLE_INTERVAL_MS, or CONFIG_SOLAR_ADAPTIVE_INTERVAL_MS once
+ *         every channel's filtered input has settled away from its thresholds
+ * 
+ * Read by adc_task after each reading (see cadence_logic.h).
+ */
+uint32_t channel_sample_interval_ms(void);
+
 #endif
\ No newline at end of file
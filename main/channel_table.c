@@ -0,0 +1,26 @@
+#include "channel_table.h"
+
+/**
+ * @brief Channel descriptor table
+ * 
+ * Row index is the channel id used by the CLI, NVS and logs.
+ */
+const channel_desc_t channel_table[] = {
+    {
+        .adc_source = ADC_SOURCE_BATTERY,
+        .ledc_channel = LEDC_CHANNEL_0,
+        .gpio = GPIO_NUM_25,
+        .nvs_prefix = "ch0",
+    },
+    {
+        .adc_source = ADC_SOURCE_BATTERY,
+        .ledc_channel = LEDC_CHANNEL_1,
+        .gpio = GPIO_NUM_26,
+        .nvs_prefix = "ch1",
+    },
+};
+
+_Static_assert(sizeof(channel_table) / sizeof(channel_table[0]) == CHANNEL_COUNT,
+               "channel_table rows must match CHANNEL_COUNT");
+_Static_assert(CHANNEL_COUNT <= LEDC_CHANNEL_MAX,
+               "CHANNEL_COUNT exceeds available LEDC channels");
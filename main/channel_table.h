@@ -0,0 +1,42 @@
+/**
+ * @file channel_table.h
+ * @brief Compile-time channel descriptor table
+ * 
+ * Every per-channel resource (ADC source, LEDC channel, output GPIO and NVS
+ * key prefix) is described here. Processing, storage and output all iterate
+ * this table, so adding an LED string means adding one row to
+ * channel_table.c and bumping CHANNEL_COUNT.
+ */
+
+#ifndef CHANNEL_TABLE_H
+#define CHANNEL_TABLE_H
+
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "adc_handler.h"
+
+/**
+ * @brief Number of output channels
+ * 
+ * Must match the number of rows in channel_table[]. Limited by the number
+ * of LEDC channels available in one speed mode (8 on ESP32).
+ */
+#define CHANNEL_COUNT   2
+
+/**
+ * @struct channel_desc_t
+ * @brief Static description of one output channel
+ */
+typedef struct {
+    adc_source_t adc_source;     // ADC input this channel's hysteresis is evaluated on
+    ledc_channel_t ledc_channel; // LEDC channel driving the output
+    gpio_num_t gpio;             // Output GPIO (MOSFET gate)
+    const char *nvs_prefix;      // NVS key prefix, e.g. "ch0" -> "ch0_th_on"
+} channel_desc_t;
+
+/**
+ * @brief Channel descriptor table, indexed by channel id
+ */
+extern const channel_desc_t channel_table[CHANNEL_COUNT];
+
+#endif
@@ -1,8 +1,20 @@
 #include "cli_handler.h"
 #include "adc_handler.h"
+#include "sample_ring.h"
 #include "channel_processor.h"
+#include "channel_table.h"
 #include "control_handler.h"
 #include "nvs_storage.h"
+#include "nvs.h"
+#include "task_stats.h"
+#include "perf_stats.h"
+#include "mem_stats.h"
+#include "samplelog.h"
+#include "telemetry.h"
+#include "fleet.h"
+#include "power_mgmt.h"
+#include "rtlog.h"
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "esp_console.h"
 #include "esp_vfs_dev.h"
@@ -11,6 +23,8 @@
 #include "argtable3/argtable3.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "rtos_alloc.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -19,6 +33,61 @@ static const char *TAG = "CLI";
 // Verification data (global for this module)
 static verification_data_t g_verification_data = {0};
 
+// Argtables are static: one command runs at a time, from any task
+static SemaphoreHandle_t console_mutex = NULL;
+RTOS_MUTEX_STORAGE(console_mutex);
+
+// Commands a fleet config push may run: thresholds, filtering and timing.
+// Output duties, calibration and maintenance stay at the console.
+static const char *const remote_commands[] = {
+    "set_threshold",
+    "set_filter",
+    "set_comp_curve",
+    "set_temp_coeff",
+    "set_schedule",
+    "set_fleet_interval",
+};
+
+/**
+ * @brief Print the dimming curve in set_dimming syntax
+ */
+static void print_dimming_curve(const dimming_curve_t *curve)
+{
+    if (curve->count == 0) {
+        printf("battery bands (set_pwm duties)\n");
+        return;
+    }
+    if (curve->input == DIMMING_INPUT_SOC) {
+        printf("--soc ");
+        for (int i = 0; i < curve->count; i++) {
+            printf("%u.%u:%u ", curve->point[i].mv / 10, curve->point[i].mv % 10,
+                   curve->point[i].duty);
+        }
+        printf("(hysteresis %u.%u%%)\n", curve->hysteresis_mv / 10, curve->hysteresis_mv % 10);
+        return;
+    }
+    for (int i = 0; i < curve->count; i++) {
+        printf("%u:%u ", curve->point[i].mv, curve->point[i].duty);
+    }
+    printf("(hysteresis %u mV)\n", curve->hysteresis_mv);
+}
+
+/**
+ * @brief Print the night schedule in set_schedule syntax
+ */
+static void print_schedule(const schedule_config_t *schedule)
+{
+    if (!schedule->enabled) {
+        printf("off\n");
+        return;
+    }
+    for (int i = 0; i < schedule->count; i++) {
+        printf("%u:%u ", schedule->segment[i].start_min, schedule->segment[i].level);
+    }
+    printf("(day %u%%, dusk < %u mV, dawn > %u mV, confirm %u min)\n",
+           schedule->day_level, schedule->dusk_mv, schedule->dawn_mv, schedule->confirm_min);
+}
+
 /**
  * @brief 'status' command - Display current system status
  */
@@ -28,221 +97,1318 @@ static int cmd_status(int argc, char **argv)
     printf("=== Solar Battery Controller Status ===\n");
     printf("\n");
     
-    // Battery and temperature
-    uint32_t battery_mv = adc_get_battery_voltage_now();
-    float temp_c = adc_get_temperature_now();
+    // Battery and temperature (from the shared snapshot, no ADC access)
+    adc_reading_t reading;
+    float temp_c;
+    bool fresh = adc_get_latest_reading(&reading, ADC_READING_MAX_AGE_MS);
+    adc_get_latest_temperature(&temp_c, ADC_READING_MAX_AGE_MS);
+    uint32_t battery_mv = reading.battery_voltage_mv;
+    uint32_t age_ms = xTaskGetTickCount() * portTICK_PERIOD_MS - reading.timestamp_ms;
     
     printf("Battery:\n");
     printf("  Voltage: %u mV (%.2f V)\n", (unsigned int)battery_mv, battery_mv / 1000.0f);
     printf("  Temperature: %.1f °C\n", temp_c);
+    printf("  Sample Age: %u ms%s\n", (unsigned int)age_ms, fresh ? "" : " (STALE)");
+    if (reading.soc_permille != ADC_SOC_UNKNOWN) {
+        printf("  Current: %ld mA (%s)\n", (long)reading.current_ma,
+               reading.current_ma >= 0 ? "charging" : "discharging");
+        printf("  State of Charge: %u.%u%%\n",
+               reading.soc_permille / 10, reading.soc_permille % 10);
+        printf("  Charge Cycles: %u since boot\n", (unsigned int)adc_get_charge_cycles());
+    }
+    printf("\n");
+    
+    // Per-channel status
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        // State, voltage and thresholds of the same reading
+        channel_state_t state;
+        channel_get_snapshot(ch, &state);
+        printf("Channel %d:\n", ch);
+        printf("  State: %s\n", state.output_state ? "ON" : "OFF");
+        printf("  Filtered Voltage: %ld mV (%.2f V)\n",
+               (long)state.filtered_voltage, state.filtered_voltage / 1000.0f);
+        printf("  Threshold ON: %ld mV (compensated %ld mV)\n",
+               nvs_get_ch_th_on(ch), (long)state.th_on_mv);
+        printf("  Threshold OFF: %ld mV (compensated %ld mV)\n",
+               nvs_get_ch_th_off(ch), (long)state.th_off_mv);
+        filter_config_t filter;
+        nvs_get_ch_filter(ch, &filter);
+        printf("  Filter: %s %u", filter_type_name(filter.type), filter.length);
+        if (filter.median > 1) {
+            printf(" after median-of-%u", filter.median);
+        }
+        printf("\n");
+        printf("  Compensation: %s\n", comp_curve_name(nvs_get_ch_comp_curve(ch)));
+        printf("\n");
+    }
+    
+    // Hardware control state
+    hw_control_t hw_state = {0};
+    printf("Hardware:%s\n", control_get_state(&hw_state) ? "" : " (hw_mutex busy, state not read)");
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        printf("  CH%d Output: %s\n", ch, hw_state.ch_state[ch] ? "ON" : "OFF");
+    }
+    printf("  PWM Duty: %d%%%s\n", hw_state.pwm_duty, hw_state.fading_mask ? " (ramping)" : "");
+    printf("  Motion Detected: %s\n", hw_state.motion_detected ? "YES" : "no");
+    printf("  Schedule: %s, level %u%%\n", hw_state.night ? "night" : "day", hw_state.schedule_level);
+    printf("  Charger Status: %s\n", control_get_charger_status() ? "CHARGING" : "not charging");
+    printf("\n");
+    
+    // Sample ring consumers
+    printf("Sample Ring:\n");
+    for (int i = 0; i < sample_ring_reader_count(); i++) {
+        sample_ring_reader_info_t info;
+        if (sample_ring_get_reader_info(i, &info)) {
+            printf("  %s: received=%u, overruns=%u, lag=%u\n",
+                   info.name,
+                   (unsigned int)info.received,
+                   (unsigned int)info.overruns,
+                   (unsigned int)info.lag);
+        }
+    }
+    printf("\n");
+    
+    // Configuration
+    printf("Configuration:\n");
+    printf("  Temp Coefficient: %.3f\n", nvs_get_temp_coefficient());
+    printf("  PWM Half Duty: %d%%\n", nvs_get_pwm_half_duty());
+    printf("  PWM Full Duty: %d%%\n", nvs_get_pwm_full_duty());
+    printf("  Motion Timeout: %u ms\n", (unsigned int)nvs_get_motion_timeout());
+    dimming_curve_t curve;
+    nvs_get_dimming_curve(&curve);
+    printf("  Dimming: ");
+    print_dimming_curve(&curve);
+    schedule_config_t schedule;
+    nvs_get_schedule(&schedule);
+    printf("  Schedule: ");
+    print_schedule(&schedule);
+    printf("\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'tasks' command - Show per-task execution time and jitter
+ */
+static struct {
+    struct arg_lit *reset;
+    struct arg_end *end;
+} tasks_args;
+
+static int cmd_tasks(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&tasks_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, tasks_args.end, argv[0]);
+        return 1;
+    }
+    
+    if (tasks_args.reset->count > 0) {
+        task_stats_reset();
+        printf("Task statistics will be cleared at each task's next activation\n");
+        return 0;
+    }
+    
+    printf("\n");
+    printf("=== Task Timing (CLI on core %d) ===\n", xPortGetCoreID());
+    printf("%-10s %4s %10s %8s %8s %8s %8s %6s %6s\n",
+           "Task", "Core", "Period", "Runs", "WCET", "Avg", "Jitter", "Miss", "Load");
+    
+    for (int i = 0; i < task_stats_count(); i++) {
+        task_stats_info_t info;
+        if (!task_stats_get(i, &info)) {
+            continue;
+        }
+        
+        // Worst-case share of the period consumed by one activation
+        float load_pct = info.period_us ? (100.0f * info.exec_max_us) / info.period_us : 0.0f;
+        
+        char period[12];
+        if (info.period_us) {
+            snprintf(period, sizeof(period), "%ums", (unsigned int)(info.period_us / 1000));
+        } else {
+            snprintf(period, sizeof(period), "event");
+        }
+        
+        printf("%-10s %4d %10s %8u %6uus %6uus %6uus %6u %5.1f%%\n",
+               info.name,
+               info.core_id,
+               period,
+               (unsigned int)info.activations,
+               (unsigned int)info.exec_max_us,
+               (unsigned int)info.exec_avg_us,
+               (unsigned int)info.jitter_max_us,
+               (unsigned int)info.deadline_misses,
+               load_pct);
+    }
+    printf("\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'perf' command - Show sample-to-PWM latency and pipeline drops
+ */
+static struct {
+    struct arg_lit *reset;
+    struct arg_end *end;
+} perf_args;
+
+static int cmd_perf(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&perf_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, perf_args.end, argv[0]);
+        return 1;
+    }
+    
+    if (perf_args.reset->count > 0) {
+        perf_reset();
+        printf("Pipeline statistics cleared\n");
+        return 0;
+    }
+    
+    float window_s = perf_elapsed_us() / 1000000.0f;
+    perf_stage_info_t info;
+    
+    printf("\n");
+    printf("=== Pipeline Latency from ADC Conversion (%.1f s window) ===\n", window_s);
+    printf("%-10s %8s %8s %8s %8s %8s\n", "Stage", "Count", "Min", "P50", "P99", "Max");
+    
+    for (int s = 0; s < PERF_STAGE_COUNT; s++) {
+        if (!perf_get_stage((perf_stage_t)s, &info)) {
+            continue;
+        }
+        printf("%-10s %8u %6uus %6uus %6uus %6uus\n",
+               info.name,
+               (unsigned int)info.count,
+               (unsigned int)info.min_us,
+               (unsigned int)info.p50_us,
+               (unsigned int)info.p99_us,
+               (unsigned int)info.max_us);
+    }
+    
+    // Throughput: readings published and outputs updated per second
+    perf_stage_info_t pwm;
+    perf_get_stage(PERF_STAGE_SAMPLE, &info);
+    perf_get_stage(PERF_STAGE_PWM, &pwm);
+    if (window_s > 0.0f) {
+        printf("Throughput: %.1f samples/s, %.2f PWM updates/s\n",
+               info.count / window_s, pwm.count / window_s);
+    }
+    printf("\n");
+    
+    printf("Queues (high-water / capacity):\n");
+    for (int q = 0; q < PERF_QUEUE_COUNT; q++) {
+        perf_queue_info_t queue;
+        if (perf_get_queue((perf_queue_t)q, &queue)) {
+            printf("  %-12s %u / %u\n", queue.name,
+                   (unsigned int)queue.high_water, (unsigned int)queue.capacity);
+        }
+    }
+    printf("\n");
+    
+    printf("Drops:\n");
+    for (int d = 0; d < PERF_DROP_COUNT; d++) {
+        const char *name = NULL;
+        uint32_t count = perf_get_drops((perf_drop_t)d, &name);
+        printf("  %-12s %u\n", name ? name : "?", (unsigned int)count);
+    }
+    printf("\n");
+    
+    printf("Output writes:\n");
+    for (int c = 0; c < PERF_COUNT_COUNT; c++) {
+        const char *name = NULL;
+        uint32_t count = perf_get_count((perf_count_t)c, &name);
+        printf("  %-12s %u\n", name ? name : "?", (unsigned int)count);
+    }
+    printf("\n");
+    
+    // Deferred log pipeline (since boot, not cleared by -r)
+    rtlog_stats_t log_stats;
+    rtlog_get_stats(&log_stats);
+    printf("Deferred log: %u queued, %u printed, %u coalesced, %u dropped, high-water %u / %d\n",
+           (unsigned int)log_stats.written,
+           (unsigned int)log_stats.emitted,
+           (unsigned int)log_stats.coalesced,
+           (unsigned int)log_stats.dropped,
+           (unsigned int)log_stats.high_water,
+           RTLOG_SLOTS);
+    printf("\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'mem' command - Show task stack high-water marks and heap fragmentation
+ */
+static int cmd_mem(int argc, char **argv)
+{
+    printf("\n");
+    printf("=== Task Stacks (%s allocation) ===\n", RTOS_STATIC_ALLOCATION ? "static" : "heap");
+    printf("%-16s %6s %8s %6s %6s\n", "Task", "Stack", "MinFree", "Used", "Alloc");
+    
+    for (int i = 0; i < mem_stats_task_count(); i++) {
+        mem_task_info_t info;
+        if (!mem_stats_get_task(i, &info)) {
+            continue;
+        }
+        
+        // Peak share of the stack ever touched since the task started
+        float used_pct = info.stack_bytes ?
+            100.0f * (info.stack_bytes - info.stack_free_min) / info.stack_bytes : 0.0f;
+        
+        printf("%-16s %6u %8u %5.1f%% %6s%s\n",
+               info.name,
+               (unsigned int)info.stack_bytes,
+               (unsigned int)info.stack_free_min,
+               used_pct,
+               info.static_alloc ? "static" : "heap",
+               info.stack_free_min < MEM_STACK_LOW_BYTES ? "  LOW" : "");
+    }
+    printf("\n");
+    
+    mem_heap_info_t heap;
+    mem_stats_get_heap(&heap);
+    printf("Stacks: %u bytes static, %u bytes heap\n",
+           (unsigned int)heap.static_stack_bytes, (unsigned int)heap.heap_stack_bytes);
+    printf("Heap: %u free (min %u), largest block %u, %u%% fragmented\n",
+           (unsigned int)heap.free_bytes,
+           (unsigned int)heap.free_min_bytes,
+           (unsigned int)heap.largest_block,
+           (unsigned int)heap.fragmentation_pct);
+    printf("Heap blocks: %u allocated, %u free\n",
+           (unsigned int)heap.allocated_blocks, (unsigned int)heap.free_blocks);
     printf("\n");
     
-    // Channel 0 status
-    bool ch0_state = channel_get_state(0);
-    int32_t ch0_voltage = channel_get_filtered_voltage(0);
-    printf("Channel 0:\n");
-    printf("  State: %s\n", ch0_state ? "ON" : "OFF");
-    printf("  Filtered Voltage: %ld mV (%.2f V)\n", ch0_voltage, ch0_voltage / 1000.0f);
-    printf("  Threshold ON: %ld mV\n", nvs_get_ch0_th_on());
-    printf("  Threshold OFF: %ld mV\n", nvs_get_ch0_th_off());
+    return 0;
+}
+
+/**
+ * @brief 'power' command - Show CPU frequency range, sample interval and sleep residency
+ */
+static struct {
+    struct arg_lit *reset;
+    struct arg_lit *locks;
+    struct arg_end *end;
+} power_args;
+
+static int cmd_power(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&power_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, power_args.end, argv[0]);
+        return 1;
+    }
+    
+    if (power_args.reset->count > 0) {
+        power_reset_stats();
+        printf("Sleep residency cleared\n");
+        return 0;
+    }
+    
+    power_stats_t stats;
+    power_get_stats(&stats);
+    uint32_t interval = adc_get_sample_interval_ms();
+    float window_s = stats.window_us / 1000000.0f;
+    
+    printf("\n");
+    printf("=== Power (%.1f s window) ===\n", window_s);
+    if (stats.light_sleep) {
+        printf("  CPU: %u-%u MHz, automatic light sleep\n",
+               (unsigned int)stats.min_freq_mhz, (unsigned int)stats.max_freq_mhz);
+    } else {
+        printf("  CPU: %u MHz, light sleep off\n", (unsigned int)stats.max_freq_mhz);
+    }
+    printf("  Sample Interval: %u ms (%s)\n", (unsigned int)interval,
+           interval > ADC_SAMPLE_INTERVAL_MS ? "inputs settled" : "normal");
+    if (stats.light_sleep) {
+        float slept_s = stats.slept_us / 1000000.0f;
+        printf("  Light Sleep: %.1f s (%.1f%%), %u entries, avg %u ms, longest %u ms\n",
+               slept_s,
+               stats.window_us ? (100.0f * stats.slept_us) / stats.window_us : 0.0f,
+               (unsigned int)stats.sleeps,
+               (unsigned int)(stats.sleeps ? stats.slept_us / stats.sleeps / 1000 : 0),
+               (unsigned int)(stats.longest_us / 1000));
+    }
+    printf("\n");
+    
+    if (power_args.locks->count > 0) {
+        power_dump_locks();
+        printf("\n");
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 'set_threshold' command - Set channel thresholds
+ */
+static struct {
+    struct arg_int *channel;
+    struct arg_int *th_on;
+    struct arg_int *th_off;
+    struct arg_end *end;
+} set_threshold_args;
+
+static int cmd_set_threshold(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&set_threshold_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, set_threshold_args.end, argv[0]);
+        return 1;
+    }
+    
+    int channel = set_threshold_args.channel->ival[0];
+    int th_on_mv = set_threshold_args.th_on->ival[0];
+    int th_off_mv = set_threshold_args.th_off->ival[0];
+    
+    // Validate inputs
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        printf("Error: Channel must be 0 to %d\n", CHANNEL_COUNT - 1);
+        return 1;
+    }
+    
+    if (th_on_mv <= th_off_mv) {
+        printf("Error: ON threshold must be greater than OFF threshold\n");
+        return 1;
+    }
+    
+    if (th_on_mv < 0 || th_on_mv > 20000) {
+        printf("Error: ON threshold out of range (0-20000 mV)\n");
+        return 1;
+    }
+    
+    if (th_off_mv < 0 || th_off_mv > 20000) {
+        printf("Error: OFF threshold out of range (0-20000 mV)\n");
+        return 1;
+    }
+    
+    // Set thresholds
+    nvs_set_ch_thresholds(channel, th_on_mv, th_off_mv);
+    
+    // Save to NVS
+    nvs_save_config();
+    
+    printf("Channel %d thresholds set: ON=%d mV, OFF=%d mV\n", channel, th_on_mv, th_off_mv);
+    printf("Configuration queued for NVS write-back\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'set_filter' command - Select a channel's input filter
+ */
+static struct {
+    struct arg_int *channel;
+    struct arg_str *type;
+    struct arg_int *length;
+    struct arg_int *median;
+    struct arg_end *end;
+} set_filter_args;
+
+static int cmd_set_filter(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&set_filter_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, set_filter_args.end, argv[0]);
+        return 1;
+    }
+    
+    int channel = set_filter_args.channel->ival[0];
+    const char *type = set_filter_args.type->sval[0];
+    int length = set_filter_args.length->count ? set_filter_args.length->ival[0] : 0;
+    int median = set_filter_args.median->count ? set_filter_args.median->ival[0] : 0;
+    
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        printf("Error: Channel must be 0 to %d\n", CHANNEL_COUNT - 1);
+        return 1;
+    }
+    
+    filter_config_t filter = {0};
+    if (strcmp(type, filter_type_name(FILTER_BOXCAR)) == 0) {
+        filter.type = FILTER_BOXCAR;
+    } else if (strcmp(type, filter_type_name(FILTER_EMA)) == 0) {
+        filter.type = FILTER_EMA;
+    } else {
+        printf("Error: Filter must be 'boxcar' or 'ema'\n");
+        return 1;
+    }
+    
+    if (length < 0 || length > FILTER_MAX_LENGTH) {
+        printf("Error: Length out of range (1-%d samples)\n", FILTER_MAX_LENGTH);
+        return 1;
+    }
+    if (median < 0 || median > FILTER_MAX_MEDIAN || (median > 1 && (median & 1) == 0)) {
+        printf("Error: Median window must be 0 (off) or odd, up to %d\n", FILTER_MAX_MEDIAN);
+        return 1;
+    }
+    filter.length = (uint8_t)length;
+    filter.median = (uint8_t)median;
+    
+    if (!nvs_set_ch_filter(channel, &filter)) {
+        printf("Error: Failed to update the filter\n");
+        return 1;
+    }
+    nvs_save_config();
+    
+    nvs_get_ch_filter(channel, &filter);
+    printf("Channel %d filter set: %s %u", channel, filter_type_name(filter.type), filter.length);
+    if (filter.median > 1) {
+        printf(" after median-of-%u", filter.median);
+    }
+    printf("\n");
+    printf("Configuration queued for NVS write-back\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'set_comp_curve' command - Select a channel's compensation curve
+ */
+static struct {
+    struct arg_int *channel;
+    struct arg_str *curve;
+    struct arg_end *end;
+} set_comp_curve_args;
+
+static int cmd_set_comp_curve(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&set_comp_curve_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, set_comp_curve_args.end, argv[0]);
+        return 1;
+    }
+    
+    int channel = set_comp_curve_args.channel->ival[0];
+    const char *name = set_comp_curve_args.curve->sval[0];
+    
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        printf("Error: Channel must be 0 to %d\n", CHANNEL_COUNT - 1);
+        return 1;
+    }
+    
+    comp_curve_t curve = COMP_CURVE_COUNT;
+    for (int c = 0; c < COMP_CURVE_COUNT; c++) {
+        if (strcmp(name, comp_curve_name((comp_curve_t)c)) == 0) {
+            curve = (comp_curve_t)c;
+        }
+    }
+    if (curve == COMP_CURVE_COUNT) {
+        printf("Error: Curve must be 'linear', 'lead-acid' or 'lithium'\n");
+        return 1;
+    }
+    
+    if (!nvs_set_ch_comp_curve(channel, curve)) {
+        printf("Error: Failed to update the compensation curve\n");
+        return 1;
+    }
+    nvs_save_config();
+    
+    printf("Channel %d compensation curve set: %s\n", channel, comp_curve_name(curve));
+    printf("Configuration queued for NVS write-back\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'set_temp_coeff' command - Set temperature coefficient
+ */
+static struct {
+    struct arg_dbl *coefficient;
+    struct arg_end *end;
+} set_temp_coeff_args;
+
+static int cmd_set_temp_coeff(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&set_temp_coeff_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, set_temp_coeff_args.end, argv[0]);
+        return 1;
+    }
+    
+    float coeff = (float)set_temp_coeff_args.coefficient->dval[0];
+    
+    // Validate range (typically -0.1 to 0.1)
+    if (coeff < -0.1f || coeff > 0.1f) {
+        printf("Error: Coefficient out of range (-0.1 to 0.1)\n");
+        return 1;
+    }
+    
+    nvs_set_temp_coefficient(coeff);
+    nvs_save_config();
+    
+    printf("Temperature coefficient set to %.3f\n", coeff);
+    printf("Configuration queued for NVS write-back\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'set_pwm' command - Set PWM duty cycles
+ */
+static struct {
+    struct arg_int *half;
+    struct arg_int *full;
+    struct arg_end *end;
+} set_pwm_args;
+
+static int cmd_set_pwm(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&set_pwm_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, set_pwm_args.end, argv[0]);
+        return 1;
+    }
+    
+    int half_duty = set_pwm_args.half->ival[0];
+    int full_duty = set_pwm_args.full->ival[0];
+    
+    // Validate range
+    if (half_duty < 0 || half_duty > 100) {
+        printf("Error: Half duty out of range (0-100%%)\n");
+        return 1;
+    }
+    
+    if (full_duty < 0 || full_duty > 100) {
+        printf("Error: Full duty out of range (0-100%%)\n");
+        return 1;
+    }
+    
+    if (half_duty > full_duty) {
+        printf("Error: Half duty should be less than or equal to full duty\n");
+        return 1;
+    }
+    
+    nvs_set_pwm_duties((uint8_t)half_duty, (uint8_t)full_duty);
+    nvs_save_config();
+    
+    printf("PWM duties set: Half=%d%%, Full=%d%%\n", half_duty, full_duty);
+    printf("Configuration queued for NVS write-back\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'set_dimming' command - Set the battery voltage to duty curve
+ */
+static struct {
+    struct arg_lit *soc;
+    struct arg_str *points;
+    struct arg_int *hysteresis;
+    struct arg_end *end;
+} set_dimming_args;
+
+static int cmd_set_dimming(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&set_dimming_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, set_dimming_args.end, argv[0]);
+        return 1;
+    }
+    
+    dimming_curve_t curve = {0};
+    int count = set_dimming_args.points->count;
+    bool soc = set_dimming_args.soc->count > 0;
+    
+    // SoC curves take whole percent on the command line, 0.1 % units stored
+    if (count == 1 && strcmp(set_dimming_args.points->sval[0], "bands") == 0) {
+        count = 0;
+    } else {
+        for (int i = 0; i < count; i++) {
+            unsigned int input, duty;
+            char extra;
+            if (sscanf(set_dimming_args.points->sval[i], "%u:%u%c", &input, &duty, &extra) != 2 ||
+                input > (soc ? 100 : UINT16_MAX) || duty > 100) {
+                printf("Error: Point '%s' must be <%s>:<duty 0-100>\n",
+                       set_dimming_args.points->sval[i], soc ? "SoC 0-100" : "mV");
+                return 1;
+            }
+            curve.point[i].mv = (uint16_t)(soc ? input * 10 : input);
+            curve.point[i].duty = (uint8_t)duty;
+        }
+    }
+    curve.count = (uint8_t)count;
+    curve.input = soc ? DIMMING_INPUT_SOC : DIMMING_INPUT_VOLTAGE;
+    
+    int hysteresis = set_dimming_args.hysteresis->count ? set_dimming_args.hysteresis->ival[0] : 0;
+    if (soc) {
+        hysteresis *= 10;
+    }
+    if (hysteresis < 0 || hysteresis > DIMMING_MAX_HYSTERESIS_MV) {
+        printf("Error: Hysteresis out of range (0-%d mV, or 0-100%% with --soc)\n",
+               DIMMING_MAX_HYSTERESIS_MV);
+        return 1;
+    }
+    curve.hysteresis_mv = (uint16_t)hysteresis;
+    
+    if (curve.count != 0 && !control_logic_curve_valid(&curve)) {
+        printf("Error: Points must be in strictly ascending order\n");
+        return 1;
+    }
+    
+    if (!nvs_set_dimming_curve(&curve)) {
+        printf("Error: Failed to update the dimming curve%s\n",
+               soc ? " (SoC curves need CONFIG_SOLAR_CURRENT_SENSE)" : "");
+        return 1;
+    }
+    nvs_save_config();
+    
+    printf("Dimming curve set: ");
+    print_dimming_curve(&curve);
+    printf("Configuration queued for NVS write-back\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'set_schedule' command - Set the night schedule
+ */
+static struct {
+    struct arg_str *segments;
+    struct arg_int *day_level;
+    struct arg_int *dusk;
+    struct arg_int *dawn;
+    struct arg_int *confirm;
+    struct arg_end *end;
+} set_schedule_args;
+
+static int cmd_set_schedule(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&set_schedule_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, set_schedule_args.end, argv[0]);
+        return 1;
+    }
+    
+    // Options not given keep their configured values
+    schedule_config_t schedule;
+    nvs_get_schedule(&schedule);
+    int count = set_schedule_args.segments->count;
+    
+    if (count == 1 && strcmp(set_schedule_args.segments->sval[0], "off") == 0) {
+        schedule.enabled = 0;
+    } else {
+        for (int i = 0; i < count; i++) {
+            unsigned int start, level;
+            char extra;
+            if (sscanf(set_schedule_args.segments->sval[i], "%u:%u%c", &start, &level, &extra) != 2 ||
+                start > UINT16_MAX || level > 100) {
+                printf("Error: Segment '%s' must be <minutes after dusk>:<level 0-100>\n",
+                       set_schedule_args.segments->sval[i]);
+                return 1;
+            }
+            schedule.segment[i].start_min = (uint16_t)start;
+            schedule.segment[i].level = (uint8_t)level;
+        }
+        schedule.count = (uint8_t)count;
+        schedule.enabled = 1;
+    }
+    
+    if (set_schedule_args.day_level->count) {
+        int level = set_schedule_args.day_level->ival[0];
+        if (level < 0 || level > 100) {
+            printf("Error: Day level out of range (0-100%%)\n");
+            return 1;
+        }
+        schedule.day_level = (uint8_t)level;
+    }
+    struct {
+        struct arg_int *arg;
+        uint16_t *value;
+    } const options[] = {
+        { set_schedule_args.dusk, &schedule.dusk_mv },
+        { set_schedule_args.dawn, &schedule.dawn_mv },
+        { set_schedule_args.confirm, &schedule.confirm_min },
+    };
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++) {
+        if (options[i].arg->count) {
+            int value = options[i].arg->ival[0];
+            if (value < 0 || value > UINT16_MAX) {
+                printf("Error: Dusk, dawn and confirm time must be 0-%u\n", UINT16_MAX);
+                return 1;
+            }
+            *options[i].value = (uint16_t)value;
+        }
+    }
+    
+    if (!schedule_config_valid(&schedule)) {
+        printf("Error: Segments must start at 0 in ascending order, with dawn above dusk\n");
+        return 1;
+    }
+    
+    if (!nvs_set_schedule(&schedule)) {
+        printf("Error: Failed to update the schedule\n");
+        return 1;
+    }
+    nvs_save_config();
+    
+    printf("Schedule set: ");
+    print_schedule(&schedule);
+    printf("Configuration queued for NVS write-back\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'motion' command - Trigger motion detection manually
+ */
+static int cmd_motion(int argc, char **argv)
+{
+    control_trigger_motion();
+    printf("Motion detection triggered manually\n");
+    printf("Lights will stay at full brightness for %lu seconds\n", 
+           nvs_get_motion_timeout() / 1000);
+    return 0;
+}
+
+/**
+ * @brief 'dump_verification' command - Display verification data
+ */
+static int cmd_dump_verification(int argc, char **argv)
+{
+    nvs_load_verification(&g_verification_data);
+    
     printf("\n");
+    printf("=== Verification Data ===\n");
+    printf("  Total Cycles: %u\n", (unsigned int)g_verification_data.total_cycles);
+    printf("  Last Voltage: %u mV (%.2f V)\n", 
+           (unsigned int)g_verification_data.last_voltage_mv,
+           g_verification_data.last_voltage_mv / 1000.0f);
+    printf("  Uptime Hours: %u\n", (unsigned int)g_verification_data.uptime_hours);
+    printf("  Charge Cycles: %u\n", (unsigned int)g_verification_data.charge_cycles);
+    printf("\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'samplelog' command - Recorder status, flush or binary dump
+ */
+static struct {
+    struct arg_lit *dump;
+    struct arg_lit *flush;
+    struct arg_end *end;
+} samplelog_args;
+
+/**
+ * @brief Stream the sample log as raw pages on the console UART
+ *
+ * Framed by text lines so a capture script can find the binary part:
+ *   SAMPLELOG BEGIN <pages> <page_size>\n <pages * page_size bytes> \nSAMPLELOG END\n
+ * Logging is silenced for the duration so no text lands inside the stream.
+ */
+static int samplelog_dump_binary(void)
+{
+    samplelog_dump_t plan;
+    if (!samplelog_dump_prepare(&plan)) {
+        printf("Sample log not available\n");
+        return 1;
+    }
+    
+    esp_log_level_t log_level = esp_log_level_get("*");
+    esp_log_level_set("*", ESP_LOG_NONE);
+    
+    printf("SAMPLELOG BEGIN %u %u\n", (unsigned int)plan.total, (unsigned int)SAMPLELOG_PAGE_SIZE);
+    fflush(stdout);
+    
+    // The driver bypasses the VFS CRLF translation that would corrupt binary data
+    static const uint8_t erased[SAMPLELOG_PAGE_SIZE];
+    for (uint32_t n = 0; n < plan.total; n++) {
+        const samplelog_page_t *page = samplelog_dump_page(&plan, n);
+        
+        // Keep the framing intact: a page that cannot be read goes out as zeros
+        const void *data = page ? (const void *)page : (const void *)erased;
+        uart_write_bytes(CONFIG_ESP_CONSOLE_UART_NUM, data, sizeof(samplelog_page_t));
+        if (sizeof(samplelog_page_t) < SAMPLELOG_PAGE_SIZE) {
+            uart_write_bytes(CONFIG_ESP_CONSOLE_UART_NUM, erased,
+                             SAMPLELOG_PAGE_SIZE - sizeof(samplelog_page_t));
+        }
+    }
+    uart_wait_tx_done(CONFIG_ESP_CONSOLE_UART_NUM, portMAX_DELAY);
+    
+    printf("\nSAMPLELOG END\n");
+    fflush(stdout);
+    
+    esp_log_level_set("*", log_level);
+    
+    return 0;
+}
+
+static int cmd_samplelog(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&samplelog_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, samplelog_args.end, argv[0]);
+        return 1;
+    }
+    
+    if (samplelog_args.dump->count > 0) {
+        return samplelog_dump_binary();
+    }
+    
+    if (samplelog_args.flush->count > 0) {
+        esp_err_t err = samplelog_flush();
+        if (err != ESP_OK) {
+            printf("Flush failed: %s\n", esp_err_to_name(err));
+            return 1;
+        }
+        printf("Staging page written to flash\n");
+        return 0;
+    }
     
-    // Channel 1 status
-    bool ch1_state = channel_get_state(1);
-    int32_t ch1_voltage = channel_get_filtered_voltage(1);
-    printf("Channel 1:\n");
-    printf("  State: %s\n", ch1_state ? "ON" : "OFF");
-    printf("  Filtered Voltage: %ld mV (%.2f V)\n", ch1_voltage, ch1_voltage / 1000.0f);
-    printf("  Threshold ON: %ld mV\n", nvs_get_ch1_th_on());
-    printf("  Threshold OFF: %ld mV\n", nvs_get_ch1_th_off());
-    printf("\n");
+    samplelog_info_t info;
+    samplelog_get_info(&info);
     
-    // Hardware control state
-    hw_control_t hw_state;
-    control_get_state(&hw_state);
-    printf("Hardware:\n");
-    printf("  CH0 Output: %s\n", hw_state.ch0_state ? "ON" : "OFF");
-    printf("  CH1 Output: %s\n", hw_state.ch1_state ? "ON" : "OFF");
-    printf("  PWM Duty: %d%%\n", hw_state.pwm_duty);
-    printf("  Motion Detected: %s\n", hw_state.motion_detected ? "YES" : "no");
-    printf("  Charger Status: %s\n", control_get_charger_status() ? "CHARGING" : "not charging");
     printf("\n");
+    printf("=== Sample Log ===\n");
+    if (!info.available) {
+        printf("  Not available (no '%s' partition)\n", SAMPLELOG_PARTITION_LABEL);
+        printf("\n");
+        return 0;
+    }
     
-    // Configuration
-    printf("Configuration:\n");
-    printf("  Temp Coefficient: %.3f\n", nvs_get_temp_coefficient());
-    printf("  PWM Half Duty: %d%%\n", nvs_get_pwm_half_duty());
-    printf("  PWM Full Duty: %d%%\n", nvs_get_pwm_full_duty());
-    printf("  Motion Timeout: %u ms\n", (unsigned int)nvs_get_motion_timeout());
+    uint32_t held_s = info.pages_used * info.records_per_page * ADC_SAMPLE_INTERVAL_MS / 1000;
+    printf("  Pages Used: %u / %u (%u records each)\n",
+           (unsigned int)info.pages_used, (unsigned int)info.page_count,
+           (unsigned int)info.records_per_page);
+    printf("  History: %.1f h of %.1f h\n", held_s / 3600.0f, info.capacity_s / 3600.0f);
+    printf("  Staged Records: %u\n", (unsigned int)info.staged);
+    printf("  Pages Written (since boot): %u\n", (unsigned int)info.pages_written);
+    printf("  Sampling Gaps: %u\n", (unsigned int)info.gaps);
+    printf("  Write Errors: %u\n", (unsigned int)info.write_errors);
     printf("\n");
     
     return 0;
 }
 
 /**
- * @brief 'set_threshold' command - Set channel thresholds
+ * @brief 'stream' command - Binary telemetry on/off and status
  */
 static struct {
-    struct arg_int *channel;
-    struct arg_int *th_on;
-    struct arg_int *th_off;
+    struct arg_str *mode;
+    struct arg_int *rate;
     struct arg_end *end;
-} set_threshold_args;
+} stream_args;
 
-static int cmd_set_threshold(int argc, char **argv)
+// Log level to restore when the stream stops
+static esp_log_level_t stream_saved_log_level = ESP_LOG_INFO;
+
+static int cmd_stream(int argc, char **argv)
 {
-    int nerrors = arg_parse(argc, argv, (void **)&set_threshold_args);
+    int nerrors = arg_parse(argc, argv, (void **)&stream_args);
     if (nerrors != 0) {
-        arg_print_errors(stderr, set_threshold_args.end, argv[0]);
+        arg_print_errors(stderr, stream_args.end, argv[0]);
         return 1;
     }
     
-    int channel = set_threshold_args.channel->ival[0];
-    int th_on_mv = set_threshold_args.th_on->ival[0];
-    int th_off_mv = set_threshold_args.th_off->ival[0];
+    telemetry_info_t info;
+    telemetry_get_info(&info);
     
-    // Validate inputs
-    if (channel < 0 || channel > 1) {
-        printf("Error: Channel must be 0 or 1\n");
-        return 1;
+    const char *mode = stream_args.mode->count > 0 ? stream_args.mode->sval[0] : NULL;
+    
+    if (mode != NULL && strcmp(mode, "on") == 0) {
+        int rate = stream_args.rate->count > 0 ? stream_args.rate->ival[0] : CONFIG_SOLAR_TELEMETRY_RATE_HZ;
+        if (rate < 1 || rate > TELEMETRY_RATE_MAX_HZ) {
+            printf("Error: rate must be 1-%d Hz\n", TELEMETRY_RATE_MAX_HZ);
+            return 1;
+        }
+        
+        // Frames resynchronize around text, but INFO chatter wastes the link
+        if (!info.streaming) {
+            stream_saved_log_level = esp_log_level_get("*");
+            esp_log_level_set("*", ESP_LOG_WARN);
+        }
+        
+        esp_err_t err = telemetry_stream_start((uint32_t)rate);
+        if (err != ESP_OK) {
+            if (!info.streaming) {
+                esp_log_level_set("*", stream_saved_log_level);
+            }
+            printf("Error: failed to start stream: %s\n", esp_err_to_name(err));
+            return 1;
+        }
+        printf("Streaming %u-byte status frames at %d Hz\n",
+               (unsigned int)TELEMETRY_STATUS_FRAME_SIZE, rate);
+        return 0;
     }
     
-    if (th_on_mv <= th_off_mv) {
-        printf("Error: ON threshold must be greater than OFF threshold\n");
-        return 1;
+    if (mode != NULL && strcmp(mode, "off") == 0) {
+        telemetry_stream_stop();
+        if (info.streaming) {
+            esp_log_level_set("*", stream_saved_log_level);
+        }
+        printf("Stream stopped\n");
+        return 0;
     }
     
-    if (th_on_mv < 0 || th_on_mv > 20000) {
-        printf("Error: ON threshold out of range (0-20000 mV)\n");
+    if (mode != NULL) {
+        printf("Error: mode must be 'on' or 'off'\n");
         return 1;
     }
     
-    if (th_off_mv < 0 || th_off_mv > 20000) {
-        printf("Error: OFF threshold out of range (0-20000 mV)\n");
+    printf("\n");
+    printf("=== Telemetry Stream ===\n");
+    if (info.streaming) {
+        printf("  State: streaming at %u Hz\n", (unsigned int)info.rate_hz);
+    } else {
+        printf("  State: off\n");
+    }
+    printf("  Frame Size: %u bytes (type 0x%02x)\n",
+           (unsigned int)TELEMETRY_STATUS_FRAME_SIZE, TELEMETRY_TYPE_STATUS);
+    printf("  Frames Sent: %u (%u bytes)\n",
+           (unsigned int)info.frames_sent, (unsigned int)info.bytes_sent);
+    printf("  Output State Reused: %u\n", (unsigned int)info.hw_stale);
+    printf("\n");
+    
+    return 0;
+}
+
+/**
+ * @brief 'fleet' command - Show fleet upload status or upload now
+ */
+static struct {
+    struct arg_str *action;
+    struct arg_end *end;
+} fleet_args;
+
+static int cmd_fleet(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&fleet_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, fleet_args.end, argv[0]);
         return 1;
     }
     
-    // Set thresholds
-    if (channel == 0) {
-        nvs_set_ch0_thresholds(th_on_mv, th_off_mv);
-    } else {
-        nvs_set_ch1_thresholds(th_on_mv, th_off_mv);
+    const char *action = fleet_args.action->count > 0 ? fleet_args.action->sval[0] : NULL;
+    
+    if (action != NULL && strcmp(action, "now") == 0) {
+        esp_err_t err = fleet_trigger();
+        if (err != ESP_OK) {
+            printf("Error: fleet upload not available: %s\n", esp_err_to_name(err));
+            return 1;
+        }
+        printf("Upload started\n");
+        return 0;
     }
     
-    // Save to NVS
-    nvs_save_config();
+    if (action != NULL) {
+        printf("Error: action must be 'now'\n");
+        return 1;
+    }
     
-    printf("Channel %d thresholds set: ON=%d mV, OFF=%d mV\n", channel, th_on_mv, th_off_mv);
-    printf("Configuration saved to NVS\n");
+    fleet_info_t info;
+    fleet_get_info(&info);
+    
+    printf("\n");
+    printf("=== Fleet Upload ===\n");
+    if (!info.enabled) {
+        printf("  State: disabled\n");
+        printf("\n");
+        return 0;
+    }
+    printf("  Unit: %s\n", info.unit);
+    if (info.active) {
+        printf("  State: uploading\n");
+    } else {
+        printf("  State: idle, next upload in %u s\n", (unsigned int)info.next_in_s);
+    }
+    printf("  Interval: %u s\n", (unsigned int)info.interval_s);
+    printf("  Uploads: %u (%u failed)\n", (unsigned int)info.bursts, (unsigned int)info.bursts_failed);
+    printf("  Last Upload: connect %u ms, radio on %u ms\n",
+           (unsigned int)info.last_connect_ms, (unsigned int)info.last_radio_ms);
+    printf("  Pages Sent: %u (%u bytes), next page %u\n",
+           (unsigned int)info.pages_sent, (unsigned int)info.bytes_sent,
+           (unsigned int)info.next_sequence);
+    printf("  Config Pushes: %u applied, %u rejected\n",
+           (unsigned int)info.config_applied, (unsigned int)info.config_rejected);
+    printf("\n");
     
     return 0;
 }
 
 /**
- * @brief 'set_temp_coeff' command - Set temperature coefficient
+ * @brief 'set_fleet_interval' command - Set the time between fleet uploads
  */
 static struct {
-    struct arg_dbl *coefficient;
+    struct arg_int *interval;
     struct arg_end *end;
-} set_temp_coeff_args;
+} set_fleet_interval_args;
 
-static int cmd_set_temp_coeff(int argc, char **argv)
+static int cmd_set_fleet_interval(int argc, char **argv)
 {
-    int nerrors = arg_parse(argc, argv, (void **)&set_temp_coeff_args);
+    int nerrors = arg_parse(argc, argv, (void **)&set_fleet_interval_args);
     if (nerrors != 0) {
-        arg_print_errors(stderr, set_temp_coeff_args.end, argv[0]);
+        arg_print_errors(stderr, set_fleet_interval_args.end, argv[0]);
         return 1;
     }
     
-    float coeff = (float)set_temp_coeff_args.coefficient->dval[0];
-    
-    // Validate range (typically -0.1 to 0.1)
-    if (coeff < -0.1f || coeff > 0.1f) {
-        printf("Error: Coefficient out of range (-0.1 to 0.1)\n");
+    int interval_s = set_fleet_interval_args.interval->ival[0];
+    if (interval_s != 0 && (interval_s < FLEET_INTERVAL_MIN_S || interval_s > FLEET_INTERVAL_MAX_S)) {
+        printf("Error: interval must be %d-%d s, or 0 for the default\n",
+               FLEET_INTERVAL_MIN_S, FLEET_INTERVAL_MAX_S);
         return 1;
     }
     
-    nvs_set_temp_coefficient(coeff);
+    nvs_set_fleet_interval((uint32_t)interval_s);
     nvs_save_config();
     
-    printf("Temperature coefficient set to %.3f\n", coeff);
-    printf("Configuration saved to NVS\n");
+    if (interval_s == 0) {
+        printf("Fleet upload interval set to the default\n");
+    } else {
+        printf("Fleet upload interval set: %d s\n", interval_s);
+    }
+    printf("Configuration queued for NVS write-back\n");
     
     return 0;
 }
 
 /**
- * @brief 'set_pwm' command - Set PWM duty cycles
+ * @brief 'calibrate' command - Capture or show the unit's ADC calibration
  */
 static struct {
-    struct arg_int *half;
-    struct arg_int *full;
+    struct arg_str *input;
+    struct arg_dbl *reference;
+    struct arg_lit *clear;
     struct arg_end *end;
-} set_pwm_args;
+} calibrate_args;
 
-static int cmd_set_pwm(int argc, char **argv)
+// Previous point per input this session; the next one fits a line through both
+static adc_cal_point_t cal_previous[ADC_CAL_INPUT_COUNT];
+static bool cal_previous_valid[ADC_CAL_INPUT_COUNT];
+
+/**
+ * @brief Print the calibration profile
+ */
+static void print_calibration(const adc_cal_profile_t *profile)
 {
-    int nerrors = arg_parse(argc, argv, (void **)&set_pwm_args);
+    printf("\n");
+    printf("=== ADC Calibration ===\n");
+    for (int i = 0; i < ADC_CAL_INPUT_COUNT; i++) {
+        const adc_cal_line_t *line = &profile->line[i];
+        printf("  %-8s ", adc_cal_input_name((adc_cal_input_t)i));
+        if (!adc_cal_active(profile, (adc_cal_input_t)i)) {
+            printf("eFuse%s\n", i == ADC_CAL_BATTERY ? ", nominal divider" : "");
+            continue;
+        }
+        printf("%u-point, %.4f mV/count, offset %.1f mV\n", profile->points[i],
+               (double)line->gain_q16 / 65536.0, (double)line->offset_q16 / 65536.0);
+    }
+    if (profile->divider_q16 != 0) {
+        printf("  Measured divider: %.3f (nominal %.3f)\n",
+               (double)profile->divider_q16 / 65536.0, (double)SENSOR_DIVIDER_RATIO);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief Input value a reference corresponds to (battery mV, TMP36 or sensor pin mV)
+ */
+static bool calibration_target_mv(adc_cal_input_t input, double reference, uint32_t *mv)
+{
+    double target;
+    switch (input) {
+    case ADC_CAL_BATTERY:
+        if (reference < 1000.0 || reference > 40000.0) {
+            printf("Error: battery reference must be 1000-40000 mV\n");
+            return false;
+        }
+        target = reference;
+        break;
+    case ADC_CAL_TEMP:
+        if (reference < SENSOR_TEMP_MIN_C || reference > SENSOR_TEMP_MAX_C) {
+            printf("Error: temperature reference must be %d to %d C\n",
+                   SENSOR_TEMP_MIN_C, SENSOR_TEMP_MAX_C);
+            return false;
+        }
+        target = TMP36_OFFSET_MV + reference * TMP36_MV_PER_C;
+        break;
+    case ADC_CAL_CURRENT:
+    default:
+#if CONFIG_SOLAR_CURRENT_SENSE
+        target = CONFIG_SOLAR_CURRENT_ZERO_MV + reference * CONFIG_SOLAR_CURRENT_MV_PER_A / 1000.0;
+        if (target < 0.0 || target > 3300.0) {
+            printf("Error: current reference is outside the sensor range\n");
+            return false;
+        }
+        break;
+#else
+        printf("Error: current sensing is not enabled (CONFIG_SOLAR_CURRENT_SENSE)\n");
+        return false;
+#endif
+    }
+    
+    *mv = (uint32_t)(target + 0.5);
+    return true;
+}
+
+static int cmd_calibrate(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&calibrate_args);
     if (nerrors != 0) {
-        arg_print_errors(stderr, set_pwm_args.end, argv[0]);
+        arg_print_errors(stderr, calibrate_args.end, argv[0]);
         return 1;
     }
     
-    int half_duty = set_pwm_args.half->ival[0];
-    int full_duty = set_pwm_args.full->ival[0];
+    adc_cal_profile_t profile;
+    nvs_get_adc_cal(&profile);
     
-    // Validate range
-    if (half_duty < 0 || half_duty > 100) {
-        printf("Error: Half duty out of range (0-100%%)\n");
+    if (calibrate_args.input->count == 0) {
+        if (calibrate_args.clear->count > 0) {
+            memset(&profile, 0, sizeof(profile));
+            memset(cal_previous_valid, 0, sizeof(cal_previous_valid));
+            if (!nvs_set_adc_cal(&profile)) {
+                printf("Error: Failed to update the calibration\n");
+                return 1;
+            }
+            nvs_save_config();
+            printf("Calibration cleared: all inputs use the eFuse conversion\n");
+            printf("Configuration queued for NVS write-back\n");
+            return 0;
+        }
+        print_calibration(&profile);
+        return 0;
+    }
+    
+    adc_cal_input_t input = ADC_CAL_INPUT_COUNT;
+    for (int i = 0; i < ADC_CAL_INPUT_COUNT; i++) {
+        if (strcmp(calibrate_args.input->sval[0], adc_cal_input_name((adc_cal_input_t)i)) == 0) {
+            input = (adc_cal_input_t)i;
+        }
+    }
+    if (input == ADC_CAL_INPUT_COUNT) {
+        printf("Error: input must be 'battery', 'temp' or 'current'\n");
         return 1;
     }
     
-    if (full_duty < 0 || full_duty > 100) {
-        printf("Error: Full duty out of range (0-100%%)\n");
+    if (calibrate_args.clear->count > 0) {
+        memset(&profile.line[input], 0, sizeof(profile.line[input]));
+        profile.points[input] = 0;
+        if (input == ADC_CAL_BATTERY) {
+            profile.divider_q16 = 0;
+        }
+        cal_previous_valid[input] = false;
+        if (!nvs_set_adc_cal(&profile)) {
+            printf("Error: Failed to update the calibration\n");
+            return 1;
+        }
+        nvs_save_config();
+        printf("Calibration of %s cleared\n", adc_cal_input_name(input));
+        printf("Configuration queued for NVS write-back\n");
+        return 0;
+    }
+    
+    if (calibrate_args.reference->count == 0) {
+        printf("Error: reference value missing (battery mV, temp C, current mA)\n");
+        return 1;
+    }
+    adc_cal_point_t point;
+    if (!calibration_target_mv(input, calibrate_args.reference->dval[0], &point.mv)) {
         return 1;
     }
     
-    if (half_duty > full_duty) {
-        printf("Error: Half duty should be less than or equal to full duty\n");
+    printf("Measuring %s...\n", adc_cal_input_name(input));
+    adc_cal_sample_t sample;
+    if (!adc_calibration_capture(input, &sample)) {
+        printf("Error: ADC measurement failed\n");
         return 1;
     }
+    point.raw = sample.raw;
     
-    nvs_set_pwm_duties((uint8_t)half_duty, (uint8_t)full_duty);
+    adc_cal_line_t line;
+    uint8_t points = 1;
+    uint32_t divider_q16 = profile.divider_q16;
+    const adc_cal_point_t *previous = cal_previous_valid[input] ? &cal_previous[input] : NULL;
+    int32_t span = previous ? (int32_t)point.raw - (int32_t)previous->raw : 0;
+    
+    if (input == ADC_CAL_BATTERY) {
+        divider_q16 = adc_cal_divider_q16(point.mv, sample.pin_mv);
+    }
+    
+    if (previous != NULL && (span >= ADC_CAL_MIN_SPAN_RAW || span <= -ADC_CAL_MIN_SPAN_RAW)) {
+        if (!adc_cal_fit_two(&line, previous, &point)) {
+            printf("Error: points %u mV at raw %u and %u mV at raw %u do not fit a usable line\n",
+                   (unsigned int)previous->mv, (unsigned int)previous->raw,
+                   (unsigned int)point.mv, (unsigned int)point.raw);
+            return 1;
+        }
+        points = 2;
+    } else {
+        // One point: keep the eFuse slope, with the measured divider for the battery
+        int32_t gain_q16 = sample.nominal_gain_q16;
+        if (input == ADC_CAL_BATTERY && divider_q16 != 0) {
+            gain_q16 = (int32_t)((int64_t)gain_q16 * divider_q16 / SENSOR_DIVIDER_Q16);
+        }
+        if (!adc_cal_fit_one(&line, gain_q16, &point)) {
+            printf("Error: %u mV at raw %u is too far from the eFuse conversion (%u mV)\n",
+                   (unsigned int)point.mv, (unsigned int)point.raw,
+                   (unsigned int)sample.nominal_mv);
+            return 1;
+        }
+    }
+    
+    profile.line[input] = line;
+    profile.points[input] = points;
+    profile.divider_q16 = divider_q16;
+    if (!nvs_set_adc_cal(&profile)) {
+        printf("Error: Failed to update the calibration\n");
+        return 1;
+    }
     nvs_save_config();
     
-    printf("PWM duties set: Half=%d%%, Full=%d%%\n", half_duty, full_duty);
-    printf("Configuration saved to NVS\n");
+    cal_previous[input] = point;
+    cal_previous_valid[input] = true;
+    
+    printf("Raw %u: reference %u mV, was %u mV (eFuse %u mV), now %u mV\n",
+           (unsigned int)point.raw, (unsigned int)point.mv, (unsigned int)sample.calibrated_mv,
+           (unsigned int)sample.nominal_mv, (unsigned int)adc_cal_apply(&line, point.raw));
+    if (points == 1) {
+        printf("Offset corrected; a second point far from this one also fits the gain\n");
+    }
+    print_calibration(&profile);
+    printf("Configuration queued for NVS write-back\n");
     
     return 0;
 }
 
 /**
- * @brief 'motion' command - Trigger motion detection manually
- */
-static int cmd_motion(int argc, char **argv)
-{
-    control_trigger_motion();
-    printf("Motion detection triggered manually\n");
-    printf("Lights will stay at full brightness for %lu seconds\n", 
-           nvs_get_motion_timeout() / 1000);
-    return 0;
-}
-
-/**
- * @brief 'dump_verification' command - Display verification data
+ * @brief 'nvs_stats' command - Display NVS write-back and wear counters
  */
-static int cmd_dump_verification(int argc, char **argv)
+static int cmd_nvs_stats(int argc, char **argv)
 {
-    nvs_load_verification(&g_verification_data);
+    nvs_writeback_stats_t wb;
+    nvs_get_writeback_stats(&wb);
     
     printf("\n");
-    printf("=== Verification Data ===\n");
-    printf("  Total Cycles: %u\n", (unsigned int)g_verification_data.total_cycles);
-    printf("  Last Voltage: %u mV (%.2f V)\n", 
-           (unsigned int)g_verification_data.last_voltage_mv,
-           g_verification_data.last_voltage_mv / 1000.0f);
-    printf("  Uptime Hours: %u\n", (unsigned int)g_verification_data.uptime_hours);
-    printf("  Charge Cycles: %u\n", (unsigned int)g_verification_data.charge_cycles);
+    printf("=== NVS Write-back (since boot) ===\n");
+    printf("  Commits: %u\n", (unsigned int)wb.commits);
+    printf("  Keys Written: %u\n", (unsigned int)wb.keys_written);
+    printf("  Bytes Written: %u\n", (unsigned int)wb.bytes_written);
+    printf("  Coalesced Saves: %u\n", (unsigned int)wb.coalesced);
+    printf("  Failures: %u\n", (unsigned int)wb.failures);
+    printf("  Pending Keys: 0x%llx\n", (unsigned long long)wb.pending_mask);
+    
+    nvs_stats_t part;
+    if (nvs_get_stats(NULL, &part) == ESP_OK) {
+        printf("  Partition Entries: used=%u, free=%u, total=%u\n",
+               (unsigned int)part.used_entries,
+               (unsigned int)part.free_entries,
+               (unsigned int)part.total_entries);
+    }
+    printf("\n");
+    
+    printf("%-12s %8s %8s %s\n", "Key", "Commits", "Bytes", "State");
+    for (int i = 0; i < nvs_key_count(); i++) {
+        nvs_key_stats_t key;
+        if (!nvs_get_key_stats(i, &key)) {
+            continue;
+        }
+        printf("%-12s %8u %8u %s\n",
+               key.name,
+               (unsigned int)key.commits,
+               (unsigned int)key.bytes_written,
+               key.dirty ? "dirty" : "clean");
+    }
     printf("\n");
     
     return 0;
@@ -281,14 +1447,37 @@ static int cmd_help(int argc, char **argv)
     printf("System Status:\n");
     printf("  status                     - Display system status\n");
     printf("  dump_verification          - Show verification data\n");
+    printf("  tasks [-r]                 - Task core, WCET and jitter (-r resets)\n");
+    printf("  perf [-r]                  - Sample-to-PWM latency, queues, drops (-r resets)\n");
+    printf("  mem                        - Task stack high-water marks, heap fragmentation\n");
+    printf("  power [-r] [-l]            - Sleep residency and sample interval (-l locks)\n");
+    printf("  nvs_stats                  - NVS write-back and flash wear counters\n");
+    printf("  samplelog [-f|-d]          - Sample log status (-f flush, -d binary dump)\n");
+    printf("  stream [on|off] [-r <hz>]  - Binary telemetry frames on the console\n");
+    printf("  fleet [now]                - Fleet upload status (now: upload immediately)\n");
     printf("\n");
     printf("Configuration:\n");
     printf("  set_threshold <ch> <on> <off>  - Set channel thresholds (mV)\n");
     printf("                                   Example: set_threshold 0 12500 11800\n");
+    printf("  set_filter <ch> <boxcar|ema> [-n <len>] [-m <median>]\n");
+    printf("                                 - Select a channel's input filter\n");
+    printf("                                   Example: set_filter 0 ema -n 8 -m 3\n");
     printf("  set_temp_coeff <coeff>         - Set temperature coefficient\n");
     printf("                                   Example: set_temp_coeff -0.02\n");
+    printf("  set_comp_curve <ch> <linear|lead-acid|lithium>\n");
+    printf("                                 - Select a channel's compensation curve\n");
     printf("  set_pwm <half> <full>          - Set PWM duty cycles (%%)\n");
     printf("                                   Example: set_pwm 50 100\n");
+    printf("  set_dimming [--soc] <mV:duty>... [-H <mV>] | bands\n");
+    printf("                                 - Set the battery voltage (or SoC %%) to duty curve\n");
+    printf("                                   Example: set_dimming 11000:0 12000:40 13200:100 -H 50\n");
+    printf("  set_schedule <min:level>... [-d <level>] [--dusk <mV>] [--dawn <mV>] [-c <min>] | off\n");
+    printf("                                 - Scale the duty by minutes after dusk\n");
+    printf("                                   Example: set_schedule 0:100 300:40 --dusk 12800\n");
+    printf("  set_fleet_interval <s>         - Set the fleet upload interval (0 = default)\n");
+    printf("  calibrate [<input> <reference>] [-c]\n");
+    printf("                                 - Unit ADC calibration: show, capture a point, clear\n");
+    printf("                                   Example: calibrate battery 12840\n");
     printf("\n");
     printf("Testing:\n");
     printf("  motion                     - Trigger motion detection\n");
@@ -308,6 +1497,13 @@ static int cmd_help(int argc, char **argv)
  */
 static int cmd_restart(int argc, char **argv)
 {
+    // Persist anything still waiting for write-back
+    esp_err_t err = nvs_flush();
+    if (err != ESP_OK) {
+        printf("Warning: NVS flush failed: %s\n", esp_err_to_name(err));
+    }
+    samplelog_flush();
+    
     printf("Restarting system in 2 seconds...\n");
     vTaskDelay(pdMS_TO_TICKS(2000));
     esp_restart();
@@ -328,8 +1524,57 @@ static void register_commands(void)
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&status_cmd));
     
+    // Task timing command
+    tasks_args.reset = arg_lit0("r", "reset", "Clear accumulated statistics");
+    tasks_args.end = arg_end(1);
+    
+    const esp_console_cmd_t tasks_cmd = {
+        .command = "tasks",
+        .help = "Show per-task core, execution time and jitter",
+        .hint = NULL,
+        .func = &cmd_tasks,
+        .argtable = &tasks_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&tasks_cmd));
+    
+    // Pipeline latency command
+    perf_args.reset = arg_lit0("r", "reset", "Clear histograms, high-water marks and drops");
+    perf_args.end = arg_end(1);
+    
+    const esp_console_cmd_t perf_cmd = {
+        .command = "perf",
+        .help = "Show sample-to-PWM latency histograms, queue high-water marks and drops",
+        .hint = NULL,
+        .func = &cmd_perf,
+        .argtable = &perf_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&perf_cmd));
+    
+    // Memory command
+    const esp_console_cmd_t mem_cmd = {
+        .command = "mem",
+        .help = "Show task stack high-water marks and heap fragmentation",
+        .hint = NULL,
+        .func = &cmd_mem,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&mem_cmd));
+    
+    // Power management command
+    power_args.reset = arg_lit0("r", "reset", "Start a new residency window");
+    power_args.locks = arg_lit0("l", "locks", "Also list the power locks and their holders");
+    power_args.end = arg_end(2);
+    
+    const esp_console_cmd_t power_cmd = {
+        .command = "power",
+        .help = "Show CPU frequency range, sample interval and light-sleep residency",
+        .hint = NULL,
+        .func = &cmd_power,
+        .argtable = &power_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&power_cmd));
+    
     // Set threshold command
-    set_threshold_args.channel = arg_int1(NULL, NULL, "<channel>", "Channel (0 or 1)");
+    set_threshold_args.channel = arg_int1(NULL, NULL, "<channel>", "Channel index (see channel_table)");
     set_threshold_args.th_on = arg_int1(NULL, NULL, "<on_mv>", "ON threshold (mV)");
     set_threshold_args.th_off = arg_int1(NULL, NULL, "<off_mv>", "OFF threshold (mV)");
     set_threshold_args.end = arg_end(3);
@@ -343,6 +1588,36 @@ static void register_commands(void)
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&set_threshold_cmd));
     
+    // Set filter command
+    set_filter_args.channel = arg_int1(NULL, NULL, "<channel>", "Channel index (see channel_table)");
+    set_filter_args.type = arg_str1(NULL, NULL, "<boxcar|ema>", "Smoothing filter");
+    set_filter_args.length = arg_int0("n", "length", "<len>", "Boxcar taps / EMA span in samples (default 16)");
+    set_filter_args.median = arg_int0("m", "median", "<median>", "Median-of-N spike rejection before smoothing (3-9, odd)");
+    set_filter_args.end = arg_end(4);
+    
+    const esp_console_cmd_t set_filter_cmd = {
+        .command = "set_filter",
+        .help = "Select a channel's input filter",
+        .hint = NULL,
+        .func = &cmd_set_filter,
+        .argtable = &set_filter_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_filter_cmd));
+    
+    // Set compensation curve command
+    set_comp_curve_args.channel = arg_int1(NULL, NULL, "<channel>", "Channel index (see channel_table)");
+    set_comp_curve_args.curve = arg_str1(NULL, NULL, "<linear|lead-acid|lithium>", "Compensation curve");
+    set_comp_curve_args.end = arg_end(2);
+    
+    const esp_console_cmd_t set_comp_curve_cmd = {
+        .command = "set_comp_curve",
+        .help = "Select a channel's temperature compensation curve",
+        .hint = NULL,
+        .func = &cmd_set_comp_curve,
+        .argtable = &set_comp_curve_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_comp_curve_cmd));
+    
     // Set temperature coefficient command
     set_temp_coeff_args.coefficient = arg_dbl1(NULL, NULL, "<coeff>", "Temperature coefficient");
     set_temp_coeff_args.end = arg_end(1);
@@ -370,6 +1645,40 @@ static void register_commands(void)
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&set_pwm_cmd));
     
+    // Set dimming curve command
+    set_dimming_args.soc = arg_lit0("s", "soc", "Points are state of charge (%) instead of mV");
+    set_dimming_args.points = arg_strn(NULL, NULL, "<mV:duty>", 1, DIMMING_MAX_POINTS,
+                                       "Curve points in ascending voltage, or 'bands'");
+    set_dimming_args.hysteresis = arg_int0("H", "hysteresis", "<mV>", "Battery change needed to re-evaluate (default 0)");
+    set_dimming_args.end = arg_end(DIMMING_MAX_POINTS + 2);
+    
+    const esp_console_cmd_t set_dimming_cmd = {
+        .command = "set_dimming",
+        .help = "Set the battery voltage to PWM duty curve",
+        .hint = NULL,
+        .func = &cmd_set_dimming,
+        .argtable = &set_dimming_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_dimming_cmd));
+    
+    // Night schedule command
+    set_schedule_args.segments = arg_strn(NULL, NULL, "<min:level>", 1, SCHEDULE_MAX_SEGMENTS,
+                                          "Segments as minutes after dusk, or 'off'");
+    set_schedule_args.day_level = arg_int0("d", "day", "<level>", "Level between dawn and dusk (%)");
+    set_schedule_args.dusk = arg_int0(NULL, "dusk", "<mV>", "Battery below this is night");
+    set_schedule_args.dawn = arg_int0(NULL, "dawn", "<mV>", "Battery above this is day");
+    set_schedule_args.confirm = arg_int0("c", "confirm", "<min>", "Time past a threshold before dusk/dawn");
+    set_schedule_args.end = arg_end(SCHEDULE_MAX_SEGMENTS + 4);
+    
+    const esp_console_cmd_t set_schedule_cmd = {
+        .command = "set_schedule",
+        .help = "Set the night schedule (duty level by minutes after dusk)",
+        .hint = NULL,
+        .func = &cmd_set_schedule,
+        .argtable = &set_schedule_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_schedule_cmd));
+    
     // Motion trigger command
     const esp_console_cmd_t motion_cmd = {
         .command = "motion",
@@ -388,6 +1697,83 @@ static void register_commands(void)
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&dump_verification_cmd));
     
+    // NVS statistics command
+    const esp_console_cmd_t nvs_stats_cmd = {
+        .command = "nvs_stats",
+        .help = "Display NVS write-back and flash wear counters",
+        .hint = NULL,
+        .func = &cmd_nvs_stats,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&nvs_stats_cmd));
+    
+    // Sample log command
+    samplelog_args.dump = arg_lit0("d", "dump", "Stream the log as binary pages");
+    samplelog_args.flush = arg_lit0("f", "flush", "Write the staging page to flash");
+    samplelog_args.end = arg_end(2);
+    
+    const esp_console_cmd_t samplelog_cmd = {
+        .command = "samplelog",
+        .help = "Show sample log status, flush it or stream it in binary",
+        .hint = NULL,
+        .func = &cmd_samplelog,
+        .argtable = &samplelog_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&samplelog_cmd));
+    
+    // Binary telemetry command
+    stream_args.mode = arg_str0(NULL, NULL, "<on|off>", "Start or stop streaming (omit for status)");
+    stream_args.rate = arg_int0("r", "rate", "<hz>", "Frames per second (1-10)");
+    stream_args.end = arg_end(2);
+    
+    const esp_console_cmd_t stream_cmd = {
+        .command = "stream",
+        .help = "Stream CRC-framed binary status records on the console UART",
+        .hint = NULL,
+        .func = &cmd_stream,
+        .argtable = &stream_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&stream_cmd));
+    
+    // Fleet upload commands
+    fleet_args.action = arg_str0(NULL, NULL, "<now>", "Upload immediately (omit for status)");
+    fleet_args.end = arg_end(1);
+    
+    const esp_console_cmd_t fleet_cmd = {
+        .command = "fleet",
+        .help = "Show fleet upload status or start an upload",
+        .hint = NULL,
+        .func = &cmd_fleet,
+        .argtable = &fleet_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&fleet_cmd));
+    
+    set_fleet_interval_args.interval = arg_int1(NULL, NULL, "<s>", "Seconds between uploads, 0 for the default");
+    set_fleet_interval_args.end = arg_end(1);
+    
+    const esp_console_cmd_t set_fleet_interval_cmd = {
+        .command = "set_fleet_interval",
+        .help = "Set the time between fleet uploads",
+        .hint = NULL,
+        .func = &cmd_set_fleet_interval,
+        .argtable = &set_fleet_interval_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_fleet_interval_cmd));
+    
+    // Calibrate command
+    calibrate_args.input = arg_str0(NULL, NULL, "<battery|temp|current>", "Input to calibrate");
+    calibrate_args.reference = arg_dbl0(NULL, NULL, "<reference>", "Measured value: battery mV, temp C, current mA");
+    calibrate_args.clear = arg_lit0("c", "clear", "Drop the calibration (of one input, or all)");
+    calibrate_args.end = arg_end(3);
+    
+    const esp_console_cmd_t calibrate_cmd = {
+        .command = "calibrate",
+        .help = "Capture a reference point for the unit's ADC calibration, or show it",
+        .hint = NULL,
+        .func = &cmd_calibrate,
+        .argtable = &calibrate_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&calibrate_cmd));
+    
     // Reset verification command
     const esp_console_cmd_t reset_verification_cmd = {
         .command = "reset_verification",
@@ -432,6 +1818,8 @@ void cli_init(void)
 {
     ESP_LOGI(TAG, "Initializing CLI console");
     
+    console_mutex = RTOS_MUTEX_CREATE(console_mutex);
+    
     // Disable buffering on stdin
     setvbuf(stdin, NULL, _IONBF, 0);
     
@@ -439,17 +1827,22 @@ void cli_init(void)
     esp_vfs_dev_uart_set_rx_line_endings(ESP_LINE_ENDINGS_CR);
     // Move the caret to the beginning of the next line on '\n'
     esp_vfs_dev_uart_set_tx_line_endings(ESP_LINE_ENDINGS_CRLF);
-
-    // Configure UART
+    
+    // Configure UART (REF_TICK keeps the baud rate while DFS scales APB)
     const uart_config_t uart_config = {
         .baud_rate = CONFIG_ESP_CONSOLE_UART_BAUDRATE,
         .data_bits = UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
+#if CONFIG_SOLAR_LOW_POWER && SOC_UART_SUPPORT_REF_TICK
+        .source_clk = UART_SCLK_REF_TICK,
+#else
         .source_clk = UART_SCLK_DEFAULT,
+#endif
     };
     ESP_ERROR_CHECK(uart_driver_install(CONFIG_ESP_CONSOLE_UART_NUM, 256, 0, 0, NULL, 0));
     ESP_ERROR_CHECK(uart_param_config(CONFIG_ESP_CONSOLE_UART_NUM, &uart_config));
+    power_console_wakeup_init();
     
     // Tell VFS to use UART driver
     esp_vfs_dev_uart_use_driver(CONFIG_ESP_CONSOLE_UART_NUM);
@@ -457,7 +1850,7 @@ void cli_init(void)
     // Initialize console
     esp_console_config_t console_config = {
         .max_cmdline_length = 256,
-        .max_cmdline_args = 8,
+        .max_cmdline_args = 13,     // set_schedule: 4 segments and 4 options
         .hint_color = atoi(LOG_COLOR_D)
     };
     ESP_ERROR_CHECK(esp_console_init(&console_config));
@@ -483,6 +1876,45 @@ void cli_init(void)
     printf("\n");
 }
 
+/**
+ * @brief Check a command line against the commands open to remote callers
+ */
+static bool cli_remote_allowed(const char *line)
+{
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+    size_t len = strcspn(line, " \t");
+    
+    for (size_t i = 0; i < sizeof(remote_commands) / sizeof(remote_commands[0]); i++) {
+        if (strlen(remote_commands[i]) == len && strncmp(line, remote_commands[i], len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Run one console command line
+ */
+esp_err_t cli_run_command(const char *line, bool remote, int *ret)
+{
+    if (remote && !cli_remote_allowed(line)) {
+        return ESP_ERR_NOT_ALLOWED;
+    }
+    
+    // Not before cli_init() (deferred by fast boot)
+    if (console_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(console_mutex, portMAX_DELAY);
+    esp_err_t err = esp_console_run(line, ret);
+    xSemaphoreGive(console_mutex);
+    
+    return err;
+}
+
 /**
  * @brief CLI task - processes console commands
  */
@@ -490,6 +1922,11 @@ void cli_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "CLI task started");
     
+#if CONFIG_SOLAR_FAST_BOOT
+    // Deferred from app_main: the outputs and control loop come up first
+    cli_init();
+#endif
+    
     const char *prompt = LOG_COLOR_I "solar> " LOG_RESET_COLOR;
     
     while (1) {
@@ -508,7 +1945,7 @@ void cli_task(void *pvParameters)
         
         // Try to run the command
         int ret;
-        esp_err_t err = esp_console_run(line, &ret);
+        esp_err_t err = cli_run_command(line, false, &ret);
         
         if (err == ESP_ERR_NOT_FOUND) {
             printf("Unrecognized command. Type 'help' for available commands.\n");
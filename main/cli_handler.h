@@ -9,6 +9,9 @@
 #ifndef CLI_HANDLER_H
 #define CLI_HANDLER_H
 
+#include <stdbool.h>
+#include "esp_err.h"
+
 /**
  * @brief Initialize CLI console
  * 
@@ -16,7 +19,9 @@
  * command-line interface. Registers all available commands and
  * displays welcome banner.
  * 
- * @note Must be called before starting CLI task
+ * @note With CONFIG_SOLAR_FAST_BOOT cli_task calls it once it runs, so the
+ *       control loop starts first; otherwise call it before starting the
+ *       CLI task
  */
 void cli_init(void);
 
@@ -34,4 +39,18 @@ void cli_init(void);
  */
 void cli_task(void *pvParameters);
 
+/**
+ * @brief Run one console command line
+ * @param line Command line, as typed at the prompt
+ * @param remote true for lines not typed at the console (only the
+ *               configuration commands in remote_commands[] are accepted)
+ * @param ret Set to the command's return code
+ * @return ESP_OK if the command ran, ESP_ERR_NOT_FOUND for an unknown
+ *         command, ESP_ERR_NOT_ALLOWED for a command refused to a remote
+ *         caller, ESP_ERR_INVALID_ARG for an empty line
+ * 
+ * Commands run one at a time whatever task calls this.
+ */
+esp_err_t cli_run_command(const char *line, bool remote, int *ret);
+
 #endif
\ No newline at end of file
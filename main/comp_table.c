@@ -0,0 +1,54 @@
+#include "comp_table.h"
+
+/**
+ * @brief Temperatures the coefficient applies between, per curve
+ */
+static const struct {
+    const char *name;
+    sensor_temp_t min;
+    sensor_temp_t max;
+} curves[COMP_CURVE_COUNT] = {
+    [COMP_CURVE_LINEAR]    = { "linear",    SENSOR_TEMP_C(SENSOR_TEMP_MIN_C), SENSOR_TEMP_C(SENSOR_TEMP_MAX_C) },
+    [COMP_CURVE_LEAD_ACID] = { "lead-acid", SENSOR_TEMP_C(0),                 SENSOR_TEMP_C(50) },
+    [COMP_CURVE_LITHIUM]   = { "lithium",   SENSOR_TEMP_C(0),                 SENSOR_TEMP_C(25) },
+};
+
+/**
+ * @brief Name of a compensation curve
+ */
+const char *comp_curve_name(comp_curve_t curve)
+{
+    return (curve >= 0 && curve < COMP_CURVE_COUNT) ? curves[curve].name : "unknown";
+}
+
+/**
+ * @brief Saturate a threshold to the table's storage type
+ */
+static int16_t comp_saturate(int32_t mv)
+{
+    return (mv > INT16_MAX) ? INT16_MAX : (mv < INT16_MIN) ? INT16_MIN : (int16_t)mv;
+}
+
+/**
+ * @brief Fill the table for a set of thresholds
+ */
+void comp_table_build(comp_table_t *table, int32_t th_on_mv, int32_t th_off_mv,
+                      sensor_coeff_t coeff, comp_curve_t curve)
+{
+    if (curve < 0 || curve >= COMP_CURVE_COUNT) {
+        curve = COMP_CURVE_LINEAR;
+    }
+    
+    for (int i = 0; i < COMP_TABLE_SIZE; i++) {
+        sensor_temp_t temp = comp_table_temp(i);
+        if (temp < curves[curve].min) {
+            temp = curves[curve].min;
+        } else if (temp > curves[curve].max) {
+            temp = curves[curve].max;
+        }
+        
+        int32_t compensation_mv = sensor_compensation_mv(coeff, temp - COMP_REF_TEMP);
+        table->pair[i].on_mv = comp_saturate(th_on_mv + compensation_mv);
+        table->pair[i].off_mv = comp_saturate(th_off_mv + compensation_mv);
+    }
+}
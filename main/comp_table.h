@@ -0,0 +1,103 @@
+/**
+ * @file comp_table.h
+ * @brief Temperature-compensated threshold lookup table
+ *
+ * Holds one channel's compensated (ON, OFF) threshold pair for every
+ * COMP_TABLE_STEP of the TMP36 range. The table is built when the
+ * configuration changes, so per sample the compensation is a bucket index
+ * and one load.
+ *
+ * The compensation curve applies the configured coefficient between two
+ * temperatures and holds the offset flat outside them:
+ * - linear: the whole sensor range (a single coefficient, no limits)
+ * - lead-acid: 0 to 50 °C, the usual charger limits that keep a hot or
+ *   frozen pack from being driven to extreme voltages
+ * - lithium: 0 to 25 °C; at and above room temperature the pack voltage
+ *   barely depends on temperature, so the thresholds stay as configured
+ *
+ * channel_logic rebuilds a channel's table when its parameters change.
+ */
+
+#ifndef COMP_TABLE_H
+#define COMP_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sensor_math.h"
+
+// Reference temperature of the configured thresholds
+#define COMP_REF_TEMP       SENSOR_TEMP_C(25)
+
+// Bucket width (0.5 °C) and buckets over the sensor range, both ends included
+#define COMP_TABLE_STEP     SENSOR_TEMP_C(0.5)
+#define COMP_TABLE_SIZE     ((SENSOR_TEMP_MAX_C - SENSOR_TEMP_MIN_C) * 2 + 1)
+
+/**
+ * @brief Compensation curve
+ */
+typedef enum {
+    COMP_CURVE_LINEAR = 0,
+    COMP_CURVE_LEAD_ACID,
+    COMP_CURVE_LITHIUM,
+    COMP_CURVE_COUNT
+} comp_curve_t;
+
+/**
+ * @struct comp_pair_t
+ * @brief Compensated thresholds of one temperature bucket
+ */
+typedef struct {
+    int16_t on_mv;
+    int16_t off_mv;
+} comp_pair_t;
+
+/**
+ * @struct comp_table_t
+ * @brief Compensated thresholds of one channel over the sensor range
+ */
+typedef struct {
+    comp_pair_t pair[COMP_TABLE_SIZE];
+} comp_table_t;
+
+/**
+ * @brief Name of a compensation curve ("linear", "lead-acid", "lithium")
+ */
+const char *comp_curve_name(comp_curve_t curve);
+
+/**
+ * @brief Fill the table for a set of thresholds
+ * @param table Table to fill
+ * @param th_on_mv ON threshold at COMP_REF_TEMP
+ * @param th_off_mv OFF threshold at COMP_REF_TEMP
+ * @param coeff Compensation coefficient (see sensor_coeff())
+ * @param curve Compensation curve (out of range = linear)
+ *
+ * Thresholds are saturated to the int16_t range.
+ */
+void comp_table_build(comp_table_t *table, int32_t th_on_mv, int32_t th_off_mv,
+                      sensor_coeff_t coeff, comp_curve_t curve);
+
+/**
+ * @brief Bucket of a temperature (nearest, clamped to the sensor range)
+ */
+static inline int comp_table_index(sensor_temp_t temp)
+{
+#if SOLAR_FIXED_POINT
+    int32_t offset = temp - SENSOR_TEMP_C(SENSOR_TEMP_MIN_C);
+    int index = offset <= 0 ? 0 : (int)((offset + COMP_TABLE_STEP / 2) / COMP_TABLE_STEP);
+#else
+    float offset = temp - SENSOR_TEMP_C(SENSOR_TEMP_MIN_C);
+    int index = offset <= 0.0f ? 0 : (int)(offset / COMP_TABLE_STEP + 0.5f);
+#endif
+    return index < COMP_TABLE_SIZE ? index : COMP_TABLE_SIZE - 1;
+}
+
+/**
+ * @brief Temperature at the centre of a bucket
+ */
+static inline sensor_temp_t comp_table_temp(int index)
+{
+    return SENSOR_TEMP_C(SENSOR_TEMP_MIN_C) + (sensor_temp_t)index * COMP_TABLE_STEP;
+}
+
+#endif
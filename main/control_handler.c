@@ -1,73 +1,178 @@
 #include "control_handler.h"
 #include "channel_processor.h"
+#include "channel_table.h"
 #include "adc_handler.h"
+#include "task_stats.h"
+#include "perf_stats.h"
 #include "nvs_storage.h"
+#include "control_logic.h"
+#include "schedule_logic.h"
+#include "fastboot.h"
+#include "rtlog.h"
 #include "esp_log.h"
 #include "driver/ledc.h"
 #include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "rtos_alloc.h"
+#include <stdio.h>
 
 static const char *TAG = "CONTROL";
 
 // GPIO pin definitions
-#define GPIO_LED_CH0        GPIO_NUM_25  // PWM output for Channel 0
-#define GPIO_LED_CH1        GPIO_NUM_26  // PWM output for Channel 1
+// PWM output pins are defined per channel in channel_table.c
 #define GPIO_MOTION_SENSOR  GPIO_NUM_4   // Motion sensor input
 #define GPIO_CHARGER_STATUS GPIO_NUM_27  // Optional: charger status input
 
 // LEDC (PWM) configuration
 #define LEDC_TIMER              LEDC_TIMER_0
 #define LEDC_MODE               LEDC_LOW_SPEED_MODE
-#define LEDC_CH0_CHANNEL        LEDC_CHANNEL_0
-#define LEDC_CH1_CHANNEL        LEDC_CHANNEL_1
-#define LEDC_DUTY_RES           LEDC_TIMER_13_BIT  // 13-bit resolution (0-8191)
 #define LEDC_FREQUENCY          5000               // 5 kHz
+#if CONFIG_SOLAR_LOW_POWER
+// RC_FAST (~8 MHz) keeps running in light sleep and does not follow DFS,
+// which leaves 10 bits of resolution at 5 kHz
+#define LEDC_CLK_CFG            LEDC_USE_RC_FAST_CLK
+#define LEDC_DUTY_RES           LEDC_TIMER_10_BIT  // 10-bit resolution (0-1023)
+#define LEDC_MAX_DUTY           1023               // (2^10 - 1)
+#else
+#define LEDC_CLK_CFG            LEDC_AUTO_CLK
+#define LEDC_DUTY_RES           LEDC_TIMER_13_BIT  // 13-bit resolution (0-8191)
 #define LEDC_MAX_DUTY           8191               // (2^13 - 1)
+#endif
+
+// Time of a full-scale (0-100%) duty ramp, 0 = instant
+#define LEDC_FADE_FULL_SCALE_MS     CONFIG_SOLAR_PWM_FADE_MS
 
-// Battery levels for dimming logic (in mV)
-#define BATTERY_FULL_THRESHOLD      13500  // 13.5V - full operation
-#define BATTERY_HALF_THRESHOLD      12000  // 12.0V - half brightness
-#define BATTERY_CRITICAL_THRESHOLD  11000  // 11.0V - shut off loads
+// Longest idle sleep: control_task re-evaluates and logs status this often
+#define CONTROL_HEARTBEAT_MS        5000
 
 // Motion sensor configuration
-#define MOTION_TIMEOUT_MS           30000  // 30 seconds full brightness after motion
-#define MOTION_DEBOUNCE_MS          500    // 500ms debounce
+#define MOTION_DEBOUNCE_US          500000 // 500ms debounce
+#if CONFIG_SOLAR_LOW_POWER
+// Only a GPIO level can wake light sleep: the ISR masks the level interrupt
+// and control_task unmasks it once the input is low again
+#define MOTION_INTR_TYPE            GPIO_INTR_HIGH_LEVEL
+#else
+#define MOTION_INTR_TYPE            GPIO_INTR_POSEDGE
+#endif
 
 // Mutex for hardware access
 SemaphoreHandle_t hw_mutex = NULL;
+RTOS_MUTEX_STORAGE(hw_mutex);
 
 // Hardware state
 static hw_control_t hw_state = {
-    .ch0_state = false,
-    .ch1_state = false,
+    .ch_state = {false},
     .pwm_duty = 0,
-    .motion_detected = false
+    .motion_detected = false,
+    .schedule_level = 100
 };
 
-// Motion detection state
-static volatile bool motion_active = false;
-static volatile uint32_t last_motion_time = 0;
+// control_task handle, target of event notifications
+static TaskHandle_t control_task_handle = NULL;
+
+// Motion override state, owned by control_task
+static bool motion_active = false;
+
+// Set by an emergency shutdown until an output switches on again (hw_mutex)
+static bool outputs_held = false;
+
+// One-shot timer that ends the motion override
+static esp_timer_handle_t motion_timer = NULL;
+
+// One-shot timer at the next schedule segment boundary
+static esp_timer_handle_t schedule_timer = NULL;
+
+#if CONFIG_SOLAR_LOW_POWER
+// Level interrupt masked by the ISR until the input goes low
+static volatile bool motion_irq_masked = false;
+#endif
+
+// Channels ramping in hardware (bit per channel_table index); cleared by
+// the fade-end callback, which may run on the other core
+static volatile uint32_t fading_mask = 0;
+static portMUX_TYPE fading_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Values derived from the configuration snapshot (control_task only)
+ */
+typedef struct {
+    uint32_t generation;
+    bool valid;
+    dimming_table_t dimming;    // Compiled voltage to duty curve
+    schedule_config_t schedule;
+    uint32_t motion_timeout_ms;
+} control_config_t;
+
+static control_config_t control_config;
 
 /**
  * @brief GPIO ISR handler for motion sensor
+ * Only debounces and defers to control_task; all state lives in the task
  */
 static void IRAM_ATTR motion_sensor_isr_handler(void *arg)
 {
-    uint32_t now = xTaskGetTickCountFromISR() * portTICK_PERIOD_MS;
+    // Debounce timestamp is private to the ISR
+    static int64_t last_edge_us = 0;
+    int64_t now = esp_timer_get_time();
     
-    // Simple debounce
-    if (now - last_motion_time > MOTION_DEBOUNCE_MS) {
-        motion_active = true;
-        last_motion_time = now;
+#if CONFIG_SOLAR_LOW_POWER
+    // A level keeps firing while the PIR output is high
+    gpio_intr_disable(GPIO_MOTION_SENSOR);
+    motion_irq_masked = true;
+#endif
+    
+    if (now - last_edge_us < MOTION_DEBOUNCE_US) {
+        return;
+    }
+    last_edge_us = now;
+    
+    if (control_task_handle != NULL) {
+        BaseType_t higher_prio_woken = pdFALSE;
+        xTaskNotifyFromISR(control_task_handle, CONTROL_EVT_MOTION, eSetBits, &higher_prio_woken);
+        portYIELD_FROM_ISR(higher_prio_woken);
+    }
+}
+
+/**
+ * @brief Motion timeout expiry (esp_timer task context)
+ */
+static void motion_timer_cb(void *arg)
+{
+    control_notify(CONTROL_EVT_MOTION_TIMEOUT);
+}
+
+/**
+ * @brief Schedule segment boundary (esp_timer task context)
+ */
+static void schedule_timer_cb(void *arg)
+{
+    control_notify(CONTROL_EVT_SCHEDULE);
+}
+
+/**
+ * @brief LEDC fade end (LEDC ISR context)
+ */
+static bool IRAM_ATTR ledc_fade_end_cb(const ledc_cb_param_t *param, void *user_arg)
+{
+    if (param->event == LEDC_FADE_END_EVT) {
+        portENTER_CRITICAL_ISR(&fading_mux);
+        fading_mask &= ~(1U << (uintptr_t)user_arg);
+        portEXIT_CRITICAL_ISR(&fading_mux);
     }
+    
+    return false;
 }
 
 /**
  * @brief Initialize LEDC (PWM) for LED control
+ * @param initial_duty Duty each channel starts at, in LEDC counts
  */
-static void ledc_init(void)
+static void ledc_init(const uint32_t initial_duty[CHANNEL_COUNT])
 {
     ESP_LOGI(TAG, "Initializing LEDC/PWM");
     
@@ -77,7 +182,7 @@ static void ledc_init(void)
         .duty_resolution  = LEDC_DUTY_RES,
         .timer_num        = LEDC_TIMER,
         .freq_hz          = LEDC_FREQUENCY,
-        .clk_cfg          = LEDC_AUTO_CLK
+        .clk_cfg          = LEDC_CLK_CFG
     };
     esp_err_t ret = ledc_timer_config(&ledc_timer);
     if (ret != ESP_OK) {
@@ -85,40 +190,44 @@ static void ledc_init(void)
         return;
     }
     
-    // Configure Channel 0
-    ledc_channel_config_t ledc_ch0 = {
-        .speed_mode     = LEDC_MODE,
-        .channel        = LEDC_CH0_CHANNEL,
-        .timer_sel      = LEDC_TIMER,
-        .intr_type      = LEDC_INTR_DISABLE,
-        .gpio_num       = GPIO_LED_CH0,
-        .duty           = 0,  // Start with 0% duty
-        .hpoint         = 0
-    };
-    ret = ledc_channel_config(&ledc_ch0);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure LEDC CH0: %s", esp_err_to_name(ret));
-        return;
+    // Configure one LEDC channel per table entry
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        ledc_channel_config_t ledc_ch = {
+            .speed_mode     = LEDC_MODE,
+            .channel        = channel_table[ch].ledc_channel,
+            .timer_sel      = LEDC_TIMER,
+            .intr_type      = LEDC_INTR_DISABLE,
+            .gpio_num       = channel_table[ch].gpio,
+            .duty           = initial_duty[ch],  // 0 unless resuming (fastboot.h)
+            .hpoint         = 0,
+#if CONFIG_SOLAR_LOW_POWER
+            .sleep_mode     = LEDC_SLEEP_MODE_KEEP_ALIVE,
+#endif
+        };
+        ret = ledc_channel_config(&ledc_ch);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to configure LEDC CH%d: %s", ch, esp_err_to_name(ret));
+            return;
+        }
+        
+        ESP_LOGI(TAG, "LEDC CH%d on GPIO%d", ch, channel_table[ch].gpio);
     }
     
-    // Configure Channel 1
-    ledc_channel_config_t ledc_ch1 = {
-        .speed_mode     = LEDC_MODE,
-        .channel        = LEDC_CH1_CHANNEL,
-        .timer_sel      = LEDC_TIMER,
-        .intr_type      = LEDC_INTR_DISABLE,
-        .gpio_num       = GPIO_LED_CH1,
-        .duty           = 0,  // Start with 0% duty
-        .hpoint         = 0
-    };
-    ret = ledc_channel_config(&ledc_ch1);
+    // Hardware ramps between duty targets
+    ret = ledc_fade_func_install(0);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure LEDC CH1: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to install LEDC fade service: %s", esp_err_to_name(ret));
         return;
     }
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        ledc_cbs_t cbs = {
+            .fade_cb = ledc_fade_end_cb,
+        };
+        ledc_cb_register(LEDC_MODE, channel_table[ch].ledc_channel, &cbs, (void *)(uintptr_t)ch);
+    }
     
-    ESP_LOGI(TAG, "LEDC initialized: CH0=GPIO%d, CH1=GPIO%d, freq=%dHz",
-             GPIO_LED_CH0, GPIO_LED_CH1, LEDC_FREQUENCY);
+    ESP_LOGI(TAG, "LEDC initialized: %d channels, freq=%dHz, %d ms full-scale fade",
+             CHANNEL_COUNT, LEDC_FREQUENCY, LEDC_FADE_FULL_SCALE_MS);
 }
 
 /**
@@ -134,10 +243,29 @@ static void motion_sensor_init(void)
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE,
         .pull_down_en = GPIO_PULLDOWN_ENABLE,
-        .intr_type = GPIO_INTR_POSEDGE  // Trigger on rising edge
+        .intr_type = MOTION_INTR_TYPE   // Rising edge (high level in low-power builds)
     };
     gpio_config(&io_conf);
     
+#if CONFIG_SOLAR_LOW_POWER
+    // Motion wakes the chip from light sleep
+    gpio_wakeup_enable(GPIO_MOTION_SENSOR, GPIO_INTR_HIGH_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+#endif
+    
+    // One-shot timeout, armed by control_task on every motion edge
+    const esp_timer_create_args_t timer_args = {
+        .callback = motion_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "motion",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &motion_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create motion timer: %s", esp_err_to_name(ret));
+        return;
+    }
+    
     // Install GPIO ISR service
     gpio_install_isr_service(0);
     gpio_isr_handler_add(GPIO_MOTION_SENSOR, motion_sensor_isr_handler, NULL);
@@ -146,113 +274,152 @@ static void motion_sensor_init(void)
 }
 
 /**
- * @brief Convert percentage (0-100) to LEDC duty cycle
+ * @brief Convert an LEDC duty to a percentage (0-100, for reporting)
  */
-static uint32_t percent_to_duty(uint8_t percent)
+static uint8_t duty_to_percent(uint32_t duty)
 {
-    if (percent > 100) percent = 100;
-    return (uint32_t)((LEDC_MAX_DUTY * percent) / 100);
+    if (duty > LEDC_MAX_DUTY) duty = LEDC_MAX_DUTY;
+    return (uint8_t)((duty * 100 + LEDC_MAX_DUTY / 2) / LEDC_MAX_DUTY);
 }
 
 /**
- * @brief Set PWM duty cycle for a channel
+ * @brief Move a channel towards a PWM duty target (hw_mutex held)
+ * @param ch Channel index in channel_table
+ * @param target Target duty in LEDC counts
+ * @param fade Ramp in hardware; false switches at once
+ *
+ * A ramp in progress is stopped where it is and the new one starts from
+ * there, so a new target always preempts the old one. The fade hardware
+ * runs the ramp to the end with no task involvement.
  */
-static void set_pwm_duty(ledc_channel_t channel, uint8_t duty_percent)
+static void set_pwm_duty(int ch, uint32_t target, bool fade)
 {
-    uint32_t duty = percent_to_duty(duty_percent);
+    ledc_channel_t channel = channel_table[ch].ledc_channel;
+    uint32_t bit = 1U << ch;
     
-    esp_err_t ret = ledc_set_duty(LEDC_MODE, channel, duty);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set duty: %s", esp_err_to_name(ret));
+    if (fading_mask & bit) {
+        // Fixes the duty where the ramp is within one PWM period
+        ledc_fade_stop(LEDC_MODE, channel);
+        portENTER_CRITICAL(&fading_mux);
+        fading_mask &= ~bit;
+        portEXIT_CRITICAL(&fading_mux);
+    }
+    
+    uint32_t current = ledc_get_duty(LEDC_MODE, channel);
+    uint32_t fade_ms = fade ? control_logic_fade_ms(LEDC_FADE_FULL_SCALE_MS, current,
+                                                    target, LEDC_MAX_DUTY)
+                            : 0;
+    
+    if (fade_ms == 0) {
+        // Fade-safe immediate update (ledc_set_duty() races the fade service)
+        esp_err_t ret = ledc_set_duty_and_update(LEDC_MODE, channel, target, 0);
+        if (ret != ESP_OK) {
+            RTLOG(RTLOG_CTRL_SET_DUTY_FAILED, RTLOG_S(esp_err_to_name(ret)));
+        }
         return;
     }
     
-    ret = ledc_update_duty(LEDC_MODE, channel);
+    esp_err_t ret = ledc_set_fade_with_time(LEDC_MODE, channel, target, (int)fade_ms);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to update duty: %s", esp_err_to_name(ret));
+        RTLOG(RTLOG_CTRL_SET_DUTY_FAILED, RTLOG_S(esp_err_to_name(ret)));
+        return;
     }
-}
-
-/**
- * @brief Determine dimming level based on battery voltage
- * Returns duty cycle percentage (0-100)
- */
-static uint8_t calculate_dimming_level(uint32_t battery_mv, bool motion_override)
-{
-    // Motion override: always full brightness
-    if (motion_override) {
-        return nvs_get_pwm_full_duty();
-    }
-    
-    // Battery-based dimming
-    if (battery_mv >= BATTERY_FULL_THRESHOLD) {
-        // Full brightness - battery is healthy
-        return nvs_get_pwm_full_duty();
-    } else if (battery_mv >= BATTERY_HALF_THRESHOLD) {
-        // Half brightness - conserve battery
-        return nvs_get_pwm_half_duty();
-    } else if (battery_mv >= BATTERY_CRITICAL_THRESHOLD) {
-        // Quarter brightness - very low battery
-        return nvs_get_pwm_half_duty() / 2;
-    } else {
-        // Turn off - critical battery level
-        return 0;
+    
+    portENTER_CRITICAL(&fading_mux);
+    fading_mask |= bit;
+    portEXIT_CRITICAL(&fading_mux);
+    ret = ledc_fade_start(LEDC_MODE, channel, LEDC_FADE_NO_WAIT);
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&fading_mux);
+        fading_mask &= ~bit;
+        portEXIT_CRITICAL(&fading_mux);
+        RTLOG(RTLOG_CTRL_UPDATE_DUTY_FAILED, RTLOG_S(esp_err_to_name(ret)));
     }
 }
 
 /**
- * @brief Check if motion timeout has expired
+ * @brief Refresh the compiled dimming curve if a new config was published
+ * @return true if the cached values changed
  */
-static bool check_motion_timeout(void)
+static bool refresh_control_config(void)
 {
-    if (!motion_active) {
+    if (control_config.valid && nvs_config_generation() == control_config.generation) {
         return false;
     }
     
-    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    uint32_t motion_timeout = nvs_get_motion_timeout();
+    app_config_t config;
+    control_config.generation = nvs_config_snapshot(&config);
     
-    if (now - last_motion_time > motion_timeout) {
-        motion_active = false;
-        ESP_LOGI(TAG, "Motion timeout expired");
-        return false;
+    // No stored curve: the fixed battery bands at the set_pwm duties, over
+    // the state of charge when the current is measured
+    dimming_curve_t curve = config.dimming;
+    if (curve.count == 0) {
+        const dimming_params_t bands = {
+            .full_duty = config.pwm_full_duty,
+            .half_duty = config.pwm_half_duty,
+            .quarter_duty = config.pwm_half_duty / 2,
+        };
+#if CONFIG_SOLAR_CURRENT_SENSE
+        control_logic_default_soc_curve(&bands, &curve);
+#else
+        control_logic_default_curve(&bands, &curve);
+#endif
     }
+    control_logic_dimming_compile(&control_config.dimming, &curve,
+                                  config.pwm_full_duty, LEDC_MAX_DUTY);
+    control_config.schedule = config.schedule;
+    control_config.motion_timeout_ms = config.motion_timeout_ms;
+    control_config.valid = true;
+    
+    ESP_LOGD(TAG, "Config generation %u: %u-point curve, hysteresis=%umV, full=%d%%, motion=%ums",
+             (unsigned int)control_config.generation,
+             control_config.dimming.count, control_config.dimming.hysteresis_mv,
+             config.pwm_full_duty, (unsigned int)control_config.motion_timeout_ms);
     
     return true;
 }
 
 /**
- * @brief Apply hardware control commands with mutex protection
+ * @brief Configuration change listener: re-evaluate outputs right away
+ */
+static void control_config_changed(uint32_t generation)
+{
+    control_notify(CONTROL_EVT_CONFIG);
+}
+
+/**
+ * @brief Commit changed channel duties with mutex protection
+ * @param enable Channel outputs
+ * @param target Duty target per channel in LEDC counts
+ * @param dirty Channels whose target differs from the committed one
+ * @param duty_percent Dimming level behind the targets
+ * @return false if hw_mutex timed out and nothing was written
  */
-static void apply_hardware_control(bool ch0_enable, bool ch1_enable, uint8_t duty_percent)
+static bool apply_hardware_control(const bool enable[CHANNEL_COUNT],
+                                   const uint32_t target[CHANNEL_COUNT],
+                                   uint32_t dirty, uint8_t duty_percent)
 {
     // Take mutex with timeout
     if (xSemaphoreTake(hw_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGW(TAG, "Failed to acquire hw_mutex");
-        return;
+        rtlog_write(RTLOG_CTRL_MUTEX_TIMEOUT, NULL, 0);
+        return false;
     }
     
     // Update hardware state
-    hw_state.ch0_state = ch0_enable;
-    hw_state.ch1_state = ch1_enable;
     hw_state.pwm_duty = duty_percent;
     
-    // Apply Channel 0
-    if (ch0_enable) {
-        set_pwm_duty(LEDC_CH0_CHANNEL, duty_percent);
-    } else {
-        set_pwm_duty(LEDC_CH0_CHANNEL, 0);
-    }
-    
-    // Apply Channel 1
-    if (ch1_enable) {
-        set_pwm_duty(LEDC_CH1_CHANNEL, duty_percent);
-    } else {
-        set_pwm_duty(LEDC_CH1_CHANNEL, 0);
+    // Issue the changed targets only; the fade hardware does the rest
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        hw_state.ch_state[ch] = enable[ch];
+        if (dirty & (1U << ch)) {
+            set_pwm_duty(ch, target[ch], true);
+        }
     }
     
     // Release mutex
     xSemaphoreGive(hw_mutex);
+    
+    return true;
 }
 
 /**
@@ -263,18 +430,43 @@ void control_init(void)
     ESP_LOGI(TAG, "Initializing control handler");
     
     // Create mutex
-    hw_mutex = xSemaphoreCreateMutex();
+    hw_mutex = RTOS_MUTEX_CREATE(hw_mutex);
     if (hw_mutex == NULL) {
         ESP_LOGE(TAG, "Failed to create hardware mutex");
         return;
     }
     
-    // Initialize PWM
-    ledc_init();
+    // Initialize PWM, at the previous run's duties after a warm reset
+    uint32_t initial_duty[CHANNEL_COUNT] = {0};
+    fastboot_state_t resume;
+    if (fastboot_get(&resume) && resume.max_duty == LEDC_MAX_DUTY) {
+        for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+            initial_duty[ch] = resume.duty[ch];
+            hw_state.ch_state[ch] = (resume.output_mask >> ch) & 1;
+        }
+        hw_state.pwm_duty = resume.duty_percent;
+    }
+    ledc_init(initial_duty);
     
     // Initialize motion sensor
     motion_sensor_init();
     
+    // Segment boundaries of the night schedule
+    const esp_timer_create_args_t timer_args = {
+        .callback = schedule_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "schedule",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &schedule_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create schedule timer: %s", esp_err_to_name(ret));
+        return;
+    }
+    
+    // Re-evaluate outputs as soon as the configuration changes
+    nvs_config_add_listener(control_config_changed);
+    
     // Initialize charger status GPIO (optional)
     gpio_config_t io_conf = {
         .pin_bit_mask = (1ULL << GPIO_CHARGER_STATUS),
@@ -288,6 +480,138 @@ void control_init(void)
     ESP_LOGI(TAG, "Control handler initialized");
 }
 
+/**
+ * @brief Ticks until the next status heartbeat
+ */
+static TickType_t control_next_timeout(uint32_t last_log_time)
+{
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    uint32_t elapsed = now - last_log_time;
+    
+    return pdMS_TO_TICKS((elapsed < CONTROL_HEARTBEAT_MS) ? CONTROL_HEARTBEAT_MS - elapsed : 0);
+}
+
+#if CONFIG_SOLAR_LOW_POWER
+/**
+ * @brief Re-enable the level-triggered motion input (control_task only)
+ * @return CONTROL_EVT_MOTION if the input is still high at the timeout
+ * 
+ * The input is unmasked once it reads low, so the next rising level fires
+ * again. A PIR still reporting motion when the override expires extends it.
+ */
+static uint32_t motion_irq_poll(uint32_t events)
+{
+    if (!motion_irq_masked) {
+        return 0;
+    }
+    
+    if (gpio_get_level(GPIO_MOTION_SENSOR) == 0) {
+        motion_irq_masked = false;
+        gpio_intr_enable(GPIO_MOTION_SENSOR);
+        return 0;
+    }
+    
+    return (events & CONTROL_EVT_MOTION_TIMEOUT) ? CONTROL_EVT_MOTION : 0;
+}
+#endif
+
+/**
+ * @brief Handle motion events (control_task context only)
+ * An edge (re)arms the one-shot timeout; expiry releases the override
+ */
+static void control_handle_motion(uint32_t events)
+{
+    if (events & CONTROL_EVT_MOTION) {
+        uint32_t timeout_ms = control_config.motion_timeout_ms;
+        
+        // Restart the countdown from this edge
+        esp_timer_stop(motion_timer);
+        esp_err_t ret = esp_timer_start_once(motion_timer, (uint64_t)timeout_ms * 1000);
+        if (ret != ESP_OK) {
+            RTLOG(RTLOG_CTRL_TIMER_FAILED, RTLOG_S("motion"), RTLOG_S(esp_err_to_name(ret)));
+        }
+        
+        if (!motion_active) {
+            RTLOG(RTLOG_CTRL_MOTION, timeout_ms);
+        }
+        motion_active = true;
+    } else if ((events & CONTROL_EVT_MOTION_TIMEOUT) && motion_active) {
+        // Ignore an expiry that raced with a re-arm
+        if (!esp_timer_is_active(motion_timer)) {
+            motion_active = false;
+            rtlog_write(RTLOG_CTRL_MOTION_EXPIRED, NULL, 0);
+        }
+    }
+}
+
+/**
+ * @brief Re-evaluate the schedule level and arm the next boundary (control_task only)
+ * @return % of the dimming duty in effect
+ */
+static uint8_t control_schedule_rearm(const schedule_t *schedule, uint32_t now_ms)
+{
+    uint32_t next_ms;
+    uint8_t level = schedule_level(schedule, &control_config.schedule, now_ms, &next_ms);
+    
+    // Dawn and dusk arrive with the battery voltage; only segments need a timer
+    esp_timer_stop(schedule_timer);
+    if (next_ms != 0) {
+        esp_err_t ret = esp_timer_start_once(schedule_timer, (uint64_t)next_ms * 1000);
+        if (ret != ESP_OK) {
+            RTLOG(RTLOG_CTRL_TIMER_FAILED, RTLOG_S("schedule"), RTLOG_S(esp_err_to_name(ret)));
+        }
+    }
+    
+    if (xSemaphoreTake(hw_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        hw_state.night = schedule->night;
+        hw_state.schedule_level = level;
+        xSemaphoreGive(hw_mutex);
+    }
+    
+    return level;
+}
+
+/**
+ * @brief Save the output state for the next boot (control_task only)
+ * @param enable Channel outputs
+ * @param committed Duty last committed to each channel
+ * @param cmds Latest command per channel (filtered voltages)
+ * @param schedule Day/night state
+ * @param duty_percent Dimming level behind the duties
+ * @param now_ms Current time
+ */
+static void control_save_resume(const bool enable[CHANNEL_COUNT],
+                                const uint32_t committed[CHANNEL_COUNT],
+                                const channel_command_t cmds[CHANNEL_COUNT],
+                                const schedule_t *schedule, uint8_t duty_percent,
+                                uint32_t now_ms)
+{
+    fastboot_state_t state = {
+        .max_duty = LEDC_MAX_DUTY,
+        .duty_percent = duty_percent,
+        .night = schedule->started && schedule->night,
+    };
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        state.duty[ch] = committed[ch];
+        state.filtered_mv[ch] = cmds[ch].filtered_voltage;
+        if (enable[ch]) {
+            state.output_mask |= 1U << ch;
+        }
+    }
+    if (state.night) {
+        state.since_dusk_ms = now_ms - schedule->dusk_ms;
+    }
+    
+    // Checked under hw_mutex, so a save never lands after an emergency
+    // shutdown's clear
+    if (xSemaphoreTake(hw_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        if (!outputs_held) {
+            fastboot_save(&state);
+        }
+        xSemaphoreGive(hw_mutex);
+    }
+}
+
 /**
  * @brief Control task - processes commands and applies hardware control
  */
@@ -295,72 +619,242 @@ void control_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "Control task started");
     
-    channel_command_t ch0_cmd = {0};
-    channel_command_t ch1_cmd = {0};
+    control_task_handle = xTaskGetCurrentTaskHandle();
+    
+    // Latest command per channel
+    channel_command_t cmds[CHANNEL_COUNT] = {0};
+    bool enable[CHANNEL_COUNT] = {false};
+    
+    // Shadow of the duty counts last committed to each LEDC channel
+    uint32_t committed[CHANNEL_COUNT] = {0};
+    bool committed_valid = false;
+    // Outputs forced off by an emergency shutdown
+    bool held = false;
+    // Reported once, for the first sample-driven change to the outputs
+    bool first_change_logged = false;
+    
+    // Battery voltage the dimming curve was last evaluated at
+    dimming_state_t dimming_state = {0};
+    
+    // Day/night from channel 0's filtered battery voltage
+    schedule_t schedule;
+    schedule_init(&schedule);
+    uint8_t schedule_pct = 100;
     
     uint32_t last_log_time = 0;
+    uint32_t battery_mv = 0;
+    uint16_t soc_permille = ADC_SOC_UNKNOWN;
+    
+    // After a warm reset, carry on from the outputs control_init restored
+    fastboot_state_t resume;
+    if (fastboot_get(&resume) && resume.max_duty == LEDC_MAX_DUTY) {
+        for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+            cmds[ch].channel_id = ch;
+            cmds[ch].output_state = (resume.output_mask >> ch) & 1;
+            cmds[ch].filtered_voltage = resume.filtered_mv[ch];
+            enable[ch] = cmds[ch].output_state;
+            committed[ch] = resume.duty[ch];
+        }
+        committed_valid = true;
+        schedule_resume(&schedule, resume.night, resume.since_dusk_ms,
+                        xTaskGetTickCount() * portTICK_PERIOD_MS);
+    }
+    
+    // Event driven: no nominal period
+    task_stats_t *stats = task_stats_register(pcTaskGetName(NULL), 0);
     
     while (1) {
-        bool ch0_updated = false;
-        bool ch1_updated = false;
+        // Sleep until a command, a motion edge, the motion timeout or the heartbeat
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, control_next_timeout(last_log_time));
+        task_stats_begin(stats);
         
-        // Check for Channel 0 commands
-        if (xQueueReceive(ch0_command_queue, &ch0_cmd, pdMS_TO_TICKS(10)) == pdTRUE) {
-            ch0_updated = true;
+        // Pick up configuration changes (cheap generation check)
+        bool config_changed = refresh_control_config();
+        
+        // Drain the shared command queue, keeping the newest command per channel
+        // and the oldest sample behind this wakeup for PWM latency accounting
+        channel_command_t cmd;
+        int64_t oldest_sample_us = 0;
+        bool switched_on = false;
+        while (xQueueReceive(channel_command_queue, &cmd, 0) == pdTRUE) {
+            perf_record(PERF_STAGE_HANDOFF, cmd.sample_us);
+            if (oldest_sample_us == 0 || cmd.sample_us < oldest_sample_us) {
+                oldest_sample_us = cmd.sample_us;
+            }
+            if (cmd.channel_id >= 0 && cmd.channel_id < CHANNEL_COUNT) {
+                switched_on |= cmd.output_state && !cmds[cmd.channel_id].output_state;
+                cmds[cmd.channel_id] = cmd;
+            }
         }
         
-        // Check for Channel 1 commands
-        if (xQueueReceive(ch1_command_queue, &ch1_cmd, pdMS_TO_TICKS(10)) == pdTRUE) {
-            ch1_updated = true;
+        // The shutdown wrote the LEDC behind the shadow's back: rewrite every
+        // channel, and keep them off until the channel logic switches one on
+        if (events & CONTROL_EVT_SHUTDOWN) {
+            held = true;
+            committed_valid = false;
+        } else if (held && switched_on && xSemaphoreTake(hw_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            outputs_held = false;
+            xSemaphoreGive(hw_mutex);
+            held = false;
         }
         
-        // Get current battery voltage for dimming calculation
-        uint32_t battery_mv = adc_get_battery_voltage_now();
+        // Get latest battery voltage and state of charge for dimming
+        // calculation (keeps the last known values if the snapshot is stale)
+        adc_reading_t reading;
+        if (adc_get_latest_reading(&reading, ADC_READING_MAX_AGE_MS)) {
+            battery_mv = reading.battery_voltage_mv;
+            soc_permille = reading.soc_permille;
+        }
         
-        // Check motion sensor timeout
-        bool motion_override = check_motion_timeout();
+        // Motion edges and timeouts arrive as events; low-power builds also
+        // unmask the level input here once it has gone low
+#if CONFIG_SOLAR_LOW_POWER
+        events |= motion_irq_poll(events);
+#endif
+        control_handle_motion(events);
+        bool motion_override = motion_active;
         hw_state.motion_detected = motion_override;
         
-        // Calculate dimming level
-        uint8_t duty_percent = calculate_dimming_level(battery_mv, motion_override);
+        // Dusk and dawn come from the filtered voltage; segment changes from
+        // the schedule timer
+        uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+        channel_state_t ch0;
+        bool phase_changed = channel_get_snapshot(0, &ch0) && ch0.timestamp_ms != 0 &&
+                             schedule_update(&schedule, &control_config.schedule,
+                                             ch0.filtered_voltage, now_ms);
+        if (phase_changed || config_changed || (events & CONTROL_EVT_SCHEDULE)) {
+            schedule_pct = control_schedule_rearm(&schedule, now_ms);
+            if (phase_changed) {
+                RTLOG(RTLOG_CTRL_SCHEDULE, RTLOG_S(schedule.night ? "night" : "day"),
+                      ch0.filtered_voltage, schedule_pct);
+            }
+        }
         
-        // Apply control based on channel commands and battery level
-        bool ch0_enable = ch0_cmd.output_state && (duty_percent > 0);
-        bool ch1_enable = ch1_cmd.output_state && (duty_percent > 0);
+        // Dimming level: one interpolation in the compiled curve, scaled by
+        // the schedule (motion still forces the full duty). An SoC curve
+        // without an estimate yet sees an empty battery.
+        uint32_t dimming_input = battery_mv;
+        if (control_config.dimming.input == DIMMING_INPUT_SOC) {
+            dimming_input = (soc_permille == ADC_SOC_UNKNOWN) ? 0 : soc_permille;
+        }
+        uint32_t duty = control_logic_dimming_duty(&control_config.dimming, &dimming_state,
+                                                   dimming_input, motion_override);
+        if (!motion_override && schedule_pct < 100) {
+            duty = duty * schedule_pct / 100;
+        }
+        uint8_t duty_percent = duty_to_percent(duty);
         
-        // Apply hardware changes
-        if (ch0_updated || ch1_updated || motion_override) {
-            apply_hardware_control(ch0_enable, ch1_enable, duty_percent);
+        // Per-channel targets from the channel commands and battery level
+        uint32_t target[CHANNEL_COUNT];
+        uint32_t dirty = 0;
+        int dirty_count = 0;
+        for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+            enable[ch] = !held && cmds[ch].output_state && (duty > 0);
+            target[ch] = enable[ch] ? duty : 0;
+            if (!committed_valid || target[ch] != committed[ch]) {
+                dirty |= 1U << ch;
+                dirty_count++;
+            }
+        }
+        
+        // Touch the hardware (and hw_mutex) only for channels that change
+        if (dirty != 0 && apply_hardware_control(enable, target, dirty, duty_percent)) {
+            perf_record(PERF_STAGE_PWM, oldest_sample_us);
+            for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+                committed[ch] = target[ch];
+            }
+            committed_valid = true;
+            perf_count(PERF_COUNT_PWM_COMMIT, dirty_count);
+            perf_count(PERF_COUNT_PWM_SKIP, CHANNEL_COUNT - dirty_count);
+            if (!held) {
+                control_save_resume(enable, committed, cmds, &schedule, duty_percent, now_ms);
+            }
+            
+            // Boot-to-first-output time and the latency of that decision
+            if (!first_change_logged && oldest_sample_us != 0) {
+                int64_t now_us = esp_timer_get_time();
+                uint32_t outputs = 0;
+                for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+                    if (enable[ch]) {
+                        outputs |= 1U << ch;
+                    }
+                }
+                RTLOG(RTLOG_CTRL_FIRST_CHANGE, (uint32_t)(now_us / 1000),
+                      (uint32_t)(now_us - oldest_sample_us), outputs, duty_percent);
+                first_change_logged = true;
+            }
+        } else if (dirty == 0) {
+            perf_count(PERF_COUNT_PWM_SKIP, CHANNEL_COUNT);
         }
         
         // Periodic logging (every 5 seconds)
-        uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-        if (now - last_log_time > 5000) {
-            ESP_LOGI(TAG, "Status: CH0=%s, CH1=%s, Duty=%d%%, Battery=%umV, Motion=%s",
-                     ch0_enable ? "ON" : "OFF",
-                     ch1_enable ? "ON" : "OFF",
-                     duty_percent,
-                     (unsigned int)battery_mv,
-                     motion_override ? "ACTIVE" : "idle");
-            last_log_time = now;
+        if (now_ms - last_log_time >= CONTROL_HEARTBEAT_MS) {
+            uint32_t outputs = 0;
+            for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+                if (enable[ch]) {
+                    outputs |= 1U << ch;
+                }
+            }
+            RTLOG(RTLOG_CTRL_STATUS,
+                  outputs,
+                  duty_percent,
+                  battery_mv,
+                  RTLOG_S(motion_override ? "ACTIVE" : "idle"));
+            last_log_time = now_ms;
+            
+            // Filtered voltages and night time move without a commit
+            if (committed_valid && !held) {
+                control_save_resume(enable, committed, cmds, &schedule, duty_percent, now_ms);
+            }
         }
         
-        // Task delay
-        vTaskDelay(pdMS_TO_TICKS(100));
+        task_stats_end(stats);
+    }
+}
+
+/**
+ * @brief Wake control_task with the given events
+ */
+void control_notify(uint32_t events)
+{
+    if (control_task_handle != NULL) {
+        xTaskNotify(control_task_handle, events, eSetBits);
     }
 }
 
 /**
  * @brief Get current hardware state (for status queries)
  */
-void control_get_state(hw_control_t *state)
+bool control_get_state(hw_control_t *state)
 {
-    if (state == NULL) return;
+    if (state == NULL) return false;
     
-    if (xSemaphoreTake(hw_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        *state = hw_state;
-        xSemaphoreGive(hw_mutex);
+    if (xSemaphoreTake(hw_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
     }
+    *state = hw_state;
+    state->fading_mask = fading_mask;
+    xSemaphoreGive(hw_mutex);
+    
+    return true;
+}
+
+/**
+ * @brief Get current hardware state without waiting (for telemetry)
+ */
+bool control_try_get_state(hw_control_t *state)
+{
+    if (state == NULL) return false;
+    
+    if (xSemaphoreTake(hw_mutex, 0) != pdTRUE) {
+        return false;
+    }
+    *state = hw_state;
+    state->fading_mask = fading_mask;
+    xSemaphoreGive(hw_mutex);
+    
+    return true;
 }
 
 /**
@@ -368,8 +862,7 @@ void control_get_state(hw_control_t *state)
  */
 void control_trigger_motion(void)
 {
-    motion_active = true;
-    last_motion_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    control_notify(CONTROL_EVT_MOTION);
     ESP_LOGI(TAG, "Motion triggered manually");
 }
 
@@ -391,14 +884,21 @@ void control_emergency_shutdown(void)
     ESP_LOGW(TAG, "EMERGENCY SHUTDOWN");
     
     if (xSemaphoreTake(hw_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        // Turn off all outputs
-        set_pwm_duty(LEDC_CH0_CHANNEL, 0);
-        set_pwm_duty(LEDC_CH1_CHANNEL, 0);
+        // Turn off all outputs, cutting any ramp short
+        for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+            set_pwm_duty(ch, 0, false);
+            hw_state.ch_state[ch] = false;
+        }
         
-        hw_state.ch0_state = false;
-        hw_state.ch1_state = false;
         hw_state.pwm_duty = 0;
+        outputs_held = true;
+        
+        // Stay dark through a reset too
+        fastboot_clear();
         
         xSemaphoreGive(hw_mutex);
     }
+    
+    // control_task resyncs its committed duties and keeps the outputs off
+    control_notify(CONTROL_EVT_SHUTDOWN);
 }
\ No newline at end of file
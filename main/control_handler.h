@@ -12,6 +12,7 @@
 #include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "channel_table.h"
 
 /**
  * @struct hw_control_t
@@ -21,17 +22,28 @@
  * channel states, PWM duty cycle, and motion detection status.
  */
 typedef struct {
-    bool ch0_state;
-    bool ch1_state;
-    uint8_t pwm_duty;  // 0-100%
+    bool ch_state[CHANNEL_COUNT];
+    uint8_t pwm_duty;  // 0-100% at the last committed change (outputs may still be ramping)
     bool motion_detected;
+    uint32_t fading_mask;  // Channels with a hardware fade in progress
+    bool night;            // Schedule phase (dusk to dawn)
+    uint8_t schedule_level;  // % of the dimming duty the schedule allows
 } hw_control_t;
 
+// control_task wakeup events (task notification bits)
+#define CONTROL_EVT_COMMAND         (1U << 0)  // New channel command queued
+#define CONTROL_EVT_MOTION          (1U << 1)  // Motion sensor edge or manual trigger
+#define CONTROL_EVT_MOTION_TIMEOUT  (1U << 2)  // Motion one-shot timer expired
+#define CONTROL_EVT_CONFIG          (1U << 3)  // New configuration published
+#define CONTROL_EVT_SCHEDULE        (1U << 4)  // Schedule segment boundary reached
+#define CONTROL_EVT_SHUTDOWN        (1U << 5)  // Emergency shutdown requested
+
 /**
  * @brief Initialize control subsystem
  * 
  * Configures hardware peripherals:
- * - LEDC (PWM) timers and channels for LED control
+ * - LEDC (PWM) timers, channels and the hardware fade service; after a warm
+ *   reset the channels start at the previous run's duties (fastboot.h)
  * - Motion sensor GPIO with interrupt
  * - Charger status GPIO input
  * - Creates mutex for thread-safe hardware access
@@ -42,28 +54,51 @@ void control_init(void);
  * @brief Control task
  * @param pvParameters Task parameters (unused)
  * 
- * Main hardware control loop that:
+ * Event-driven hardware control loop that:
  * - Receives commands from channel processors
  * - Monitors battery voltage for dimming decisions
+ * - Tracks dusk and dawn and scales the duty by the night schedule
  * - Handles motion sensor timeout
- * - Applies PWM duty cycles to hardware outputs
+ * - Applies PWM duty targets when they change; the LEDC fade hardware
+ *   ramps the outputs without further task involvement
  * - Logs periodic status updates
  * 
- * @note Runs continuously at 100ms intervals
+ * @note Blocks on its task notification until a command, a motion edge,
+ *       the motion timer expiry, a schedule boundary or the 5 s status
+ *       heartbeat; sleeps fully when nothing changes.
  */
 void control_task(void *pvParameters);
 
+/**
+ * @brief Wake control_task
+ * @param events CONTROL_EVT_* bits describing the cause
+ * 
+ * Called by producers after queuing work for control_task. Safe to call
+ * before the task has started (the event is dropped).
+ */
+void control_notify(uint32_t events);
+
 // Mutex for hardware access
 extern SemaphoreHandle_t hw_mutex;
 
 /**
  * @brief Get current hardware state
  * @param state Pointer to hw_control_t structure to fill
+ * @return false (state untouched) if hw_mutex stayed busy for 100 ms
  * 
  * Thread-safe query of current hardware state protected by mutex.
  * Used by CLI and status reporting functions.
  */
-void control_get_state(hw_control_t *state);
+bool control_get_state(hw_control_t *state);
+
+/**
+ * @brief Get current hardware state without waiting
+ * @param state Pointer to hw_control_t structure to fill
+ * @return false (state untouched) if control_task holds hw_mutex
+ * 
+ * For periodic reporters that must never delay an output update.
+ */
+bool control_try_get_state(hw_control_t *state);
 
 /**
  * @brief Force motion detection trigger
@@ -86,7 +121,10 @@ bool control_get_charger_status(void);
 /**
  * @brief Emergency shutdown
  * 
- * Immediately turns off all outputs by setting PWM duty to 0%.
+ * Immediately turns off all outputs by setting PWM duty to 0%, stopping
+ * any ramp in progress, and drops the saved fast-boot state so a reset
+ * does not light them again. control_task then holds every output off
+ * until a channel switches on again.
  * Thread-safe operation protected by mutex. Used for critical
  * battery conditions or emergency stop commands.
  */
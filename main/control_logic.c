@@ -0,0 +1,167 @@
+#include "control_logic.h"
+#include "soc_logic.h"
+
+/**
+ * @brief Check a configured curve
+ */
+bool control_logic_curve_valid(const dimming_curve_t *curve)
+{
+    if (curve->count == 0 || curve->count > DIMMING_MAX_POINTS ||
+        curve->hysteresis_mv > DIMMING_MAX_HYSTERESIS_MV || curve->input >= DIMMING_INPUT_COUNT) {
+        return false;
+    }
+    if (curve->input == DIMMING_INPUT_SOC &&
+        curve->point[curve->count - 1].mv > SOC_PERMILLE_FULL) {
+        return false;
+    }
+    
+    for (int i = 0; i < curve->count; i++) {
+        if (curve->point[i].duty > 100) {
+            return false;
+        }
+        if (i > 0 && curve->point[i].mv <= curve->point[i - 1].mv) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Build a stepped curve from three band edges
+ */
+static void dimming_bands(const dimming_params_t *params, uint8_t input, uint16_t critical,
+                          uint16_t half, uint16_t full, dimming_curve_t *curve)
+{
+    // Each band edge is a step between two points one unit apart
+    const dimming_point_t points[] = {
+        { critical - 1, 0, 0 },                     // Critical: off
+        { critical, params->quarter_duty, 0 },      // Very low battery
+        { half - 1, params->quarter_duty, 0 },
+        { half, params->half_duty, 0 },             // Conserve battery
+        { full - 1, params->half_duty, 0 },
+        { full, params->full_duty, 0 },             // Healthy battery
+    };
+    _Static_assert(sizeof(points) / sizeof(points[0]) <= DIMMING_MAX_POINTS,
+                   "default curve exceeds DIMMING_MAX_POINTS");
+    
+    curve->count = sizeof(points) / sizeof(points[0]);
+    curve->input = input;
+    curve->hysteresis_mv = 0;
+    for (int i = 0; i < DIMMING_MAX_POINTS; i++) {
+        curve->point[i] = (i < curve->count) ? points[i] : (dimming_point_t){0};
+    }
+}
+
+/**
+ * @brief Build the default curve from the battery bands
+ */
+void control_logic_default_curve(const dimming_params_t *params, dimming_curve_t *curve)
+{
+    dimming_bands(params, DIMMING_INPUT_VOLTAGE, BATTERY_CRITICAL_THRESHOLD,
+                  BATTERY_HALF_THRESHOLD, BATTERY_FULL_THRESHOLD, curve);
+}
+
+/**
+ * @brief Build the default curve over state of charge
+ */
+void control_logic_default_soc_curve(const dimming_params_t *params, dimming_curve_t *curve)
+{
+    dimming_bands(params, DIMMING_INPUT_SOC, BATTERY_CRITICAL_SOC,
+                  BATTERY_HALF_SOC, BATTERY_FULL_SOC, curve);
+}
+
+/**
+ * @brief Convert a duty percentage to LEDC counts
+ */
+static uint32_t dimming_counts(uint8_t percent, uint32_t max_duty)
+{
+    if (percent > 100) {
+        percent = 100;
+    }
+    return (max_duty * percent) / 100;
+}
+
+/**
+ * @brief Compile a curve to LEDC counts
+ */
+void control_logic_dimming_compile(dimming_table_t *table, const dimming_curve_t *curve,
+                                   uint8_t override_percent, uint32_t max_duty)
+{
+    table->override_duty = dimming_counts(override_percent, max_duty);
+    
+    if (!control_logic_curve_valid(curve)) {
+        // One point at zero duty: outputs off at any voltage
+        table->count = 1;
+        table->input = curve->input < DIMMING_INPUT_COUNT ? curve->input : DIMMING_INPUT_VOLTAGE;
+        table->hysteresis_mv = 0;
+        table->mv[0] = 0;
+        table->duty[0] = 0;
+        table->slope_q16[0] = 0;
+        return;
+    }
+    
+    table->count = curve->count;
+    table->input = curve->input;
+    table->hysteresis_mv = curve->hysteresis_mv;
+    for (int i = 0; i < curve->count; i++) {
+        table->mv[i] = curve->point[i].mv;
+        table->duty[i] = dimming_counts(curve->point[i].duty, max_duty);
+    }
+    for (int i = 0; i < curve->count; i++) {
+        if (i + 1 == curve->count) {
+            table->slope_q16[i] = 0;
+            continue;
+        }
+        int64_t rise = ((int64_t)table->duty[i + 1] - (int64_t)table->duty[i]) * 65536;
+        table->slope_q16[i] = (int32_t)(rise / (int64_t)(table->mv[i + 1] - table->mv[i]));
+    }
+}
+
+/**
+ * @brief Duty for a battery voltage or state of charge
+ */
+uint32_t control_logic_dimming_duty(const dimming_table_t *table, dimming_state_t *state,
+                                    uint32_t battery_mv, bool motion_override)
+{
+    // Hold the evaluated voltage inside the hysteresis band
+    uint32_t moved = (battery_mv > state->input_mv) ? battery_mv - state->input_mv
+                                                    : state->input_mv - battery_mv;
+    if (!state->valid || moved >= table->hysteresis_mv) {
+        state->input_mv = battery_mv;
+        state->valid = true;
+    }
+    
+    // Motion override: always full brightness
+    if (motion_override) {
+        return table->override_duty;
+    }
+    
+    uint32_t mv = state->input_mv;
+    if (mv <= table->mv[0]) {
+        return table->duty[0];
+    }
+    
+    int i = table->count - 1;
+    while (mv < table->mv[i]) {
+        i--;
+    }
+    
+    // Linear between points i and i + 1, flat past the last point
+    int64_t offset = ((int64_t)(mv - table->mv[i]) * table->slope_q16[i] + 0x8000) >> 16;
+    return (uint32_t)((int64_t)table->duty[i] + offset);
+}
+
+/**
+ * @brief Duration of a duty ramp at a constant full-scale rate
+ */
+uint32_t control_logic_fade_ms(uint32_t full_scale_ms, uint32_t from_duty,
+                               uint32_t to_duty, uint32_t max_duty)
+{
+    if (max_duty == 0) {
+        return 0;
+    }
+    
+    uint32_t step = (to_duty > from_duty) ? to_duty - from_duty : from_duty - to_duty;
+    return (uint32_t)(((uint64_t)full_scale_ms * step) / max_duty);
+}
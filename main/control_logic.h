@@ -0,0 +1,162 @@
+/**
+ * @file control_logic.h
+ * @brief Platform-independent battery dimming decision
+ *
+ * Maps battery voltage or state of charge and the motion override to a PWM
+ * duty, and sizes the hardware fade between two duty values.
+ *
+ * The voltage to duty mapping is an N-point curve, linear between points
+ * and flat beyond the first and last. Two points a millivolt apart make a
+ * step, so the fixed battery bands are one such curve (the default). The
+ * curve is compiled once per configuration into LEDC counts and Q16 slopes;
+ * each evaluation is then one segment search and an integer interpolation.
+ * A hysteresis band holds the evaluated voltage until the battery moves by
+ * at least that much, so noise around a step or a slope does not retune
+ * the outputs. A curve over state of charge works the same way, with its
+ * points and hysteresis in 0.1 % instead of mV.
+ *
+ * control_handler recompiles the table whenever its configuration changes.
+ */
+
+#ifndef CONTROL_LOGIC_H
+#define CONTROL_LOGIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Battery levels of the default dimming curve (in mV)
+#define BATTERY_FULL_THRESHOLD      13500  // 13.5V - full operation
+#define BATTERY_HALF_THRESHOLD      12000  // 12.0V - half brightness
+#define BATTERY_CRITICAL_THRESHOLD  11000  // 11.0V - shut off loads
+
+// State-of-charge levels of the default curve with current sensing (in 0.1 %)
+#define BATTERY_FULL_SOC            800     // 80% - full operation
+#define BATTERY_HALF_SOC            500     // 50% - half brightness
+#define BATTERY_CRITICAL_SOC        200     // 20% - shut off loads
+
+// Most points of a dimming curve
+#define DIMMING_MAX_POINTS          8
+
+// Widest hysteresis band accepted for a curve
+#define DIMMING_MAX_HYSTERESIS_MV   1000
+
+/**
+ * @brief Quantity a dimming curve is evaluated on
+ */
+typedef enum {
+    DIMMING_INPUT_VOLTAGE = 0,  // Battery voltage in mV
+    DIMMING_INPUT_SOC,          // State of charge in 0.1 %
+    DIMMING_INPUT_COUNT
+} dimming_input_t;
+
+/**
+ * @struct dimming_params_t
+ * @brief Duty levels of the default curve's battery bands
+ */
+typedef struct {
+    uint8_t full_duty;          // % at full brightness / motion override
+    uint8_t half_duty;          // % when conserving battery
+    uint8_t quarter_duty;       // % at very low battery
+} dimming_params_t;
+
+/**
+ * @struct dimming_point_t
+ * @brief One point of a dimming curve
+ */
+typedef struct {
+    uint16_t mv;                // Battery voltage (state of charge in 0.1 % for SoC curves)
+    uint8_t duty;               // % at that input
+    uint8_t reserved;
+} dimming_point_t;
+
+/**
+ * @struct dimming_curve_t
+ * @brief Voltage to duty curve as configured (stored as an NVS blob)
+ */
+typedef struct {
+    uint8_t count;              // Points in use, 0 = default curve
+    uint8_t input;              // dimming_input_t
+    uint16_t hysteresis_mv;     // Input change needed to re-evaluate
+    dimming_point_t point[DIMMING_MAX_POINTS];  // Strictly ascending mv
+} dimming_curve_t;
+
+/**
+ * @struct dimming_table_t
+ * @brief Curve compiled to LEDC counts for control_logic_dimming_duty()
+ */
+typedef struct {
+    uint8_t count;
+    uint8_t input;              // dimming_input_t
+    uint16_t hysteresis_mv;
+    uint32_t override_duty;     // Counts while motion forces full brightness
+    uint32_t mv[DIMMING_MAX_POINTS];
+    uint32_t duty[DIMMING_MAX_POINTS];
+    int32_t slope_q16[DIMMING_MAX_POINTS];  // Counts per mV up to the next point
+} dimming_table_t;
+
+/**
+ * @struct dimming_state_t
+ * @brief Hysteresis state of one evaluation stream
+ */
+typedef struct {
+    uint32_t input_mv;          // Input the duty was last evaluated at
+    bool valid;
+} dimming_state_t;
+
+/**
+ * @brief Check a configured curve
+ * @return true if it has 1 to DIMMING_MAX_POINTS strictly ascending points,
+ *         duties up to 100 % and a hysteresis up to DIMMING_MAX_HYSTERESIS_MV
+ *         (SoC points up to 100 %)
+ */
+bool control_logic_curve_valid(const dimming_curve_t *curve);
+
+/**
+ * @brief Build the default curve: the fixed battery bands, no hysteresis
+ * @param params Duty levels of the bands
+ * @param curve Filled with the stepped curve
+ */
+void control_logic_default_curve(const dimming_params_t *params, dimming_curve_t *curve);
+
+/**
+ * @brief Build the default curve over state of charge: the same bands at
+ *        the BATTERY_*_SOC levels, no hysteresis
+ * @param params Duty levels of the bands
+ * @param curve Filled with the stepped curve
+ */
+void control_logic_default_soc_curve(const dimming_params_t *params, dimming_curve_t *curve);
+
+/**
+ * @brief Compile a curve to LEDC counts
+ * @param table Compiled table
+ * @param curve Curve (an invalid curve compiles to outputs off)
+ * @param override_percent Duty % while motion forces full brightness
+ * @param max_duty LEDC counts at 100 %
+ */
+void control_logic_dimming_compile(dimming_table_t *table, const dimming_curve_t *curve,
+                                   uint8_t override_percent, uint32_t max_duty);
+
+/**
+ * @brief Duty for a battery voltage or state of charge
+ * @param table Compiled curve
+ * @param state Hysteresis state (zero-initialized for a new stream)
+ * @param battery_mv Battery voltage in mV, or state of charge in 0.1 % if
+ *                   the table's input is DIMMING_INPUT_SOC
+ * @param motion_override true while motion forces full brightness
+ * @return Duty in LEDC counts
+ */
+uint32_t control_logic_dimming_duty(const dimming_table_t *table, dimming_state_t *state,
+                                    uint32_t battery_mv, bool motion_override);
+
+/**
+ * @brief Duration of a duty ramp at a constant full-scale rate
+ * @param full_scale_ms Time of a 0 to max_duty ramp (0 = instant)
+ * @param from_duty Current duty
+ * @param to_duty Target duty
+ * @param max_duty Full-scale duty
+ * @return Ramp time in ms, 0 to switch at once
+ */
+uint32_t control_logic_fade_ms(uint32_t full_scale_ms, uint32_t from_duty,
+                               uint32_t to_duty, uint32_t max_duty);
+
+#endif
@@ -0,0 +1,163 @@
+#include "fastboot.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "FASTBOOT";
+
+#if CONFIG_SOLAR_FAST_BOOT
+
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#define FASTBOOT_MAGIC      0x54534642  // "BFST"
+
+/**
+ * @struct fastboot_snapshot_t
+ * @brief RTC memory image, checked by size and CRC before use
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t size;                  // sizeof(fastboot_snapshot_t) of the writer
+    uint32_t resumes;               // Boots resumed from this state in a row
+    fastboot_state_t state;
+    uint32_t crc;                   // esp_rom_crc32_le() of the bytes above
+} fastboot_snapshot_t;
+
+// Not cleared by the startup code, so it outlives every reset but power-on
+static RTC_NOINIT_ATTR fastboot_snapshot_t snapshot;
+
+// State found at boot; read-only once fastboot_init() returns
+static fastboot_state_t restored;
+static bool restored_valid = false;
+
+// Resumes in a row including this boot, saved until the run is stable
+static uint32_t boot_resumes = 0;
+
+/**
+ * @brief CRC of a snapshot's contents
+ */
+static uint32_t snapshot_crc(const fastboot_snapshot_t *image)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)image, offsetof(fastboot_snapshot_t, crc));
+}
+
+/**
+ * @brief Write a sealed image into RTC memory
+ */
+static void snapshot_write(const fastboot_state_t *state, uint32_t resumes)
+{
+    fastboot_snapshot_t image;
+    memset(&image, 0, sizeof(image));
+    image.magic = FASTBOOT_MAGIC;
+    image.size = sizeof(image);
+    image.resumes = resumes;
+    image.state = *state;
+    image.crc = snapshot_crc(&image);
+    
+    snapshot = image;
+}
+
+/**
+ * @brief Validate the snapshot left by the previous run
+ */
+void fastboot_init(void)
+{
+    esp_reset_reason_t reason = esp_reset_reason();
+    
+    // RTC memory holds noise after power-on; the CRC would almost always
+    // catch it, but an outage is a cold start either way
+    if (reason == ESP_RST_POWERON || reason == ESP_RST_UNKNOWN) {
+        ESP_LOGI(TAG, "Power-on reset: outputs start dark");
+        memset(&snapshot, 0, sizeof(snapshot));
+        return;
+    }
+    
+    fastboot_snapshot_t image = snapshot;
+    if (image.magic != FASTBOOT_MAGIC || image.size != sizeof(image) ||
+        image.crc != snapshot_crc(&image)) {
+        ESP_LOGI(TAG, "No saved output state (reset reason %d)", (int)reason);
+        return;
+    }
+    
+    if (image.resumes >= FASTBOOT_MAX_RESUMES) {
+        ESP_LOGW(TAG, "%u resets in a row since the last stable run: outputs start dark",
+                 (unsigned int)image.resumes);
+        memset(&snapshot, 0, sizeof(snapshot));
+        return;
+    }
+    
+    // Counted until this run has been up FASTBOOT_STABLE_MS
+    boot_resumes = image.resumes + 1;
+    snapshot_write(&image.state, boot_resumes);
+    
+    restored = image.state;
+    restored_valid = true;
+    ESP_LOGI(TAG, "Resuming outputs 0x%x at %u%% (%s, reset reason %d, resume %u)",
+             (unsigned int)restored.output_mask, restored.duty_percent,
+             restored.night ? "night" : "day", (int)reason,
+             (unsigned int)boot_resumes);
+}
+
+/**
+ * @brief Get the state to resume from
+ */
+bool fastboot_get(fastboot_state_t *state)
+{
+    if (!restored_valid || state == NULL) {
+        return false;
+    }
+    
+    *state = restored;
+    return true;
+}
+
+/**
+ * @brief Save the current output state
+ */
+void fastboot_save(const fastboot_state_t *state)
+{
+    if (state == NULL) {
+        return;
+    }
+    
+    // A run that stayed up clears the count of resets in a row
+    if (boot_resumes != 0 && esp_timer_get_time() >= (int64_t)FASTBOOT_STABLE_MS * 1000) {
+        boot_resumes = 0;
+    }
+    snapshot_write(state, boot_resumes);
+}
+
+/**
+ * @brief Drop the saved state
+ */
+void fastboot_clear(void)
+{
+    memset(&snapshot, 0, sizeof(snapshot));
+    ESP_LOGI(TAG, "Saved output state cleared: the next boot starts dark");
+}
+
+#else
+
+void fastboot_init(void)
+{
+    ESP_LOGI(TAG, "Fast boot disabled (CONFIG_SOLAR_FAST_BOOT)");
+}
+
+bool fastboot_get(fastboot_state_t *state)
+{
+    return false;
+}
+
+void fastboot_save(const fastboot_state_t *state)
+{
+}
+
+void fastboot_clear(void)
+{
+}
+
+#endif
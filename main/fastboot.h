@@ -0,0 +1,75 @@
+/**
+ * @file fastboot.h
+ * @brief Output state kept in RTC memory across resets
+ *
+ * control_task saves the committed LEDC duties, the channel outputs, the
+ * filtered channel voltages and the night phase after every change and at
+ * each status heartbeat. RTC slow memory survives brownout, watchdog,
+ * panic and software resets, so after such a reset control_init() starts
+ * the LEDC channels at the saved duties and the channel and control logic
+ * resume from the saved state: the lights stay on through a reset at night
+ * instead of going dark until the filters settle and the debounce expires.
+ *
+ * The snapshot is dropped after a power-on reset, an emergency shutdown,
+ * a firmware change of its layout, or FASTBOOT_MAX_RESUMES resets in a
+ * row within FASTBOOT_STABLE_MS of boot (a restored load that keeps
+ * browning the supply out).
+ *
+ * Compiled to stubs unless CONFIG_SOLAR_FAST_BOOT is set.
+ */
+
+#ifndef FASTBOOT_H
+#define FASTBOOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "channel_table.h"
+
+// Consecutive resumes allowed within FASTBOOT_STABLE_MS of boot
+#define FASTBOOT_MAX_RESUMES    3
+
+// Uptime after which a run counts as stable and the resume count clears
+#define FASTBOOT_STABLE_MS      60000
+
+/**
+ * @struct fastboot_state_t
+ * @brief Output state of the previous run
+ */
+typedef struct {
+    uint32_t max_duty;                      // LEDC full scale the duties are counted in
+    uint32_t duty[CHANNEL_COUNT];           // Committed duty targets
+    int32_t filtered_mv[CHANNEL_COUNT];     // Filtered channel inputs
+    uint32_t output_mask;                   // Channel outputs ON (bit per channel)
+    uint8_t duty_percent;                   // Dimming level behind the duties
+    bool night;                             // Schedule phase
+    uint32_t since_dusk_ms;                 // Night time elapsed (night only)
+} fastboot_state_t;
+
+/**
+ * @brief Validate the snapshot left by the previous run
+ *
+ * Call once, first thing at boot. Logs the outcome.
+ */
+void fastboot_init(void);
+
+/**
+ * @brief Get the state to resume from
+ * @param state Filled with the previous run's state
+ * @return false if there is none (cold start)
+ */
+bool fastboot_get(fastboot_state_t *state);
+
+/**
+ * @brief Save the current output state (control_task only)
+ */
+void fastboot_save(const fastboot_state_t *state);
+
+/**
+ * @brief Drop the saved state so the next boot starts dark
+ *
+ * Only the current snapshot is dropped; the caller stops saving for as long
+ * as the outputs should stay dark.
+ */
+void fastboot_clear(void);
+
+#endif
@@ -0,0 +1,790 @@
+#include "fleet.h"
+#include "adc_handler.h"
+#include "cli_handler.h"
+#include "nvs_storage.h"
+#include "samplelog.h"
+#include "telemetry.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "FLEET";
+
+#if CONFIG_SOLAR_FLEET_UPLOAD
+
+#include "esp_event.h"
+#include "esp_mac.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "mqtt_client.h"
+#include "mbedtls/constant_time.h"
+#include "mbedtls/md.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "rtos_alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if CONFIG_SOLAR_FLEET_VERIFY_BUNDLE
+#include "esp_crt_bundle.h"
+#else
+// main/fleet_ca.pem, embedded by CMakeLists.txt
+extern const char fleet_ca_pem_start[] asm("_binary_fleet_ca_pem_start");
+#endif
+
+// Upload phase timeouts
+#define FLEET_WIFI_TIMEOUT_MS       20000   // Radio on to IP address
+#define FLEET_BROKER_TIMEOUT_MS     10000   // IP address to MQTT session
+#define FLEET_ACK_TIMEOUT_MS        10000   // Publish to PUBACK
+#define FLEET_LINGER_MS             2000    // Session time left for queued config
+
+// fleet_task notifications
+#define FLEET_EVT_BURST             (1U << 0)   // Upload now
+#define FLEET_EVT_RESCHEDULE        (1U << 1)   // Interval may have changed
+
+// fleet_events bits, set by the Wi-Fi and MQTT event handlers
+#define FLEET_BIT_GOT_IP            (1U << 0)
+#define FLEET_BIT_CONNECTED         (1U << 1)
+#define FLEET_BIT_ACKED             (1U << 2)
+#define FLEET_BIT_DOWN              (1U << 3)   // Wi-Fi or broker lost
+
+#define FLEET_CONFIG_QUEUE_DEPTH    2
+#define FLEET_TOPIC_MAX             64
+
+// Config push authentication: HMAC-SHA256 under a 256-bit key
+#define FLEET_KEY_BYTES             32
+#define FLEET_MAC_BYTES             32
+
+/**
+ * @struct fleet_config_msg_t
+ * @brief Configuration push handed from the MQTT task to fleet_task
+ */
+typedef struct {
+    uint16_t length;
+    char text[FLEET_CONFIG_MAX_BYTES + 1];
+} fleet_config_msg_t;
+
+static TaskHandle_t fleet_task_handle = NULL;
+static EventGroupHandle_t fleet_events = NULL;
+static QueueHandle_t config_queue = NULL;
+RTOS_EVENT_GROUP_STORAGE(fleet_events);
+RTOS_QUEUE_STORAGE(config_queue, FLEET_CONFIG_QUEUE_DEPTH, sizeof(fleet_config_msg_t));
+static esp_mqtt_client_handle_t mqtt_client = NULL;
+static volatile bool radio_on = false;
+static volatile int acked_msg_id = -1;
+
+static uint8_t unit_id[FLEET_UNIT_ID_LEN];
+static char unit_hex[2 * FLEET_UNIT_ID_LEN + 1];
+
+// Config push key from CONFIG_SOLAR_FLEET_CONFIG_KEY (pushes refused without one)
+static uint8_t config_key[FLEET_KEY_BYTES];
+static bool config_key_valid = false;
+static char topic_status[FLEET_TOPIC_MAX];
+static char topic_samples[FLEET_TOPIC_MAX];
+static char topic_config[FLEET_TOPIC_MAX];
+
+// Samples message being filled and the page read into it (fleet_task only)
+static uint8_t message[sizeof(fleet_header_t) + FLEET_MESSAGE_PAGES * sizeof(samplelog_page_t)];
+static samplelog_page_t page_buffer;
+static fleet_config_msg_t config_msg;
+
+// Upload position: next sample log page the broker has not acknowledged
+static uint32_t next_sequence = 0;
+static bool synced = false;     // next_sequence known (false until the first upload)
+
+// Statistics since boot
+static volatile bool burst_active = false;
+static uint32_t burst_count = 0;
+static uint32_t burst_failures = 0;
+static uint32_t last_connect_ms = 0;
+static uint32_t last_radio_ms = 0;
+static uint32_t last_burst_ms = 0;
+static uint32_t pages_sent = 0;
+static uint32_t bytes_sent = 0;
+static uint32_t config_applied = 0;
+static uint32_t config_rejected = 0;
+
+static uint32_t fleet_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/**
+ * @brief Upload interval in effect
+ */
+static uint32_t fleet_interval_s(void)
+{
+    uint32_t interval_s = nvs_get_fleet_interval();
+    return interval_s ? interval_s : CONFIG_SOLAR_FLEET_INTERVAL_S;
+}
+
+/**
+ * @brief Wi-Fi and IP events
+ */
+static void wifi_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    if (base == WIFI_EVENT && id == WIFI_EVENT_STA_START) {
+        esp_wifi_connect();
+    } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+        xEventGroupClearBits(fleet_events, FLEET_BIT_GOT_IP);
+        xEventGroupSetBits(fleet_events, FLEET_BIT_DOWN);
+        if (radio_on) {
+            esp_wifi_connect();
+        }
+    } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        xEventGroupSetBits(fleet_events, FLEET_BIT_GOT_IP);
+    }
+}
+
+/**
+ * @brief Queue a configuration push for fleet_task
+ *
+ * Runs in the MQTT task. Fragmented or oversized messages are dropped.
+ */
+static void fleet_receive_config(const esp_mqtt_event_t *event)
+{
+    if (event->current_data_offset != 0 || event->data_len != event->total_data_len ||
+        event->data_len > FLEET_CONFIG_MAX_BYTES) {
+        ESP_LOGW(TAG, "Config push of %d bytes dropped (max %d)",
+                 event->total_data_len, FLEET_CONFIG_MAX_BYTES);
+        config_rejected++;
+        return;
+    }
+    
+    static fleet_config_msg_t incoming;
+    incoming.length = (uint16_t)event->data_len;
+    memcpy(incoming.text, event->data, event->data_len);
+    incoming.text[event->data_len] = '\0';
+    
+    if (xQueueSend(config_queue, &incoming, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Config queue full, push dropped");
+        config_rejected++;
+    }
+}
+
+/**
+ * @brief MQTT client events
+ */
+static void mqtt_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    esp_mqtt_event_handle_t event = data;
+    
+    switch ((esp_mqtt_event_id_t)id) {
+    case MQTT_EVENT_CONNECTED:
+        xEventGroupSetBits(fleet_events, FLEET_BIT_CONNECTED);
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        xEventGroupClearBits(fleet_events, FLEET_BIT_CONNECTED);
+        xEventGroupSetBits(fleet_events, FLEET_BIT_DOWN);
+        break;
+    case MQTT_EVENT_PUBLISHED:
+        acked_msg_id = event->msg_id;
+        xEventGroupSetBits(fleet_events, FLEET_BIT_ACKED);
+        break;
+    case MQTT_EVENT_DATA:
+        if (event->topic_len == (int)strlen(topic_config) &&
+            strncmp(event->topic, topic_config, event->topic_len) == 0) {
+            fleet_receive_config(event);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Publish one message and wait for the broker's acknowledgement
+ */
+static bool fleet_publish(const char *topic, const void *data, size_t len)
+{
+    xEventGroupClearBits(fleet_events, FLEET_BIT_ACKED | FLEET_BIT_DOWN);
+    acked_msg_id = -1;
+    
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, data, (int)len, 1, 0);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Publish to %s failed", topic);
+        return false;
+    }
+    
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(FLEET_ACK_TIMEOUT_MS);
+    while (acked_msg_id != msg_id) {
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(deadline - now) <= 0) {
+            ESP_LOGE(TAG, "No acknowledgement for %s", topic);
+            return false;
+        }
+        EventBits_t bits = xEventGroupWaitBits(fleet_events, FLEET_BIT_ACKED | FLEET_BIT_DOWN,
+                                               pdTRUE, pdFALSE, deadline - now);
+        if (bits & FLEET_BIT_DOWN) {
+            ESP_LOGE(TAG, "Connection lost publishing %s", topic);
+            return false;
+        }
+    }
+    
+    bytes_sent += (uint32_t)len;
+    return true;
+}
+
+/**
+ * @brief Publish the status record
+ */
+static bool fleet_publish_status(void)
+{
+    struct __attribute__((packed)) {
+        fleet_header_t header;
+        fleet_status_t status;
+    } msg;
+    
+    fleet_header_init(&msg.header, FLEET_TYPE_STATUS, unit_id, burst_count);
+    msg.header.count = 1;
+    msg.header.length = sizeof(msg.status);
+    
+    memset(&msg.status, 0, sizeof(msg.status));
+    telemetry_get_status(&msg.status.status);
+    msg.status.status.sequence = burst_count;
+    
+    verification_data_t verification;
+    nvs_load_verification(&verification);
+    msg.status.uptime_hours = verification.uptime_hours;
+    msg.status.charge_cycles = verification.charge_cycles;
+    msg.status.last_voltage_mv = verification.last_voltage_mv;
+    
+    adc_reading_t reading;
+    adc_get_latest_reading(&reading, ADC_READING_MAX_AGE_MS);
+    msg.status.current_ma = reading.current_ma;
+    msg.status.soc_permille = reading.soc_permille;
+    msg.status.interval_s = fleet_interval_s();
+    msg.status.bursts_failed = burst_failures;
+    msg.status.last_connect_ms = last_connect_ms;
+    msg.status.config_applied = config_applied;
+    msg.status.config_rejected = config_rejected;
+    
+    return fleet_publish(topic_status, &msg, sizeof(msg));
+}
+
+/**
+ * @brief Publish the samples message being filled and start the next one
+ * @param flash_end Sequence after its last flash page (becomes next_sequence)
+ */
+static bool fleet_flush_samples(uint32_t flash_end)
+{
+    fleet_header_t *header = (fleet_header_t *)message;
+    bool ok = true;
+    
+    if (header->count > 0) {
+        ok = fleet_publish(topic_samples, message, sizeof(*header) + header->length);
+        if (ok) {
+            pages_sent += header->count;
+        }
+    }
+    if (ok) {
+        next_sequence = flash_end;
+        synced = true;
+    }
+    
+    fleet_header_init(header, FLEET_TYPE_SAMPLES, unit_id, burst_count);
+    return ok;
+}
+
+/**
+ * @brief Publish the sample log pages not yet acknowledged, oldest first
+ *
+ * The staging page goes last, flagged partial; it is not counted as
+ * uploaded, so the complete page follows in a later upload.
+ */
+static bool fleet_publish_samples(void)
+{
+    samplelog_dump_t plan;
+    if (!samplelog_dump_prepare(&plan)) {
+        return true;
+    }
+    
+    // Flash page n of the plan has sequence stage_sequence - flash_pages + n
+    uint32_t first;
+    if (!synced) {
+        first = plan.flash_pages > FLEET_RESEND_PAGES ? plan.flash_pages - FLEET_RESEND_PAGES : 0;
+    } else {
+        uint32_t behind = plan.stage_sequence - next_sequence;
+        if (behind > plan.flash_pages) {
+            ESP_LOGW(TAG, "%u pages overwritten before upload",
+                     (unsigned int)(behind - plan.flash_pages));
+            behind = plan.flash_pages;
+        }
+        first = plan.flash_pages - behind;
+    }
+    
+    uint32_t last = plan.flash_pages;
+    if (last - first > FLEET_MAX_PAGES_PER_BURST) {
+        last = first + FLEET_MAX_PAGES_PER_BURST;
+        ESP_LOGW(TAG, "%u pages behind, sending the oldest %d",
+                 (unsigned int)(plan.flash_pages - first), FLEET_MAX_PAGES_PER_BURST);
+    } else if (plan.staged) {
+        // Caught up: the staging page goes too
+        last = plan.total;
+    }
+    
+    fleet_header_t *header = (fleet_header_t *)message;
+    fleet_header_init(header, FLEET_TYPE_SAMPLES, unit_id, burst_count);
+    uint32_t flash_end = plan.stage_sequence - (plan.flash_pages - first);
+    
+    for (uint32_t n = first; n < last; n++) {
+        if (samplelog_read_page(&plan, n, &page_buffer) != ESP_OK ||
+            !samplelog_header_valid(&page_buffer.header) || page_buffer.header.count == 0) {
+            continue;
+        }
+        
+        if (!fleet_append_page(message, sizeof(message), &page_buffer)) {
+            if (!fleet_flush_samples(flash_end)) {
+                return false;
+            }
+            fleet_append_page(message, sizeof(message), &page_buffer);
+        }
+        if (n >= plan.flash_pages) {
+            header->flags |= FLEET_FLAG_PARTIAL;
+        } else {
+            flash_end = page_buffer.header.sequence + 1;
+        }
+    }
+    
+    return fleet_flush_samples(flash_end);
+}
+
+/**
+ * @brief Decode exactly len bytes of hex
+ */
+static bool fleet_hex_decode(const char *hex, uint8_t *out, size_t len)
+{
+    if (strlen(hex) != 2 * len) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < 2 * len; i++) {
+        char c = hex[i];
+        int nibble = (c >= '0' && c <= '9') ? c - '0' :
+                     (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                     (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (nibble < 0) {
+            return false;
+        }
+        out[i / 2] = (uint8_t)((i % 2) ? (out[i / 2] | nibble) : (nibble << 4));
+    }
+    return true;
+}
+
+/**
+ * @brief Authenticate a configuration push
+ * @param msg Push; its first line is replaced by a terminator
+ * @param seq Set to the push's sequence number
+ * @return The lines after the auth line, or NULL for a push that is not
+ *         signed with the fleet key or is not newer than the last accepted
+ *
+ * The first line is "auth <seq> <hmac>", the HMAC-SHA256 in hex over
+ * "<unit> <seq>\n" and the rest of the push. The unit binds a push to one
+ * controller and the sequence number stops a recorded push being replayed.
+ */
+static char *fleet_authenticate_config(fleet_config_msg_t *msg, uint32_t *seq)
+{
+    if (!config_key_valid) {
+        ESP_LOGW(TAG, "Config push refused: no fleet config key");
+        return NULL;
+    }
+    
+    char *body = strchr(msg->text, '\n');
+    if (strncmp(msg->text, "auth ", 5) != 0 || body == NULL) {
+        ESP_LOGW(TAG, "Config push refused: no auth line");
+        return NULL;
+    }
+    *body++ = '\0';
+    size_t body_len = msg->length - (size_t)(body - msg->text);
+    
+    // Digits only: strtoull() would also take a sign or leading spaces
+    char *mac_hex = msg->text + 5;
+    unsigned long long value = 0;
+    if (*mac_hex >= '0' && *mac_hex <= '9') {
+        value = strtoull(msg->text + 5, &mac_hex, 10);
+    }
+    mac_hex[strcspn(mac_hex, "\r")] = '\0';
+    uint8_t mac[FLEET_MAC_BYTES];
+    if (value == 0 || value > UINT32_MAX || *mac_hex != ' ' ||
+        !fleet_hex_decode(mac_hex + 1, mac, sizeof(mac))) {
+        ESP_LOGW(TAG, "Config push refused: malformed auth line");
+        return NULL;
+    }
+    
+    char prefix[sizeof(unit_hex) + 12];
+    int prefix_len = snprintf(prefix, sizeof(prefix), "%s %u\n", unit_hex, (unsigned int)value);
+    uint8_t expected[FLEET_MAC_BYTES];
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    int err = mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+    if (err == 0) {
+        err = mbedtls_md_hmac_starts(&ctx, config_key, sizeof(config_key));
+    }
+    if (err == 0) {
+        err = mbedtls_md_hmac_update(&ctx, (const unsigned char *)prefix, prefix_len);
+    }
+    if (err == 0) {
+        err = mbedtls_md_hmac_update(&ctx, (const unsigned char *)body, body_len);
+    }
+    if (err == 0) {
+        err = mbedtls_md_hmac_finish(&ctx, expected);
+    }
+    mbedtls_md_free(&ctx);
+    
+    if (err != 0 || mbedtls_ct_memcmp(expected, mac, sizeof(mac)) != 0) {
+        ESP_LOGW(TAG, "Config push refused: bad signature");
+        return NULL;
+    }
+    uint32_t last = nvs_get_fleet_config_seq();
+    if (value <= last) {
+        ESP_LOGW(TAG, "Config push refused: sequence %u not above %u",
+                 (unsigned int)value, (unsigned int)last);
+        return NULL;
+    }
+    
+    *seq = (uint32_t)value;
+    return body;
+}
+
+/**
+ * @brief Run the lines of an authenticated configuration push as console commands
+ */
+static void fleet_apply_config(fleet_config_msg_t *msg)
+{
+    uint32_t seq = 0;
+    char *body = fleet_authenticate_config(msg, &seq);
+    if (body == NULL) {
+        config_rejected++;
+        return;
+    }
+    // Recorded before the lines run, so a push that fails halfway is not replayable
+    nvs_set_fleet_config_seq(seq);
+    
+    char *save = NULL;
+    for (char *line = strtok_r(body, "\r\n;", &save); line != NULL;
+         line = strtok_r(NULL, "\r\n;", &save)) {
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+        if (*line == '\0' || *line == '#') {
+            continue;
+        }
+        
+        int ret = 0;
+        esp_err_t err = cli_run_command(line, true, &ret);
+        if (err == ESP_OK && ret == 0) {
+            ESP_LOGI(TAG, "Config applied: %s", line);
+            config_applied++;
+        } else {
+            ESP_LOGW(TAG, "Config rejected (%s): %s",
+                     err == ESP_OK ? "command failed" : esp_err_to_name(err), line);
+            config_rejected++;
+        }
+    }
+    nvs_save_config();
+}
+
+/**
+ * @brief Apply configuration pushes queued until the deadline
+ */
+static void fleet_drain_config(TickType_t deadline)
+{
+    while (1) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+        if (xQueueReceive(config_queue, &config_msg, wait) != pdTRUE) {
+            return;
+        }
+        fleet_apply_config(&config_msg);
+    }
+}
+
+/**
+ * @brief Wait for an event bit
+ */
+static bool fleet_wait(EventBits_t bit, uint32_t timeout_ms)
+{
+    EventBits_t bits = xEventGroupWaitBits(fleet_events, bit, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(timeout_ms));
+    return (bits & bit) != 0;
+}
+
+/**
+ * @brief Broker session of an upload: publish, take config
+ */
+static bool fleet_session(uint32_t start_ms)
+{
+    esp_err_t err = esp_mqtt_client_start(mqtt_client);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start MQTT client: %s", esp_err_to_name(err));
+        return false;
+    }
+    
+    bool ok = false;
+    if (!fleet_wait(FLEET_BIT_CONNECTED, FLEET_BROKER_TIMEOUT_MS)) {
+        ESP_LOGE(TAG, "Broker not reached after %d ms", FLEET_BROKER_TIMEOUT_MS);
+    } else {
+        last_connect_ms = fleet_now_ms() - start_ms;
+        
+        // Persistent session: pushes queued while offline arrive from here on
+        TickType_t linger_end = xTaskGetTickCount() + pdMS_TO_TICKS(FLEET_LINGER_MS);
+        esp_mqtt_client_subscribe(mqtt_client, topic_config, 1);
+        
+        ok = fleet_publish_status() && fleet_publish_samples();
+        fleet_drain_config(linger_end);
+    }
+    
+    esp_mqtt_client_stop(mqtt_client);
+    return ok;
+}
+
+/**
+ * @brief One upload: radio on, broker session, radio off
+ */
+static bool fleet_burst(void)
+{
+    uint32_t start_ms = fleet_now_ms();
+    bool ok = false;
+    
+    burst_active = true;
+    burst_count++;
+    xEventGroupClearBits(fleet_events, FLEET_BIT_GOT_IP | FLEET_BIT_CONNECTED | FLEET_BIT_DOWN);
+    
+    radio_on = true;
+    esp_err_t err = esp_wifi_start();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start Wi-Fi: %s", esp_err_to_name(err));
+    } else if (!fleet_wait(FLEET_BIT_GOT_IP, FLEET_WIFI_TIMEOUT_MS)) {
+        ESP_LOGE(TAG, "No IP address after %d ms", FLEET_WIFI_TIMEOUT_MS);
+    } else {
+        ok = fleet_session(start_ms);
+    }
+    radio_on = false;
+    esp_wifi_stop();
+    
+    last_radio_ms = fleet_now_ms() - start_ms;
+    if (!ok) {
+        burst_failures++;
+    }
+    burst_active = false;
+    
+    ESP_LOGI(TAG, "Upload %u %s: connect %u ms, radio %u ms, next page %u",
+             (unsigned int)burst_count, ok ? "done" : "failed",
+             (unsigned int)last_connect_ms, (unsigned int)last_radio_ms,
+             (unsigned int)next_sequence);
+    return ok;
+}
+
+/**
+ * @brief Reschedule on configuration changes (the interval may have changed)
+ */
+static void fleet_config_changed(uint32_t generation)
+{
+    if (fleet_task_handle != NULL) {
+        xTaskNotify(fleet_task_handle, FLEET_EVT_RESCHEDULE, eSetBits);
+    }
+}
+
+/**
+ * @brief Initialize the network stack and the MQTT client
+ */
+void fleet_init(void)
+{
+    fleet_events = RTOS_EVENT_GROUP_CREATE(fleet_events);
+    config_queue = RTOS_QUEUE_CREATE(config_queue, FLEET_CONFIG_QUEUE_DEPTH, sizeof(fleet_config_msg_t));
+    if (fleet_events == NULL || config_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create fleet events/queue");
+        return;
+    }
+    
+    esp_err_t err = esp_netif_init();
+    if (err == ESP_OK) {
+        err = esp_event_loop_create_default();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize the network stack: %s", esp_err_to_name(err));
+        return;
+    }
+    esp_netif_create_default_wifi_sta();
+    
+    // Credentials come from sdkconfig: keep Wi-Fi from writing them to NVS
+    wifi_init_config_t init_config = WIFI_INIT_CONFIG_DEFAULT();
+    err = esp_wifi_init(&init_config);
+    if (err == ESP_OK) {
+        err = esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    }
+    if (err == ESP_OK) {
+        err = esp_wifi_set_mode(WIFI_MODE_STA);
+    }
+    if (err == ESP_OK) {
+        wifi_config_t wifi_config = {
+            .sta = {
+                .ssid = CONFIG_SOLAR_FLEET_WIFI_SSID,
+                .password = CONFIG_SOLAR_FLEET_WIFI_PASSWORD,
+            },
+        };
+        err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    }
+    if (err == ESP_OK) {
+        err = esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event_handler, NULL);
+    }
+    if (err == ESP_OK) {
+        err = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize Wi-Fi: %s", esp_err_to_name(err));
+        return;
+    }
+    
+    // Unit id and topics from the station MAC
+    esp_read_mac(unit_id, ESP_MAC_WIFI_STA);
+    for (int i = 0; i < FLEET_UNIT_ID_LEN; i++) {
+        snprintf(&unit_hex[2 * i], 3, "%02x", unit_id[i]);
+    }
+    snprintf(topic_status, sizeof(topic_status), "%s/%s/status", CONFIG_SOLAR_FLEET_TOPIC_ROOT, unit_hex);
+    snprintf(topic_samples, sizeof(topic_samples), "%s/%s/samples", CONFIG_SOLAR_FLEET_TOPIC_ROOT, unit_hex);
+    snprintf(topic_config, sizeof(topic_config), "%s/%s/config", CONFIG_SOLAR_FLEET_TOPIC_ROOT, unit_hex);
+    
+    config_key_valid = fleet_hex_decode(CONFIG_SOLAR_FLEET_CONFIG_KEY, config_key, sizeof(config_key));
+    if (!config_key_valid) {
+        ESP_LOGW(TAG, "No fleet config key (64 hex digits): config pushes will be refused");
+    }
+    if (strncmp(CONFIG_SOLAR_FLEET_BROKER_URI, "mqtts://", 8) != 0) {
+        ESP_LOGW(TAG, "Broker URI is not mqtts://: uploads and broker credentials are not encrypted");
+    }
+    
+    // Persistent session keyed by the unit, reconnected only by fleet_task
+    const esp_mqtt_client_config_t mqtt_config = {
+        .broker.address.uri = CONFIG_SOLAR_FLEET_BROKER_URI,
+#if CONFIG_SOLAR_FLEET_VERIFY_BUNDLE
+        .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
+#else
+        .broker.verification.certificate = fleet_ca_pem_start,
+#endif
+        .credentials.client_id = unit_hex,
+        .session.disable_clean_session = true,
+        .network.disable_auto_reconnect = true,
+        .buffer.size = FLEET_CONFIG_MAX_BYTES + FLEET_TOPIC_MAX + 16,
+    };
+    mqtt_client = esp_mqtt_client_init(&mqtt_config);
+    if (mqtt_client == NULL) {
+        ESP_LOGE(TAG, "Failed to create MQTT client");
+        return;
+    }
+    esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+    
+    nvs_config_add_listener(fleet_config_changed);
+    
+    ESP_LOGI(TAG, "Fleet upload to %s as %s every %u s", CONFIG_SOLAR_FLEET_BROKER_URI,
+             unit_hex, (unsigned int)fleet_interval_s());
+}
+
+/**
+ * @brief Upload task
+ */
+void fleet_task(void *pvParameters)
+{
+    if (mqtt_client == NULL) {
+        ESP_LOGW(TAG, "Fleet upload not initialized, task exiting");
+        vTaskDelete(NULL);
+        return;
+    }
+    fleet_task_handle = xTaskGetCurrentTaskHandle();
+    
+    ESP_LOGI(TAG, "Fleet task started");
+    
+    // First upload one interval after boot, like every other
+    last_burst_ms = fleet_now_ms();
+    
+    while (1) {
+        uint32_t interval_ms = fleet_interval_s() * 1000U;
+        uint32_t elapsed_ms = fleet_now_ms() - last_burst_ms;
+        
+        if (elapsed_ms < interval_ms) {
+            uint32_t events = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &events, pdMS_TO_TICKS(interval_ms - elapsed_ms));
+            if (!(events & FLEET_EVT_BURST)) {
+                // Timeout or a new interval: check the schedule again
+                continue;
+            }
+        }
+        
+        last_burst_ms = fleet_now_ms();
+        fleet_burst();
+        
+        // Pushes that arrived after the linger period
+        fleet_drain_config(xTaskGetTickCount());
+    }
+}
+
+/**
+ * @brief Start an upload now
+ */
+esp_err_t fleet_trigger(void)
+{
+    if (fleet_task_handle == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    xTaskNotify(fleet_task_handle, FLEET_EVT_BURST, eSetBits);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get upload status
+ */
+void fleet_get_info(fleet_info_t *info)
+{
+    if (info == NULL) {
+        return;
+    }
+    
+    memset(info, 0, sizeof(*info));
+    info->enabled = mqtt_client != NULL;
+    info->active = burst_active;
+    memcpy(info->unit, unit_hex, sizeof(info->unit));
+    info->interval_s = fleet_interval_s();
+    uint32_t elapsed_s = (fleet_now_ms() - last_burst_ms) / 1000;
+    info->next_in_s = elapsed_s < info->interval_s ? info->interval_s - elapsed_s : 0;
+    info->bursts = burst_count;
+    info->bursts_failed = burst_failures;
+    info->last_connect_ms = last_connect_ms;
+    info->last_radio_ms = last_radio_ms;
+    info->pages_sent = pages_sent;
+    info->bytes_sent = bytes_sent;
+    info->next_sequence = next_sequence;
+    info->config_applied = config_applied;
+    info->config_rejected = config_rejected;
+}
+
+#else
+
+/**
+ * @brief Uploads disabled in this build
+ */
+void fleet_init(void)
+{
+    ESP_LOGI(TAG, "Fleet upload disabled (CONFIG_SOLAR_FLEET_UPLOAD)");
+}
+
+void fleet_task(void *pvParameters)
+{
+    vTaskDelete(NULL);
+}
+
+esp_err_t fleet_trigger(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void fleet_get_info(fleet_info_t *info)
+{
+    if (info != NULL) {
+        memset(info, 0, sizeof(*info));
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file fleet.h
+ * @brief Batched telemetry upload and remote configuration over Wi-Fi/MQTT
+ *
+ * A low-priority task wakes once per upload interval, brings Wi-Fi up,
+ * connects to the broker and publishes (see fleet_format.h):
+ * - one status record (telemetry status, verification counters, SoC)
+ * - the sample log pages recorded since the previous upload, in messages of
+ *   up to FLEET_MESSAGE_PAGES pages
+ *
+ * then applies any configuration pushed to its config topic and turns the
+ * radio off again. Pages count as uploaded once the broker has acknowledged
+ * them (QoS 1); a failed upload is retried whole at the next interval.
+ *
+ * Compiled to stubs unless CONFIG_SOLAR_FLEET_UPLOAD is set.
+ */
+
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "fleet_format.h"
+
+// Sample log pages per samples message (a full page is 4 KB)
+#define FLEET_MESSAGE_PAGES         2
+
+// Pages re-sent by the first upload after boot (receivers skip duplicates)
+#define FLEET_RESEND_PAGES          4
+
+// Most pages one upload sends; older backlog follows at the next interval
+#define FLEET_MAX_PAGES_PER_BURST   32
+
+// Largest configuration push accepted, in bytes
+#define FLEET_CONFIG_MAX_BYTES      512
+
+// Upload interval limits (set_fleet_interval)
+#define FLEET_INTERVAL_MIN_S        60
+#define FLEET_INTERVAL_MAX_S        86400
+
+/**
+ * @struct fleet_info_t
+ * @brief Upload status for the CLI
+ */
+typedef struct {
+    bool enabled;               // Built with CONFIG_SOLAR_FLEET_UPLOAD
+    bool active;                // Upload in progress
+    char unit[2 * FLEET_UNIT_ID_LEN + 1];
+    uint32_t interval_s;        // Interval in effect
+    uint32_t next_in_s;         // Time to the next upload
+    uint32_t bursts;            // Uploads attempted since boot
+    uint32_t bursts_failed;
+    uint32_t last_connect_ms;   // Radio on to broker connected, last upload
+    uint32_t last_radio_ms;     // Radio on time, last upload
+    uint32_t pages_sent;        // Since boot, including re-sent staging pages
+    uint32_t bytes_sent;
+    uint32_t next_sequence;     // First sample log page not yet acknowledged
+    uint32_t config_applied;    // Pushed config lines applied since boot
+    uint32_t config_rejected;
+} fleet_info_t;
+
+/**
+ * @brief Bring up the network stack, Wi-Fi (radio off) and the MQTT client
+ *
+ * Logs an error and leaves uploads disabled if any step fails.
+ */
+void fleet_init(void);
+
+/**
+ * @brief Upload task
+ * @param pvParameters Task parameters (unused)
+ */
+void fleet_task(void *pvParameters);
+
+/**
+ * @brief Start an upload now
+ * @return ESP_OK, or ESP_ERR_NOT_SUPPORTED if uploads are disabled
+ */
+esp_err_t fleet_trigger(void);
+
+/**
+ * @brief Get upload status
+ */
+void fleet_get_info(fleet_info_t *info);
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file fleet_format.h
+ * @brief Fleet upload message format, shared with host decoders
+ *
+ * Each upload burst publishes, per unit, to "<root>/<unit>/":
+ *
+ *   status   one fleet_status_t: the telemetry status record plus the
+ *            verification counters, state of charge and upload statistics
+ *   samples  sample log pages written since the previous burst, each cut
+ *            to its used records (see samplelog_format.h: 2 or 4 bytes
+ *            per reading, delta-encoded)
+ *
+ * and subscribes to "<root>/<unit>/config" for configuration pushes (text:
+ * an "auth <seq> <hmac>" line, then one set_* console command per line).
+ *
+ * Every message starts with a fleet_header_t. Pages of a samples message
+ * follow each other as samplelog_page_header_t + header.count records. The
+ * last page may be the recorder's staging page (FLEET_FLAG_PARTIAL); it is
+ * sent again with more records once complete, so receivers keep the
+ * longest copy of each page sequence. All multi-byte fields are
+ * little-endian.
+ *
+ * Header-only and free of ESP-IDF dependencies.
+ */
+
+#ifndef FLEET_FORMAT_H
+#define FLEET_FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "samplelog_format.h"
+#include "telemetry_format.h"
+
+#define FLEET_MAGIC             0x31544C46  // "FLT1"
+#define FLEET_UNIT_ID_LEN       6           // Station MAC
+
+// Message types
+#define FLEET_TYPE_STATUS       0x01
+#define FLEET_TYPE_SAMPLES      0x02
+
+// fleet_header_t.flags
+#define FLEET_FLAG_PARTIAL      0x01        // Last page is still being recorded
+
+/**
+ * @struct fleet_header_t
+ * @brief Bytes preceding every message payload
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t type;
+    uint8_t flags;                          // FLEET_FLAG_*
+    uint16_t count;                         // Pages in a samples message, 1 for status
+    uint8_t unit[FLEET_UNIT_ID_LEN];
+    uint16_t reserved;
+    uint32_t burst;                         // Burst counter since boot
+    uint32_t length;                        // Payload bytes after this header
+} fleet_header_t;
+
+/**
+ * @struct fleet_status_t
+ * @brief FLEET_TYPE_STATUS payload
+ */
+typedef struct __attribute__((packed)) {
+    telemetry_status_t status;              // As streamed on the console UART
+    uint32_t uptime_hours;                  // verification_data_t
+    uint32_t charge_cycles;
+    uint32_t last_voltage_mv;
+    int32_t current_ma;                     // 0 without current sensing
+    uint16_t soc_permille;                  // 0xFFFF without current sensing
+    uint16_t reserved;
+    uint32_t interval_s;                    // Upload interval in effect
+    uint32_t bursts_failed;                 // Since boot
+    uint32_t last_connect_ms;               // Radio on to broker connected, previous burst
+    uint32_t config_applied;                // Pushed config lines applied since boot
+    uint32_t config_rejected;
+} fleet_status_t;
+
+/**
+ * @brief Bytes a page takes in a samples message
+ */
+static inline size_t fleet_page_size(const samplelog_page_header_t *header)
+{
+    return sizeof(samplelog_page_header_t) +
+           (size_t)header->count * samplelog_record_words(header->magic) * sizeof(uint16_t);
+}
+
+/**
+ * @brief Start a message
+ */
+static inline void fleet_header_init(fleet_header_t *header, uint8_t type,
+                                     const uint8_t unit[FLEET_UNIT_ID_LEN], uint32_t burst)
+{
+    memset(header, 0, sizeof(*header));
+    header->magic = FLEET_MAGIC;
+    header->type = type;
+    memcpy(header->unit, unit, FLEET_UNIT_ID_LEN);
+    header->burst = burst;
+}
+
+/**
+ * @brief Append a page to a samples message
+ * @param buf Message buffer, starting with its fleet_header_t
+ * @param capacity Buffer size
+ * @param page Page to append (only header.count records are copied)
+ * @return false if the page does not fit (the message is unchanged)
+ */
+static inline bool fleet_append_page(uint8_t *buf, size_t capacity, const samplelog_page_t *page)
+{
+    fleet_header_t *header = (fleet_header_t *)buf;
+    size_t used = sizeof(*header) + header->length;
+    size_t size = fleet_page_size(&page->header);
+    
+    if (page->header.count == 0 || used + size > capacity) {
+        return false;
+    }
+    
+    memcpy(buf + used, page, size);
+    header->length += size;
+    header->count++;
+    return true;
+}
+
+/**
+ * @brief Walk the pages of a samples message
+ * @param buf Message
+ * @param len Message bytes
+ * @param offset Start at 0; advanced past the returned page
+ * @param header Filled with the page header
+ * @param records Set to the page's records (unaligned, little-endian)
+ * @return false at the end of the message or on a malformed page
+ */
+static inline bool fleet_next_page(const uint8_t *buf, size_t len, size_t *offset,
+                                   samplelog_page_header_t *header, const uint8_t **records)
+{
+    if (*offset == 0) {
+        *offset = sizeof(fleet_header_t);
+    }
+    if (*offset + sizeof(*header) > len) {
+        return false;
+    }
+    
+    memcpy(header, buf + *offset, sizeof(*header));
+    size_t size = fleet_page_size(header);
+    if (!samplelog_header_valid(header) || *offset + size > len) {
+        return false;
+    }
+    
+    *records = buf + *offset + sizeof(*header);
+    *offset += size;
+    return true;
+}
+
+#endif
@@ -11,8 +11,19 @@
 #include "nvs_storage.h"
 #include "adc_handler.h"
 #include "channel_processor.h"
+#include "channel_table.h"
 #include "control_handler.h"
 #include "cli_handler.h"
+#include "task_stats.h"
+#include "samplelog.h"
+#include "telemetry.h"
+#include "fleet.h"
+#include "rtlog.h"
+#include "power_mgmt.h"
+#include "fastboot.h"
+#include "soc_logic.h"
+#include "mem_stats.h"
+#include "rtos_alloc.h"
 
 static const char *TAG = "MAIN";
 
@@ -21,23 +32,72 @@ static const char *TAG = "MAIN";
 #define PRIORITY_PROCESSOR  4
 #define PRIORITY_CONTROL    5
 #define PRIORITY_CLI        3
+#define PRIORITY_NVS        2
+#define PRIORITY_SAMPLELOG  2
+#define PRIORITY_TELEMETRY  2
+#define PRIORITY_RTLOG      1
+#define PRIORITY_FLEET      1
+#define PRIORITY_UPTIME     2
+#define PRIORITY_WATCHDOG   2
 
-// Task stack sizes (in words, not bytes)
+// Core affinity: sampling/control on one core, console/NVS/monitoring on the other
+#if CONFIG_FREERTOS_UNICORE
+#define CORE_RT             0
+#define CORE_AUX            0
+#else
+#define CORE_RT             CONFIG_SOLAR_RT_CORE
+#define CORE_AUX            CONFIG_SOLAR_AUX_CORE
+#endif
+
+// Monitoring task periods
+#define UPTIME_PERIOD_MS    3600000  // 1 hour
+#define WATCHDOG_PERIOD_MS  60000    // 1 minute
+
+// Task stack sizes (bytes: ESP-IDF counts stack depth in bytes; see 'mem')
 #define STACK_SIZE_ADC      2048
 #define STACK_SIZE_PROCESSOR 3072
 #define STACK_SIZE_CONTROL  2048
 #define STACK_SIZE_CLI      4096
+#define STACK_SIZE_NVS      3072
+#define STACK_SIZE_SAMPLELOG 3072
+#define STACK_SIZE_TELEMETRY 2048
+#define STACK_SIZE_RTLOG    3072
+#define STACK_SIZE_FLEET    4096
+#define STACK_SIZE_UPTIME   2048
+#define STACK_SIZE_WATCHDOG 2048
 
 // Task handles
 static TaskHandle_t adc_task_handle = NULL;
-static TaskHandle_t ch0_proc_task_handle = NULL;
-static TaskHandle_t ch1_proc_task_handle = NULL;
+static TaskHandle_t chan_proc_task_handle = NULL;
 static TaskHandle_t control_task_handle = NULL;
 static TaskHandle_t cli_task_handle = NULL;
+static TaskHandle_t nvs_task_handle = NULL;
+static TaskHandle_t samplelog_task_handle = NULL;
+static TaskHandle_t telemetry_task_handle = NULL;
+static TaskHandle_t rtlog_task_handle = NULL;
+#if CONFIG_SOLAR_FLEET_UPLOAD
+static TaskHandle_t fleet_task_handle = NULL;
+#endif
+static TaskHandle_t uptime_task_handle = NULL;
+static TaskHandle_t watchdog_task_handle = NULL;
+
+// Task stacks and control blocks (static allocation builds only)
+RTOS_TASK_STORAGE(adc_task, STACK_SIZE_ADC);
+RTOS_TASK_STORAGE(chan_proc_task, STACK_SIZE_PROCESSOR);
+RTOS_TASK_STORAGE(control_task, STACK_SIZE_CONTROL);
+RTOS_TASK_STORAGE(cli_task, STACK_SIZE_CLI);
+RTOS_TASK_STORAGE(nvs_task, STACK_SIZE_NVS);
+RTOS_TASK_STORAGE(samplelog_task, STACK_SIZE_SAMPLELOG);
+RTOS_TASK_STORAGE(telemetry_task, STACK_SIZE_TELEMETRY);
+RTOS_TASK_STORAGE(rtlog_task, STACK_SIZE_RTLOG);
+#if CONFIG_SOLAR_FLEET_UPLOAD
+RTOS_TASK_STORAGE(fleet_task, STACK_SIZE_FLEET);
+#endif
+RTOS_TASK_STORAGE(uptime_task, STACK_SIZE_UPTIME);
+RTOS_TASK_STORAGE(watchdog_task, STACK_SIZE_WATCHDOG);
 
 // Channel configurations
-static channel_config_t ch0_config;
-static channel_config_t ch1_config;
+static channel_config_t channel_configs[CHANNEL_COUNT];
 
 /**
  * @brief Print system information
@@ -66,6 +126,21 @@ static void print_system_info(void)
     printf("\n");
 }
 
+/**
+ * @brief Count this boot in the verification data (one NVS write)
+ */
+static void record_boot(void)
+{
+    verification_data_t verification;
+    nvs_load_verification(&verification);
+    
+    // Increment total cycles on startup
+    verification.total_cycles++;
+    nvs_save_verification(&verification);
+    
+    ESP_LOGI(TAG, "Boot count: %u", (unsigned int)verification.total_cycles);
+}
+
 /**
  * @brief Initialize all subsystems
  * 
@@ -74,44 +149,67 @@ static void print_system_info(void)
  * 2. ADC sampling
  * 3. Channel processors
  * 4. Hardware control
- * 5. CLI console
+ * 5. Sample recorder
+ * 6. Telemetry stream
+ * 7. Fleet upload (network stack, radio off)
+ * 8. CLI console
+ * 9. Power management (before any task runs)
+ * 
+ * The deferred log ring is set up first, before any real-time code can
+ * record an event. Also loads and increments boot counter.
  * 
- * Also loads and increments boot counter.
+ * With CONFIG_SOLAR_FAST_BOOT, app_main has already done step 4 before
+ * anything else, and the CLI console and the boot count are left to
+ * cli_task and uptime_task.
  */
 static void initialize_subsystems(void)
 {
     ESP_LOGI(TAG, "Initializing subsystems...");
+    rtlog_init();
     
     // 1. Initialize NVS
-    ESP_LOGI(TAG, "Step 1/5: Initializing NVS");
+    ESP_LOGI(TAG, "Step 1/9: Initializing NVS");
     nvs_init();
     nvs_load_config();
-    
-    // Load verification data
-    verification_data_t verification;
-    nvs_load_verification(&verification);
-    
-    // Increment total cycles on startup
-    verification.total_cycles++;
-    nvs_save_verification(&verification);
-    
-    ESP_LOGI(TAG, "Boot count: %u", (unsigned int)verification.total_cycles);
+#if !CONFIG_SOLAR_FAST_BOOT
+    record_boot();
+#endif
     
     // 2. Initialize ADC
-    ESP_LOGI(TAG, "Step 2/5: Initializing ADC");
+    ESP_LOGI(TAG, "Step 2/9: Initializing ADC");
     adc_init();
     
     // 3. Initialize channel processors
-    ESP_LOGI(TAG, "Step 3/5: Initializing channel processors");
+    ESP_LOGI(TAG, "Step 3/9: Initializing channel processors");
     channel_processor_init();
     
+#if !CONFIG_SOLAR_FAST_BOOT
     // 4. Initialize hardware control
-    ESP_LOGI(TAG, "Step 4/5: Initializing hardware control");
+    ESP_LOGI(TAG, "Step 4/9: Initializing hardware control");
     control_init();
+#endif
+    
+    // 5. Initialize sample recorder
+    ESP_LOGI(TAG, "Step 5/9: Initializing sample recorder");
+    samplelog_init();
     
-    // 5. Initialize CLI
-    ESP_LOGI(TAG, "Step 5/5: Initializing CLI console");
+    // 6. Initialize telemetry
+    ESP_LOGI(TAG, "Step 6/9: Initializing telemetry");
+    telemetry_init();
+    
+    // 7. Initialize fleet upload (Wi-Fi stays off until the first upload)
+    ESP_LOGI(TAG, "Step 7/9: Initializing fleet upload");
+    fleet_init();
+    
+#if !CONFIG_SOLAR_FAST_BOOT
+    // 8. Initialize CLI
+    ESP_LOGI(TAG, "Step 8/9: Initializing CLI console");
     cli_init();
+#endif
+    
+    // 9. Configure power management
+    ESP_LOGI(TAG, "Step 9/9: Configuring power management");
+    power_init();
     
     ESP_LOGI(TAG, "All subsystems initialized successfully");
 }
@@ -126,114 +224,201 @@ static void configure_channels(void)
 {
     ESP_LOGI(TAG, "Configuring channels from NVS");
     
-    // Channel 0 configuration
-    ch0_config.channel_id = 0;
-    ch0_config.th_on_mv = nvs_get_ch0_th_on();
-    ch0_config.th_off_mv = nvs_get_ch0_th_off();
-    ch0_config.temp_coeff = nvs_get_temp_coefficient();
-    
-    ESP_LOGI(TAG, "Channel 0: ON=%dmV, OFF=%dmV, temp_coeff=%.3f",
-             ch0_config.th_on_mv, ch0_config.th_off_mv, ch0_config.temp_coeff);
-    
-    // Channel 1 configuration
-    ch1_config.channel_id = 1;
-    ch1_config.th_on_mv = nvs_get_ch1_th_on();
-    ch1_config.th_off_mv = nvs_get_ch1_th_off();
-    ch1_config.temp_coeff = nvs_get_temp_coefficient();
-    
-    ESP_LOGI(TAG, "Channel 1: ON=%dmV, OFF=%dmV, temp_coeff=%.3f",
-             ch1_config.th_on_mv, ch1_config.th_off_mv, ch1_config.temp_coeff);
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        channel_config_t *config = &channel_configs[ch];
+        config->channel_id = ch;
+        config->th_on_mv = nvs_get_ch_th_on(ch);
+        config->th_off_mv = nvs_get_ch_th_off(ch);
+        config->temp_coeff = nvs_get_temp_coefficient();
+        
+        ESP_LOGI(TAG, "Channel %d: ON=%dmV, OFF=%dmV, temp_coeff=%.3f",
+                 ch, config->th_on_mv, config->th_off_mv, config->temp_coeff);
+    }
 }
 
 /**
  * @brief Create all application tasks
  * 
- * Creates FreeRTOS tasks with appropriate priorities and stack sizes:
- * - ADC sampling task (priority 5)
- * - Channel 0 processor (priority 4)
- * - Channel 1 processor (priority 4)
- * - Hardware control task (priority 5)
- * - CLI console task (priority 3)
+ * Creates FreeRTOS tasks with appropriate priorities, stack sizes and
+ * core affinity:
+ * - ADC sampling task (priority 5, RT core)
+ * - Channel processor, one task for all channels (priority 4, RT core)
+ * - Hardware control task (priority 5, RT core)
+ * - CLI console task (priority 3, aux core)
+ * - NVS write-back task (priority 2, aux core)
+ * - Sample recorder task (priority 2, aux core)
+ * - Telemetry stream task (priority 2, aux core)
+ * - Deferred log formatter task (priority 1, aux core)
+ * - Fleet upload task (priority 1, aux core, CONFIG_SOLAR_FLEET_UPLOAD only)
  */
 static void create_tasks(void)
 {
-    ESP_LOGI(TAG, "Creating application tasks...");
+    ESP_LOGI(TAG, "Creating application tasks (RT core %d, aux core %d)...", CORE_RT, CORE_AUX);
     
     // Create ADC task
-    BaseType_t ret = xTaskCreate(
+    BaseType_t ret = RTOS_TASK_CREATE(
+        adc_task,
         adc_task,
         "adc_task",
         STACK_SIZE_ADC,
         NULL,
         PRIORITY_ADC,
-        &adc_task_handle
+        &adc_task_handle,
+        CORE_RT
     );
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create ADC task");
         return;
     }
+    mem_stats_register_task(adc_task_handle, STACK_SIZE_ADC, RTOS_STATIC_ALLOCATION);
     ESP_LOGI(TAG, "ADC task created");
     
-    // Create Channel 0 processor task
-    ret = xTaskCreate(
+    // Create channel processor task (serves every channel in channel_table)
+    ret = RTOS_TASK_CREATE(
+        chan_proc_task,
         channel_proc_task,
-        "ch0_proc",
+        "chan_proc",
         STACK_SIZE_PROCESSOR,
-        &ch0_config,
+        channel_configs,
         PRIORITY_PROCESSOR,
-        &ch0_proc_task_handle
+        &chan_proc_task_handle,
+        CORE_RT
     );
     if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create CH0 processor task");
+        ESP_LOGE(TAG, "Failed to create channel processor task");
         return;
     }
-    ESP_LOGI(TAG, "Channel 0 processor task created");
-    
-    // Create Channel 1 processor task
-    ret = xTaskCreate(
-        channel_proc_task,
-        "ch1_proc",
-        STACK_SIZE_PROCESSOR,
-        &ch1_config,
-        PRIORITY_PROCESSOR,
-        &ch1_proc_task_handle
-    );
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create CH1 processor task");
-        return;
-    }
-    ESP_LOGI(TAG, "Channel 1 processor task created");
+    mem_stats_register_task(chan_proc_task_handle, STACK_SIZE_PROCESSOR, RTOS_STATIC_ALLOCATION);
+    ESP_LOGI(TAG, "Channel processor task created (%d channels)", CHANNEL_COUNT);
     
     // Create control task
-    ret = xTaskCreate(
+    ret = RTOS_TASK_CREATE(
+        control_task,
         control_task,
         "control",
         STACK_SIZE_CONTROL,
         NULL,
         PRIORITY_CONTROL,
-        &control_task_handle
+        &control_task_handle,
+        CORE_RT
     );
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create control task");
         return;
     }
+    mem_stats_register_task(control_task_handle, STACK_SIZE_CONTROL, RTOS_STATIC_ALLOCATION);
     ESP_LOGI(TAG, "Control task created");
     
     // Create CLI task
-    ret = xTaskCreate(
+    ret = RTOS_TASK_CREATE(
+        cli_task,
         cli_task,
         "cli",
         STACK_SIZE_CLI,
         NULL,
         PRIORITY_CLI,
-        &cli_task_handle
+        &cli_task_handle,
+        CORE_AUX
     );
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create CLI task");
         return;
     }
+    mem_stats_register_task(cli_task_handle, STACK_SIZE_CLI, RTOS_STATIC_ALLOCATION);
     ESP_LOGI(TAG, "CLI task created");
     
+    // Create NVS write-back task
+    ret = RTOS_TASK_CREATE(
+        nvs_task,
+        nvs_writeback_task,
+        "nvs_wb",
+        STACK_SIZE_NVS,
+        NULL,
+        PRIORITY_NVS,
+        &nvs_task_handle,
+        CORE_AUX
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create NVS write-back task");
+        return;
+    }
+    mem_stats_register_task(nvs_task_handle, STACK_SIZE_NVS, RTOS_STATIC_ALLOCATION);
+    ESP_LOGI(TAG, "NVS write-back task created");
+    
+    // Create sample recorder task
+    ret = RTOS_TASK_CREATE(
+        samplelog_task,
+        samplelog_task,
+        "samplelog",
+        STACK_SIZE_SAMPLELOG,
+        NULL,
+        PRIORITY_SAMPLELOG,
+        &samplelog_task_handle,
+        CORE_AUX
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sample recorder task");
+        return;
+    }
+    mem_stats_register_task(samplelog_task_handle, STACK_SIZE_SAMPLELOG, RTOS_STATIC_ALLOCATION);
+    ESP_LOGI(TAG, "Sample recorder task created");
+    
+    // Create telemetry stream task
+    ret = RTOS_TASK_CREATE(
+        telemetry_task,
+        telemetry_task,
+        "telemetry",
+        STACK_SIZE_TELEMETRY,
+        NULL,
+        PRIORITY_TELEMETRY,
+        &telemetry_task_handle,
+        CORE_AUX
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create telemetry task");
+        return;
+    }
+    mem_stats_register_task(telemetry_task_handle, STACK_SIZE_TELEMETRY, RTOS_STATIC_ALLOCATION);
+    ESP_LOGI(TAG, "Telemetry task created");
+    
+    // Create deferred log formatter task
+    ret = RTOS_TASK_CREATE(
+        rtlog_task,
+        rtlog_task,
+        "rtlog",
+        STACK_SIZE_RTLOG,
+        NULL,
+        PRIORITY_RTLOG,
+        &rtlog_task_handle,
+        CORE_AUX
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create deferred log task");
+        return;
+    }
+    mem_stats_register_task(rtlog_task_handle, STACK_SIZE_RTLOG, RTOS_STATIC_ALLOCATION);
+    ESP_LOGI(TAG, "Deferred log task created");
+    
+#if CONFIG_SOLAR_FLEET_UPLOAD
+    // Create fleet upload task
+    ret = RTOS_TASK_CREATE(
+        fleet_task,
+        fleet_task,
+        "fleet",
+        STACK_SIZE_FLEET,
+        NULL,
+        PRIORITY_FLEET,
+        &fleet_task_handle,
+        CORE_AUX
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create fleet upload task");
+        return;
+    }
+    mem_stats_register_task(fleet_task_handle, STACK_SIZE_FLEET, RTOS_STATIC_ALLOCATION);
+    ESP_LOGI(TAG, "Fleet upload task created");
+#endif
+    
     ESP_LOGI(TAG, "All tasks created successfully");
 }
 
@@ -244,18 +429,31 @@ static void create_tasks(void)
  * Updates verification data every hour:
  * - Increments uptime counter
  * - Records current battery voltage
+ * - Adds the charge cycles counted by the SoC estimator
  * - Saves data to NVS for persistence
  * 
+ * With CONFIG_SOLAR_FAST_BOOT it also counts the boot when it starts.
+ * 
  * @note Low priority background task
  */
 static void uptime_task(void *pvParameters)
 {
     verification_data_t verification;
     uint32_t last_hour = 0;
+    uint32_t cycles_saved = 0;
+    
+#if CONFIG_SOLAR_FAST_BOOT
+    // Deferred from app_main so the boot's flash write follows the outputs
+    record_boot();
+#endif
+    
+    task_stats_t *stats = task_stats_register(pcTaskGetName(NULL), UPTIME_PERIOD_MS);
+    TickType_t last_wake_time = xTaskGetTickCount();
     
     while (1) {
         // Wait 1 hour
-        vTaskDelay(pdMS_TO_TICKS(3600000));  // 1 hour in ms
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(UPTIME_PERIOD_MS));
+        task_stats_begin(stats);
         
         // Load current verification data
         nvs_load_verification(&verification);
@@ -264,7 +462,17 @@ static void uptime_task(void *pvParameters)
         verification.uptime_hours++;
         
         // Update last voltage
-        verification.last_voltage_mv = adc_get_battery_voltage_now();
+        adc_reading_t reading;
+        if (adc_get_latest_reading(&reading, ADC_READING_MAX_AGE_MS)) {
+            verification.last_voltage_mv = reading.battery_voltage_mv;
+        } else {
+            verification.last_voltage_mv = adc_get_battery_voltage_now();
+        }
+        
+        // Charge cycles completed since the last save
+        uint32_t cycles = adc_get_charge_cycles();
+        verification.charge_cycles += cycles - cycles_saved;
+        cycles_saved = cycles;
         
         // Save back to NVS
         nvs_save_verification(&verification);
@@ -273,6 +481,8 @@ static void uptime_task(void *pvParameters)
         ESP_LOGI(TAG, "Uptime: %u hours, Battery: %u mV",
                  (unsigned int)verification.uptime_hours,
                  (unsigned int)verification.last_voltage_mv);
+        
+        task_stats_end(stats);
     }
 }
 
@@ -282,7 +492,11 @@ static void uptime_task(void *pvParameters)
  * 
  * Periodically checks:
  * - Available heap memory (warns if < 10KB)
- * - Battery voltage (warns if low, error if critical)
+ * - Stack headroom of every registered task (warns once per task if less
+ *   than MEM_STACK_LOW_BYTES was ever left)
+ * - ADC snapshot freshness (warns if adc_task stopped publishing)
+ * - Battery state of charge with current sensing, battery voltage otherwise
+ *   (warns if low, error if critical)
  * - Logs health status every 5 minutes
  * 
  * @note Could be extended to trigger emergency actions on critical conditions
@@ -290,10 +504,15 @@ static void uptime_task(void *pvParameters)
 static void watchdog_task(void *pvParameters)
 {
     uint32_t last_check = 0;
-    const uint32_t check_interval_ms = 60000;  // Check every minute
+    uint32_t stack_warned = 0;  // Bit per mem_stats task index
+    
+    task_stats_t *stats = task_stats_register(pcTaskGetName(NULL), WATCHDOG_PERIOD_MS);
+    TickType_t last_wake_time = xTaskGetTickCount();
     
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(check_interval_ms));
+        // Check every minute
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(WATCHDOG_PERIOD_MS));
+        task_stats_begin(stats);
         
         uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
         
@@ -303,8 +522,44 @@ static void watchdog_task(void *pvParameters)
             ESP_LOGW(TAG, "Low heap warning: %u bytes free", (unsigned int)free_heap);
         }
         
-        // Check battery voltage
-        uint32_t battery_mv = adc_get_battery_voltage_now();
+        // Check stack headroom (the high-water mark only ever drops)
+        for (int i = 0; i < mem_stats_task_count(); i++) {
+            mem_task_info_t task;
+            if (!(stack_warned & (1U << i)) && mem_stats_get_task(i, &task) &&
+                task.stack_free_min < MEM_STACK_LOW_BYTES) {
+                ESP_LOGW(TAG, "Low stack warning: %s has used %u of %u bytes",
+                         task.name,
+                         (unsigned int)(task.stack_bytes - task.stack_free_min),
+                         (unsigned int)task.stack_bytes);
+                stack_warned |= 1U << i;
+            }
+        }
+        
+        // Check battery voltage (a stale snapshot means adc_task stalled)
+        uint32_t battery_mv;
+        adc_reading_t reading;
+        if (adc_get_latest_reading(&reading, ADC_READING_MAX_AGE_MS)) {
+            battery_mv = reading.battery_voltage_mv;
+        } else {
+            ESP_LOGW(TAG, "ADC snapshot stale, forcing fresh read");
+            battery_mv = adc_get_battery_voltage_now();
+        }
+#if CONFIG_SOLAR_CURRENT_SENSE
+        // State of charge: not fooled by sag under the LED load
+        unsigned int soc = reading.soc_permille;
+        if (soc == ADC_SOC_UNKNOWN) {
+            soc = SOC_PERMILLE_FULL;
+        }
+        if (soc < BATTERY_CRITICAL_SOC / 2) {  // Below 10% - critical
+            ESP_LOGE(TAG, "CRITICAL: Battery charge very low: %u.%u%% (%u mV)",
+                     soc / 10, soc % 10, (unsigned int)battery_mv);
+            // Could trigger emergency shutdown here
+            // control_emergency_shutdown();
+        } else if (soc < BATTERY_CRITICAL_SOC) {
+            ESP_LOGW(TAG, "Warning: Battery charge low: %u.%u%% (%u mV)",
+                     soc / 10, soc % 10, (unsigned int)battery_mv);
+        }
+#else
         if (battery_mv < 10500) {  // Below 10.5V - critical
             ESP_LOGE(TAG, "CRITICAL: Battery voltage very low: %u mV", (unsigned int)battery_mv);
             // Could trigger emergency shutdown here
@@ -312,15 +567,28 @@ static void watchdog_task(void *pvParameters)
         } else if (battery_mv < 11000) {
             ESP_LOGW(TAG, "Warning: Battery voltage low: %u mV", (unsigned int)battery_mv);
         }
+#endif
         
         // Log periodic health status
         if ((now - last_check) > 300000) {  // Every 5 minutes
-            ESP_LOGI(TAG, "Health check: heap=%u bytes, battery=%u mV, uptime=%u min",
+            mem_heap_info_t heap;
+            mem_stats_get_heap(&heap);
+            ESP_LOGI(TAG, "Health check: heap=%u bytes (largest %u, %u%% fragmented), "
+                     "battery=%u mV, uptime=%u min",
                      (unsigned int)free_heap,
+                     (unsigned int)heap.largest_block,
+                     (unsigned int)heap.fragmentation_pct,
                      (unsigned int)battery_mv,
                      (unsigned int)(now / 60000));
+#if CONFIG_SOLAR_CURRENT_SENSE
+            ESP_LOGI(TAG, "Battery: %d mA, SoC %u.%u%%, %u cycles since boot",
+                     (int)reading.current_ma, soc / 10, soc % 10,
+                     (unsigned int)adc_get_charge_cycles());
+#endif
             last_check = now;
         }
+        
+        task_stats_end(stats);
     }
 }
 
@@ -328,6 +596,7 @@ static void watchdog_task(void *pvParameters)
  * @brief Main application entry point
  * 
  * System startup sequence:
+ * 0. Fast boot only: hardware control, at the previous run's outputs
  * 1. Print system information
  * 2. Initialize all subsystems
  * 3. Configure channels from NVS
@@ -337,6 +606,14 @@ static void watchdog_task(void *pvParameters)
  */
 void app_main(void)
 {
+#if CONFIG_SOLAR_FAST_BOOT
+    // After a warm reset the outputs go back on before anything slow
+    // (fastboot.h); the channel and control tasks resume from the same state
+    ESP_LOGI(TAG, "Fast boot: initializing hardware control first");
+    fastboot_init();
+    control_init();
+#endif
+    
     // Print system information
     print_system_info();
     
@@ -354,28 +631,34 @@ void app_main(void)
     create_tasks();
     
     // Create uptime tracking task
-    BaseType_t ret = xTaskCreate(
+    BaseType_t ret = RTOS_TASK_CREATE(
+        uptime_task,
         uptime_task,
         "uptime",
-        2048,
+        STACK_SIZE_UPTIME,
         NULL,
-        2,
-        NULL
+        PRIORITY_UPTIME,
+        &uptime_task_handle,
+        CORE_AUX
     );
     if (ret == pdPASS) {
+        mem_stats_register_task(uptime_task_handle, STACK_SIZE_UPTIME, RTOS_STATIC_ALLOCATION);
         ESP_LOGI(TAG, "Uptime tracking task created");
     }
     
     // Create watchdog task
-    ret = xTaskCreate(
+    ret = RTOS_TASK_CREATE(
+        watchdog_task,
         watchdog_task,
         "watchdog",
-        2048,
+        STACK_SIZE_WATCHDOG,
         NULL,
-        2,
-        NULL
+        PRIORITY_WATCHDOG,
+        &watchdog_task_handle,
+        CORE_AUX
     );
     if (ret == pdPASS) {
+        mem_stats_register_task(watchdog_task_handle, STACK_SIZE_WATCHDOG, RTOS_STATIC_ALLOCATION);
         ESP_LOGI(TAG, "Watchdog task created");
     }
     
@@ -0,0 +1,100 @@
+#include "mem_stats.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "MEM_STATS";
+
+/**
+ * @struct mem_task_t
+ * @brief Registered task
+ */
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t stack_bytes;
+    bool static_alloc;
+} mem_task_t;
+
+// Written by app_main before the tasks run; count published last
+static mem_task_t tasks[MEM_STATS_MAX_TASKS];
+static volatile int task_count = 0;
+
+/**
+ * @brief Register a task for the report
+ */
+void mem_stats_register_task(TaskHandle_t task, uint32_t stack_bytes, bool static_alloc)
+{
+    if (task == NULL) {
+        return;
+    }
+    if (task_count >= MEM_STATS_MAX_TASKS) {
+        ESP_LOGE(TAG, "No free slot for task '%s'", pcTaskGetName(task));
+        return;
+    }
+    
+    tasks[task_count] = (mem_task_t){
+        .handle = task,
+        .stack_bytes = stack_bytes,
+        .static_alloc = static_alloc,
+    };
+    task_count++;
+}
+
+/**
+ * @brief Number of registered tasks
+ */
+int mem_stats_task_count(void)
+{
+    return task_count;
+}
+
+/**
+ * @brief Get one task's stack usage
+ */
+bool mem_stats_get_task(int index, mem_task_info_t *info)
+{
+    if (index < 0 || index >= task_count || info == NULL) {
+        return false;
+    }
+    
+    const mem_task_t *task = &tasks[index];
+    info->name = pcTaskGetName(task->handle);
+    info->stack_bytes = task->stack_bytes;
+    // ESP-IDF counts stack in bytes
+    info->stack_free_min = uxTaskGetStackHighWaterMark(task->handle);
+    info->static_alloc = task->static_alloc;
+    
+    return true;
+}
+
+/**
+ * @brief Get the heap state
+ */
+void mem_stats_get_heap(mem_heap_info_t *info)
+{
+    if (info == NULL) {
+        return;
+    }
+    
+    memset(info, 0, sizeof(*info));
+    
+    multi_heap_info_t heap;
+    heap_caps_get_info(&heap, MALLOC_CAP_8BIT);
+    info->free_bytes = heap.total_free_bytes;
+    info->free_min_bytes = heap.minimum_free_bytes;
+    info->largest_block = heap.largest_free_block;
+    info->allocated_blocks = heap.allocated_blocks;
+    info->free_blocks = heap.free_blocks;
+    if (heap.total_free_bytes > 0) {
+        info->fragmentation_pct = (uint8_t)(100 - (uint64_t)heap.largest_free_block * 100 /
+                                                  heap.total_free_bytes);
+    }
+    
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].static_alloc) {
+            info->static_stack_bytes += tasks[i].stack_bytes;
+        } else {
+            info->heap_stack_bytes += tasks[i].stack_bytes;
+        }
+    }
+}
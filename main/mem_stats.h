@@ -0,0 +1,77 @@
+/**
+ * @file mem_stats.h
+ * @brief Per-task stack headroom and heap fragmentation report
+ *
+ * main.c registers every application task with its stack size at creation.
+ * The report reads each task's stack high-water mark and the heap
+ * statistics on demand, so stacks can be sized from measurements and the
+ * RAM they free given to buffers; nothing is sampled in the background.
+ */
+
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Maximum number of registered tasks
+#define MEM_STATS_MAX_TASKS     16
+
+// Stack headroom below which the watchdog warns (bytes)
+#define MEM_STACK_LOW_BYTES     256
+
+/**
+ * @struct mem_task_info_t
+ * @brief Stack usage of one task
+ */
+typedef struct {
+    const char *name;
+    uint32_t stack_bytes;       // Configured stack size
+    uint32_t stack_free_min;    // Least free stack seen since the task started
+    bool static_alloc;          // Stack in .bss rather than on the heap
+} mem_task_info_t;
+
+/**
+ * @struct mem_heap_info_t
+ * @brief Default heap state
+ */
+typedef struct {
+    uint32_t free_bytes;
+    uint32_t free_min_bytes;    // Low-water mark since boot
+    uint32_t largest_block;     // Largest single allocation that can succeed
+    uint32_t allocated_blocks;
+    uint32_t free_blocks;
+    uint8_t fragmentation_pct;  // Free memory outside the largest block
+    uint32_t static_stack_bytes; // Registered stacks allocated at link time
+    uint32_t heap_stack_bytes;   // Registered stacks allocated from the heap
+} mem_heap_info_t;
+
+/**
+ * @brief Register a task for the report
+ * @param task Task handle
+ * @param stack_bytes Stack size it was created with
+ * @param static_alloc true if its stack is a static buffer
+ */
+void mem_stats_register_task(TaskHandle_t task, uint32_t stack_bytes, bool static_alloc);
+
+/**
+ * @brief Number of registered tasks
+ */
+int mem_stats_task_count(void);
+
+/**
+ * @brief Get one task's stack usage
+ * @param index Task index (0 to mem_stats_task_count() - 1)
+ * @param info Filled with the usage
+ * @return false for an invalid index
+ */
+bool mem_stats_get_task(int index, mem_task_info_t *info);
+
+/**
+ * @brief Get the heap state
+ */
+void mem_stats_get_heap(mem_heap_info_t *info);
+
+#endif
@@ -1,7 +1,15 @@
 #include "nvs_storage.h"
+#include "channel_table.h"
 #include "nvs_flash.h"
 #include "nvs.h"
+#include "sdkconfig.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "seqlock.h"
+#include "rtos_alloc.h"
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "NVS_STORAGE";
@@ -10,14 +18,21 @@ static const char *TAG = "NVS_STORAGE";
 #define NVS_NAMESPACE "solar_ctrl"
 
 // Configuration keys
-#define KEY_CH0_TH_ON       "ch0_th_on"
-#define KEY_CH0_TH_OFF      "ch0_th_off"
-#define KEY_CH1_TH_ON       "ch1_th_on"
-#define KEY_CH1_TH_OFF      "ch1_th_off"
+// Per-channel keys are "<nvs_prefix><suffix>", e.g. "ch0_th_on"
+#define KEY_SUFFIX_TH_ON    "_th_on"
+#define KEY_SUFFIX_TH_OFF   "_th_off"
+#define KEY_SUFFIX_FILTER   "_filter"
+#define KEY_SUFFIX_CURVE    "_curve"
+#define KEY_MAX_LEN         16  // NVS_KEY_NAME_MAX_SIZE including terminator
 #define KEY_TEMP_COEFF      "temp_coeff"
 #define KEY_PWM_HALF_DUTY   "pwm_half"
 #define KEY_PWM_FULL_DUTY   "pwm_full"
 #define KEY_MOTION_TIMEOUT  "motion_to"
+#define KEY_DIMMING         "dimming"
+#define KEY_SCHEDULE        "schedule"
+#define KEY_FLEET_INTERVAL  "fleet_int"
+#define KEY_FLEET_SEQ       "fleet_seq"
+#define KEY_ADC_CAL         "adc_cal"
 
 // Verification data keys
 #define KEY_TOTAL_CYCLES    "tot_cycles"
@@ -26,28 +41,377 @@ static const char *TAG = "NVS_STORAGE";
 #define KEY_CHARGE_CYCLES   "chg_cycles"
 
 // Default configuration values (in mV)
-#define DEFAULT_CH0_TH_ON    12500  // 12.5V turn on
-#define DEFAULT_CH0_TH_OFF   11800  // 11.8V turn off
-#define DEFAULT_CH1_TH_ON    12500
-#define DEFAULT_CH1_TH_OFF   11800
+#define DEFAULT_TH_ON        12500  // 12.5V turn on
+#define DEFAULT_TH_OFF       11800  // 11.8V turn off
 #define DEFAULT_TEMP_COEFF   -0.02f
 #define DEFAULT_PWM_HALF     50     // 50% duty
 #define DEFAULT_PWM_FULL     100    // 100% duty
 #define DEFAULT_MOTION_TO    30000  // 30 seconds in ms
 
-// Global configuration structure
-typedef struct {
-    int32_t ch0_th_on_mv;
-    int32_t ch0_th_off_mv;
-    int32_t ch1_th_on_mv;
-    int32_t ch1_th_off_mv;
-    float temp_coefficient;
-    uint8_t pwm_half_duty;
-    uint8_t pwm_full_duty;
-    uint32_t motion_timeout_ms;
-} app_config_t;
+// Flash cost of one primitive value: one 32-byte NVS entry
+#define NVS_ENTRY_BYTES      32
 
+// A blob takes an index entry, a data header entry and its data entries
+#define NVS_BLOB_BYTES(size) ((2 + ((size) + NVS_ENTRY_BYTES - 1) / NVS_ENTRY_BYTES) * NVS_ENTRY_BYTES)
+
+/**
+ * @brief Index of every persisted key (bit position in the dirty mask)
+ */
+enum {
+    KEY_IDX_TH_ON = 0,                                  // + channel
+    KEY_IDX_TH_OFF = KEY_IDX_TH_ON + CHANNEL_COUNT,     // + channel
+    KEY_IDX_FILTER = KEY_IDX_TH_OFF + CHANNEL_COUNT,    // + channel
+    KEY_IDX_CURVE = KEY_IDX_FILTER + CHANNEL_COUNT,     // + channel
+    KEY_IDX_TEMP_COEFF = KEY_IDX_CURVE + CHANNEL_COUNT,
+    KEY_IDX_PWM_HALF,
+    KEY_IDX_PWM_FULL,
+    KEY_IDX_MOTION_TO,
+    KEY_IDX_DIMMING,
+    KEY_IDX_SCHEDULE,
+    KEY_IDX_FLEET_INT,
+    KEY_IDX_FLEET_SEQ,
+    KEY_IDX_ADC_CAL,
+    KEY_IDX_TOTAL_CYCLES,
+    KEY_IDX_LAST_VOLTAGE,
+    KEY_IDX_UPTIME_HOURS,
+    KEY_IDX_CHARGE_CYCLES,
+    KEY_IDX_COUNT
+};
+
+_Static_assert(KEY_IDX_COUNT <= 64, "dirty mask holds at most 64 keys");
+
+#define KEY_BIT(idx)    (1ULL << (idx))
+
+// Published configuration, written only through config_publish()
 static app_config_t g_config;
+static seqlock_t config_lock = SEQLOCK_INITIALIZER;
+
+// In-RAM copy of the verification data (authoritative after first load)
+static verification_data_t g_verification;
+static bool verification_loaded = false;
+
+// Serializes setters and guards the verification cache and dirty mask
+static SemaphoreHandle_t config_write_mutex = NULL;
+RTOS_MUTEX_STORAGE(config_write_mutex);
+
+// Keys changed since the last successful commit
+static uint64_t dirty_mask = 0;
+
+// Persistent handle, opened once in nvs_init()
+static nvs_handle_t storage_handle;
+static bool storage_open = false;
+
+// Write-back task, woken by nvs_save_config() / nvs_save_verification()
+static TaskHandle_t writeback_task_handle = NULL;
+
+// Key names and wear counters
+static char key_names[KEY_IDX_COUNT][KEY_MAX_LEN];
+static nvs_key_stats_t key_stats[KEY_IDX_COUNT];
+static nvs_writeback_stats_t writeback_stats;
+
+// Change listeners
+static nvs_config_listener_t config_listeners[NVS_CONFIG_MAX_LISTENERS];
+static int config_listener_count = 0;
+
+/**
+ * @brief Build a per-channel NVS key from the channel's prefix
+ */
+static const char *channel_key(char *buf, int channel, const char *suffix)
+{
+    snprintf(buf, KEY_MAX_LEN, "%s%s", channel_table[channel].nvs_prefix, suffix);
+    return buf;
+}
+
+/**
+ * @brief Check a channel index against the channel table
+ */
+static bool channel_valid(int channel)
+{
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        ESP_LOGE(TAG, "Invalid channel %d", channel);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Filter selection as stored: type | length << 8 | median << 16
+ */
+static uint32_t filter_pack(const filter_config_t *config)
+{
+    return config->type | ((uint32_t)config->length << 8) | ((uint32_t)config->median << 16);
+}
+
+static filter_config_t filter_unpack(uint32_t packed)
+{
+    filter_config_t config = {
+        .type = packed & 0xFF,
+        .length = (packed >> 8) & 0xFF,
+        .median = (packed >> 16) & 0xFF,
+    };
+    return config;
+}
+
+/**
+ * @brief Default filter selection (normalized)
+ */
+static filter_config_t filter_default(void)
+{
+    filter_config_t config = {0};
+    filter_config_normalize(&config);
+    return config;
+}
+
+/**
+ * @brief Fill key_names[] from the channel table and fixed keys
+ */
+static void init_key_names(void)
+{
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        channel_key(key_names[KEY_IDX_TH_ON + ch], ch, KEY_SUFFIX_TH_ON);
+        channel_key(key_names[KEY_IDX_TH_OFF + ch], ch, KEY_SUFFIX_TH_OFF);
+        channel_key(key_names[KEY_IDX_FILTER + ch], ch, KEY_SUFFIX_FILTER);
+        channel_key(key_names[KEY_IDX_CURVE + ch], ch, KEY_SUFFIX_CURVE);
+    }
+    strcpy(key_names[KEY_IDX_TEMP_COEFF], KEY_TEMP_COEFF);
+    strcpy(key_names[KEY_IDX_PWM_HALF], KEY_PWM_HALF_DUTY);
+    strcpy(key_names[KEY_IDX_PWM_FULL], KEY_PWM_FULL_DUTY);
+    strcpy(key_names[KEY_IDX_MOTION_TO], KEY_MOTION_TIMEOUT);
+    strcpy(key_names[KEY_IDX_DIMMING], KEY_DIMMING);
+    strcpy(key_names[KEY_IDX_SCHEDULE], KEY_SCHEDULE);
+    strcpy(key_names[KEY_IDX_FLEET_INT], KEY_FLEET_INTERVAL);
+    strcpy(key_names[KEY_IDX_FLEET_SEQ], KEY_FLEET_SEQ);
+    strcpy(key_names[KEY_IDX_ADC_CAL], KEY_ADC_CAL);
+    strcpy(key_names[KEY_IDX_TOTAL_CYCLES], KEY_TOTAL_CYCLES);
+    strcpy(key_names[KEY_IDX_LAST_VOLTAGE], KEY_LAST_VOLTAGE);
+    strcpy(key_names[KEY_IDX_UPTIME_HOURS], KEY_UPTIME_HOURS);
+    strcpy(key_names[KEY_IDX_CHARGE_CYCLES], KEY_CHARGE_CYCLES);
+}
+
+/**
+ * @brief Flash bytes one write of a key costs
+ */
+static uint32_t key_flash_bytes(int idx)
+{
+    if (idx == KEY_IDX_DIMMING) {
+        return NVS_BLOB_BYTES(sizeof(dimming_curve_t));
+    }
+    if (idx == KEY_IDX_SCHEDULE) {
+        return NVS_BLOB_BYTES(sizeof(schedule_config_t));
+    }
+    if (idx == KEY_IDX_ADC_CAL) {
+        return NVS_BLOB_BYTES(sizeof(adc_cal_profile_t));
+    }
+    return NVS_ENTRY_BYTES;
+}
+
+/**
+ * @brief Check a dimming curve against the curve rules and the hardware
+ * SoC curves need the battery current sensor
+ */
+static bool dimming_curve_usable(const dimming_curve_t *curve)
+{
+    if (!control_logic_curve_valid(curve)) {
+        return false;
+    }
+#if !CONFIG_SOLAR_CURRENT_SENSE
+    if (curve->input == DIMMING_INPUT_SOC) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Dirty bits for every configuration key that differs
+ */
+static uint64_t config_diff(const app_config_t *a, const app_config_t *b)
+{
+    uint64_t mask = 0;
+    
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        if (a->th_on_mv[ch] != b->th_on_mv[ch]) {
+            mask |= KEY_BIT(KEY_IDX_TH_ON + ch);
+        }
+        if (a->th_off_mv[ch] != b->th_off_mv[ch]) {
+            mask |= KEY_BIT(KEY_IDX_TH_OFF + ch);
+        }
+        if (filter_pack(&a->filter[ch]) != filter_pack(&b->filter[ch])) {
+            mask |= KEY_BIT(KEY_IDX_FILTER + ch);
+        }
+        if (a->comp_curve[ch] != b->comp_curve[ch]) {
+            mask |= KEY_BIT(KEY_IDX_CURVE + ch);
+        }
+    }
+    // Compare as stored (milli-units), so float noise does not cause writes
+    if ((int32_t)(a->temp_coefficient * 1000.0f) != (int32_t)(b->temp_coefficient * 1000.0f)) {
+        mask |= KEY_BIT(KEY_IDX_TEMP_COEFF);
+    }
+    if (a->pwm_half_duty != b->pwm_half_duty) {
+        mask |= KEY_BIT(KEY_IDX_PWM_HALF);
+    }
+    if (a->pwm_full_duty != b->pwm_full_duty) {
+        mask |= KEY_BIT(KEY_IDX_PWM_FULL);
+    }
+    if (a->motion_timeout_ms != b->motion_timeout_ms) {
+        mask |= KEY_BIT(KEY_IDX_MOTION_TO);
+    }
+    if (memcmp(&a->dimming, &b->dimming, sizeof(a->dimming)) != 0) {
+        mask |= KEY_BIT(KEY_IDX_DIMMING);
+    }
+    if (memcmp(&a->schedule, &b->schedule, sizeof(a->schedule)) != 0) {
+        mask |= KEY_BIT(KEY_IDX_SCHEDULE);
+    }
+    if (a->fleet_interval_s != b->fleet_interval_s) {
+        mask |= KEY_BIT(KEY_IDX_FLEET_INT);
+    }
+    if (a->fleet_config_seq != b->fleet_config_seq) {
+        mask |= KEY_BIT(KEY_IDX_FLEET_SEQ);
+    }
+    if (memcmp(&a->adc_cal, &b->adc_cal, sizeof(a->adc_cal)) != 0) {
+        mask |= KEY_BIT(KEY_IDX_ADC_CAL);
+    }
+    
+    return mask;
+}
+
+/**
+ * @brief Dirty bits for every verification field that differs
+ */
+static uint64_t verification_diff(const verification_data_t *a, const verification_data_t *b)
+{
+    uint64_t mask = 0;
+    
+    if (a->total_cycles != b->total_cycles) {
+        mask |= KEY_BIT(KEY_IDX_TOTAL_CYCLES);
+    }
+    if (a->last_voltage_mv != b->last_voltage_mv) {
+        mask |= KEY_BIT(KEY_IDX_LAST_VOLTAGE);
+    }
+    if (a->uptime_hours != b->uptime_hours) {
+        mask |= KEY_BIT(KEY_IDX_UPTIME_HOURS);
+    }
+    if (a->charge_cycles != b->charge_cycles) {
+        mask |= KEY_BIT(KEY_IDX_CHARGE_CYCLES);
+    }
+    
+    return mask;
+}
+
+/**
+ * @brief Stage one key's current value in the open handle
+ */
+static esp_err_t write_key(int idx, const app_config_t *config, const verification_data_t *ver)
+{
+    const char *key = key_names[idx];
+    
+    if (idx >= KEY_IDX_TH_ON && idx < KEY_IDX_TH_OFF) {
+        return nvs_set_i32(storage_handle, key, config->th_on_mv[idx - KEY_IDX_TH_ON]);
+    }
+    if (idx >= KEY_IDX_TH_OFF && idx < KEY_IDX_FILTER) {
+        return nvs_set_i32(storage_handle, key, config->th_off_mv[idx - KEY_IDX_TH_OFF]);
+    }
+    if (idx >= KEY_IDX_FILTER && idx < KEY_IDX_CURVE) {
+        return nvs_set_u32(storage_handle, key, filter_pack(&config->filter[idx - KEY_IDX_FILTER]));
+    }
+    if (idx >= KEY_IDX_CURVE && idx < KEY_IDX_TEMP_COEFF) {
+        return nvs_set_u8(storage_handle, key, config->comp_curve[idx - KEY_IDX_CURVE]);
+    }
+    
+    switch (idx) {
+    case KEY_IDX_TEMP_COEFF:
+        // Convert float to int32 for storage (multiply by 1000)
+        return nvs_set_i32(storage_handle, key, (int32_t)(config->temp_coefficient * 1000.0f));
+    case KEY_IDX_PWM_HALF:
+        return nvs_set_u8(storage_handle, key, config->pwm_half_duty);
+    case KEY_IDX_PWM_FULL:
+        return nvs_set_u8(storage_handle, key, config->pwm_full_duty);
+    case KEY_IDX_MOTION_TO:
+        return nvs_set_u32(storage_handle, key, config->motion_timeout_ms);
+    case KEY_IDX_DIMMING:
+        return nvs_set_blob(storage_handle, key, &config->dimming, sizeof(config->dimming));
+    case KEY_IDX_SCHEDULE:
+        return nvs_set_blob(storage_handle, key, &config->schedule, sizeof(config->schedule));
+    case KEY_IDX_FLEET_INT:
+        return nvs_set_u32(storage_handle, key, config->fleet_interval_s);
+    case KEY_IDX_FLEET_SEQ:
+        return nvs_set_u32(storage_handle, key, config->fleet_config_seq);
+    case KEY_IDX_ADC_CAL:
+        return nvs_set_blob(storage_handle, key, &config->adc_cal, sizeof(config->adc_cal));
+    case KEY_IDX_TOTAL_CYCLES:
+        return nvs_set_u32(storage_handle, key, ver->total_cycles);
+    case KEY_IDX_LAST_VOLTAGE:
+        return nvs_set_u32(storage_handle, key, ver->last_voltage_mv);
+    case KEY_IDX_UPTIME_HOURS:
+        return nvs_set_u32(storage_handle, key, ver->uptime_hours);
+    case KEY_IDX_CHARGE_CYCLES:
+        return nvs_set_u32(storage_handle, key, ver->charge_cycles);
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+/**
+ * @brief Mark keys dirty (caller holds config_write_mutex)
+ */
+static void mark_dirty_locked(uint64_t mask)
+{
+    dirty_mask |= mask;
+}
+
+/**
+ * @brief Wake the write-back task to coalesce and commit dirty keys
+ */
+static void writeback_schedule(void)
+{
+    if (writeback_task_handle != NULL) {
+        xTaskNotifyGive(writeback_task_handle);
+    }
+}
+
+/**
+ * @brief Publish a new configuration and notify listeners
+ */
+static void config_publish(const app_config_t *config)
+{
+    // Convert once here so readers on the RT core stay off the FPU
+    sensor_coeff_t temp_comp = sensor_coeff(config->temp_coefficient);
+    
+    seqlock_write_begin(&config_lock);
+    g_config = *config;
+    g_config.temp_comp = temp_comp;
+    seqlock_write_end(&config_lock);
+    
+    uint32_t generation = seqlock_sequence(&config_lock);
+    for (int i = 0; i < config_listener_count; i++) {
+        config_listeners[i](generation);
+    }
+}
+
+/**
+ * @brief Begin a setter: take the write lock and copy the current config
+ */
+static bool config_update_begin(app_config_t *config)
+{
+    if (config_write_mutex == NULL ||
+        xSemaphoreTake(config_write_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Configuration busy, update dropped");
+        return false;
+    }
+    nvs_config_snapshot(config);
+    return true;
+}
+
+/**
+ * @brief End a setter: track changed keys, publish and release the write lock
+ */
+static void config_update_end(const app_config_t *config)
+{
+    // g_config is stable here: only setters holding the mutex replace it
+    mark_dirty_locked(config_diff(&g_config, config));
+    config_publish(config);
+    xSemaphoreGive(config_write_mutex);
+}
 
 /**
  * @brief Initialize NVS flash
@@ -65,6 +429,22 @@ void nvs_init(void)
     }
     ESP_ERROR_CHECK(ret);
     
+    config_write_mutex = RTOS_MUTEX_CREATE(config_write_mutex);
+    if (config_write_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create config mutex");
+        return;
+    }
+    
+    init_key_names();
+    
+    // Keep one handle open for the lifetime of the application
+    ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &storage_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return;
+    }
+    storage_open = true;
+    
     ESP_LOGI(TAG, "NVS initialized successfully");
 }
 
@@ -73,23 +453,29 @@ void nvs_init(void)
  */
 void nvs_load_config(void)
 {
-    nvs_handle_t handle;
-    esp_err_t err;
+    app_config_t config;
     
     ESP_LOGI(TAG, "Loading configuration from NVS");
     
-    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "NVS namespace not found, using defaults");
+    if (!storage_open) {
+        ESP_LOGW(TAG, "NVS namespace not available, using defaults");
         // Set defaults
-        g_config.ch0_th_on_mv = DEFAULT_CH0_TH_ON;
-        g_config.ch0_th_off_mv = DEFAULT_CH0_TH_OFF;
-        g_config.ch1_th_on_mv = DEFAULT_CH1_TH_ON;
-        g_config.ch1_th_off_mv = DEFAULT_CH1_TH_OFF;
-        g_config.temp_coefficient = DEFAULT_TEMP_COEFF;
-        g_config.pwm_half_duty = DEFAULT_PWM_HALF;
-        g_config.pwm_full_duty = DEFAULT_PWM_FULL;
-        g_config.motion_timeout_ms = DEFAULT_MOTION_TO;
+        for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+            config.th_on_mv[ch] = DEFAULT_TH_ON;
+            config.th_off_mv[ch] = DEFAULT_TH_OFF;
+            config.filter[ch] = filter_default();
+            config.comp_curve[ch] = COMP_CURVE_LINEAR;
+        }
+        config.temp_coefficient = DEFAULT_TEMP_COEFF;
+        config.pwm_half_duty = DEFAULT_PWM_HALF;
+        config.pwm_full_duty = DEFAULT_PWM_FULL;
+        config.motion_timeout_ms = DEFAULT_MOTION_TO;
+        memset(&config.dimming, 0, sizeof(config.dimming));
+        schedule_default_config(&config.schedule);
+        config.fleet_interval_s = 0;
+        config.fleet_config_seq = 0;
+        memset(&config.adc_cal, 0, sizeof(config.adc_cal));
+        config_publish(&config);
         return;
     }
     
@@ -98,112 +484,153 @@ void nvs_load_config(void)
     uint8_t val_u8;
     uint32_t val_u32;
     
-    // Channel 0 thresholds
-    if (nvs_get_i32(handle, KEY_CH0_TH_ON, &val_i32) == ESP_OK) {
-        g_config.ch0_th_on_mv = val_i32;
-    } else {
-        g_config.ch0_th_on_mv = DEFAULT_CH0_TH_ON;
+    // Per-channel thresholds
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        if (nvs_get_i32(storage_handle, key_names[KEY_IDX_TH_ON + ch], &val_i32) == ESP_OK) {
+            config.th_on_mv[ch] = val_i32;
+        } else {
+            config.th_on_mv[ch] = DEFAULT_TH_ON;
+        }
+        
+        if (nvs_get_i32(storage_handle, key_names[KEY_IDX_TH_OFF + ch], &val_i32) == ESP_OK) {
+            config.th_off_mv[ch] = val_i32;
+        } else {
+            config.th_off_mv[ch] = DEFAULT_TH_OFF;
+        }
+        
+        config.filter[ch] = filter_default();
+        if (nvs_get_u32(storage_handle, key_names[KEY_IDX_FILTER + ch], &val_u32) == ESP_OK) {
+            filter_config_t filter = filter_unpack(val_u32);
+            if (filter_config_normalize(&filter)) {
+                config.filter[ch] = filter;
+            } else {
+                ESP_LOGW(TAG, "CH%d: invalid stored filter 0x%06x, using default",
+                         ch, (unsigned int)val_u32);
+            }
+        }
+        
+        config.comp_curve[ch] = COMP_CURVE_LINEAR;
+        if (nvs_get_u8(storage_handle, key_names[KEY_IDX_CURVE + ch], &val_u8) == ESP_OK) {
+            if (val_u8 < COMP_CURVE_COUNT) {
+                config.comp_curve[ch] = val_u8;
+            } else {
+                ESP_LOGW(TAG, "CH%d: invalid stored curve %u, using linear", ch, val_u8);
+            }
+        }
     }
     
-    if (nvs_get_i32(handle, KEY_CH0_TH_OFF, &val_i32) == ESP_OK) {
-        g_config.ch0_th_off_mv = val_i32;
+    // Temperature coefficient (stored as int32, convert to float)
+    if (nvs_get_i32(storage_handle, KEY_TEMP_COEFF, &val_i32) == ESP_OK) {
+        config.temp_coefficient = (float)val_i32 / 1000.0f;
     } else {
-        g_config.ch0_th_off_mv = DEFAULT_CH0_TH_OFF;
+        config.temp_coefficient = DEFAULT_TEMP_COEFF;
     }
     
-    // Channel 1 thresholds
-    if (nvs_get_i32(handle, KEY_CH1_TH_ON, &val_i32) == ESP_OK) {
-        g_config.ch1_th_on_mv = val_i32;
+    // PWM duties
+    if (nvs_get_u8(storage_handle, KEY_PWM_HALF_DUTY, &val_u8) == ESP_OK) {
+        config.pwm_half_duty = val_u8;
     } else {
-        g_config.ch1_th_on_mv = DEFAULT_CH1_TH_ON;
+        config.pwm_half_duty = DEFAULT_PWM_HALF;
     }
     
-    if (nvs_get_i32(handle, KEY_CH1_TH_OFF, &val_i32) == ESP_OK) {
-        g_config.ch1_th_off_mv = val_i32;
+    if (nvs_get_u8(storage_handle, KEY_PWM_FULL_DUTY, &val_u8) == ESP_OK) {
+        config.pwm_full_duty = val_u8;
     } else {
-        g_config.ch1_th_off_mv = DEFAULT_CH1_TH_OFF;
+        config.pwm_full_duty = DEFAULT_PWM_FULL;
     }
     
-    // Temperature coefficient (stored as int32, convert to float)
-    if (nvs_get_i32(handle, KEY_TEMP_COEFF, &val_i32) == ESP_OK) {
-        g_config.temp_coefficient = (float)val_i32 / 1000.0f;
+    // Motion timeout
+    if (nvs_get_u32(storage_handle, KEY_MOTION_TIMEOUT, &val_u32) == ESP_OK) {
+        config.motion_timeout_ms = val_u32;
     } else {
-        g_config.temp_coefficient = DEFAULT_TEMP_COEFF;
+        config.motion_timeout_ms = DEFAULT_MOTION_TO;
     }
     
-    // PWM duties
-    if (nvs_get_u8(handle, KEY_PWM_HALF_DUTY, &val_u8) == ESP_OK) {
-        g_config.pwm_half_duty = val_u8;
-    } else {
-        g_config.pwm_half_duty = DEFAULT_PWM_HALF;
+    // Dimming curve (absent = battery bands)
+    memset(&config.dimming, 0, sizeof(config.dimming));
+    size_t blob_size = sizeof(config.dimming);
+    dimming_curve_t curve;
+    if (nvs_get_blob(storage_handle, KEY_DIMMING, &curve, &blob_size) == ESP_OK) {
+        if (blob_size == sizeof(curve) && (curve.count == 0 || dimming_curve_usable(&curve))) {
+            config.dimming = curve;
+        } else {
+            ESP_LOGW(TAG, "Invalid stored dimming curve (%u bytes), using battery bands",
+                     (unsigned int)blob_size);
+        }
+    }
+    
+    // Night schedule (absent = default, disabled)
+    schedule_default_config(&config.schedule);
+    blob_size = sizeof(config.schedule);
+    schedule_config_t schedule;
+    if (nvs_get_blob(storage_handle, KEY_SCHEDULE, &schedule, &blob_size) == ESP_OK) {
+        if (blob_size == sizeof(schedule) && schedule_config_valid(&schedule)) {
+            config.schedule = schedule;
+        } else {
+            ESP_LOGW(TAG, "Invalid stored schedule (%u bytes), using default",
+                     (unsigned int)blob_size);
+        }
     }
     
-    if (nvs_get_u8(handle, KEY_PWM_FULL_DUTY, &val_u8) == ESP_OK) {
-        g_config.pwm_full_duty = val_u8;
+    // Fleet upload interval (absent = build default)
+    if (nvs_get_u32(storage_handle, KEY_FLEET_INTERVAL, &val_u32) == ESP_OK) {
+        config.fleet_interval_s = val_u32;
     } else {
-        g_config.pwm_full_duty = DEFAULT_PWM_FULL;
+        config.fleet_interval_s = 0;
     }
     
-    // Motion timeout
-    if (nvs_get_u32(handle, KEY_MOTION_TIMEOUT, &val_u32) == ESP_OK) {
-        g_config.motion_timeout_ms = val_u32;
+    // Last accepted config push (absent = none yet)
+    if (nvs_get_u32(storage_handle, KEY_FLEET_SEQ, &val_u32) == ESP_OK) {
+        config.fleet_config_seq = val_u32;
     } else {
-        g_config.motion_timeout_ms = DEFAULT_MOTION_TO;
+        config.fleet_config_seq = 0;
+    }
+    
+    // ADC calibration profile (absent = eFuse and nominal divider)
+    memset(&config.adc_cal, 0, sizeof(config.adc_cal));
+    blob_size = sizeof(config.adc_cal);
+    adc_cal_profile_t profile;
+    if (nvs_get_blob(storage_handle, KEY_ADC_CAL, &profile, &blob_size) == ESP_OK) {
+        if (blob_size == sizeof(profile) && adc_cal_profile_valid(&profile)) {
+            config.adc_cal = profile;
+        } else {
+            ESP_LOGW(TAG, "Invalid stored ADC calibration (%u bytes), using eFuse",
+                     (unsigned int)blob_size);
+        }
     }
     
-    nvs_close(handle);
+    config_publish(&config);
     
     ESP_LOGI(TAG, "Configuration loaded:");
-    ESP_LOGI(TAG, "  CH0: ON=%d mV, OFF=%d mV", g_config.ch0_th_on_mv, g_config.ch0_th_off_mv);
-    ESP_LOGI(TAG, "  CH1: ON=%d mV, OFF=%d mV", g_config.ch1_th_on_mv, g_config.ch1_th_off_mv);
-    ESP_LOGI(TAG, "  Temp coeff: %.3f", g_config.temp_coefficient);
-    ESP_LOGI(TAG, "  PWM: half=%d%%, full=%d%%", g_config.pwm_half_duty, g_config.pwm_full_duty);
-    ESP_LOGI(TAG, "  Motion timeout: %u ms", (unsigned int)g_config.motion_timeout_ms);
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        ESP_LOGI(TAG, "  CH%d: ON=%d mV, OFF=%d mV, filter=%s/%u median=%u, curve=%s",
+                 ch, config.th_on_mv[ch], config.th_off_mv[ch],
+                 filter_type_name(config.filter[ch].type),
+                 config.filter[ch].length, config.filter[ch].median,
+                 comp_curve_name(config.comp_curve[ch]));
+    }
+    ESP_LOGI(TAG, "  Temp coeff: %.3f", config.temp_coefficient);
+    ESP_LOGI(TAG, "  PWM: half=%d%%, full=%d%%", config.pwm_half_duty, config.pwm_full_duty);
+    ESP_LOGI(TAG, "  Motion timeout: %u ms", (unsigned int)config.motion_timeout_ms);
+    ESP_LOGI(TAG, "  Dimming: %s", config.dimming.count ? "curve" : "battery bands");
+    ESP_LOGI(TAG, "  Schedule: %s, %u segments", config.schedule.enabled ? "on" : "off",
+             config.schedule.count);
+    ESP_LOGI(TAG, "  ADC calibration points: battery=%u, temp=%u, current=%u",
+             config.adc_cal.points[ADC_CAL_BATTERY], config.adc_cal.points[ADC_CAL_TEMP],
+             config.adc_cal.points[ADC_CAL_CURRENT]);
 }
 
 /**
- * @brief Save current configuration to NVS
+ * @brief Schedule a write-back of changed configuration keys
  */
 void nvs_save_config(void)
 {
-    nvs_handle_t handle;
-    esp_err_t err;
-    
-    ESP_LOGI(TAG, "Saving configuration to NVS");
-    
-    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for writing: %s", esp_err_to_name(err));
-        return;
-    }
-    
-    // Save all configuration items
-    nvs_set_i32(handle, KEY_CH0_TH_ON, g_config.ch0_th_on_mv);
-    nvs_set_i32(handle, KEY_CH0_TH_OFF, g_config.ch0_th_off_mv);
-    nvs_set_i32(handle, KEY_CH1_TH_ON, g_config.ch1_th_on_mv);
-    nvs_set_i32(handle, KEY_CH1_TH_OFF, g_config.ch1_th_off_mv);
-    
-    // Convert float to int32 for storage (multiply by 1000)
-    int32_t temp_coeff_i32 = (int32_t)(g_config.temp_coefficient * 1000.0f);
-    nvs_set_i32(handle, KEY_TEMP_COEFF, temp_coeff_i32);
-    
-    nvs_set_u8(handle, KEY_PWM_HALF_DUTY, g_config.pwm_half_duty);
-    nvs_set_u8(handle, KEY_PWM_FULL_DUTY, g_config.pwm_full_duty);
-    nvs_set_u32(handle, KEY_MOTION_TIMEOUT, g_config.motion_timeout_ms);
-    
-    // Commit changes
-    err = nvs_commit(handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(err));
-    } else {
-        ESP_LOGI(TAG, "Configuration saved successfully");
-    }
-    
-    nvs_close(handle);
+    ESP_LOGD(TAG, "Configuration write-back scheduled");
+    writeback_schedule();
 }
 
 /**
- * @brief Load verification data from NVS
+ * @brief Load verification data (from flash once, then from the RAM copy)
  */
 void nvs_load_verification(verification_data_t *data)
 {
@@ -212,39 +639,53 @@ void nvs_load_verification(verification_data_t *data)
         return;
     }
     
-    nvs_handle_t handle;
-    esp_err_t err;
+    if (config_write_mutex == NULL) {
+        ESP_LOGE(TAG, "NVS storage not initialized");
+        memset(data, 0, sizeof(verification_data_t));
+        return;
+    }
+    
+    xSemaphoreTake(config_write_mutex, portMAX_DELAY);
+    
+    if (verification_loaded) {
+        *data = g_verification;
+        xSemaphoreGive(config_write_mutex);
+        return;
+    }
     
     ESP_LOGI(TAG, "Loading verification data from NVS");
     
     // Initialize with zeros
-    memset(data, 0, sizeof(verification_data_t));
+    memset(&g_verification, 0, sizeof(verification_data_t));
+    verification_loaded = true;
     
-    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
-    if (err != ESP_OK) {
+    if (!storage_open) {
         ESP_LOGW(TAG, "No verification data found, initializing to zero");
+        *data = g_verification;
+        xSemaphoreGive(config_write_mutex);
         return;
     }
     
     uint32_t val;
     
-    if (nvs_get_u32(handle, KEY_TOTAL_CYCLES, &val) == ESP_OK) {
-        data->total_cycles = val;
+    if (nvs_get_u32(storage_handle, KEY_TOTAL_CYCLES, &val) == ESP_OK) {
+        g_verification.total_cycles = val;
     }
     
-    if (nvs_get_u32(handle, KEY_LAST_VOLTAGE, &val) == ESP_OK) {
-        data->last_voltage_mv = val;
+    if (nvs_get_u32(storage_handle, KEY_LAST_VOLTAGE, &val) == ESP_OK) {
+        g_verification.last_voltage_mv = val;
     }
     
-    if (nvs_get_u32(handle, KEY_UPTIME_HOURS, &val) == ESP_OK) {
-        data->uptime_hours = val;
+    if (nvs_get_u32(storage_handle, KEY_UPTIME_HOURS, &val) == ESP_OK) {
+        g_verification.uptime_hours = val;
     }
     
-    if (nvs_get_u32(handle, KEY_CHARGE_CYCLES, &val) == ESP_OK) {
-        data->charge_cycles = val;
+    if (nvs_get_u32(storage_handle, KEY_CHARGE_CYCLES, &val) == ESP_OK) {
+        g_verification.charge_cycles = val;
     }
     
-    nvs_close(handle);
+    *data = g_verification;
+    xSemaphoreGive(config_write_mutex);
     
     ESP_LOGI(TAG, "Verification data loaded:");
     ESP_LOGI(TAG, "  Total cycles: %u", (unsigned int)data->total_cycles);
@@ -254,7 +695,7 @@ void nvs_load_verification(verification_data_t *data)
 }
 
 /**
- * @brief Save verification data to NVS
+ * @brief Update verification data and schedule a write-back of changed fields
  */
 void nvs_save_verification(const verification_data_t *data)
 {
@@ -263,64 +704,265 @@ void nvs_save_verification(const verification_data_t *data)
         return;
     }
     
-    nvs_handle_t handle;
-    esp_err_t err;
+    if (config_write_mutex == NULL) {
+        ESP_LOGE(TAG, "NVS storage not initialized");
+        return;
+    }
     
-    ESP_LOGD(TAG, "Saving verification data to NVS");
+    xSemaphoreTake(config_write_mutex, portMAX_DELAY);
+    uint64_t mask = verification_diff(&g_verification, data);
+    g_verification = *data;
+    verification_loaded = true;
+    mark_dirty_locked(mask);
+    xSemaphoreGive(config_write_mutex);
     
-    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for writing verification data: %s", esp_err_to_name(err));
-        return;
+    if (mask != 0) {
+        ESP_LOGD(TAG, "Verification write-back scheduled (mask=0x%llx)", (unsigned long long)mask);
+        writeback_schedule();
+    }
+}
+
+/**
+ * @brief Write every dirty key and commit once
+ */
+esp_err_t nvs_flush(void)
+{
+    if (config_write_mutex == NULL || !storage_open) {
+        return ESP_ERR_INVALID_STATE;
     }
     
-    // Save all verification items
-    nvs_set_u32(handle, KEY_TOTAL_CYCLES, data->total_cycles);
-    nvs_set_u32(handle, KEY_LAST_VOLTAGE, data->last_voltage_mv);
-    nvs_set_u32(handle, KEY_UPTIME_HOURS, data->uptime_hours);
-    nvs_set_u32(handle, KEY_CHARGE_CYCLES, data->charge_cycles);
+    // Take the dirty set and the values it refers to in one step
+    xSemaphoreTake(config_write_mutex, portMAX_DELAY);
+    uint64_t mask = dirty_mask;
+    dirty_mask = 0;
+    app_config_t config = g_config;
+    verification_data_t verification = g_verification;
+    xSemaphoreGive(config_write_mutex);
+    
+    if (mask == 0) {
+        return ESP_OK;
+    }
+    
+    uint64_t written = 0;
+    esp_err_t err = ESP_OK;
+    
+    for (int idx = 0; idx < KEY_IDX_COUNT; idx++) {
+        if (!(mask & KEY_BIT(idx))) {
+            continue;
+        }
+        
+        esp_err_t ret = write_key(idx, &config, &verification);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write '%s': %s", key_names[idx], esp_err_to_name(ret));
+            err = ret;
+            continue;
+        }
+        written |= KEY_BIT(idx);
+    }
     
     // Commit changes
-    err = nvs_commit(handle);
+    esp_err_t ret = nvs_commit(storage_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(ret));
+        err = ret;
+        written = 0;
+    }
+    
+    // Anything not committed is retried by the next write-back
+    xSemaphoreTake(config_write_mutex, portMAX_DELAY);
+    mark_dirty_locked(mask & ~written);
+    for (int idx = 0; idx < KEY_IDX_COUNT; idx++) {
+        if (written & KEY_BIT(idx)) {
+            uint32_t bytes = key_flash_bytes(idx);
+            key_stats[idx].commits++;
+            key_stats[idx].bytes_written += bytes;
+            writeback_stats.bytes_written += bytes;
+        }
+    }
+    if (written != 0) {
+        writeback_stats.commits++;
+        writeback_stats.keys_written += __builtin_popcountll(written);
+    }
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit verification data: %s", esp_err_to_name(err));
-    } else {
-        ESP_LOGD(TAG, "Verification data saved successfully");
+        writeback_stats.failures++;
+    }
+    xSemaphoreGive(config_write_mutex);
+    
+    ESP_LOGD(TAG, "Write-back committed %d keys (mask=0x%llx)",
+             __builtin_popcountll(written), (unsigned long long)written);
+    
+    return err;
+}
+
+/**
+ * @brief Write-back task: coalesce bursts of updates into one commit
+ */
+void nvs_writeback_task(void *pvParameters)
+{
+    writeback_task_handle = xTaskGetCurrentTaskHandle();
+    
+    ESP_LOGI(TAG, "Write-back task started (quiet=%d ms, max=%d ms)",
+             NVS_WRITEBACK_QUIET_MS, NVS_WRITEBACK_MAX_DELAY_MS);
+    
+    // Updates made before this task existed (e.g. the boot counter)
+    bool pending = (dirty_mask != 0);
+    
+    while (1) {
+        if (!pending) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        pending = false;
+        
+        // Wait until updates stop for the quiet period, bounded so a
+        // continuous stream of updates is still persisted
+        TickType_t first = xTaskGetTickCount();
+        uint32_t coalesced = 0;
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NVS_WRITEBACK_QUIET_MS)) > 0) {
+            coalesced++;
+            if (xTaskGetTickCount() - first >= pdMS_TO_TICKS(NVS_WRITEBACK_MAX_DELAY_MS)) {
+                break;
+            }
+        }
+        
+        // Statistics are read under the same mutex
+        xSemaphoreTake(config_write_mutex, portMAX_DELAY);
+        writeback_stats.coalesced += coalesced;
+        xSemaphoreGive(config_write_mutex);
+        
+        nvs_flush();
+    }
+}
+
+/**
+ * @brief Get write-back totals
+ */
+void nvs_get_writeback_stats(nvs_writeback_stats_t *stats)
+{
+    if (stats == NULL || config_write_mutex == NULL) {
+        return;
     }
     
-    nvs_close(handle);
+    xSemaphoreTake(config_write_mutex, portMAX_DELAY);
+    *stats = writeback_stats;
+    stats->pending_mask = dirty_mask;
+    xSemaphoreGive(config_write_mutex);
 }
 
 /**
- * @brief Get current channel 0 ON threshold
+ * @brief Number of persisted keys
  */
-int32_t nvs_get_ch0_th_on(void)
+int nvs_key_count(void)
 {
-    return g_config.ch0_th_on_mv;
+    return KEY_IDX_COUNT;
 }
 
 /**
- * @brief Get current channel 0 OFF threshold
+ * @brief Get wear counters for one persisted key
  */
-int32_t nvs_get_ch0_th_off(void)
+bool nvs_get_key_stats(int index, nvs_key_stats_t *stats)
 {
-    return g_config.ch0_th_off_mv;
+    if (stats == NULL || index < 0 || index >= KEY_IDX_COUNT || config_write_mutex == NULL) {
+        return false;
+    }
+    
+    xSemaphoreTake(config_write_mutex, portMAX_DELAY);
+    *stats = key_stats[index];
+    stats->name = key_names[index];
+    stats->dirty = (dirty_mask & KEY_BIT(index)) != 0;
+    xSemaphoreGive(config_write_mutex);
+    
+    return true;
 }
 
 /**
- * @brief Get current channel 1 ON threshold
+ * @brief Copy the current configuration
  */
-int32_t nvs_get_ch1_th_on(void)
+uint32_t nvs_config_snapshot(app_config_t *config)
 {
-    return g_config.ch1_th_on_mv;
+    unsigned int seq;
+    
+    do {
+        seq = seqlock_read_begin(&config_lock);
+        *config = g_config;
+    } while (seqlock_read_retry(&config_lock, seq));
+    
+    return seq;
 }
 
 /**
- * @brief Get current channel 1 OFF threshold
+ * @brief Current configuration generation
  */
-int32_t nvs_get_ch1_th_off(void)
+uint32_t nvs_config_generation(void)
 {
-    return g_config.ch1_th_off_mv;
+    return seqlock_sequence(&config_lock);
+}
+
+/**
+ * @brief Register a configuration change listener
+ */
+bool nvs_config_add_listener(nvs_config_listener_t listener)
+{
+    if (listener == NULL || config_listener_count >= NVS_CONFIG_MAX_LISTENERS) {
+        ESP_LOGE(TAG, "Cannot register config listener");
+        return false;
+    }
+    
+    // Registered during init, before any concurrent setter runs
+    config_listeners[config_listener_count++] = listener;
+    return true;
+}
+
+/**
+ * @brief Get current ON threshold for a channel
+ */
+int32_t nvs_get_ch_th_on(int channel)
+{
+    if (!channel_valid(channel)) {
+        return DEFAULT_TH_ON;
+    }
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return config.th_on_mv[channel];
+}
+
+/**
+ * @brief Get current OFF threshold for a channel
+ */
+int32_t nvs_get_ch_th_off(int channel)
+{
+    if (!channel_valid(channel)) {
+        return DEFAULT_TH_OFF;
+    }
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return config.th_off_mv[channel];
+}
+
+/**
+ * @brief Get a channel's input filter
+ */
+void nvs_get_ch_filter(int channel, filter_config_t *config)
+{
+    if (!channel_valid(channel)) {
+        *config = filter_default();
+        return;
+    }
+    app_config_t snapshot;
+    nvs_config_snapshot(&snapshot);
+    *config = snapshot.filter[channel];
+}
+
+/**
+ * @brief Get a channel's temperature compensation curve
+ */
+comp_curve_t nvs_get_ch_comp_curve(int channel)
+{
+    if (!channel_valid(channel)) {
+        return COMP_CURVE_LINEAR;
+    }
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return (comp_curve_t)config.comp_curve[channel];
 }
 
 /**
@@ -328,7 +970,9 @@ int32_t nvs_get_ch1_th_off(void)
  */
 float nvs_get_temp_coefficient(void)
 {
-    return g_config.temp_coefficient;
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return config.temp_coefficient;
 }
 
 /**
@@ -336,7 +980,9 @@ float nvs_get_temp_coefficient(void)
  */
 uint8_t nvs_get_pwm_half_duty(void)
 {
-    return g_config.pwm_half_duty;
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return config.pwm_half_duty;
 }
 
 /**
@@ -344,7 +990,9 @@ uint8_t nvs_get_pwm_half_duty(void)
  */
 uint8_t nvs_get_pwm_full_duty(void)
 {
-    return g_config.pwm_full_duty;
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return config.pwm_full_duty;
 }
 
 /**
@@ -352,27 +1000,197 @@ uint8_t nvs_get_pwm_full_duty(void)
  */
 uint32_t nvs_get_motion_timeout(void)
 {
-    return g_config.motion_timeout_ms;
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return config.motion_timeout_ms;
 }
 
 /**
- * @brief Set channel 0 thresholds
+ * @brief Get the fleet upload interval
  */
-void nvs_set_ch0_thresholds(int32_t th_on_mv, int32_t th_off_mv)
+uint32_t nvs_get_fleet_interval(void)
 {
-    g_config.ch0_th_on_mv = th_on_mv;
-    g_config.ch0_th_off_mv = th_off_mv;
-    ESP_LOGI(TAG, "CH0 thresholds updated: ON=%d mV, OFF=%d mV", th_on_mv, th_off_mv);
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return config.fleet_interval_s;
 }
 
 /**
- * @brief Set channel 1 thresholds
+ * @brief Get the sequence number of the last accepted fleet config push
  */
-void nvs_set_ch1_thresholds(int32_t th_on_mv, int32_t th_off_mv)
+uint32_t nvs_get_fleet_config_seq(void)
 {
-    g_config.ch1_th_on_mv = th_on_mv;
-    g_config.ch1_th_off_mv = th_off_mv;
-    ESP_LOGI(TAG, "CH1 thresholds updated: ON=%d mV, OFF=%d mV", th_on_mv, th_off_mv);
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    return config.fleet_config_seq;
+}
+
+/**
+ * @brief Get the ADC calibration profile
+ */
+void nvs_get_adc_cal(adc_cal_profile_t *profile)
+{
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    *profile = config.adc_cal;
+}
+
+/**
+ * @brief Set thresholds for a channel
+ */
+void nvs_set_ch_thresholds(int channel, int32_t th_on_mv, int32_t th_off_mv)
+{
+    if (!channel_valid(channel)) {
+        return;
+    }
+    
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return;
+    }
+    config.th_on_mv[channel] = th_on_mv;
+    config.th_off_mv[channel] = th_off_mv;
+    config_update_end(&config);
+    
+    ESP_LOGI(TAG, "CH%d thresholds updated: ON=%d mV, OFF=%d mV", channel, th_on_mv, th_off_mv);
+}
+
+/**
+ * @brief Set a channel's input filter
+ */
+bool nvs_set_ch_filter(int channel, const filter_config_t *filter)
+{
+    if (!channel_valid(channel)) {
+        return false;
+    }
+    filter_config_t normalized = *filter;
+    if (!filter_config_normalize(&normalized)) {
+        ESP_LOGE(TAG, "CH%d: invalid filter selection", channel);
+        return false;
+    }
+    
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return false;
+    }
+    config.filter[channel] = normalized;
+    config_update_end(&config);
+    
+    ESP_LOGI(TAG, "CH%d filter updated: %s/%u median=%u", channel,
+             filter_type_name(normalized.type), normalized.length, normalized.median);
+    return true;
+}
+
+/**
+ * @brief Get the dimming curve
+ */
+void nvs_get_dimming_curve(dimming_curve_t *curve)
+{
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    *curve = config.dimming;
+}
+
+/**
+ * @brief Set the dimming curve
+ */
+bool nvs_set_dimming_curve(const dimming_curve_t *curve)
+{
+    if (curve->count != 0 && !dimming_curve_usable(curve)) {
+        ESP_LOGE(TAG, "Invalid dimming curve");
+        return false;
+    }
+    
+    // Unused points are zero so the stored blob compares by content
+    dimming_curve_t normalized = {0};
+    normalized.count = curve->count;
+    normalized.input = curve->count ? curve->input : DIMMING_INPUT_VOLTAGE;
+    normalized.hysteresis_mv = curve->count ? curve->hysteresis_mv : 0;
+    for (int i = 0; i < curve->count; i++) {
+        normalized.point[i].mv = curve->point[i].mv;
+        normalized.point[i].duty = curve->point[i].duty;
+    }
+    
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return false;
+    }
+    config.dimming = normalized;
+    config_update_end(&config);
+    
+    ESP_LOGI(TAG, "Dimming curve updated: %u points, hysteresis=%u mV",
+             normalized.count, normalized.hysteresis_mv);
+    return true;
+}
+
+/**
+ * @brief Get the night schedule
+ */
+void nvs_get_schedule(schedule_config_t *schedule)
+{
+    app_config_t config;
+    nvs_config_snapshot(&config);
+    *schedule = config.schedule;
+}
+
+/**
+ * @brief Set the night schedule
+ */
+bool nvs_set_schedule(const schedule_config_t *schedule)
+{
+    if (!schedule_config_valid(schedule)) {
+        ESP_LOGE(TAG, "Invalid schedule");
+        return false;
+    }
+    
+    // Unused segments and padding are zero so the stored blob compares by content
+    schedule_config_t normalized = {0};
+    normalized.enabled = schedule->enabled ? 1 : 0;
+    normalized.count = schedule->count;
+    normalized.day_level = schedule->day_level;
+    normalized.dusk_mv = schedule->dusk_mv;
+    normalized.dawn_mv = schedule->dawn_mv;
+    normalized.confirm_min = schedule->confirm_min;
+    for (int i = 0; i < schedule->count; i++) {
+        normalized.segment[i].start_min = schedule->segment[i].start_min;
+        normalized.segment[i].level = schedule->segment[i].level;
+    }
+    
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return false;
+    }
+    config.schedule = normalized;
+    config_update_end(&config);
+    
+    ESP_LOGI(TAG, "Schedule updated: %s, %u segments, dusk<%u mV, dawn>%u mV",
+             normalized.enabled ? "on" : "off", normalized.count,
+             normalized.dusk_mv, normalized.dawn_mv);
+    return true;
+}
+
+/**
+ * @brief Set a channel's temperature compensation curve
+ */
+bool nvs_set_ch_comp_curve(int channel, comp_curve_t curve)
+{
+    if (!channel_valid(channel)) {
+        return false;
+    }
+    if (curve < 0 || curve >= COMP_CURVE_COUNT) {
+        ESP_LOGE(TAG, "CH%d: invalid compensation curve %d", channel, (int)curve);
+        return false;
+    }
+    
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return false;
+    }
+    config.comp_curve[channel] = (uint8_t)curve;
+    config_update_end(&config);
+    
+    ESP_LOGI(TAG, "CH%d compensation curve updated: %s", channel, comp_curve_name(curve));
+    return true;
 }
 
 /**
@@ -380,7 +1198,13 @@ void nvs_set_ch1_thresholds(int32_t th_on_mv, int32_t th_off_mv)
  */
 void nvs_set_temp_coefficient(float coefficient)
 {
-    g_config.temp_coefficient = coefficient;
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return;
+    }
+    config.temp_coefficient = coefficient;
+    config_update_end(&config);
+    
     ESP_LOGI(TAG, "Temperature coefficient updated: %.3f", coefficient);
 }
 
@@ -389,8 +1213,14 @@ void nvs_set_temp_coefficient(float coefficient)
  */
 void nvs_set_pwm_duties(uint8_t half_duty, uint8_t full_duty)
 {
-    g_config.pwm_half_duty = half_duty;
-    g_config.pwm_full_duty = full_duty;
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return;
+    }
+    config.pwm_half_duty = half_duty;
+    config.pwm_full_duty = full_duty;
+    config_update_end(&config);
+    
     ESP_LOGI(TAG, "PWM duties updated: half=%d%%, full=%d%%", half_duty, full_duty);
 }
 
@@ -399,6 +1229,63 @@ void nvs_set_pwm_duties(uint8_t half_duty, uint8_t full_duty)
  */
 void nvs_set_motion_timeout(uint32_t timeout_ms)
 {
-    g_config.motion_timeout_ms = timeout_ms;
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return;
+    }
+    config.motion_timeout_ms = timeout_ms;
+    config_update_end(&config);
+    
     ESP_LOGI(TAG, "Motion timeout updated: %u ms", (unsigned int)timeout_ms);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Set the fleet upload interval
+ */
+void nvs_set_fleet_interval(uint32_t interval_s)
+{
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return;
+    }
+    config.fleet_interval_s = interval_s;
+    config_update_end(&config);
+    
+    ESP_LOGI(TAG, "Fleet upload interval updated: %u s", (unsigned int)interval_s);
+}
+
+/**
+ * @brief Record the sequence number of an accepted fleet config push
+ */
+void nvs_set_fleet_config_seq(uint32_t seq)
+{
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return;
+    }
+    config.fleet_config_seq = seq;
+    config_update_end(&config);
+}
+
+/**
+ * @brief Set the ADC calibration profile
+ */
+bool nvs_set_adc_cal(const adc_cal_profile_t *profile)
+{
+    if (!adc_cal_profile_valid(profile)) {
+        ESP_LOGE(TAG, "Invalid ADC calibration profile");
+        return false;
+    }
+    
+    app_config_t config;
+    if (!config_update_begin(&config)) {
+        return false;
+    }
+    config.adc_cal = *profile;
+    config_update_end(&config);
+    
+    ESP_LOGI(TAG, "ADC calibration updated: points battery=%u, temp=%u, current=%u",
+             profile->points[ADC_CAL_BATTERY], profile->points[ADC_CAL_TEMP],
+             profile->points[ADC_CAL_CURRENT]);
+    return true;
+}
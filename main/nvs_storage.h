@@ -10,6 +10,77 @@
 #define NVS_STORAGE_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "adc_cal.h"
+#include "channel_table.h"
+#include "comp_table.h"
+#include "control_logic.h"
+#include "schedule_logic.h"
+#include "sensor_math.h"
+#include "signal_filter.h"
+
+/**
+ * @struct app_config_t
+ * @brief Runtime configuration snapshot
+ * 
+ * Published as a whole: readers always see a consistent set of values
+ * (e.g. a channel's ON/OFF pair from the same update).
+ */
+typedef struct {
+    int32_t th_on_mv[CHANNEL_COUNT];
+    int32_t th_off_mv[CHANNEL_COUNT];
+    filter_config_t filter[CHANNEL_COUNT];  // Input filter, normalized
+    uint8_t comp_curve[CHANNEL_COUNT];      // comp_curve_t
+    float temp_coefficient;
+    sensor_coeff_t temp_comp;   // temp_coefficient for channel_logic, derived on publish
+    uint8_t pwm_half_duty;
+    uint8_t pwm_full_duty;
+    dimming_curve_t dimming;    // count 0 = battery bands at the PWM duties
+    schedule_config_t schedule; // Night schedule, applied on top of dimming
+    uint32_t motion_timeout_ms;
+    uint32_t fleet_interval_s;  // Seconds between fleet uploads, 0 = build default
+    uint32_t fleet_config_seq;  // Sequence number of the last accepted config push
+    adc_cal_profile_t adc_cal;  // Per-unit ADC calibration
+} app_config_t;
+
+/**
+ * @brief Configuration change callback
+ * @param generation Generation of the newly published configuration
+ */
+typedef void (*nvs_config_listener_t)(uint32_t generation);
+
+// Maximum number of configuration change listeners
+#define NVS_CONFIG_MAX_LISTENERS    4
+
+// Write-back coalescing: commit once updates have been quiet this long...
+#define NVS_WRITEBACK_QUIET_MS      500
+// ...but never hold dirty keys longer than this
+#define NVS_WRITEBACK_MAX_DELAY_MS  5000
+
+/**
+ * @struct nvs_key_stats_t
+ * @brief Flash wear counters for one persisted key (since boot)
+ */
+typedef struct {
+    const char *name;
+    uint32_t commits;           // Commits that included this key
+    uint32_t bytes_written;     // Flash bytes written for this key (32 per entry)
+    bool dirty;                 // Changed but not yet committed
+} nvs_key_stats_t;
+
+/**
+ * @struct nvs_writeback_stats_t
+ * @brief Write-back totals (since boot)
+ */
+typedef struct {
+    uint32_t commits;           // nvs_commit() calls that wrote at least one key
+    uint32_t keys_written;      // Key writes across all commits
+    uint32_t bytes_written;     // Flash bytes written
+    uint32_t coalesced;         // Save requests merged into a pending commit
+    uint32_t failures;          // Write-backs with a write or commit error
+    uint64_t pending_mask;      // Keys currently dirty
+} nvs_writeback_stats_t;
 
 /**
  * @struct verification_data_t
@@ -30,6 +101,7 @@ typedef struct {
  * 
  * Initializes NVS flash partition. If initialization fails due to
  * truncation or version mismatch, erases and reinitializes the partition.
+ * Opens the application namespace once; the handle stays open.
  * 
  * @note Must be called early in system initialization
  */
@@ -48,17 +120,83 @@ void nvs_load_config(void);
 /**
  * @brief Save configuration to NVS
  * 
- * Writes current configuration parameters to NVS storage and commits.
+ * Schedules a write-back of the configuration keys changed since the last
+ * commit. Bursts of calls are coalesced by the write-back task into a
+ * single nvs_commit(); unchanged keys are never rewritten.
  * All configuration changes should be followed by this call to persist data.
  */
 void nvs_save_config(void);
 
+/**
+ * @brief Write all dirty keys now and commit once
+ * @return ESP_OK on success (or nothing to write)
+ * 
+ * Call before a deliberate restart so pending changes are not lost.
+ */
+esp_err_t nvs_flush(void);
+
+/**
+ * @brief Write-back task
+ * @param pvParameters Task parameters (unused)
+ * 
+ * Sleeps until a save is scheduled, waits for NVS_WRITEBACK_QUIET_MS
+ * without further saves (at most NVS_WRITEBACK_MAX_DELAY_MS), then
+ * calls nvs_flush().
+ */
+void nvs_writeback_task(void *pvParameters);
+
+/**
+ * @brief Get write-back totals
+ * @param stats Output totals
+ */
+void nvs_get_writeback_stats(nvs_writeback_stats_t *stats);
+
+/**
+ * @brief Number of persisted keys
+ */
+int nvs_key_count(void);
+
+/**
+ * @brief Get wear counters for one persisted key
+ * @param index Key index (0 to nvs_key_count() - 1)
+ * @param stats Output counters
+ * @return true if index is valid
+ */
+bool nvs_get_key_stats(int index, nvs_key_stats_t *stats);
+
+/**
+ * @brief Copy the current configuration
+ * @param config Output snapshot
+ * @return Generation of the copied snapshot
+ * 
+ * Lock-free and consistent: never returns a half-applied update.
+ */
+uint32_t nvs_config_snapshot(app_config_t *config);
+
+/**
+ * @brief Current configuration generation
+ * @return Value that changes on every published update
+ * 
+ * Cheap enough to call per sample. Consumers cache values derived from a
+ * snapshot and refresh them only when this differs from the generation
+ * returned by nvs_config_snapshot().
+ */
+uint32_t nvs_config_generation(void);
+
+/**
+ * @brief Register a callback invoked after every configuration update
+ * @param listener Callback, run in the setter's context (keep it short)
+ * @return true if registered
+ */
+bool nvs_config_add_listener(nvs_config_listener_t listener);
+
 /**
  * @brief Load verification data from NVS
  * @param data Pointer to verification_data_t structure to fill
  * 
- * Reads verification/statistics data from NVS. Initializes to zero
- * if no data exists (first boot).
+ * Reads verification/statistics data from NVS on the first call and from
+ * the in-RAM copy afterwards. Initializes to zero if no data exists
+ * (first boot).
  */
 void nvs_load_verification(verification_data_t *data);
 
@@ -66,34 +204,38 @@ void nvs_load_verification(verification_data_t *data);
  * @brief Save verification data to NVS
  * @param data Pointer to verification_data_t structure to save
  * 
- * Writes verification/statistics data to NVS and commits.
- * Should be called periodically to update uptime and cycle counts.
+ * Updates the in-RAM copy and schedules a write-back of the fields that
+ * changed. Should be called periodically to update uptime and cycle counts.
  */
 void nvs_save_verification(const verification_data_t *data);
 
 /**
- * @brief Get channel 0 ON threshold
+ * @brief Get a channel's ON threshold
+ * @param channel Channel index (0 to CHANNEL_COUNT - 1)
  * @return Voltage threshold in millivolts (mV)
  */
-int32_t nvs_get_ch0_th_on(void);
+int32_t nvs_get_ch_th_on(int channel);
 
 /**
- * @brief Get channel 0 OFF threshold
+ * @brief Get a channel's OFF threshold
+ * @param channel Channel index (0 to CHANNEL_COUNT - 1)
  * @return Voltage threshold in millivolts (mV)
  */
-int32_t nvs_get_ch0_th_off(void);
+int32_t nvs_get_ch_th_off(int channel);
 
 /**
- * @brief Get channel 1 ON threshold
- * @return Voltage threshold in millivolts (mV)
+ * @brief Get a channel's input filter
+ * @param channel Channel index (0 to CHANNEL_COUNT - 1)
+ * @param config Filled with the normalized filter selection
  */
-int32_t nvs_get_ch1_th_on(void);
+void nvs_get_ch_filter(int channel, filter_config_t *config);
 
 /**
- * @brief Get channel 1 OFF threshold
- * @return Voltage threshold in millivolts (mV)
+ * @brief Get a channel's temperature compensation curve
+ * @param channel Channel index (0 to CHANNEL_COUNT - 1)
+ * @return Curve (COMP_CURVE_LINEAR for an invalid channel)
  */
-int32_t nvs_get_ch1_th_off(void);
+comp_curve_t nvs_get_ch_comp_curve(int channel);
 
 /**
  * @brief Get temperature compensation coefficient
@@ -122,24 +264,102 @@ uint8_t nvs_get_pwm_full_duty(void);
  */
 uint32_t nvs_get_motion_timeout(void);
 
+/**
+ * @brief Get the fleet upload interval
+ * @return Seconds between uploads, 0 for the build default
+ */
+uint32_t nvs_get_fleet_interval(void);
+
+/**
+ * @brief Get the sequence number of the last accepted fleet config push
+ */
+uint32_t nvs_get_fleet_config_seq(void);
 
 /**
- * @brief Set channel 0 voltage thresholds
+ * @brief Get the dimming curve
+ * @param curve Filled with the configured curve (count 0 = battery bands)
+ */
+void nvs_get_dimming_curve(dimming_curve_t *curve);
+
+/**
+ * @brief Get the night schedule
+ * @param schedule Filled with the configured schedule
+ */
+void nvs_get_schedule(schedule_config_t *schedule);
+
+/**
+ * @brief Get the ADC calibration profile
+ * @param profile Filled with the stored profile (all points 0 = uncalibrated)
+ */
+void nvs_get_adc_cal(adc_cal_profile_t *profile);
+
+
+/**
+ * @brief Set a channel's voltage thresholds
+ * @param channel Channel index (0 to CHANNEL_COUNT - 1)
  * @param th_on_mv ON threshold in millivolts
  * @param th_off_mv OFF threshold in millivolts
  * 
+ * Keys are stored as "<nvs_prefix>_th_on" / "<nvs_prefix>_th_off" using
+ * the channel's prefix from channel_table.
+ * 
+ * Both values are published together in one new snapshot.
+ * 
  * @note Changes are not persisted until nvs_save_config() is called
  */
-void nvs_set_ch0_thresholds(int32_t th_on_mv, int32_t th_off_mv);
+void nvs_set_ch_thresholds(int channel, int32_t th_on_mv, int32_t th_off_mv);
 
 /**
- * @brief Set channel 1 voltage thresholds
- * @param th_on_mv ON threshold in millivolts
- * @param th_off_mv OFF threshold in millivolts
+ * @brief Set a channel's input filter
+ * @param channel Channel index (0 to CHANNEL_COUNT - 1)
+ * @param filter Filter selection (see filter_config_normalize())
+ * @return false if the channel or the selection is invalid
+ * 
+ * Stored packed in "<nvs_prefix>_filter". The channel processor switches
+ * filters without restarting from an empty window.
  * 
  * @note Changes are not persisted until nvs_save_config() is called
  */
-void nvs_set_ch1_thresholds(int32_t th_on_mv, int32_t th_off_mv);
+bool nvs_set_ch_filter(int channel, const filter_config_t *filter);
+
+/**
+ * @brief Set a channel's temperature compensation curve
+ * @param channel Channel index (0 to CHANNEL_COUNT - 1)
+ * @param curve Compensation curve
+ * @return false if the channel or the curve is invalid
+ * 
+ * Stored in "<nvs_prefix>_curve". The channel processor rebuilds its
+ * threshold table on the next sample.
+ * 
+ * @note Changes are not persisted until nvs_save_config() is called
+ */
+bool nvs_set_ch_comp_curve(int channel, comp_curve_t curve);
+
+/**
+ * @brief Set the dimming curve
+ * @param curve Voltage or SoC to duty curve (see control_logic_curve_valid()),
+ *              or count 0 to return to the battery bands
+ * @return false if the curve is invalid, or is an SoC curve on a build
+ *         without CONFIG_SOLAR_CURRENT_SENSE
+ * 
+ * Stored as one blob in "dimming". control_task recompiles it with the
+ * next configuration generation.
+ * 
+ * @note Changes are not persisted until nvs_save_config() is called
+ */
+bool nvs_set_dimming_curve(const dimming_curve_t *curve);
+
+/**
+ * @brief Set the night schedule
+ * @param schedule Schedule (see schedule_config_valid())
+ * @return false if the schedule is invalid
+ * 
+ * Stored as one blob in "schedule". control_task re-evaluates the level
+ * and re-arms its boundary timer with the next configuration generation.
+ * 
+ * @note Changes are not persisted until nvs_save_config() is called
+ */
+bool nvs_set_schedule(const schedule_config_t *schedule);
 
 /**
  * @brief Set temperature compensation coefficient
@@ -166,4 +386,31 @@ void nvs_set_pwm_duties(uint8_t half_duty, uint8_t full_duty);
  */
 void nvs_set_motion_timeout(uint32_t timeout_ms);
 
+/**
+ * @brief Set the fleet upload interval
+ * @param interval_s Seconds between uploads, 0 for the build default
+ * 
+ * @note Changes are not persisted until nvs_save_config() is called
+ */
+void nvs_set_fleet_interval(uint32_t interval_s);
+
+/**
+ * @brief Record the sequence number of an accepted fleet config push
+ * 
+ * @note Changes are not persisted until nvs_save_config() is called
+ */
+void nvs_set_fleet_config_seq(uint32_t seq);
+
+/**
+ * @brief Set the ADC calibration profile
+ * @param profile Profile (see adc_cal_profile_valid())
+ * @return false if the profile is invalid
+ * 
+ * Stored as one blob in "adc_cal". adc_task switches to it with the next
+ * configuration generation.
+ * 
+ * @note Changes are not persisted until nvs_save_config() is called
+ */
+bool nvs_set_adc_cal(const adc_cal_profile_t *profile);
+
 #endif
\ No newline at end of file
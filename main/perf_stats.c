@@ -0,0 +1,309 @@
+#include "perf_stats.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include <stdatomic.h>
+#include <string.h>
+
+/**
+ * @brief Latency histogram of one stage (owned by the stage's writer)
+ */
+typedef struct {
+    uint32_t buckets[PERF_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    volatile bool reset_pending;    // Set by perf_reset(), applied by the writer
+} perf_hist_t;
+
+static perf_hist_t stage_hist[PERF_STAGE_COUNT];
+
+static const char *const stage_names[PERF_STAGE_COUNT] = {
+    [PERF_STAGE_SAMPLE]   = "sample",
+    [PERF_STAGE_FILTER]   = "filter",
+    [PERF_STAGE_DECISION] = "decision",
+    [PERF_STAGE_HANDOFF]  = "handoff",
+    [PERF_STAGE_PWM]      = "pwm",
+};
+
+// Queue high-water marks may be updated from several tasks
+static atomic_uint queue_high_water[PERF_QUEUE_COUNT];
+static uint32_t queue_capacity[PERF_QUEUE_COUNT];
+
+static const char *const queue_names[PERF_QUEUE_COUNT] = {
+    [PERF_QUEUE_SAMPLE_RING] = "sample_ring",
+    [PERF_QUEUE_COMMAND]     = "command",
+};
+
+// Drop counters are also incremented from ISRs
+static atomic_uint drop_counts[PERF_DROP_COUNT];
+
+static const char *const drop_names[PERF_DROP_COUNT] = {
+    [PERF_DROP_ADC_FRAME]    = "adc_frame",
+    [PERF_DROP_RING_OVERRUN] = "ring_overrun",
+    [PERF_DROP_COMMAND_FULL] = "command_full",
+    [PERF_DROP_LOG_FULL]     = "log_full",
+};
+
+static atomic_uint event_counts[PERF_COUNT_COUNT];
+
+static const char *const event_names[PERF_COUNT_COUNT] = {
+    [PERF_COUNT_PWM_COMMIT]  = "pwm_commit",
+    [PERF_COUNT_PWM_SKIP]    = "pwm_skip",
+};
+
+// Start of the current measurement window
+static volatile int64_t window_start_us = 0;
+
+/**
+ * @brief Map a latency to its histogram bucket
+ */
+static int perf_bucket(uint32_t us)
+{
+    if (us < PERF_HIST_SUB_BUCKETS) {
+        return (int)us;
+    }
+    
+    // Power-of-two octave, split linearly by the two bits below the MSB
+    int msb = 31 - __builtin_clz(us);
+    int sub = (int)((us >> (msb - 2)) & (PERF_HIST_SUB_BUCKETS - 1));
+    int bucket = (msb - 1) * PERF_HIST_SUB_BUCKETS + sub;
+    
+    return (bucket < PERF_HIST_BUCKETS) ? bucket : PERF_HIST_BUCKETS - 1;
+}
+
+/**
+ * @brief Largest latency that maps to a bucket
+ */
+static uint32_t perf_bucket_upper(int bucket)
+{
+    if (bucket < PERF_HIST_SUB_BUCKETS) {
+        return (uint32_t)bucket;
+    }
+    
+    int shift = bucket / PERF_HIST_SUB_BUCKETS - 1;
+    int sub = bucket % PERF_HIST_SUB_BUCKETS;
+    
+    return ((uint32_t)(PERF_HIST_SUB_BUCKETS + sub) << shift) + (1U << shift) - 1;
+}
+
+/**
+ * @brief Upper bound of the bucket holding the given percentile
+ */
+static uint32_t perf_percentile(const uint32_t *buckets, uint32_t count, uint32_t percent)
+{
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Rank of the sample at the percentile (1-based, rounded up)
+    uint32_t rank = (uint32_t)(((uint64_t)count * percent + 99) / 100);
+    uint32_t seen = 0;
+    
+    for (int b = 0; b < PERF_HIST_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            return perf_bucket_upper(b);
+        }
+    }
+    
+    return perf_bucket_upper(PERF_HIST_BUCKETS - 1);
+}
+
+/**
+ * @brief Record one latency sample for a stage
+ */
+void perf_record(perf_stage_t stage, int64_t sample_us)
+{
+    if (stage >= PERF_STAGE_COUNT || sample_us == 0) {
+        return;
+    }
+    
+    perf_hist_t *h = &stage_hist[stage];
+    int64_t latency = esp_timer_get_time() - sample_us;
+    uint32_t us = (latency < 0) ? 0 : (latency > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency;
+    
+    if (h->reset_pending) {
+        memset(h->buckets, 0, sizeof(h->buckets));
+        h->count = 0;
+        h->max_us = 0;
+        h->reset_pending = false;
+    }
+    
+    if (h->count == 0 || us < h->min_us) {
+        h->min_us = us;
+    }
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+    h->buckets[perf_bucket(us)]++;
+    h->count++;
+}
+
+/**
+ * @brief Update a queue's high-water mark
+ */
+void perf_queue_depth(perf_queue_t queue, uint32_t depth)
+{
+    if (queue >= PERF_QUEUE_COUNT) {
+        return;
+    }
+    
+    unsigned int current = atomic_load_explicit(&queue_high_water[queue], memory_order_relaxed);
+    while (depth > current &&
+           !atomic_compare_exchange_weak_explicit(&queue_high_water[queue], &current, depth,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+        // current reloaded by the failed exchange
+    }
+}
+
+/**
+ * @brief Set the capacity reported for a queue
+ */
+void perf_queue_set_capacity(perf_queue_t queue, uint32_t capacity)
+{
+    if (queue < PERF_QUEUE_COUNT) {
+        queue_capacity[queue] = capacity;
+    }
+}
+
+/**
+ * @brief Count dropped work (callable from IRAM ISRs)
+ */
+void IRAM_ATTR perf_drop(perf_drop_t drop, uint32_t count)
+{
+    if (drop < PERF_DROP_COUNT) {
+        atomic_fetch_add_explicit(&drop_counts[drop], count, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Count an event
+ */
+void IRAM_ATTR perf_count(perf_count_t counter, uint32_t count)
+{
+    if (counter < PERF_COUNT_COUNT) {
+        atomic_fetch_add_explicit(&event_counts[counter], count, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Get the latency summary of a stage
+ */
+bool perf_get_stage(perf_stage_t stage, perf_stage_info_t *info)
+{
+    if (info == NULL || stage >= PERF_STAGE_COUNT) {
+        return false;
+    }
+    
+    const perf_hist_t *h = &stage_hist[stage];
+    
+    info->name = stage_names[stage];
+    
+    // A reset not yet applied by the writer reads as an empty histogram
+    if (h->reset_pending || h->count == 0) {
+        info->count = 0;
+        info->min_us = 0;
+        info->p50_us = 0;
+        info->p99_us = 0;
+        info->max_us = 0;
+        return true;
+    }
+    
+    // Copy first so the percentiles come from one consistent-enough view
+    uint32_t buckets[PERF_HIST_BUCKETS];
+    memcpy(buckets, h->buckets, sizeof(buckets));
+    uint32_t count = 0;
+    for (int b = 0; b < PERF_HIST_BUCKETS; b++) {
+        count += buckets[b];
+    }
+    
+    // Bucket bounds never report more than the exact maximum
+    uint32_t max_us = h->max_us;
+    uint32_t p50_us = perf_percentile(buckets, count, 50);
+    uint32_t p99_us = perf_percentile(buckets, count, 99);
+    
+    info->count = count;
+    info->min_us = h->min_us;
+    info->p50_us = (p50_us < max_us) ? p50_us : max_us;
+    info->p99_us = (p99_us < max_us) ? p99_us : max_us;
+    info->max_us = max_us;
+    
+    return true;
+}
+
+/**
+ * @brief Get a queue's high-water mark
+ */
+bool perf_get_queue(perf_queue_t queue, perf_queue_info_t *info)
+{
+    if (info == NULL || queue >= PERF_QUEUE_COUNT) {
+        return false;
+    }
+    
+    info->name = queue_names[queue];
+    info->high_water = atomic_load_explicit(&queue_high_water[queue], memory_order_relaxed);
+    info->capacity = queue_capacity[queue];
+    
+    return true;
+}
+
+/**
+ * @brief Get a drop counter
+ */
+uint32_t perf_get_drops(perf_drop_t drop, const char **name)
+{
+    if (drop >= PERF_DROP_COUNT) {
+        return 0;
+    }
+    
+    if (name != NULL) {
+        *name = drop_names[drop];
+    }
+    
+    return atomic_load_explicit(&drop_counts[drop], memory_order_relaxed);
+}
+
+/**
+ * @brief Get an event counter
+ */
+uint32_t perf_get_count(perf_count_t counter, const char **name)
+{
+    if (counter >= PERF_COUNT_COUNT) {
+        return 0;
+    }
+    
+    if (name != NULL) {
+        *name = event_names[counter];
+    }
+    
+    return atomic_load_explicit(&event_counts[counter], memory_order_relaxed);
+}
+
+/**
+ * @brief Microseconds since boot or the last reset
+ */
+int64_t perf_elapsed_us(void)
+{
+    return esp_timer_get_time() - window_start_us;
+}
+
+/**
+ * @brief Clear all statistics
+ */
+void perf_reset(void)
+{
+    for (int s = 0; s < PERF_STAGE_COUNT; s++) {
+        stage_hist[s].reset_pending = true;
+    }
+    for (int q = 0; q < PERF_QUEUE_COUNT; q++) {
+        atomic_store_explicit(&queue_high_water[q], 0, memory_order_relaxed);
+    }
+    for (int d = 0; d < PERF_DROP_COUNT; d++) {
+        atomic_store_explicit(&drop_counts[d], 0, memory_order_relaxed);
+    }
+    for (int c = 0; c < PERF_COUNT_COUNT; c++) {
+        atomic_store_explicit(&event_counts[c], 0, memory_order_relaxed);
+    }
+    
+    window_start_us = esp_timer_get_time();
+}
@@ -0,0 +1,165 @@
+/**
+ * @file perf_stats.h
+ * @brief Sample-to-PWM latency histograms, queue high-water marks, drops and
+ *        output write counters
+ *
+ * Every ADC reading carries the esp_timer time of its conversion. Each stage
+ * of the pipeline records the latency from that conversion to the moment the
+ * stage completes, so the PWM stage answers "how long from ADC conversion to
+ * LEDC duty update" directly and the intermediate stages show where the time
+ * goes.
+ *
+ * Latencies are binned into a log-linear histogram (four sub-buckets per
+ * power of two, so a percentile is reported within 25% of the true value)
+ * together with the exact minimum and maximum.
+ *
+ * Each stage has a single writer task; readers copy the record without a lock,
+ * which is good enough for diagnostics.
+ */
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Pipeline stages, each measured from the ADC conversion time
+ */
+typedef enum {
+    PERF_STAGE_SAMPLE = 0,      // Reading published to the sample ring (adc_task)
+    PERF_STAGE_FILTER,          // Moving average updated (chan_proc)
+    PERF_STAGE_DECISION,        // Hysteresis/debounce decision taken (chan_proc)
+    PERF_STAGE_HANDOFF,         // Command dequeued by control_task
+    PERF_STAGE_PWM,             // Duty target issued to LEDC (control_task)
+    PERF_STAGE_COUNT
+} perf_stage_t;
+
+/**
+ * @brief Monitored queues
+ */
+typedef enum {
+    PERF_QUEUE_SAMPLE_RING = 0, // Channel processor backlog on the sample ring
+    PERF_QUEUE_COMMAND,         // channel_command_queue depth
+    PERF_QUEUE_COUNT
+} perf_queue_t;
+
+/**
+ * @brief Dropped-work counters
+ */
+typedef enum {
+    PERF_DROP_ADC_FRAME = 0,    // DMA pool overflow or frame without conversions
+    PERF_DROP_RING_OVERRUN,     // Readings lost by the channel processor
+    PERF_DROP_COMMAND_FULL,     // Commands rejected by a full queue (retried)
+    PERF_DROP_LOG_FULL,         // Deferred log events lost to a full buffer
+    PERF_DROP_COUNT
+} perf_drop_t;
+
+/**
+ * @brief Event counters
+ */
+typedef enum {
+    PERF_COUNT_PWM_COMMIT = 0,  // Channel duty targets written to LEDC
+    PERF_COUNT_PWM_SKIP,        // Channel writes skipped, duty already committed
+    PERF_COUNT_COUNT
+} perf_count_t;
+
+// Histogram resolution: buckets 0-3 are exact, then 4 per power of two
+#define PERF_HIST_SUB_BUCKETS   4
+#define PERF_HIST_BUCKETS       96  // Covers latencies up to ~30 s
+
+/**
+ * @struct perf_stage_info_t
+ * @brief Summary of one stage's latency distribution
+ */
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t p50_us;    // Bucket upper bound
+    uint32_t p99_us;    // Bucket upper bound
+    uint32_t max_us;
+} perf_stage_info_t;
+
+/**
+ * @struct perf_queue_info_t
+ * @brief High-water mark of a monitored queue
+ */
+typedef struct {
+    const char *name;
+    uint32_t high_water;
+    uint32_t capacity;
+} perf_queue_info_t;
+
+/**
+ * @brief Record one latency sample for a stage
+ * @param stage Pipeline stage (single writer per stage)
+ * @param sample_us esp_timer time of the originating ADC conversion
+ *                  (0 is ignored, e.g. a command never issued)
+ */
+void perf_record(perf_stage_t stage, int64_t sample_us);
+
+/**
+ * @brief Update a queue's high-water mark
+ * @param queue Monitored queue
+ * @param depth Current number of queued items
+ */
+void perf_queue_depth(perf_queue_t queue, uint32_t depth);
+
+/**
+ * @brief Set the capacity reported for a queue
+ */
+void perf_queue_set_capacity(perf_queue_t queue, uint32_t capacity);
+
+/**
+ * @brief Count dropped work (safe from any task or ISR)
+ * @param drop Drop counter
+ * @param count Number of items dropped
+ */
+void perf_drop(perf_drop_t drop, uint32_t count);
+
+/**
+ * @brief Count an event (safe from any task or ISR)
+ * @param counter Event counter
+ * @param count Number of events
+ */
+void perf_count(perf_count_t counter, uint32_t count);
+
+/**
+ * @brief Get the latency summary of a stage
+ * @return false if stage is out of range
+ */
+bool perf_get_stage(perf_stage_t stage, perf_stage_info_t *info);
+
+/**
+ * @brief Get a queue's high-water mark
+ * @return false if queue is out of range
+ */
+bool perf_get_queue(perf_queue_t queue, perf_queue_info_t *info);
+
+/**
+ * @brief Get a drop counter
+ * @param name Filled with the counter name (may be NULL)
+ */
+uint32_t perf_get_drops(perf_drop_t drop, const char **name);
+
+/**
+ * @brief Get an event counter
+ * @param name Filled with the counter name (may be NULL)
+ */
+uint32_t perf_get_count(perf_count_t counter, const char **name);
+
+/**
+ * @brief Microseconds since boot or the last perf_reset()
+ */
+int64_t perf_elapsed_us(void);
+
+/**
+ * @brief Clear all histograms, high-water marks, drop and event counters
+ *
+ * Histograms are cleared by each stage's writer at its next record, so the
+ * reset never races with an update in progress.
+ */
+void perf_reset(void);
+
+#endif
@@ -0,0 +1,168 @@
+#include "power_mgmt.h"
+#include "sdkconfig.h"
+#include "seqlock.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include <stdio.h>
+
+static const char *TAG = "POWER";
+
+#if CONFIG_SOLAR_LOW_POWER
+// Console RX edges that wake the chip (the waking characters are lost)
+#define POWER_UART_WAKEUP_EDGES     3
+#endif
+
+/**
+ * @brief Residency counters, written only by the sleep exit callback
+ */
+typedef struct {
+    uint32_t sleeps;
+    uint64_t slept_us;
+    uint32_t longest_us;
+} sleep_counters_t;
+
+static sleep_counters_t counters = {0};
+static seqlock_t counters_lock = SEQLOCK_INITIALIZER;
+static volatile bool longest_reset_pending = false;
+
+// Start of the reporting window (CLI side only)
+static sleep_counters_t window_base = {0};
+static int64_t window_start_us = 0;
+
+static bool light_sleep_enabled = false;
+static uint32_t min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+static uint32_t max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+/**
+ * @brief Light sleep exit callback (idle task, interrupts disabled)
+ */
+static esp_err_t IRAM_ATTR power_sleep_exit_cb(int64_t slept_us, void *arg)
+{
+    uint32_t slept = (slept_us > (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)slept_us;
+    
+    seqlock_write_begin(&counters_lock);
+    if (longest_reset_pending) {
+        counters.longest_us = 0;
+        longest_reset_pending = false;
+    }
+    counters.sleeps++;
+    counters.slept_us += slept;
+    if (slept > counters.longest_us) {
+        counters.longest_us = slept;
+    }
+    seqlock_write_end(&counters_lock);
+    
+    return ESP_OK;
+}
+#endif
+
+/**
+ * @brief Configure power management
+ */
+void power_init(void)
+{
+    window_start_us = esp_timer_get_time();
+    
+#if CONFIG_SOLAR_LOW_POWER
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true,
+    };
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure power management: %s", esp_err_to_name(ret));
+        return;
+    }
+    min_freq_mhz = pm_config.min_freq_mhz;
+    max_freq_mhz = pm_config.max_freq_mhz;
+    light_sleep_enabled = true;
+    
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {
+        .exit_cb = power_sleep_exit_cb,
+    };
+    ret = esp_pm_light_sleep_register_cbs(&cbs);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Sleep residency not available: %s", esp_err_to_name(ret));
+    }
+#endif
+    
+    ESP_LOGI(TAG, "Power management: %u-%u MHz, automatic light sleep",
+             (unsigned int)min_freq_mhz, (unsigned int)max_freq_mhz);
+#else
+    ESP_LOGI(TAG, "Power management off: CPU fixed at %u MHz", (unsigned int)max_freq_mhz);
+#endif
+}
+
+/**
+ * @brief Let console input wake the chip from light sleep
+ */
+void power_console_wakeup_init(void)
+{
+#if CONFIG_SOLAR_LOW_POWER
+    // Typing on the console wakes the chip
+    esp_err_t ret = uart_set_wakeup_threshold(CONFIG_ESP_CONSOLE_UART_NUM, POWER_UART_WAKEUP_EDGES);
+    if (ret == ESP_OK) {
+        ret = esp_sleep_enable_uart_wakeup(CONFIG_ESP_CONSOLE_UART_NUM);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Console wakeup not available: %s", esp_err_to_name(ret));
+    }
+#endif
+}
+
+/**
+ * @brief Get the light-sleep residency counters
+ */
+void power_get_stats(power_stats_t *stats)
+{
+    sleep_counters_t now;
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&counters_lock);
+        now = counters;
+    } while (seqlock_read_retry(&counters_lock, seq));
+    
+    stats->light_sleep = light_sleep_enabled;
+    stats->min_freq_mhz = min_freq_mhz;
+    stats->max_freq_mhz = max_freq_mhz;
+    stats->sleeps = now.sleeps - window_base.sleeps;
+    stats->slept_us = now.slept_us - window_base.slept_us;
+    stats->longest_us = longest_reset_pending ? 0 : now.longest_us;
+    stats->window_us = (uint64_t)(esp_timer_get_time() - window_start_us);
+}
+
+/**
+ * @brief Start a new residency window
+ */
+void power_reset_stats(void)
+{
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&counters_lock);
+        window_base = counters;
+    } while (seqlock_read_retry(&counters_lock, seq));
+    
+    window_start_us = esp_timer_get_time();
+    // The longest sleep is a maximum, not a sum: cleared by the next sleep
+    longest_reset_pending = true;
+}
+
+/**
+ * @brief Print the power locks currently held and their owners
+ */
+void power_dump_locks(void)
+{
+#if CONFIG_PM_ENABLE
+    esp_pm_dump_locks(stdout);
+#else
+    printf("Power management is disabled (CONFIG_PM_ENABLE)\n");
+#endif
+}
@@ -0,0 +1,66 @@
+/**
+ * @file power_mgmt.h
+ * @brief Dynamic frequency scaling, automatic light sleep and sleep residency
+ *
+ * With CONFIG_SOLAR_LOW_POWER the CPU scales between the XTAL frequency and
+ * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, and the tickless idle task enters light
+ * sleep whenever no task is ready and no driver holds a power lock. The
+ * LEDC outputs run from RC_FAST and keep running asleep. The motion sensor,
+ * the console UART and the next FreeRTOS or esp_timer deadline wake the chip.
+ *
+ * The continuous ADC holds a power lock while it scans, so light sleep only
+ * happens once the channel inputs have settled and adc_task stretches its
+ * interval (see cadence_logic.h). Every light sleep is measured from the
+ * PM sleep callbacks and reported by the 'power' CLI command.
+ */
+
+#ifndef POWER_MGMT_H
+#define POWER_MGMT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @struct power_stats_t
+ * @brief Light-sleep residency since boot or the last power_reset_stats()
+ */
+typedef struct {
+    bool light_sleep;           // Automatic light sleep configured
+    uint32_t min_freq_mhz;      // DFS range (equal when DFS is off)
+    uint32_t max_freq_mhz;
+    uint32_t sleeps;            // Light sleep entries
+    uint64_t slept_us;          // Total time in light sleep
+    uint32_t longest_us;        // Longest single light sleep
+    uint64_t window_us;         // Time covered by the counters
+} power_stats_t;
+
+/**
+ * @brief Configure power management
+ *
+ * Call after every driver is set up and before the application tasks start.
+ */
+void power_init(void);
+
+/**
+ * @brief Let console input wake the chip from light sleep
+ *
+ * Called by cli_init() once the console UART is installed.
+ */
+void power_console_wakeup_init(void);
+
+/**
+ * @brief Get the light-sleep residency counters
+ */
+void power_get_stats(power_stats_t *stats);
+
+/**
+ * @brief Start a new residency window
+ */
+void power_reset_stats(void);
+
+/**
+ * @brief Print the power locks currently held and their owners
+ */
+void power_dump_locks(void);
+
+#endif
@@ -0,0 +1,457 @@
+#include "rtlog.h"
+#include "perf_stats.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+static const char *TAG = "RTLOG";
+
+_Static_assert(sizeof(void *) <= sizeof(uint32_t), "RTLOG_S() needs 32-bit pointers");
+_Static_assert((RTLOG_SLOTS & (RTLOG_SLOTS - 1)) == 0, "RTLOG_SLOTS must be a power of two");
+
+// Events printed this long after they were recorded carry their age
+#define RTLOG_LATE_MS       1000
+
+// Longest formatted line
+#define RTLOG_LINE_MAX      160
+
+// Window used for every overload warning
+#define RTLOG_WARN_WINDOW_MS 1000
+
+/**
+ * @brief Static description of an event
+ */
+typedef struct {
+    esp_log_level_t level;
+    const char *tag;
+    const char *format;
+    uint32_t window_ms;         // Coalescing window, 0 = emit every instance
+} rtlog_desc_t;
+
+static const rtlog_desc_t event_table[RTLOG_EVENT_COUNT] = {
+    [RTLOG_ADC_READING] = { ESP_LOG_INFO, "ADC_HANDLER",
+        "Battery: %u mV (%.2MV), ADC: %u raw, Temp: %.1D°C", 0 },
+    [RTLOG_ADC_READ_FAILED] = { ESP_LOG_WARN, "ADC_HANDLER",
+        "ADC read failed on channel %d: %s", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_ADC_TEMP_RANGE] = { ESP_LOG_WARN, "ADC_HANDLER",
+        "Temperature sensor out of range (%u mV), using 25°C", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_ADC_EMPTY_FRAME] = { ESP_LOG_WARN, "ADC_HANDLER",
+        "Frame without valid conversions (%u bytes)", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_CH_COMPENSATION] = { ESP_LOG_INFO, "CHAN_PROC",
+        "CH%d: Temp=%.1D°C, compensation=%dmV, TH_ON=%dmV, TH_OFF=%dmV", 0 },
+    [RTLOG_CH_STATE_CHANGE] = { ESP_LOG_INFO, "CHAN_PROC",
+        "CH%d: State change to %s (voltage=%dmV, TH_ON=%dmV, TH_OFF=%dmV)", 0 },
+    [RTLOG_CH_STATUS] = { ESP_LOG_INFO, "CHAN_PROC",
+        "CH%d: State=%s, Voltage=%dmV (raw=%umV), Temp=%.1D°C", 0 },
+    [RTLOG_CH_OVERRUN] = { ESP_LOG_WARN, "CHAN_PROC",
+        "Processor fell behind, %u samples lost in total", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_CH_QUEUE_FULL] = { ESP_LOG_WARN, "CHAN_PROC",
+        "CH%d: Command queue full", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_CTRL_SET_DUTY_FAILED] = { ESP_LOG_ERROR, "CONTROL",
+        "Failed to set duty: %s", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_CTRL_UPDATE_DUTY_FAILED] = { ESP_LOG_ERROR, "CONTROL",
+        "Failed to update duty: %s", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_CTRL_MUTEX_TIMEOUT] = { ESP_LOG_WARN, "CONTROL",
+        "Failed to acquire hw_mutex", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_CTRL_TIMER_FAILED] = { ESP_LOG_ERROR, "CONTROL",
+        "Failed to arm %s timer: %s", RTLOG_WARN_WINDOW_MS },
+    [RTLOG_CTRL_MOTION] = { ESP_LOG_INFO, "CONTROL",
+        "Motion detected, full brightness for %u ms", 0 },
+    [RTLOG_CTRL_MOTION_EXPIRED] = { ESP_LOG_INFO, "CONTROL",
+        "Motion timeout expired", 0 },
+    [RTLOG_CTRL_SCHEDULE] = { ESP_LOG_INFO, "CONTROL",
+        "Schedule: %s at %dmV, level %u%%", 0 },
+    [RTLOG_CTRL_STATUS] = { ESP_LOG_INFO, "CONTROL",
+        "Status: Outputs=0x%02x, Duty=%u%%, Battery=%umV, Motion=%s", 0 },
+    [RTLOG_CTRL_FIRST_CHANGE] = { ESP_LOG_INFO, "CONTROL",
+        "First output change %u ms after boot, %u us after its sample: Outputs=0x%02x, Duty=%u%%", 0 },
+};
+
+/**
+ * @brief One recorded event
+ */
+typedef struct {
+    uint16_t event;
+    uint16_t repeats;           // Instances suppressed since the previous one
+    uint32_t timestamp_ms;
+    uint32_t args[RTLOG_MAX_ARGS];
+} rtlog_entry_t;
+
+/**
+ * @brief Ring slot; seq tells producers and the consumer whose turn it is
+ */
+typedef struct {
+    atomic_uint seq;
+    rtlog_entry_t entry;
+} rtlog_slot_t;
+
+// Bounded multi-producer ring (per-slot sequence numbers, no locks)
+static rtlog_slot_t ring[RTLOG_SLOTS];
+static atomic_uint ring_head;               // Next position to claim (producers)
+static atomic_uint ring_tail;               // Next position to read (rtlog_task)
+
+// Formatter, notified by producers; sleeps while there is nothing to print
+static TaskHandle_t rtlog_task_handle = NULL;
+
+// Coalescing state of windowed events
+static atomic_uint last_emit_ms[RTLOG_EVENT_COUNT];
+static atomic_uint suppressed[RTLOG_EVENT_COUNT];
+
+// Last instance of each event, for quiet-period repeat summaries (rtlog_task only)
+static rtlog_entry_t last_entry[RTLOG_EVENT_COUNT];
+static bool last_valid[RTLOG_EVENT_COUNT];
+
+// Counters since boot
+static atomic_uint stat_written;
+static atomic_uint stat_emitted;
+static atomic_uint stat_coalesced;
+static atomic_uint stat_dropped;
+static atomic_uint stat_high_water;
+
+static uint32_t rtlog_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/**
+ * @brief Wake the formatter (task context)
+ */
+static void rtlog_wake(void)
+{
+    TaskHandle_t task = rtlog_task_handle;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+/**
+ * @brief Initialize the ring
+ */
+void rtlog_init(void)
+{
+    for (unsigned int i = 0; i < RTLOG_SLOTS; i++) {
+        atomic_store_explicit(&ring[i].seq, i, memory_order_relaxed);
+    }
+    atomic_store_explicit(&ring_head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring_tail, 0, memory_order_relaxed);
+    
+    // Let the first instance of every windowed event through
+    uint32_t now_ms = rtlog_now_ms();
+    for (int i = 0; i < RTLOG_EVENT_COUNT; i++) {
+        atomic_store_explicit(&last_emit_ms[i], now_ms - event_table[i].window_ms, memory_order_relaxed);
+        atomic_store_explicit(&suppressed[i], 0, memory_order_relaxed);
+    }
+    
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief Record an event
+ *
+ * A producer preempted between claiming and publishing a slot holds back the
+ * formatter (not other producers) until it resumes.
+ */
+void rtlog_write(rtlog_event_t event, const uint32_t *args, uint32_t count)
+{
+    if ((unsigned int)event >= RTLOG_EVENT_COUNT) {
+        return;
+    }
+    
+    uint32_t now_ms = rtlog_now_ms();
+    uint32_t repeats = 0;
+    
+    // Rate limit: inside the window only count the repeat
+    uint32_t window_ms = event_table[event].window_ms;
+    if (window_ms != 0) {
+        uint32_t last = atomic_load_explicit(&last_emit_ms[event], memory_order_relaxed);
+        if (now_ms - last < window_ms) {
+            // The first repeat arms the formatter's quiet-period summary
+            if (atomic_fetch_add_explicit(&suppressed[event], 1, memory_order_relaxed) == 0) {
+                rtlog_wake();
+            }
+            atomic_fetch_add_explicit(&stat_coalesced, 1, memory_order_relaxed);
+            return;
+        }
+        atomic_store_explicit(&last_emit_ms[event], now_ms, memory_order_relaxed);
+        repeats = atomic_exchange_explicit(&suppressed[event], 0, memory_order_relaxed);
+    }
+    
+    // Claim a slot
+    unsigned int pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    rtlog_slot_t *slot;
+    while (1) {
+        slot = &ring[pos & (RTLOG_SLOTS - 1)];
+        unsigned int seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring_head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: keep the repeat count for the next instance
+            if (repeats != 0) {
+                atomic_fetch_add_explicit(&suppressed[event], repeats, memory_order_relaxed);
+            }
+            atomic_fetch_add_explicit(&stat_dropped, 1, memory_order_relaxed);
+            perf_drop(PERF_DROP_LOG_FULL, 1);
+            rtlog_wake();
+            return;
+        } else {
+            pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+        }
+    }
+    
+    rtlog_entry_t *entry = &slot->entry;
+    entry->event = (uint16_t)event;
+    entry->repeats = (uint16_t)(repeats > UINT16_MAX ? UINT16_MAX : repeats);
+    entry->timestamp_ms = now_ms;
+    for (uint32_t i = 0; i < RTLOG_MAX_ARGS; i++) {
+        entry->args[i] = (args != NULL && i < count) ? args[i] : 0;
+    }
+    
+    // Publish to the formatter
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&stat_written, 1, memory_order_relaxed);
+    
+    unsigned int depth = pos + 1 - atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    unsigned int high = atomic_load_explicit(&stat_high_water, memory_order_relaxed);
+    while (depth > high &&
+           !atomic_compare_exchange_weak_explicit(&stat_high_water, &high, depth,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+    
+    rtlog_wake();
+}
+
+/**
+ * @brief Take the oldest published event (rtlog_task only)
+ */
+static bool rtlog_take(rtlog_entry_t *out)
+{
+    unsigned int tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    rtlog_slot_t *slot = &ring[tail & (RTLOG_SLOTS - 1)];
+    
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tail + 1) {
+        return false;
+    }
+    
+    *out = slot->entry;
+    
+    // Hand the slot back to producers one lap ahead
+    atomic_store_explicit(&slot->seq, tail + RTLOG_SLOTS, memory_order_release);
+    atomic_store_explicit(&ring_tail, tail + 1, memory_order_relaxed);
+    
+    return true;
+}
+
+/**
+ * @brief printf one conversion at a time, typing each argument by its
+ *        conversion character
+ */
+static int rtlog_format(char *buf, size_t size, const char *format, const uint32_t *args)
+{
+    size_t len = 0;
+    int arg = 0;
+    const char *p = format;
+    
+    while (*p != '\0' && len + 1 < size) {
+        if (*p != '%') {
+            buf[len++] = *p++;
+            continue;
+        }
+        
+        // Copy flags, width and precision, then the conversion
+        char spec[16];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL && n < sizeof(spec) - 2) {
+            spec[n++] = *p++;
+        }
+        char conv = *p;
+        if (conv == '\0') {
+            break;
+        }
+        p++;
+        if (conv == '%') {
+            buf[len++] = '%';
+            continue;
+        }
+        spec[n++] = conv;
+        spec[n] = '\0';
+        
+        uint32_t value = (arg < RTLOG_MAX_ARGS) ? args[arg++] : 0;
+        int written;
+        switch (conv) {
+        case 'd':
+        case 'i':
+        case 'c':
+            written = snprintf(buf + len, size - len, spec, (int)(int32_t)value);
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            written = snprintf(buf + len, size - len, spec, (unsigned int)value);
+            break;
+        case 'f':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G': {
+            float f;
+            memcpy(&f, &value, sizeof(f));
+            written = snprintf(buf + len, size - len, spec, (double)f);
+            break;
+        }
+        case 'D':
+        case 'M':
+            // Scaled integer, formatted here so the producer needs no float
+            spec[n - 1] = 'f';
+            written = snprintf(buf + len, size - len, spec,
+                               (double)(int32_t)value / (conv == 'D' ? 10.0 : 1000.0));
+            break;
+        case 's':
+            written = snprintf(buf + len, size - len, spec, (const char *)(uintptr_t)value);
+            break;
+        default:
+            written = 0;
+            break;
+        }
+        
+        if (written < 0) {
+            break;
+        }
+        len += (size_t)written;
+        if (len >= size) {
+            len = size - 1;
+        }
+    }
+    
+    buf[len] = '\0';
+    return (int)len;
+}
+
+/**
+ * @brief Format and print one event
+ * @param summary true for a quiet-period repeat count of the last instance
+ */
+static void rtlog_emit(const rtlog_entry_t *entry, uint32_t repeats, bool summary)
+{
+    const rtlog_desc_t *desc = &event_table[entry->event];
+    
+    // Same filtering ESP_LOGx would have applied in the producer
+    if (esp_log_level_get(desc->tag) < desc->level) {
+        return;
+    }
+    
+    char line[RTLOG_LINE_MAX];
+    int len = rtlog_format(line, sizeof(line), desc->format, entry->args);
+    if (repeats != 0) {
+        snprintf(line + len, sizeof(line) - len,
+                 summary ? " (repeated %u more times)" : " (+%u suppressed)",
+                 (unsigned int)repeats);
+    }
+    
+    // Output is timestamped when printed; flag events that waited noticeably
+    uint32_t age_ms = rtlog_now_ms() - entry->timestamp_ms;
+    if (!summary && age_ms >= RTLOG_LATE_MS) {
+        len = (int)strlen(line);
+        snprintf(line + len, sizeof(line) - len, " [%u ms ago]", (unsigned int)age_ms);
+    }
+    
+    ESP_LOG_LEVEL(desc->level, desc->tag, "%s", line);
+    
+    atomic_fetch_add_explicit(&stat_emitted, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Report repeats of events that have gone quiet since
+ * @return Time until the next pending summary is due, portMAX_DELAY if none
+ */
+static TickType_t rtlog_flush_quiet(uint32_t now_ms)
+{
+    uint32_t next_ms = UINT32_MAX;
+    
+    for (int i = 0; i < RTLOG_EVENT_COUNT; i++) {
+        uint32_t window_ms = event_table[i].window_ms;
+        if (window_ms == 0 || atomic_load_explicit(&suppressed[i], memory_order_relaxed) == 0) {
+            continue;
+        }
+        // Without a printed instance to refer to, the count waits for the next one
+        if (!last_valid[i]) {
+            continue;
+        }
+        
+        uint32_t elapsed_ms = now_ms - atomic_load_explicit(&last_emit_ms[i], memory_order_relaxed);
+        if (elapsed_ms < window_ms) {
+            if (window_ms - elapsed_ms < next_ms) {
+                next_ms = window_ms - elapsed_ms;
+            }
+            continue;
+        }
+        
+        uint32_t repeats = atomic_exchange_explicit(&suppressed[i], 0, memory_order_relaxed);
+        if (repeats != 0) {
+            rtlog_emit(&last_entry[i], repeats, true);
+        }
+    }
+    
+    return (next_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(next_ms) + 1;
+}
+
+/**
+ * @brief Formatter task
+ */
+void rtlog_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Deferred log task started (%d slots)", RTLOG_SLOTS);
+    
+    uint32_t reported_drops = 0;
+    TickType_t wait = 0;
+    
+    // Events recorded before this point are drained by the first pass
+    rtlog_task_handle = xTaskGetCurrentTaskHandle();
+    
+    while (1) {
+        // Woken by a new event, a first repeat or a full ring; the timeout
+        // only runs while a quiet-period summary is pending
+        ulTaskNotifyTake(pdTRUE, wait);
+        
+        rtlog_entry_t entry;
+        while (rtlog_take(&entry)) {
+            last_entry[entry.event] = entry;
+            last_valid[entry.event] = true;
+            rtlog_emit(&entry, entry.repeats, false);
+        }
+        
+        wait = rtlog_flush_quiet(rtlog_now_ms());
+        
+        uint32_t drops = atomic_load_explicit(&stat_dropped, memory_order_relaxed);
+        if (drops != reported_drops) {
+            ESP_LOGW(TAG, "Log buffer full, %u events lost in total", (unsigned int)drops);
+            reported_drops = drops;
+        }
+    }
+}
+
+/**
+ * @brief Get pipeline counters
+ */
+void rtlog_get_stats(rtlog_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    
+    stats->written = atomic_load_explicit(&stat_written, memory_order_relaxed);
+    stats->emitted = atomic_load_explicit(&stat_emitted, memory_order_relaxed);
+    stats->coalesced = atomic_load_explicit(&stat_coalesced, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&stat_dropped, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&stat_high_water, memory_order_relaxed);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file rtlog.h
+ * @brief Deferred logging for the real-time tasks
+ *
+ * adc_task, the channel processor and control_task must not format floats or
+ * block on the console UART inside their loops. They record a compact event
+ * instead: an id from rtlog_event_t plus up to RTLOG_MAX_ARGS 32-bit
+ * arguments. The event goes into a lock-free multi-producer ring with no
+ * formatting or locking, and a task notification wakes a low-priority task on
+ * the aux core. It drains the ring, formats each event with the printf format
+ * in the event table and emits it through the normal ESP_LOG output and level
+ * filtering, then sleeps until the next event.
+ *
+ * Events with a coalescing window (the overload warnings) are rate-limited at
+ * the producer. Repeats within the window only bump a counter, which is
+ * reported with the next emitted instance or once the event goes quiet. A
+ * full ring drops the event and counts it as PERF_DROP_LOG_FULL.
+ *
+ * Formats take integer conversions (%d %u %x %c), %f/%e/%g for arguments
+ * wrapped in RTLOG_F() and %s for string literals wrapped in RTLOG_S(). %D and
+ * %M print a signed integer in tenths or thousandths like %f (e.g. "%.1D" for
+ * 0.1 °C, "%.2M" for mV as V), so producers on the fixed-point path need no
+ * float. Length modifiers are not supported.
+ */
+
+#ifndef RTLOG_H
+#define RTLOG_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define RTLOG_MAX_ARGS  5
+#define RTLOG_SLOTS     32      // Ring capacity in events (power of two)
+
+/**
+ * @brief Deferred log events (formats and levels are in rtlog.c)
+ */
+typedef enum {
+    // adc_handler
+    RTLOG_ADC_READING = 0,      // battery mV, battery mV, ADC raw, temp 0.1 °C
+    RTLOG_ADC_READ_FAILED,      // channel, esp_err_t name
+    RTLOG_ADC_TEMP_RANGE,       // sensor mV
+    RTLOG_ADC_EMPTY_FRAME,      // frame bytes
+    // channel_processor
+    RTLOG_CH_COMPENSATION,      // ch, temp 0.1 °C, compensation mV, TH_ON, TH_OFF
+    RTLOG_CH_STATE_CHANGE,      // ch, "ON"/"OFF", filtered mV, TH_ON, TH_OFF
+    RTLOG_CH_STATUS,            // ch, "ON"/"OFF", filtered mV, raw mV, temp 0.1 °C
+    RTLOG_CH_OVERRUN,           // total samples lost
+    RTLOG_CH_QUEUE_FULL,        // ch
+    // control_handler
+    RTLOG_CTRL_SET_DUTY_FAILED, // esp_err_t name
+    RTLOG_CTRL_UPDATE_DUTY_FAILED, // esp_err_t name
+    RTLOG_CTRL_MUTEX_TIMEOUT,
+    RTLOG_CTRL_TIMER_FAILED,    // timer name, esp_err_t name
+    RTLOG_CTRL_MOTION,          // timeout ms
+    RTLOG_CTRL_MOTION_EXPIRED,
+    RTLOG_CTRL_SCHEDULE,        // "night"/"day", filtered mV, level %
+    RTLOG_CTRL_STATUS,          // output mask, duty %, battery mV, "ACTIVE"/"idle"
+    RTLOG_CTRL_FIRST_CHANGE,    // ms since boot, us since sample, output mask, duty %
+    RTLOG_EVENT_COUNT
+} rtlog_event_t;
+
+/**
+ * @struct rtlog_stats_t
+ * @brief Pipeline counters since boot
+ */
+typedef struct {
+    uint32_t written;           // Events queued
+    uint32_t emitted;           // Events formatted and printed
+    uint32_t coalesced;         // Repeats folded into a count
+    uint32_t dropped;           // Events lost to a full ring
+    uint32_t high_water;        // Most events waiting at once
+} rtlog_stats_t;
+
+/**
+ * @brief Pass a float argument (bit pattern, formatted with %f/%e/%g)
+ */
+static inline uint32_t rtlog_f(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+#define RTLOG_F(x)  rtlog_f((float)(x))
+#define RTLOG_S(s)  ((uint32_t)(uintptr_t)(s))  // String with static storage only
+
+/**
+ * @brief Record an event with arguments
+ *
+ *   RTLOG(RTLOG_CH_QUEUE_FULL, ctx->channel_id);
+ */
+#define RTLOG(event, ...) do { \
+        const uint32_t rtlog_args_[] = { __VA_ARGS__ }; \
+        rtlog_write((event), rtlog_args_, sizeof(rtlog_args_) / sizeof(rtlog_args_[0])); \
+    } while (0)
+
+/**
+ * @brief Initialize the ring before any producer runs
+ */
+void rtlog_init(void);
+
+/**
+ * @brief Record an event (task context, any core; never blocks)
+ * @param event Event id
+ * @param args Arguments in format order (may be NULL if count is 0)
+ * @param count Number of arguments (extra ones are ignored)
+ */
+void rtlog_write(rtlog_event_t event, const uint32_t *args, uint32_t count);
+
+/**
+ * @brief Formatter task: drains the ring and prints the events
+ * @param pvParameters Task parameters (unused)
+ */
+void rtlog_task(void *pvParameters);
+
+/**
+ * @brief Get pipeline counters
+ */
+void rtlog_get_stats(rtlog_stats_t *stats);
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file rtos_alloc.h
+ * @brief Static or heap allocation of the application's FreeRTOS objects
+ *
+ * With CONFIG_SOLAR_STATIC_ALLOCATION every task stack, queue, mutex and
+ * event group of the application is a buffer sized at compile time, so the
+ * footprint shows in the link map and nothing can fail for lack of heap.
+ * Without it the same calls create the objects on the heap.
+ *
+ * Each object needs a storage declaration at file scope next to its handle
+ * and a create call using the same name:
+ *
+ *   RTOS_MUTEX_STORAGE(hw_mutex);
+ *   ...
+ *   hw_mutex = RTOS_MUTEX_CREATE(hw_mutex);
+ *
+ * In heap builds the storage declarations only declare, so they cost nothing.
+ */
+
+#ifndef RTOS_ALLOC_H
+#define RTOS_ALLOC_H
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#if CONFIG_SOLAR_STATIC_ALLOCATION
+
+#define RTOS_STATIC_ALLOCATION  1
+
+// Task: stack depth in bytes, as for xTaskCreatePinnedToCore() in ESP-IDF
+#define RTOS_TASK_STORAGE(name, stack_bytes) \
+    static StackType_t name##_stack[(stack_bytes) / sizeof(StackType_t)]; \
+    static StaticTask_t name##_tcb
+
+// Evaluates to pdPASS or pdFAIL like xTaskCreatePinnedToCore()
+#define RTOS_TASK_CREATE(name, fn, label, stack_bytes, arg, priority, handle, core) \
+    ((*(handle) = xTaskCreateStaticPinnedToCore((fn), (label), sizeof(name##_stack), (arg), \
+                                                (priority), name##_stack, &name##_tcb, \
+                                                (core))) != NULL ? pdPASS : pdFAIL)
+
+#define RTOS_QUEUE_STORAGE(name, depth, item_size) \
+    static uint8_t name##_items[(depth) * (item_size)]; \
+    static StaticQueue_t name##_queue
+
+#define RTOS_QUEUE_CREATE(name, depth, item_size) \
+    xQueueCreateStatic((depth), (item_size), name##_items, &name##_queue)
+
+#define RTOS_MUTEX_STORAGE(name)        static StaticSemaphore_t name##_mutex
+#define RTOS_MUTEX_CREATE(name)         xSemaphoreCreateMutexStatic(&name##_mutex)
+
+#define RTOS_EVENT_GROUP_STORAGE(name)  static StaticEventGroup_t name##_group
+#define RTOS_EVENT_GROUP_CREATE(name)   xEventGroupCreateStatic(&name##_group)
+
+#else
+
+#define RTOS_STATIC_ALLOCATION  0
+
+#define RTOS_TASK_STORAGE(name, stack_bytes)    extern StaticTask_t name##_tcb
+#define RTOS_TASK_CREATE(name, fn, label, stack_bytes, arg, priority, handle, core) \
+    xTaskCreatePinnedToCore((fn), (label), (stack_bytes), (arg), (priority), (handle), (core))
+
+#define RTOS_QUEUE_STORAGE(name, depth, item_size)  extern StaticQueue_t name##_queue
+#define RTOS_QUEUE_CREATE(name, depth, item_size)   xQueueCreate((depth), (item_size))
+
+#define RTOS_MUTEX_STORAGE(name)        extern StaticSemaphore_t name##_mutex
+#define RTOS_MUTEX_CREATE(name)         xSemaphoreCreateMutex()
+
+#define RTOS_EVENT_GROUP_STORAGE(name)  extern StaticEventGroup_t name##_group
+#define RTOS_EVENT_GROUP_CREATE(name)   xEventGroupCreate()
+
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+#include "sample_ring.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "rtos_alloc.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "SAMPLE_RING";
+
+#define SAMPLE_RING_MASK    (SAMPLE_RING_SIZE - 1)
+
+_Static_assert((SAMPLE_RING_SIZE & SAMPLE_RING_MASK) == 0, "SAMPLE_RING_SIZE must be a power of two");
+
+/**
+ * @brief Ring slot
+ * seq holds (sequence number + 1) of the reading stored in the slot,
+ * or 0 while the writer is overwriting it.
+ */
+typedef struct {
+    atomic_uint seq;
+    adc_reading_t reading;
+} sample_slot_t;
+
+static sample_slot_t slots[SAMPLE_RING_SIZE];
+
+// Sequence number of the next reading to be written
+static atomic_uint head = 0;
+
+// Registered readers
+static sample_ring_reader_t readers[SAMPLE_RING_MAX_READERS];
+static int reader_count = 0;
+static portMUX_TYPE reader_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// One bit per reader, set by the writer to wake all readers at once
+static EventGroupHandle_t ring_events = NULL;
+RTOS_EVENT_GROUP_STORAGE(ring_events);
+static EventBits_t reader_bits = 0;
+
+/**
+ * @brief Initialize the broadcast ring
+ */
+void sample_ring_init(void)
+{
+    memset(slots, 0, sizeof(slots));
+    atomic_store(&head, 0);
+    reader_count = 0;
+    reader_bits = 0;
+    
+    ring_events = RTOS_EVENT_GROUP_CREATE(ring_events);
+    if (ring_events == NULL) {
+        ESP_LOGE(TAG, "Failed to create ring event group");
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Sample ring initialized: %d slots, %d readers max",
+             SAMPLE_RING_SIZE, SAMPLE_RING_MAX_READERS);
+}
+
+/**
+ * @brief Publish one reading (single producer)
+ */
+void sample_ring_publish(const adc_reading_t *reading)
+{
+    unsigned int seq = atomic_load_explicit(&head, memory_order_relaxed);
+    sample_slot_t *slot = &slots[seq & SAMPLE_RING_MASK];
+    
+    // Invalidate the slot before overwriting so a lapped reader notices
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    slot->reading = *reading;
+    
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+    atomic_store_explicit(&head, seq + 1, memory_order_release);
+    
+    // Wake every reader with a single call, independent of reader count
+    if (ring_events != NULL && reader_bits != 0) {
+        xEventGroupSetBits(ring_events, reader_bits);
+    }
+}
+
+/**
+ * @brief Register a reader at the current write position
+ */
+sample_ring_reader_t *sample_ring_reader_register(const char *name)
+{
+    sample_ring_reader_t *reader = NULL;
+    
+    portENTER_CRITICAL(&reader_mux);
+    if (reader_count < SAMPLE_RING_MAX_READERS) {
+        reader = &readers[reader_count];
+        memset(reader, 0, sizeof(*reader));
+        reader->name = name;
+        reader->cursor = atomic_load_explicit(&head, memory_order_acquire);
+        reader->bit = 1U << reader_count;
+        reader_bits |= reader->bit;
+        reader_count++;
+    }
+    portEXIT_CRITICAL(&reader_mux);
+    
+    if (reader == NULL) {
+        ESP_LOGE(TAG, "No free reader slot for '%s'", name);
+    } else {
+        ESP_LOGI(TAG, "Reader '%s' registered", name);
+    }
+    
+    return reader;
+}
+
+/**
+ * @brief Read the next reading for this reader
+ */
+bool sample_ring_read(sample_ring_reader_t *reader, adc_reading_t *reading, TickType_t timeout)
+{
+    if (reader == NULL || reading == NULL) {
+        return false;
+    }
+    
+    while (1) {
+        unsigned int written = atomic_load_explicit(&head, memory_order_acquire);
+        
+        if (written == reader->cursor) {
+            // Nothing new: sleep until the writer sets our bit
+            EventBits_t bits = xEventGroupWaitBits(ring_events, reader->bit,
+                                                   pdTRUE, pdFALSE, timeout);
+            if ((bits & reader->bit) == 0) {
+                return false;
+            }
+            continue;
+        }
+        
+        // Lapped: skip to the oldest reading still held in the ring
+        uint32_t lag = written - reader->cursor;
+        if (lag > SAMPLE_RING_SIZE) {
+            reader->overruns += lag - SAMPLE_RING_SIZE;
+            reader->cursor = written - SAMPLE_RING_SIZE;
+        }
+        
+        sample_slot_t *slot = &slots[reader->cursor & SAMPLE_RING_MASK];
+        unsigned int expected = reader->cursor + 1;
+        
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != expected) {
+            // Overwritten between reading head and reaching the slot
+            reader->overruns++;
+            reader->cursor++;
+            continue;
+        }
+        
+        *reading = slot->reading;
+        
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != expected) {
+            // Overwritten during the copy
+            reader->overruns++;
+            reader->cursor++;
+            continue;
+        }
+        
+        reader->cursor++;
+        reader->received++;
+        return true;
+    }
+}
+
+/**
+ * @brief Readings published but not yet consumed by this reader
+ */
+uint32_t sample_ring_reader_backlog(const sample_ring_reader_t *reader)
+{
+    if (reader == NULL) {
+        return 0;
+    }
+    
+    uint32_t lag = atomic_load_explicit(&head, memory_order_acquire) - reader->cursor;
+    return (lag > SAMPLE_RING_SIZE) ? SAMPLE_RING_SIZE : lag;
+}
+
+/**
+ * @brief Number of registered readers
+ */
+int sample_ring_reader_count(void)
+{
+    return reader_count;
+}
+
+/**
+ * @brief Get statistics for a registered reader
+ */
+bool sample_ring_get_reader_info(int index, sample_ring_reader_info_t *info)
+{
+    if (info == NULL || index < 0 || index >= reader_count) {
+        return false;
+    }
+    
+    const sample_ring_reader_t *reader = &readers[index];
+    unsigned int written = atomic_load_explicit(&head, memory_order_acquire);
+    
+    info->name = reader->name;
+    info->overruns = reader->overruns;
+    info->received = reader->received;
+    info->lag = written - reader->cursor;
+    
+    return true;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file sample_ring.h
+ * @brief Single-producer multi-consumer broadcast ring for ADC readings
+ *
+ * adc_task writes each reading into the ring exactly once. Every consumer
+ * registers a reader with its own cursor and receives every reading; a
+ * consumer that falls more than SAMPLE_RING_SIZE readings behind loses the
+ * oldest ones, which is counted per reader instead of stalling the writer.
+ *
+ * The ring is lock-free: the writer never blocks and readers detect being
+ * lapped through per-slot sequence numbers.
+ */
+
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "adc_handler.h"
+
+// Ring depth in readings (power of two, 1.6s at 100ms sampling)
+#define SAMPLE_RING_SIZE        16
+
+// Maximum number of registered readers (one event-group bit each)
+#define SAMPLE_RING_MAX_READERS 8
+
+/**
+ * @struct sample_ring_reader_t
+ * @brief Per-consumer read cursor and statistics
+ */
+typedef struct {
+    const char *name;
+    uint32_t cursor;        // Sequence number of the next reading to consume
+    uint32_t overruns;      // Readings lost because the writer lapped this reader
+    uint32_t received;      // Readings delivered
+    uint32_t bit;           // Wakeup bit in the ring's event group
+} sample_ring_reader_t;
+
+/**
+ * @struct sample_ring_reader_info_t
+ * @brief Snapshot of a reader's statistics for status reporting
+ */
+typedef struct {
+    const char *name;
+    uint32_t overruns;
+    uint32_t received;
+    uint32_t lag;           // Readings published but not yet consumed
+} sample_ring_reader_info_t;
+
+/**
+ * @brief Initialize the broadcast ring
+ *
+ * Must be called before adc_task starts publishing or any reader registers.
+ */
+void sample_ring_init(void);
+
+/**
+ * @brief Publish one reading to every reader
+ * @param reading Reading to copy into the ring
+ *
+ * @note Single producer only (adc_task). Never blocks.
+ */
+void sample_ring_publish(const adc_reading_t *reading);
+
+/**
+ * @brief Register a new reader starting at the current write position
+ * @param name Reader name for statistics (must stay valid)
+ * @return Reader handle, or NULL if all reader slots are in use
+ */
+sample_ring_reader_t *sample_ring_reader_register(const char *name);
+
+/**
+ * @brief Read the next reading for this reader
+ * @param reader Reader handle
+ * @param reading Output reading
+ * @param timeout Ticks to wait if no new reading is available
+ * @return true if a reading was delivered, false on timeout
+ *
+ * If the reader was lapped, it skips ahead to the oldest reading still in
+ * the ring and adds the skipped count to its overrun counter.
+ */
+bool sample_ring_read(sample_ring_reader_t *reader, adc_reading_t *reading, TickType_t timeout);
+
+/**
+ * @brief Readings published but not yet consumed by this reader
+ * @param reader Reader handle
+ * @return Backlog, capped at SAMPLE_RING_SIZE (anything older is lost)
+ */
+uint32_t sample_ring_reader_backlog(const sample_ring_reader_t *reader);
+
+/**
+ * @brief Number of registered readers
+ */
+int sample_ring_reader_count(void);
+
+/**
+ * @brief Get statistics for a registered reader
+ * @param index Reader index (0 to sample_ring_reader_count() - 1)
+ * @param info Output statistics
+ * @return true if index is valid
+ */
+bool sample_ring_get_reader_info(int index, sample_ring_reader_info_t *info);
+
+#endif
@@ -0,0 +1,345 @@
+#include "samplelog.h"
+#include "adc_handler.h"
+#include "sample_ring.h"
+#include "channel_processor.h"
+#include "channel_table.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "rtos_alloc.h"
+#include <string.h>
+
+static const char *TAG = "SAMPLELOG";
+
+_Static_assert(CHANNEL_COUNT <= SAMPLELOG_WIDE_STATE_BITS, "channel states do not fit a samplelog record");
+
+// Narrow records while every channel state fits, wide ones past that
+#if CHANNEL_COUNT <= SAMPLELOG_STATE_BITS
+#define SAMPLELOG_RECORD_MAGIC  SAMPLELOG_MAGIC
+#else
+#define SAMPLELOG_RECORD_MAGIC  SAMPLELOG_MAGIC_WIDE
+#endif
+
+static const esp_partition_t *log_partition = NULL;
+static uint32_t page_count = 0;
+
+// Ring position, guarded by log_mutex
+static uint32_t next_page = 0;
+static uint32_t next_sequence = 0;
+static uint32_t pages_used = 0;
+
+// RAM staging page, written to flash when full (guarded by log_mutex)
+static samplelog_page_t stage;
+static samplelog_codec_t stage_codec;
+
+// Page buffer handed out by samplelog_dump_page() (CLI only)
+static samplelog_page_t dump_buffer;
+
+// Guards the staging page and flash writes
+static SemaphoreHandle_t log_mutex = NULL;
+RTOS_MUTEX_STORAGE(log_mutex);
+
+// Statistics since boot
+static uint32_t pages_written = 0;
+static uint32_t gap_count = 0;
+static uint32_t write_errors = 0;
+
+/**
+ * @brief Scan page headers for the newest page and resume after it
+ */
+static void samplelog_scan(void)
+{
+    uint32_t newest_page = 0;
+    uint32_t newest_sequence = 0;
+    bool found = false;
+    
+    pages_used = 0;
+    
+    for (uint32_t page = 0; page < page_count; page++) {
+        samplelog_page_header_t header;
+        if (esp_partition_read(log_partition, page * SAMPLELOG_PAGE_SIZE,
+                               &header, sizeof(header)) != ESP_OK) {
+            continue;
+        }
+        if (!samplelog_header_valid(&header)) {
+            continue;
+        }
+        
+        pages_used++;
+        if (!found || (int32_t)(header.sequence - newest_sequence) > 0) {
+            newest_sequence = header.sequence;
+            newest_page = page;
+            found = true;
+        }
+    }
+    
+    next_page = found ? (newest_page + 1) % page_count : 0;
+    next_sequence = found ? newest_sequence + 1 : 0;
+}
+
+/**
+ * @brief Write the staging page to the next flash page (log_mutex held)
+ */
+static esp_err_t samplelog_write_stage_locked(void)
+{
+    if (stage.header.count == 0) {
+        return ESP_OK;
+    }
+    
+    size_t offset = next_page * SAMPLELOG_PAGE_SIZE;
+    stage.header.sequence = next_sequence;
+    
+    // One erase per page: the page is written once and never rewritten
+    esp_err_t err = esp_partition_erase_range(log_partition, offset, SAMPLELOG_PAGE_SIZE);
+    if (err == ESP_OK) {
+        err = esp_partition_write(log_partition, offset, &stage, sizeof(stage));
+    }
+    
+    // Start a fresh page either way: a failing sector must not stall sampling
+    stage.header.count = 0;
+    
+    if (err != ESP_OK) {
+        write_errors++;
+        ESP_LOGE(TAG, "Failed to write page %u: %s", (unsigned int)next_page, esp_err_to_name(err));
+    } else if (pages_used < page_count) {
+        pages_used++;
+    }
+    
+    // Skip a bad sector rather than retrying it forever
+    next_page = (next_page + 1) % page_count;
+    next_sequence++;
+    pages_written++;
+    
+    return err;
+}
+
+/**
+ * @brief Append one reading to the staging page (log_mutex held)
+ */
+static void samplelog_append_locked(const adc_reading_t *reading, uint16_t state)
+{
+    samplelog_page_header_t *header = &stage.header;
+    
+    // Records carry no timestamp, so any sampling gap closes the page
+    if (header->count > 0) {
+        uint32_t expected = header->start_ms + (uint32_t)header->count * header->interval_ms;
+        int32_t skew = (int32_t)(reading->timestamp_ms - expected);
+        int32_t tolerance = header->interval_ms / 2;
+        
+        if (reading->interval_ms != header->interval_ms) {
+            // Cadence change: a new page at the new spacing, not a gap
+            samplelog_write_stage_locked();
+        } else if (skew > tolerance || skew < -tolerance) {
+            gap_count++;
+            samplelog_write_stage_locked();
+        }
+    }
+    
+    uint32_t mv = reading->battery_voltage_mv > UINT16_MAX ? UINT16_MAX : reading->battery_voltage_mv;
+    uint32_t temp_raw = reading->temperature_raw > UINT16_MAX ? UINT16_MAX : reading->temperature_raw;
+    
+    if (header->count == 0) {
+        header->magic = SAMPLELOG_RECORD_MAGIC;
+        header->start_ms = reading->timestamp_ms;
+        header->base_mv = (uint16_t)mv;
+        header->base_temp_raw = (uint16_t)temp_raw;
+        header->interval_ms = (uint16_t)reading->interval_ms;
+        samplelog_codec_reset(&stage_codec, mv, temp_raw);
+    }
+    
+    samplelog_page_append(&stage, &stage_codec, mv, temp_raw, state);
+    
+    if (header->count == samplelog_records_per_page(SAMPLELOG_RECORD_MAGIC)) {
+        samplelog_write_stage_locked();
+    }
+}
+
+/**
+ * @brief Find the log partition and resume after its newest page
+ */
+void samplelog_init(void)
+{
+    ESP_LOGI(TAG, "Initializing sample recorder");
+    
+    log_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                             SAMPLELOG_PARTITION_SUBTYPE,
+                                             SAMPLELOG_PARTITION_LABEL);
+    if (log_partition == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition, sample recording disabled", SAMPLELOG_PARTITION_LABEL);
+        return;
+    }
+    
+    page_count = log_partition->size / SAMPLELOG_PAGE_SIZE;
+    if (page_count == 0) {
+        ESP_LOGE(TAG, "Partition too small for one page");
+        log_partition = NULL;
+        return;
+    }
+    
+    log_mutex = RTOS_MUTEX_CREATE(log_mutex);
+    if (log_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create log mutex");
+        log_partition = NULL;
+        return;
+    }
+    
+    memset(&stage, 0xFF, sizeof(stage));
+    stage.header.count = 0;
+    
+    samplelog_scan();
+    
+    ESP_LOGI(TAG, "Sample log: %u/%u pages used, resuming at page %u (seq %u), %u h capacity",
+             (unsigned int)pages_used, (unsigned int)page_count,
+             (unsigned int)next_page, (unsigned int)next_sequence,
+             (unsigned int)(page_count * samplelog_records_per_page(SAMPLELOG_RECORD_MAGIC) * ADC_SAMPLE_INTERVAL_MS / 3600000));
+}
+
+/**
+ * @brief Recorder task
+ */
+void samplelog_task(void *pvParameters)
+{
+    if (log_partition == NULL) {
+        ESP_LOGW(TAG, "Recorder not available");
+        vTaskDelete(NULL);
+        return;
+    }
+    
+    sample_ring_reader_t *reader = sample_ring_reader_register(pcTaskGetName(NULL));
+    if (reader == NULL) {
+        ESP_LOGE(TAG, "Input reader not available");
+        vTaskDelete(NULL);
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Recorder started");
+    
+    adc_reading_t reading;
+    
+    while (1) {
+        if (!sample_ring_read(reader, &reading, portMAX_DELAY)) {
+            continue;
+        }
+        
+        // Output decisions are read after the processor has seen this reading
+        uint16_t state = 0;
+        for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+            if (channel_get_state(ch)) {
+                state |= 1U << ch;
+            }
+        }
+        
+        xSemaphoreTake(log_mutex, portMAX_DELAY);
+        samplelog_append_locked(&reading, state);
+        xSemaphoreGive(log_mutex);
+    }
+}
+
+/**
+ * @brief Write the staging page now
+ */
+esp_err_t samplelog_flush(void)
+{
+    if (log_partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    esp_err_t err = samplelog_write_stage_locked();
+    xSemaphoreGive(log_mutex);
+    
+    return err;
+}
+
+/**
+ * @brief Get recorder status
+ */
+void samplelog_get_info(samplelog_info_t *info)
+{
+    if (info == NULL) {
+        return;
+    }
+    
+    memset(info, 0, sizeof(*info));
+    if (log_partition == NULL) {
+        return;
+    }
+    
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    info->available = true;
+    info->page_count = page_count;
+    info->pages_used = pages_used;
+    info->staged = stage.header.count;
+    info->pages_written = pages_written;
+    info->gaps = gap_count;
+    info->write_errors = write_errors;
+    info->records_per_page = samplelog_records_per_page(SAMPLELOG_RECORD_MAGIC);
+    info->capacity_s = page_count * info->records_per_page * ADC_SAMPLE_INTERVAL_MS / 1000;
+    xSemaphoreGive(log_mutex);
+}
+
+/**
+ * @brief Snapshot the page order for a dump
+ */
+bool samplelog_dump_prepare(samplelog_dump_t *plan)
+{
+    if (plan == NULL || log_partition == NULL) {
+        return false;
+    }
+    
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    plan->flash_pages = pages_used;
+    plan->first_page = (next_page + page_count - pages_used) % page_count;
+    plan->staged = stage.header.count > 0;
+    plan->stage_sequence = next_sequence;
+    xSemaphoreGive(log_mutex);
+    
+    plan->total = plan->flash_pages + (plan->staged ? 1 : 0);
+    
+    return true;
+}
+
+/**
+ * @brief Read one page of a dump into a caller buffer
+ */
+esp_err_t samplelog_read_page(const samplelog_dump_t *plan, uint32_t n, samplelog_page_t *page)
+{
+    if (plan == NULL || page == NULL || log_partition == NULL || n >= plan->total) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t err = ESP_OK;
+    
+    // Hold the mutex only for one sector read so recording never stalls
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    if (n < plan->flash_pages) {
+        uint32_t index = (plan->first_page + n) % page_count;
+        err = esp_partition_read(log_partition, index * SAMPLELOG_PAGE_SIZE,
+                                 page, sizeof(*page));
+    } else {
+        // Staging page; may have been flushed since the plan (then count is 0)
+        *page = stage;
+        page->header.sequence = next_sequence;
+    }
+    xSemaphoreGive(log_mutex);
+    
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read page: %s", esp_err_to_name(err));
+    }
+    
+    return err;
+}
+
+/**
+ * @brief Read one page of a dump
+ */
+const samplelog_page_t *samplelog_dump_page(const samplelog_dump_t *plan, uint32_t n)
+{
+    if (samplelog_read_page(plan, n, &dump_buffer) != ESP_OK) {
+        return NULL;
+    }
+    
+    return &dump_buffer;
+}
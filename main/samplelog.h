@@ -0,0 +1,111 @@
+/**
+ * @file samplelog.h
+ * @brief Flash-backed ring log of every ADC reading and channel state
+ *
+ * A low-priority recorder task reads the sample ring like any other consumer,
+ * delta-encodes each reading into a 16-bit record (32-bit past four channels,
+ * see samplelog_format.h) and stages a full flash sector in RAM. Only a
+ * complete page (or a page cut short by a sampling gap or an explicit flush)
+ * is written, with one sector erase per page, so flash wear is one erase per
+ * ~200 s of 10 Hz data.
+ *
+ * The log lives in the "samplelog" data partition and survives reboots; the
+ * recorder resumes after the newest page found at startup.
+ */
+
+#ifndef SAMPLELOG_H
+#define SAMPLELOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "samplelog_format.h"
+
+#define SAMPLELOG_PARTITION_LABEL   "samplelog"
+#define SAMPLELOG_PARTITION_SUBTYPE 0x40    // Custom data subtype (partitions.csv)
+
+/**
+ * @struct samplelog_info_t
+ * @brief Recorder status for the CLI
+ */
+typedef struct {
+    bool available;             // Partition found and recorder initialized
+    uint32_t page_count;        // Pages in the partition
+    uint32_t pages_used;        // Valid pages currently in flash
+    uint32_t staged;            // Records waiting in the RAM staging page
+    uint32_t pages_written;     // Pages (sector erases) written since boot
+    uint32_t gaps;              // Pages closed early by a sampling gap
+    uint32_t write_errors;
+    uint32_t records_per_page;  // Page capacity at this build's record width
+    uint32_t capacity_s;        // History held by a full log at 10 Hz
+} samplelog_info_t;
+
+/**
+ * @struct samplelog_dump_t
+ * @brief Page order captured at the start of a dump
+ */
+typedef struct {
+    uint32_t first_page;        // Oldest flash page
+    uint32_t flash_pages;       // Flash pages to stream, oldest first
+    bool staged;                // Followed by the RAM staging page
+    uint32_t total;             // flash_pages + staged
+    uint32_t stage_sequence;    // Sequence the staging page will be written with
+} samplelog_dump_t;
+
+/**
+ * @brief Find the log partition and resume after its newest page
+ *
+ * Logs a warning and leaves the recorder disabled if the partition is missing.
+ */
+void samplelog_init(void);
+
+/**
+ * @brief Recorder task
+ * @param pvParameters Task parameters (unused)
+ *
+ * Appends one record per published reading; blocks on the sample ring.
+ */
+void samplelog_task(void *pvParameters);
+
+/**
+ * @brief Write the staging page now, even if partially filled
+ * @return ESP_OK, or the flash error
+ */
+esp_err_t samplelog_flush(void);
+
+/**
+ * @brief Get recorder status
+ */
+void samplelog_get_info(samplelog_info_t *info);
+
+/**
+ * @brief Snapshot the page order for a dump
+ * @param plan Filled with the pages to stream
+ * @return false if the recorder is not available
+ */
+bool samplelog_dump_prepare(samplelog_dump_t *plan);
+
+/**
+ * @brief Read one page of a dump
+ * @param plan Plan from samplelog_dump_prepare()
+ * @param n Page number within the dump (0 to plan->total - 1)
+ * @return Page copy valid until the next call, or NULL on a read error
+ *
+ * The recorder keeps running during a dump. A flash page overwritten since
+ * the plan was taken is streamed with its new contents; readers order pages
+ * by header sequence number.
+ */
+const samplelog_page_t *samplelog_dump_page(const samplelog_dump_t *plan, uint32_t n);
+
+/**
+ * @brief Read one page of a dump into a caller buffer
+ * @param plan Plan from samplelog_dump_prepare()
+ * @param n Page number within the dump (0 to plan->total - 1)
+ * @param page Filled with the page
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or the flash error
+ *
+ * Same as samplelog_dump_page() for readers other than the CLI.
+ */
+esp_err_t samplelog_read_page(const samplelog_dump_t *plan, uint32_t n, samplelog_page_t *page);
+
+#endif
@@ -0,0 +1,189 @@
+/**
+ * @file samplelog_format.h
+ * @brief On-flash format of the sample recorder, shared with host tools
+ *
+ * The log is a ring of flash-sector-sized pages. Each page is erased and
+ * written exactly once, from a RAM staging copy, and holds a header followed
+ * by fixed-width records, one per ADC reading. The page magic sets the
+ * record width. An "SLG1" record is one 16-bit word:
+ *
+ *   bits 15..8  battery delta, mV (int8)
+ *   bits  7..4  temperature sensor delta, mV (int4, 0.1 °C for a TMP36)
+ *   bits  3..0  states of channels 0-3 (bit n = channel n)
+ *
+ * An "SLG2" record, written by builds with more than four channels, is the
+ * same word followed by a second one holding the states of channels 4-11 in
+ * its low byte (high byte zero).
+ *
+ * Deltas are taken against the value the decoder will reconstruct, not the
+ * previous raw sample, so a step larger than a field saturates for a few
+ * records and then catches up instead of drifting. Record n of a page was
+ * sampled at start_ms + n * interval_ms; a gap in sampling starts a new page.
+ *
+ * Header-only and free of ESP-IDF dependencies.
+ */
+
+#ifndef SAMPLELOG_FORMAT_H
+#define SAMPLELOG_FORMAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SAMPLELOG_PAGE_SIZE     4096        // One flash sector
+#define SAMPLELOG_MAGIC         0x31474C53  // "SLG1": one word per record
+#define SAMPLELOG_MAGIC_WIDE    0x32474C53  // "SLG2": two words per record
+#define SAMPLELOG_STATE_BITS    4           // Channel states in an SLG1 record
+#define SAMPLELOG_WIDE_STATE_BITS 12        // Channel states in an SLG2 record
+
+/**
+ * @struct samplelog_page_header_t
+ * @brief Header at the start of every page
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t sequence;          // Increments per page written, never wraps in practice
+    uint32_t start_ms;          // Timestamp of record 0
+    uint16_t base_mv;           // Battery voltage the record 0 delta applies to
+    uint16_t base_temp_raw;     // Temperature sensor mV the record 0 delta applies to
+    uint16_t count;             // Records in this page
+    uint16_t interval_ms;       // Spacing of records
+} samplelog_page_header_t;
+
+#define SAMPLELOG_WORDS_PER_PAGE \
+    ((SAMPLELOG_PAGE_SIZE - sizeof(samplelog_page_header_t)) / sizeof(uint16_t))
+
+/**
+ * @struct samplelog_page_t
+ * @brief One page as stored in flash and streamed by the CLI
+ */
+typedef struct __attribute__((packed)) {
+    samplelog_page_header_t header;
+    uint16_t records[SAMPLELOG_WORDS_PER_PAGE];     // header.count records of 1 or 2 words
+} samplelog_page_t;
+
+_Static_assert(sizeof(samplelog_page_t) <= SAMPLELOG_PAGE_SIZE, "samplelog page exceeds a sector");
+
+/**
+ * @brief 16-bit words per record for a page magic
+ */
+static inline uint32_t samplelog_record_words(uint32_t magic)
+{
+    return (magic == SAMPLELOG_MAGIC_WIDE) ? 2 : 1;
+}
+
+/**
+ * @brief Records that fit a page for a page magic
+ */
+static inline uint32_t samplelog_records_per_page(uint32_t magic)
+{
+    return SAMPLELOG_WORDS_PER_PAGE / samplelog_record_words(magic);
+}
+
+/**
+ * @brief Delta codec state (the last reconstructed values)
+ */
+typedef struct {
+    int32_t mv;
+    int32_t temp_raw;
+} samplelog_codec_t;
+
+static inline int32_t samplelog_clamp(int32_t v, int32_t lo, int32_t hi)
+{
+    return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+/**
+ * @brief Start a page: record 0 deltas apply to the header base values
+ */
+static inline void samplelog_codec_reset(samplelog_codec_t *codec, uint32_t base_mv, uint32_t base_temp_raw)
+{
+    codec->mv = (int32_t)base_mv;
+    codec->temp_raw = (int32_t)base_temp_raw;
+}
+
+/**
+ * @brief Encode one sample and advance the codec
+ */
+static inline uint16_t samplelog_encode(samplelog_codec_t *codec, uint32_t mv, uint32_t temp_raw, uint8_t state)
+{
+    int32_t dmv = samplelog_clamp((int32_t)mv - codec->mv, -128, 127);
+    int32_t dtemp = samplelog_clamp((int32_t)temp_raw - codec->temp_raw, -8, 7);
+    
+    codec->mv += dmv;
+    codec->temp_raw += dtemp;
+    
+    return (uint16_t)(((uint16_t)(uint8_t)(int8_t)dmv << 8) |
+                      (((uint16_t)dtemp & 0x0F) << 4) |
+                      (state & ((1U << SAMPLELOG_STATE_BITS) - 1)));
+}
+
+/**
+ * @brief Decode one record and advance the codec
+ */
+static inline void samplelog_decode(samplelog_codec_t *codec, uint16_t record,
+                                    uint32_t *mv, uint32_t *temp_raw, uint8_t *state)
+{
+    int32_t dmv = (int8_t)(record >> 8);
+    int32_t dtemp = (int32_t)((record >> 4) & 0x0F);
+    if (dtemp & 0x08) {
+        dtemp -= 16;
+    }
+    
+    codec->mv += dmv;
+    codec->temp_raw += dtemp;
+    
+    *mv = (uint32_t)codec->mv;
+    *temp_raw = (uint32_t)codec->temp_raw;
+    *state = (uint8_t)(record & ((1U << SAMPLELOG_STATE_BITS) - 1));
+}
+
+/**
+ * @brief Encode one sample onto the end of a page and advance the codec
+ *
+ * The caller sets header.magic before the first record and checks the page
+ * is not full (header.count < samplelog_records_per_page()).
+ */
+static inline void samplelog_page_append(samplelog_page_t *page, samplelog_codec_t *codec,
+                                         uint32_t mv, uint32_t temp_raw, uint16_t state)
+{
+    uint32_t words = samplelog_record_words(page->header.magic);
+    uint32_t at = page->header.count * words;
+    
+    page->records[at] = samplelog_encode(codec, mv, temp_raw, (uint8_t)state);
+    if (words == 2) {
+        page->records[at + 1] = (uint16_t)((state >> SAMPLELOG_STATE_BITS) & 0xFF);
+    }
+    page->header.count++;
+}
+
+/**
+ * @brief Decode record n of a page and advance the codec
+ *
+ * Records must be decoded in order from a codec reset to the header base.
+ */
+static inline void samplelog_page_decode(const samplelog_page_t *page, uint32_t n, samplelog_codec_t *codec,
+                                         uint32_t *mv, uint32_t *temp_raw, uint16_t *state)
+{
+    uint32_t words = samplelog_record_words(page->header.magic);
+    uint32_t at = n * words;
+    uint8_t low;
+    
+    samplelog_decode(codec, page->records[at], mv, temp_raw, &low);
+    *state = low;
+    if (words == 2) {
+        *state |= (uint16_t)((page->records[at + 1] & 0xFF) << SAMPLELOG_STATE_BITS);
+    }
+}
+
+/**
+ * @brief Check a page header read back from flash or a capture
+ */
+static inline bool samplelog_header_valid(const samplelog_page_header_t *header)
+{
+    return (header->magic == SAMPLELOG_MAGIC || header->magic == SAMPLELOG_MAGIC_WIDE) &&
+           header->count > 0 &&
+           header->count <= samplelog_records_per_page(header->magic) &&
+           header->interval_ms > 0;
+}
+
+#endif
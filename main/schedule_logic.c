@@ -0,0 +1,131 @@
+#include "schedule_logic.h"
+#include <string.h>
+
+#define MS_PER_MIN  60000U
+
+/**
+ * @brief Fill the default schedule
+ */
+void schedule_default_config(schedule_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->enabled = 0;
+    config->count = 2;
+    config->day_level = 0;
+    config->dusk_mv = 13000;        // Under any charging voltage of a 12 V pack
+    config->dawn_mv = 13400;
+    config->confirm_min = 15;
+    config->segment[0] = (schedule_segment_t){ .start_min = 0, .level = 100 };
+    config->segment[1] = (schedule_segment_t){ .start_min = 300, .level = 40 };
+}
+
+/**
+ * @brief Check a configured schedule
+ */
+bool schedule_config_valid(const schedule_config_t *config)
+{
+    if (config->count == 0 || config->count > SCHEDULE_MAX_SEGMENTS ||
+        config->day_level > 100 || config->dawn_mv <= config->dusk_mv ||
+        config->segment[0].start_min != 0) {
+        return false;
+    }
+    
+    for (int i = 0; i < config->count; i++) {
+        if (config->segment[i].level > 100) {
+            return false;
+        }
+        if (i > 0 && config->segment[i].start_min <= config->segment[i - 1].start_min) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Initialize the day/night state
+ */
+void schedule_init(schedule_t *schedule)
+{
+    memset(schedule, 0, sizeof(*schedule));
+}
+
+/**
+ * @brief Resume the day/night state of the run before a reset
+ */
+void schedule_resume(schedule_t *schedule, bool night, uint32_t since_dusk_ms, uint32_t now_ms)
+{
+    schedule_init(schedule);
+    schedule->started = true;
+    schedule->night = night;
+    if (night) {
+        schedule->dusk_ms = now_ms - since_dusk_ms;
+    }
+}
+
+/**
+ * @brief Track dusk and dawn
+ */
+bool schedule_update(schedule_t *schedule, const schedule_config_t *config,
+                     int32_t battery_mv, uint32_t now_ms)
+{
+    if (!schedule->started) {
+        // No history at boot: take the phase the voltage suggests, with the
+        // night counted from now
+        schedule->started = true;
+        schedule->night = battery_mv < config->dusk_mv;
+        schedule->dusk_ms = now_ms;
+        return true;
+    }
+    
+    bool crossing = schedule->night ? battery_mv > config->dawn_mv
+                                    : battery_mv < config->dusk_mv;
+    if (!crossing) {
+        schedule->pending = false;
+        return false;
+    }
+    if (!schedule->pending) {
+        schedule->pending = true;
+        schedule->pending_since_ms = now_ms;
+    }
+    if (now_ms - schedule->pending_since_ms < (uint32_t)config->confirm_min * MS_PER_MIN) {
+        return false;
+    }
+    
+    // Confirmed: the night starts when the voltage first dropped
+    schedule->night = !schedule->night;
+    schedule->pending = false;
+    if (schedule->night) {
+        schedule->dusk_ms = schedule->pending_since_ms;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Level in effect and time to the next boundary
+ */
+uint8_t schedule_level(const schedule_t *schedule, const schedule_config_t *config,
+                       uint32_t now_ms, uint32_t *next_ms)
+{
+    if (next_ms != NULL) {
+        *next_ms = 0;
+    }
+    if (!config->enabled || !schedule->started) {
+        return 100;
+    }
+    if (!schedule->night) {
+        return config->day_level;
+    }
+    
+    uint32_t since_dusk = now_ms - schedule->dusk_ms;
+    int i = config->count - 1;
+    while (i > 0 && since_dusk < (uint32_t)config->segment[i].start_min * MS_PER_MIN) {
+        i--;
+    }
+    
+    if (next_ms != NULL && i + 1 < config->count) {
+        *next_ms = (uint32_t)config->segment[i + 1].start_min * MS_PER_MIN - since_dusk;
+    }
+    return config->segment[i].level;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file schedule_logic.h
+ * @brief Platform-independent night schedule
+ *
+ * Scales the dimming duty by time since dusk, e.g. 100 % for the first
+ * five hours of the night and 40 % until dawn. There is no wall clock:
+ * dusk and dawn are inferred from the filtered battery voltage. While the
+ * panel charges, the battery sits well above its resting voltage. Dusk is
+ * the voltage staying below dusk_mv for confirm_min; dawn is it staying
+ * above dawn_mv for as long. Segment starts are minutes after dusk (the
+ * moment the voltage first crossed), so the caller can arm a timer for
+ * the next boundary instead of re-evaluating on every wakeup.
+ *
+ * control_handler keeps one schedule_t that scales every output's duty.
+ */
+
+#ifndef SCHEDULE_LOGIC_H
+#define SCHEDULE_LOGIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Most segments of a night
+#define SCHEDULE_MAX_SEGMENTS   4
+
+/**
+ * @struct schedule_segment_t
+ * @brief Part of the night from start_min after dusk to the next segment
+ */
+typedef struct {
+    uint16_t start_min;         // Minutes after dusk
+    uint8_t level;              // % of the dimming duty
+    uint8_t reserved;
+} schedule_segment_t;
+
+/**
+ * @struct schedule_config_t
+ * @brief Night schedule as configured (stored as an NVS blob)
+ */
+typedef struct {
+    uint8_t enabled;            // 0 = the dimming curve alone, day and night
+    uint8_t count;              // Segments in use
+    uint8_t day_level;          // % of the dimming duty between dawn and dusk
+    uint8_t reserved;
+    uint16_t dusk_mv;           // Battery below this: no charge input
+    uint16_t dawn_mv;           // Battery above this: charging again
+    uint16_t confirm_min;       // Time past a threshold before the phase changes
+    uint16_t reserved2;
+    schedule_segment_t segment[SCHEDULE_MAX_SEGMENTS];  // Ascending start_min, first at 0
+} schedule_config_t;
+
+/**
+ * @struct schedule_t
+ * @brief Day/night state
+ */
+typedef struct {
+    bool started;               // First voltage seen
+    bool night;
+    bool pending;               // Voltage past the opposite threshold
+    uint32_t pending_since_ms;
+    uint32_t dusk_ms;           // Start of the current night
+} schedule_t;
+
+/**
+ * @brief Fill the default schedule (disabled; 100 % for 5 h after dusk, then 40 %)
+ */
+void schedule_default_config(schedule_config_t *config);
+
+/**
+ * @brief Check a configured schedule
+ * @return true if it has 1 to SCHEDULE_MAX_SEGMENTS segments starting at 0
+ *         with ascending starts, levels up to 100 % and dawn_mv > dusk_mv
+ */
+bool schedule_config_valid(const schedule_config_t *config);
+
+/**
+ * @brief Initialize the day/night state (decided by the first voltage)
+ */
+void schedule_init(schedule_t *schedule);
+
+/**
+ * @brief Resume the day/night state of the run before a reset
+ * @param schedule Day/night state
+ * @param night Phase before the reset
+ * @param since_dusk_ms Time from dusk to the reset (ignored by day)
+ * @param now_ms Current time (ms, wraps)
+ *
+ * The reset itself is not counted: the night continues from since_dusk_ms.
+ */
+void schedule_resume(schedule_t *schedule, bool night, uint32_t since_dusk_ms, uint32_t now_ms);
+
+/**
+ * @brief Track dusk and dawn
+ * @param schedule Day/night state
+ * @param config Schedule
+ * @param battery_mv Filtered battery voltage
+ * @param now_ms Current time (ms, wraps)
+ * @return true if the phase was decided (first call) or changed
+ */
+bool schedule_update(schedule_t *schedule, const schedule_config_t *config,
+                     int32_t battery_mv, uint32_t now_ms);
+
+/**
+ * @brief Level in effect and time to the next boundary
+ * @param schedule Day/night state
+ * @param config Schedule
+ * @param now_ms Current time (ms, wraps)
+ * @param next_ms Set to the time until the level next changes, 0 if it
+ *                only changes at dawn or dusk (may be NULL)
+ * @return % of the dimming duty (100 while the schedule is disabled)
+ */
+uint8_t schedule_level(const schedule_t *schedule, const schedule_config_t *config,
+                       uint32_t now_ms, uint32_t *next_ms);
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * @file sensor_math.h
+ * @brief Sensor conversions and temperature compensation arithmetic
+ *
+ * The battery divider scaling, the TMP36 transfer function and the threshold
+ * compensation term, shared by adc_handler and channel_logic so the sensor is
+ * converted the same way everywhere.
+ *
+ * With SOLAR_FIXED_POINT (the default) the per-sample path is integer only.
+ * Temperatures are carried in 0.1 °C, which is exactly one TMP36 millivolt, so
+ * the sensor conversion is a subtraction. The divider ratio is a Q16 constant
+ * and the compensation coefficient is converted to Q16 mV per 0.1 °C once,
+ * when the configuration is published. The real-time tasks then never touch
+ * the FPU and never pay its lazy context save on a switch.
+ *
+ * Build with SOLAR_FIXED_POINT=0 for the float reference path (Kconfig
+ * SOLAR_FIXED_POINT_MATH); host/ builds, tests and benchmarks both.
+ */
+
+#ifndef SENSOR_MATH_H
+#define SENSOR_MATH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+
+#ifndef SOLAR_FIXED_POINT
+#define SOLAR_FIXED_POINT   1
+#endif
+
+// Voltage divider resistor values (in ohms)
+#define SENSOR_DIVIDER_R_TOP    47000   // 47kΩ
+#define SENSOR_DIVIDER_R_BOT    10000   // 10kΩ
+#define SENSOR_DIVIDER_RATIO    ((float)(SENSOR_DIVIDER_R_TOP + SENSOR_DIVIDER_R_BOT) / \
+                                 (float)SENSOR_DIVIDER_R_BOT)  // ~5.7
+
+// Divider ratio in Q16, rounded
+#define SENSOR_DIVIDER_Q16 \
+    ((uint32_t)((((uint64_t)(SENSOR_DIVIDER_R_TOP + SENSOR_DIVIDER_R_BOT) << 16) + \
+                 SENSOR_DIVIDER_R_BOT / 2) / SENSOR_DIVIDER_R_BOT))
+
+// A full-scale 12-bit reading in mV times the ratio must fit 32 bits
+_Static_assert(SENSOR_DIVIDER_Q16 < UINT32_MAX / 4096, "divider ratio overflows the Q16 product");
+
+// TMP36: Vout = (Temp°C * 10mV) + 500mV
+#define TMP36_OFFSET_MV     500
+#define TMP36_MV_PER_C      10
+
+// Sensor range; readings outside it are treated as a fault
+#define SENSOR_TEMP_MIN_C       (-40)
+#define SENSOR_TEMP_MAX_C       125
+#define SENSOR_TEMP_DEFAULT_C   25
+
+#if SOLAR_FIXED_POINT
+typedef int32_t sensor_temp_t;      // 0.1 °C
+typedef int32_t sensor_coeff_t;     // mV per 0.1 °C, Q16
+
+#define SENSOR_TEMP_C(c)        ((sensor_temp_t)((c) * 10))
+#define SENSOR_TEMP_EPSILON     ((sensor_temp_t)1)
+#define SENSOR_COEFF(v_per_c)   ((sensor_coeff_t)((v_per_c) * 6553600.0 + ((v_per_c) < 0 ? -0.5 : 0.5)))
+#else
+typedef float sensor_temp_t;        // °C
+typedef float sensor_coeff_t;       // V per °C
+
+#define SENSOR_TEMP_C(c)        ((sensor_temp_t)(c))
+#define SENSOR_TEMP_EPSILON     0.1f
+#define SENSOR_COEFF(v_per_c)   ((sensor_coeff_t)(v_per_c))
+#endif
+
+/**
+ * @brief Convert the divider tap voltage to the battery voltage
+ * @param adc_mv Voltage at the ADC pin in mV
+ * @return Battery voltage in mV
+ */
+static inline uint32_t sensor_battery_mv(uint32_t adc_mv)
+{
+#if SOLAR_FIXED_POINT
+    return (adc_mv * SENSOR_DIVIDER_Q16 + 0x8000U) >> 16;
+#else
+    float battery_v = ((float)adc_mv / 1000.0f) * SENSOR_DIVIDER_RATIO;
+    return (uint32_t)(battery_v * 1000.0f);
+#endif
+}
+
+/**
+ * @brief Convert a TMP36 pin voltage to a temperature
+ * @param pin_mv Sensor output in mV
+ * @param in_range Set to false if the reading is outside the sensor's range
+ *                 (may be NULL)
+ * @return Temperature, or SENSOR_TEMP_DEFAULT_C if out of range
+ */
+static inline sensor_temp_t sensor_temperature(uint32_t pin_mv, bool *in_range)
+{
+#if SOLAR_FIXED_POINT
+    // 10 mV per °C makes one millivolt exactly 0.1 °C
+    sensor_temp_t temp = (int32_t)pin_mv - TMP36_OFFSET_MV;
+#else
+    sensor_temp_t temp = ((float)pin_mv - (float)TMP36_OFFSET_MV) / (float)TMP36_MV_PER_C;
+#endif
+    bool valid = temp >= SENSOR_TEMP_C(SENSOR_TEMP_MIN_C) && temp <= SENSOR_TEMP_C(SENSOR_TEMP_MAX_C);
+    
+    if (in_range != NULL) {
+        *in_range = valid;
+    }
+    return valid ? temp : SENSOR_TEMP_C(SENSOR_TEMP_DEFAULT_C);
+}
+
+/**
+ * @brief Threshold offset for a temperature difference
+ * @param coeff Compensation coefficient (see sensor_coeff())
+ * @param delta Temperature minus the reference temperature
+ * @return Offset in mV
+ */
+static inline int32_t sensor_compensation_mv(sensor_coeff_t coeff, sensor_temp_t delta)
+{
+#if SOLAR_FIXED_POINT
+    int64_t product = (int64_t)coeff * delta;
+    // Round half away from zero
+    return (int32_t)((product + (product >= 0 ? 0x8000 : -0x8000)) / 65536);
+#else
+    return (int32_t)(coeff * delta * 1000.0f);
+#endif
+}
+
+/**
+ * @brief Convert a coefficient in V per °C for sensor_compensation_mv()
+ *
+ * Uses float in both builds; call it when the configuration changes, not
+ * per sample.
+ */
+static inline sensor_coeff_t sensor_coeff(float v_per_c)
+{
+#if SOLAR_FIXED_POINT
+    // x1000 for mV, /10 for 0.1 °C steps, x65536 for Q16
+    return (sensor_coeff_t)lroundf(v_per_c * 6553600.0f);
+#else
+    return v_per_c;
+#endif
+}
+
+/**
+ * @brief Temperature in 0.1 °C (integer, for logs and telemetry)
+ */
+static inline int32_t sensor_temp_dc(sensor_temp_t temp)
+{
+#if SOLAR_FIXED_POINT
+    return temp;
+#else
+    return (int32_t)lroundf(temp * 10.0f);
+#endif
+}
+
+/**
+ * @brief Temperature in °C (for the console)
+ */
+static inline float sensor_temp_to_c(sensor_temp_t temp)
+{
+#if SOLAR_FIXED_POINT
+    return (float)temp / 10.0f;
+#else
+    return temp;
+#endif
+}
+
+#endif
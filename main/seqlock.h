@@ -0,0 +1,87 @@
+/**
+ * @file seqlock.h
+ * @brief Single-writer sequence lock for lock-free snapshot publication
+ *
+ * A writer bumps the sequence counter to an odd value, updates the protected
+ * data, then bumps it back to even. Readers copy the data without taking any
+ * lock and retry if the counter was odd or changed during the copy.
+ *
+ * The write side runs inside a short critical section so a higher-priority
+ * reader on the same core can never preempt a half-finished write and spin.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @struct seqlock_t
+ * @brief Sequence counter plus the writer-side spinlock
+ */
+typedef struct {
+    atomic_uint seq;
+    portMUX_TYPE mux;
+} seqlock_t;
+
+#define SEQLOCK_INITIALIZER { .seq = 0, .mux = portMUX_INITIALIZER_UNLOCKED }
+
+/**
+ * @brief Begin a write (sequence becomes odd)
+ */
+static inline void seqlock_write_begin(seqlock_t *sl)
+{
+    portENTER_CRITICAL_SAFE(&sl->mux);
+    unsigned int seq = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief End a write (sequence becomes even again)
+ */
+static inline void seqlock_write_end(seqlock_t *sl)
+{
+    unsigned int seq = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, seq + 1, memory_order_release);
+    portEXIT_CRITICAL_SAFE(&sl->mux);
+}
+
+/**
+ * @brief Begin a read
+ * @return Sequence value to pass to seqlock_read_retry()
+ */
+static inline unsigned int seqlock_read_begin(seqlock_t *sl)
+{
+    unsigned int seq;
+    while ((seq = atomic_load_explicit(&sl->seq, memory_order_acquire)) & 1U) {
+        // Writer in progress on the other core; it finishes within a few cycles
+    }
+    return seq;
+}
+
+/**
+ * @brief Check whether the data copied since seqlock_read_begin() is torn
+ * @return true if the read must be repeated
+ */
+static inline bool seqlock_read_retry(seqlock_t *sl, unsigned int start)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&sl->seq, memory_order_relaxed) != start;
+}
+
+/**
+ * @brief Current sequence value (even when stable)
+ *
+ * Increases by two on every publication, so it doubles as a cheap
+ * "has anything new been published" generation counter.
+ */
+static inline unsigned int seqlock_sequence(seqlock_t *sl)
+{
+    return atomic_load_explicit(&sl->seq, memory_order_acquire);
+}
+
+#endif
@@ -0,0 +1,230 @@
+#include "signal_filter.h"
+#include <string.h>
+
+static const char *const type_names[FILTER_TYPE_COUNT] = {
+    [FILTER_BOXCAR] = "boxcar",
+    [FILTER_EMA]    = "ema",
+};
+
+/**
+ * @brief Check and normalize a filter configuration
+ */
+bool filter_config_normalize(filter_config_t *config)
+{
+    if (config->type >= FILTER_TYPE_COUNT || config->length > FILTER_MAX_LENGTH) {
+        return false;
+    }
+    if (config->median > 1 && ((config->median & 1) == 0 || config->median > FILTER_MAX_MEDIAN)) {
+        return false;
+    }
+    
+    if (config->length == 0) {
+        config->length = FILTER_DEFAULT_LENGTH;
+    }
+    if (config->median == 1) {
+        config->median = 0;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Rescale a normalized configuration to another sample interval
+ */
+void filter_config_rescale(filter_config_t *config, uint32_t interval_ms)
+{
+    if (interval_ms == 0 || interval_ms == FILTER_BASE_INTERVAL_MS) {
+        return;
+    }
+    
+    uint32_t length = (config->length * FILTER_BASE_INTERVAL_MS + interval_ms / 2) / interval_ms;
+    if (length < 1) {
+        length = 1;
+    } else if (length > FILTER_MAX_LENGTH) {
+        length = FILTER_MAX_LENGTH;
+    }
+    config->length = (uint8_t)length;
+}
+
+/**
+ * @brief Name of a smoothing stage
+ */
+const char *filter_type_name(filter_type_t type)
+{
+    return (type < FILTER_TYPE_COUNT) ? type_names[type] : "?";
+}
+
+/**
+ * @brief Fill every stage as if value had always been the input
+ */
+static void filter_prime(filter_t *filter, int32_t value)
+{
+    for (int i = 0; i < filter->config.median; i++) {
+        filter->median_ring[i] = value;
+        filter->median_sorted[i] = value;
+    }
+    filter->median_index = 0;
+    
+    for (int i = 0; i < filter->config.length; i++) {
+        filter->buffer[i] = value;
+    }
+    filter->index = 0;
+    filter->sum = value * filter->config.length;
+    
+    filter->state_q16 = (int64_t)value * 65536;
+    filter->output = value;
+    filter->primed = true;
+}
+
+/**
+ * @brief Initialize a filter
+ */
+void filter_init(filter_t *filter, const filter_config_t *config)
+{
+    memset(filter, 0, sizeof(*filter));
+    
+    filter->config = *config;
+    if (!filter_config_normalize(&filter->config)) {
+        memset(&filter->config, 0, sizeof(filter->config));
+        filter_config_normalize(&filter->config);
+    }
+    
+    // Same average lag as a boxcar of the same length: alpha = 2 / (N + 1)
+    uint32_t span = filter->config.length;
+    filter->alpha_q16 = (int32_t)(((2U << 16) + (span + 1) / 2) / (span + 1));
+}
+
+/**
+ * @brief Re-initialize with another configuration, primed with a value
+ */
+void filter_reconfigure(filter_t *filter, const filter_config_t *config, int32_t value)
+{
+    bool primed = filter->primed;
+    
+    filter_init(filter, config);
+    if (primed) {
+        filter_prime(filter, value);
+    }
+}
+
+/**
+ * @brief Prime the filter with a value
+ */
+void filter_seed(filter_t *filter, int32_t value)
+{
+    filter_prime(filter, value);
+}
+
+/**
+ * @brief Slide the median window and return its middle value
+ * The sorted copy is updated in place: O(N) per sample
+ */
+static int32_t filter_median(filter_t *filter, int32_t value)
+{
+    int n = filter->config.median;
+    int32_t *sorted = filter->median_sorted;
+    int32_t oldest = filter->median_ring[filter->median_index];
+    
+    filter->median_ring[filter->median_index] = value;
+    filter->median_index++;
+    if (filter->median_index == n) {
+        filter->median_index = 0;
+    }
+    
+    // Drop the oldest value, then insert the new one in order
+    int pos = 0;
+    while (pos < n - 1 && sorted[pos] != oldest) {
+        pos++;
+    }
+    for (; pos < n - 1; pos++) {
+        sorted[pos] = sorted[pos + 1];
+    }
+    pos = n - 1;
+    while (pos > 0 && sorted[pos - 1] > value) {
+        sorted[pos] = sorted[pos - 1];
+        pos--;
+    }
+    sorted[pos] = value;
+    
+    return sorted[n / 2];
+}
+
+/**
+ * @brief Add a sample
+ */
+int32_t filter_push(filter_t *filter, int32_t value)
+{
+    if (!filter->primed) {
+        // First fill: initialize all slots with first value
+        filter_prime(filter, value);
+        return filter->output;
+    }
+    
+    if (filter->config.median > 1) {
+        value = filter_median(filter, value);
+    }
+    
+    if (filter->config.type == FILTER_EMA) {
+        filter->state_q16 += (((int64_t)value * 65536 - filter->state_q16) * filter->alpha_q16) / 65536;
+        filter->output = (int32_t)((filter->state_q16 + 32768) / 65536);
+    } else {
+        // Remove old value, add new value
+        filter->sum += value - filter->buffer[filter->index];
+        filter->buffer[filter->index] = value;
+        filter->index++;
+        if (filter->index == filter->config.length) {
+            filter->index = 0;
+        }
+        filter->output = filter->sum / filter->config.length;
+    }
+    
+    return filter->output;
+}
+
+/**
+ * @brief Initialize a CIC decimator
+ */
+void cic_init(cic_t *cic, uint8_t order, uint32_t ratio)
+{
+    memset(cic, 0, sizeof(*cic));
+    
+    cic->order = (order < 1) ? 1 : (order > CIC_MAX_ORDER) ? CIC_MAX_ORDER : order;
+    cic->ratio = (ratio < 1) ? 1 : ratio;
+    cic->gain = 1;
+    for (int i = 0; i < cic->order; i++) {
+        cic->gain *= cic->ratio;
+    }
+    
+    // Zero state is an input of 0 before init: the first order - 1
+    // outputs still contain it
+    cic->warmup = cic->order - 1;
+}
+
+/**
+ * @brief Produce the output for the samples pushed since the last call
+ */
+bool cic_decimate(cic_t *cic, uint32_t *out)
+{
+    if (cic->count != cic->ratio) {
+        // A short or long block breaks the fixed gain: start over
+        cic_init(cic, cic->order, cic->ratio);
+        return false;
+    }
+    cic->count = 0;
+    
+    // Combs at the output rate (differential delay 1)
+    uint64_t acc = cic->integrator[cic->order - 1];
+    for (int i = 0; i < cic->order; i++) {
+        uint64_t delayed = cic->comb[i];
+        cic->comb[i] = acc;
+        acc -= delayed;
+    }
+    
+    if (cic->warmup > 0) {
+        cic->warmup--;
+        return false;
+    }
+    
+    *out = (uint32_t)((acc + cic->gain / 2) / cic->gain);
+    return true;
+}
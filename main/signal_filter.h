@@ -0,0 +1,181 @@
+/**
+ * @file signal_filter.h
+ * @brief Filter engine: per-channel smoothing and ADC block decimation
+ *
+ * A channel filter is an optional median-of-N spike rejector followed by a
+ * smoothing stage, selected per channel in the configuration:
+ * - boxcar: N-tap moving average, N samples of support, (N-1)/2 of lag
+ * - ema: single-pole IIR with the same average lag as an N-tap boxcar
+ *   (alpha = 2/(N+1)), O(1) state
+ * Coefficients are derived once in filter_init(); filter_push() is integer
+ * only.
+ *
+ * The CIC decimator turns the raw DMA conversion stream of one ADC input
+ * into one value per frame. Order 1 is the plain block average; higher
+ * orders reject ripple near the output rate better at one frame of extra
+ * settling per order.
+ *
+ * channel_logic owns each channel's filter_t; adc_task a cic_t per input.
+ */
+
+#ifndef SIGNAL_FILTER_H
+#define SIGNAL_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Boxcar taps / EMA span limits and default (16 * 100ms = 1.6s smoothing)
+#define FILTER_MAX_LENGTH       32
+#define FILTER_DEFAULT_LENGTH   16
+
+// Sample interval a configured length refers to
+#define FILTER_BASE_INTERVAL_MS 100
+
+// Largest median window (odd)
+#define FILTER_MAX_MEDIAN       9
+
+// Most integrator/comb stages of the CIC decimator
+#define CIC_MAX_ORDER           3
+
+/**
+ * @brief Smoothing stage
+ */
+typedef enum {
+    FILTER_BOXCAR = 0,
+    FILTER_EMA,
+    FILTER_TYPE_COUNT
+} filter_type_t;
+
+/**
+ * @struct filter_config_t
+ * @brief Per-channel filter selection (zero-initialized = default boxcar)
+ */
+typedef struct {
+    uint8_t type;               // filter_type_t
+    uint8_t length;             // Boxcar taps or EMA span, 0 = FILTER_DEFAULT_LENGTH
+    uint8_t median;             // Median window (3, 5, 7, 9), 0 or 1 = off
+} filter_config_t;
+
+/**
+ * @struct filter_t
+ * @brief Filter state of one channel
+ */
+typedef struct {
+    filter_config_t config;     // Normalized
+    bool primed;                // First sample seen
+    // Median stage
+    int32_t median_ring[FILTER_MAX_MEDIAN];
+    int32_t median_sorted[FILTER_MAX_MEDIAN];
+    uint8_t median_index;
+    // Boxcar
+    int32_t buffer[FILTER_MAX_LENGTH];
+    uint8_t index;
+    int32_t sum;
+    // EMA
+    int32_t alpha_q16;
+    int64_t state_q16;
+    int32_t output;
+} filter_t;
+
+/**
+ * @struct cic_t
+ * @brief CIC decimator for one ADC input
+ */
+typedef struct {
+    uint8_t order;
+    uint8_t warmup;             // Outputs still to discard after a reset
+    uint32_t ratio;             // Input samples per output
+    uint32_t count;             // Input samples since the last output
+    uint64_t gain;              // ratio^order
+    uint64_t integrator[CIC_MAX_ORDER];
+    uint64_t comb[CIC_MAX_ORDER];
+} cic_t;
+
+/**
+ * @brief Check and normalize a filter configuration
+ * @param config Configuration, defaults filled in on success
+ * @return false if the type, length or median window is out of range
+ */
+bool filter_config_normalize(filter_config_t *config);
+
+/**
+ * @brief Rescale a normalized configuration to another sample interval
+ * @param config Configuration; the length is scaled so the window keeps its
+ *               time span (at least one sample), the median is per sample
+ * @param interval_ms Sample interval the filter runs at
+ */
+void filter_config_rescale(filter_config_t *config, uint32_t interval_ms);
+
+/**
+ * @brief Name of a smoothing stage ("boxcar", "ema")
+ */
+const char *filter_type_name(filter_type_t type);
+
+/**
+ * @brief Initialize a filter (invalid configurations fall back to the default)
+ * @param filter Filter state
+ * @param config Filter selection
+ */
+void filter_init(filter_t *filter, const filter_config_t *config);
+
+/**
+ * @brief Re-initialize with another configuration, primed with a value
+ * @param filter Filter state
+ * @param config New filter selection
+ * @param value Output to start from (e.g. the previous filter's output)
+ */
+void filter_reconfigure(filter_t *filter, const filter_config_t *config, int32_t value);
+
+/**
+ * @brief Fill the window as if value had always been the input
+ * @param filter Filter state
+ * @param value Output to start from (e.g. the value before a reset)
+ */
+void filter_seed(filter_t *filter, int32_t value);
+
+/**
+ * @brief Add a sample (the first sample primes the whole window)
+ * @return Filtered value
+ */
+int32_t filter_push(filter_t *filter, int32_t value);
+
+/**
+ * @brief Last filtered value (0 before the first sample)
+ */
+static inline int32_t filter_output(const filter_t *filter)
+{
+    return filter->output;
+}
+
+/**
+ * @brief Initialize a CIC decimator
+ * @param cic Decimator state
+ * @param order Number of integrator/comb stages (1 to CIC_MAX_ORDER)
+ * @param ratio Input samples per output
+ */
+void cic_init(cic_t *cic, uint8_t order, uint32_t ratio);
+
+/**
+ * @brief Add one input sample (integrators wrap; the comb output is exact)
+ */
+static inline void cic_push(cic_t *cic, uint32_t sample)
+{
+    uint64_t acc = sample;
+    for (int i = 0; i < cic->order; i++) {
+        cic->integrator[i] += acc;
+        acc = cic->integrator[i];
+    }
+    cic->count++;
+}
+
+/**
+ * @brief Produce the output for the samples pushed since the last call
+ * @param cic Decimator state
+ * @param out Decimated value, rounded
+ * @return false while the decimator settles after init, or if the block
+ *         did not hold exactly ratio samples (the decimator is then reset);
+ *         the caller should use the block average instead
+ */
+bool cic_decimate(cic_t *cic, uint32_t *out);
+
+#endif
@@ -0,0 +1,115 @@
+#include "soc_logic.h"
+#include <string.h>
+
+// Milliseconds per hour, for mAh to mA*ms
+#define MS_PER_HOUR     3600000U
+
+/**
+ * @brief Resting voltage of a 12 V lead-acid battery at 0, 10, ... 100 %
+ */
+static const uint16_t ocv_mv[] = {
+    11300, 11510, 11660, 11810, 11960, 12100, 12240, 12370, 12500, 12620, 12730,
+};
+#define OCV_POINTS  (sizeof(ocv_mv) / sizeof(ocv_mv[0]))
+
+/**
+ * @brief Initialize the estimator
+ */
+void soc_init(soc_t *soc, const soc_params_t *params)
+{
+    memset(soc, 0, sizeof(*soc));
+    
+    uint64_t capacity_mams = (uint64_t)(params->capacity_mah ? params->capacity_mah : 1) * MS_PER_HOUR;
+    soc->discharge_gain_q24 = (int64_t)((((uint64_t)1 << 56) + capacity_mams / 2) / capacity_mams);
+    uint32_t efficiency = params->charge_efficiency_pct > 100 ? 100 : params->charge_efficiency_pct;
+    soc->charge_gain_q24 = soc->discharge_gain_q24 * efficiency / 100;
+    soc->rest_ma = params->rest_ma;
+    soc->rest_ms = params->rest_ms;
+}
+
+/**
+ * @brief State of charge of a resting battery
+ */
+uint16_t soc_ocv_permille(uint32_t battery_mv)
+{
+    if (battery_mv <= ocv_mv[0]) {
+        return 0;
+    }
+    if (battery_mv >= ocv_mv[OCV_POINTS - 1]) {
+        return SOC_PERMILLE_FULL;
+    }
+    
+    unsigned int i = 1;
+    while (battery_mv > ocv_mv[i]) {
+        i++;
+    }
+    
+    const uint32_t step = SOC_PERMILLE_FULL / (OCV_POINTS - 1);
+    return (uint16_t)((i - 1) * step +
+                      (battery_mv - ocv_mv[i - 1]) * step / (ocv_mv[i] - ocv_mv[i - 1]));
+}
+
+/**
+ * @brief Charge of a state of charge, Q32
+ */
+static int64_t soc_charge_q32(uint16_t permille)
+{
+    return (int64_t)permille * SOC_Q32_FULL / SOC_PERMILLE_FULL;
+}
+
+/**
+ * @brief Add one sample
+ */
+void soc_update(soc_t *soc, int32_t current_ma, uint32_t battery_mv, uint32_t now_ms)
+{
+    if (!soc->started) {
+        // No history at boot: assume the battery is near rest
+        soc->started = true;
+        soc->charge_q32 = soc_charge_q32(soc_ocv_permille(battery_mv));
+        soc->last_ms = now_ms;
+        soc->resting = false;
+        return;
+    }
+    
+    uint32_t dt_ms = now_ms - soc->last_ms;
+    soc->last_ms = now_ms;
+    if (dt_ms > SOC_MAX_STEP_MS) {
+        dt_ms = SOC_MAX_STEP_MS;
+    }
+    
+    // Integrate: one multiply-add in Q32 of the capacity
+    int64_t mams = (int64_t)current_ma * dt_ms;
+    int64_t delta = (mams * (current_ma > 0 ? soc->charge_gain_q24
+                                             : soc->discharge_gain_q24)) >> 24;
+    soc->charge_q32 += delta;
+    if (soc->charge_q32 < 0) {
+        soc->charge_q32 = 0;
+    } else if (soc->charge_q32 > SOC_Q32_FULL) {
+        soc->charge_q32 = SOC_Q32_FULL;
+    }
+    
+    // Equivalent full cycles from the discharged charge
+    if (delta < 0) {
+        soc->throughput_q32 -= delta;
+        if (soc->throughput_q32 >= SOC_Q32_FULL) {
+            soc->throughput_q32 -= SOC_Q32_FULL;
+            soc->cycles++;
+        }
+    }
+    
+    // Re-anchor to the open-circuit voltage once per rest period
+    uint32_t magnitude = current_ma < 0 ? (uint32_t)-(int64_t)current_ma : (uint32_t)current_ma;
+    if (magnitude > soc->rest_ma) {
+        soc->resting = false;
+        soc->anchored = false;
+        return;
+    }
+    if (!soc->resting) {
+        soc->resting = true;
+        soc->rest_since_ms = now_ms;
+    }
+    if (!soc->anchored && now_ms - soc->rest_since_ms >= soc->rest_ms) {
+        soc->charge_q32 = soc_charge_q32(soc_ocv_permille(battery_mv));
+        soc->anchored = true;
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ * @file soc_logic.h
+ * @brief Platform-independent battery state-of-charge estimator
+ *
+ * Coulomb counter: the battery current is integrated at the sample rate
+ * into the charge held, as a Q32 fraction of the capacity. Charge current
+ * is derated by the charge efficiency. Integration drifts with sensor
+ * offset, so the estimate is re-anchored to the open-circuit voltage once
+ * the current has stayed below the rest threshold for the rest time; the
+ * first sample after boot is anchored the same way.
+ *
+ * Discharged charge is also counted as throughput: each full capacity's
+ * worth is one equivalent charge cycle.
+ *
+ * One multiply-add per sample, no division; adc_task updates it with every
+ * reading.
+ */
+
+#ifndef SOC_LOGIC_H
+#define SOC_LOGIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// State of charge is reported in 0.1 % (per mille)
+#define SOC_PERMILLE_FULL       1000
+
+// Charge in Q32: 1 << 32 is a full battery
+#define SOC_Q32_FULL            (INT64_C(1) << 32)
+
+// Longest gap integrated at the measured current (a stalled sampler)
+#define SOC_MAX_STEP_MS         10000
+
+/**
+ * @struct soc_params_t
+ * @brief Battery and estimator parameters
+ */
+typedef struct {
+    uint32_t capacity_mah;          // Rated capacity
+    uint8_t charge_efficiency_pct;  // Share of the charge current stored
+    uint32_t rest_ma;               // |current| at or below this is rest
+    uint32_t rest_ms;               // Rest time before the OCV correction
+} soc_params_t;
+
+/**
+ * @struct soc_t
+ * @brief Estimator state
+ */
+typedef struct {
+    int64_t charge_q32;         // Charge held, Q32 fraction of the capacity
+    int64_t discharge_gain_q24; // Q32 charge per mA*ms, Q24
+    int64_t charge_gain_q24;    // Same, derated by the charge efficiency
+    int64_t throughput_q32;     // Discharged since the last counted cycle
+    uint32_t cycles;            // Equivalent full cycles counted
+    uint32_t rest_ma;
+    uint32_t rest_ms;
+    uint32_t last_ms;           // Time of the previous sample
+    uint32_t rest_since_ms;     // Start of the current rest
+    bool started;               // First sample seen
+    bool resting;
+    bool anchored;              // OCV correction done for this rest
+} soc_t;
+
+/**
+ * @brief Initialize the estimator (the first sample sets the charge)
+ * @param soc Estimator state
+ * @param params Battery parameters (capacity must be non-zero)
+ */
+void soc_init(soc_t *soc, const soc_params_t *params);
+
+/**
+ * @brief Add one sample
+ * @param soc Estimator state
+ * @param current_ma Battery current, positive while charging
+ * @param battery_mv Battery voltage
+ * @param now_ms Sample time (ms, wraps)
+ */
+void soc_update(soc_t *soc, int32_t current_ma, uint32_t battery_mv, uint32_t now_ms);
+
+/**
+ * @brief State of charge a resting 12 V lead-acid battery shows at a voltage
+ * @return 0 to SOC_PERMILLE_FULL, interpolated in 10 % steps
+ */
+uint16_t soc_ocv_permille(uint32_t battery_mv);
+
+/**
+ * @brief Current state of charge
+ * @return 0 to SOC_PERMILLE_FULL
+ */
+static inline uint16_t soc_permille(const soc_t *soc)
+{
+    return (uint16_t)((soc->charge_q32 * SOC_PERMILLE_FULL + SOC_Q32_FULL / 2) >> 32);
+}
+
+#endif
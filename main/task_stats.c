@@ -0,0 +1,163 @@
+#include "task_stats.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "TASK_STATS";
+
+// Registered task records
+static task_stats_t records[TASK_STATS_MAX_TASKS];
+static int record_count = 0;
+static portMUX_TYPE record_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Clear the accumulated statistics of one record
+ */
+static void task_stats_clear(task_stats_t *ts)
+{
+    ts->activations = 0;
+    ts->exec_max_us = 0;
+    ts->exec_total_us = 0;
+    ts->jitter_max_us = 0;
+    ts->deadline_misses = 0;
+    ts->last_release_us = 0;
+}
+
+/**
+ * @brief Register the calling task for timing accounting
+ */
+task_stats_t *task_stats_register(const char *name, uint32_t period_ms)
+{
+    task_stats_t *ts = NULL;
+    
+    portENTER_CRITICAL(&record_mux);
+    if (record_count < TASK_STATS_MAX_TASKS) {
+        ts = &records[record_count];
+        memset(ts, 0, sizeof(*ts));
+        ts->name = name;
+        ts->period_us = period_ms * 1000;
+        ts->core_id = -1;
+        record_count++;
+    }
+    portEXIT_CRITICAL(&record_mux);
+    
+    if (ts == NULL) {
+        ESP_LOGE(TAG, "No free stats slot for '%s'", name);
+    } else {
+        ESP_LOGI(TAG, "Task '%s' registered, period=%u ms, core=%d",
+                 name, (unsigned int)period_ms, xPortGetCoreID());
+    }
+    
+    return ts;
+}
+
+/**
+ * @brief Change the nominal period
+ */
+void task_stats_set_period(task_stats_t *ts, uint32_t period_ms)
+{
+    if (ts != NULL) {
+        ts->period_us = period_ms * 1000;
+    }
+}
+
+/**
+ * @brief Mark the start of an activation
+ */
+void task_stats_begin(task_stats_t *ts)
+{
+    if (ts == NULL) {
+        return;
+    }
+    
+    int64_t now = esp_timer_get_time();
+    
+    if (ts->reset_pending) {
+        task_stats_clear(ts);
+        ts->reset_pending = false;
+    }
+    
+    // Release jitter: deviation of this wakeup from one period after the last
+    if (ts->period_us != 0 && ts->last_release_us != 0) {
+        int64_t interval = now - ts->last_release_us;
+        int64_t deviation = interval - (int64_t)ts->period_us;
+        uint32_t jitter = (uint32_t)(deviation < 0 ? -deviation : deviation);
+        
+        if (jitter > ts->jitter_max_us) {
+            ts->jitter_max_us = jitter;
+        }
+    }
+    
+    ts->last_release_us = now;
+    ts->current_start_us = now;
+    ts->core_id = xPortGetCoreID();
+}
+
+/**
+ * @brief Mark the end of an activation
+ */
+void task_stats_end(task_stats_t *ts)
+{
+    if (ts == NULL || ts->current_start_us == 0) {
+        return;
+    }
+    
+    uint32_t exec = (uint32_t)(esp_timer_get_time() - ts->current_start_us);
+    ts->current_start_us = 0;
+    
+    if (exec > ts->exec_max_us) {
+        ts->exec_max_us = exec;
+    }
+    ts->exec_total_us += exec;
+    
+    // Running past the period means the next release was already due
+    if (ts->period_us != 0 && exec > ts->period_us) {
+        ts->deadline_misses++;
+    }
+    
+    ts->activations++;
+}
+
+/**
+ * @brief Number of registered tasks
+ */
+int task_stats_count(void)
+{
+    return record_count;
+}
+
+/**
+ * @brief Get a snapshot of a registered task's record
+ */
+bool task_stats_get(int index, task_stats_info_t *info)
+{
+    if (info == NULL || index < 0 || index >= record_count) {
+        return false;
+    }
+    
+    const task_stats_t *ts = &records[index];
+    uint32_t activations = ts->activations;
+    
+    info->name = ts->name;
+    info->period_us = ts->period_us;
+    info->activations = activations;
+    info->exec_max_us = ts->exec_max_us;
+    info->exec_avg_us = activations ? (uint32_t)(ts->exec_total_us / activations) : 0;
+    info->jitter_max_us = ts->jitter_max_us;
+    info->deadline_misses = ts->deadline_misses;
+    info->core_id = ts->core_id;
+    
+    return true;
+}
+
+/**
+ * @brief Request a clear of every task's statistics
+ */
+void task_stats_reset(void)
+{
+    for (int i = 0; i < record_count; i++) {
+        records[i].reset_pending = true;
+    }
+}
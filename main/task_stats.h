@@ -0,0 +1,109 @@
+/**
+ * @file task_stats.h
+ * @brief Per-task execution time and release jitter accounting
+ *
+ * Each periodic (or sample-driven) task registers once with its nominal
+ * period and brackets every activation with task_stats_begin() and
+ * task_stats_end(). The module keeps the worst-case execution time, the
+ * worst release jitter against the nominal period and a deadline-miss count,
+ * so the real-time budget of the pinned topology can be checked from the CLI
+ * while the console core is loaded.
+ *
+ * Each record has a single writer (its own task); readers take a snapshot.
+ */
+
+#ifndef TASK_STATS_H
+#define TASK_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Maximum number of instrumented tasks
+#define TASK_STATS_MAX_TASKS    8
+
+/**
+ * @struct task_stats_t
+ * @brief Per-task timing record (owned by the instrumented task)
+ */
+typedef struct {
+    const char *name;
+    uint32_t period_us;         // Nominal activation period
+    uint32_t activations;       // Completed activations
+    uint32_t exec_max_us;       // Worst-case execution time
+    uint64_t exec_total_us;     // Sum of execution times (for the average)
+    uint32_t jitter_max_us;     // Worst |release interval - period|
+    uint32_t deadline_misses;   // Activations that finished after the next release
+    int64_t last_release_us;    // Start of the previous activation
+    int64_t current_start_us;   // Start of the activation in progress
+    int core_id;                // Core of the most recent activation
+    volatile bool reset_pending; // Set by task_stats_reset(), applied by the owner
+} task_stats_t;
+
+/**
+ * @struct task_stats_info_t
+ * @brief Snapshot of a task's timing record for status reporting
+ */
+typedef struct {
+    const char *name;
+    uint32_t period_us;
+    uint32_t activations;
+    uint32_t exec_max_us;
+    uint32_t exec_avg_us;
+    uint32_t jitter_max_us;
+    uint32_t deadline_misses;
+    int core_id;
+} task_stats_info_t;
+
+/**
+ * @brief Register the calling task for timing accounting
+ * @param name Task name for reporting (must stay valid)
+ * @param period_ms Nominal activation period in milliseconds, or 0 for an
+ *                  event-driven task (execution time only, no jitter/misses)
+ * @return Record handle, or NULL if all slots are in use
+ */
+task_stats_t *task_stats_register(const char *name, uint32_t period_ms);
+
+/**
+ * @brief Change the nominal period (e.g. when the sampling cadence changes)
+ * @param ts Record handle (NULL is ignored)
+ * @param period_ms New period in milliseconds
+ *
+ * Call from the owning task before the task_stats_begin() of the first
+ * activation released at the new period.
+ */
+void task_stats_set_period(task_stats_t *ts, uint32_t period_ms);
+
+/**
+ * @brief Mark the start of an activation (call right after waking)
+ * @param ts Record handle (NULL is ignored)
+ */
+void task_stats_begin(task_stats_t *ts);
+
+/**
+ * @brief Mark the end of an activation (call right before sleeping)
+ * @param ts Record handle (NULL is ignored)
+ */
+void task_stats_end(task_stats_t *ts);
+
+/**
+ * @brief Number of registered tasks
+ */
+int task_stats_count(void);
+
+/**
+ * @brief Get a snapshot of a registered task's record
+ * @param index Task index (0 to task_stats_count() - 1)
+ * @param info Output snapshot
+ * @return true if index is valid
+ */
+bool task_stats_get(int index, task_stats_info_t *info);
+
+/**
+ * @brief Clear the accumulated maxima and counters of every task
+ *
+ * The clear is applied by each owning task at its next activation, so it
+ * never races with an update in progress.
+ */
+void task_stats_reset(void);
+
+#endif
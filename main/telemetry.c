@@ -0,0 +1,232 @@
+#include "telemetry.h"
+#include "adc_handler.h"
+#include "sample_ring.h"
+#include "channel_processor.h"
+#include "channel_table.h"
+#include "control_handler.h"
+#include "nvs_storage.h"
+#include "perf_stats.h"
+#include "task_stats.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "TELEMETRY";
+
+_Static_assert(CHANNEL_COUNT <= TELEMETRY_CHANNELS, "channels do not fit a telemetry record");
+
+static TaskHandle_t telemetry_task_handle = NULL;
+
+// Frames per second, 0 while streaming is off (single word, written by the CLI)
+static volatile uint32_t stream_rate_hz = 0;
+
+// Pre-serialized frame and the sources it is built from (telemetry_task only)
+static uint8_t frame_buffer[TELEMETRY_STATUS_FRAME_SIZE];
+static telemetry_status_t status;
+static hw_control_t last_hw_state;
+
+// Statistics since boot
+static uint32_t frames_sent = 0;
+static uint32_t bytes_sent = 0;
+static uint32_t hw_stale_count = 0;
+
+static int16_t clamp_i16(int32_t v)
+{
+    return (int16_t)((v < INT16_MIN) ? INT16_MIN : (v > INT16_MAX) ? INT16_MAX : v);
+}
+
+static uint16_t clamp_u16(uint32_t v)
+{
+    return (uint16_t)((v > UINT16_MAX) ? UINT16_MAX : v);
+}
+
+/**
+ * @brief Fill a status record from the published snapshots
+ * @param status Record to fill (sequence is left to the caller)
+ * @param hw Output state to report
+ * @param hw_fresh false if hw is a previous copy (flagged HW_STALE)
+ *
+ * Readings, channel states and counters are read without locks.
+ */
+static void telemetry_build_status(telemetry_status_t *status, const hw_control_t *hw, bool hw_fresh)
+{
+    adc_reading_t reading;
+    float temp_c;
+    bool fresh = adc_get_latest_reading(&reading, ADC_READING_MAX_AGE_MS);
+    adc_get_latest_temperature(&temp_c, ADC_READING_MAX_AGE_MS);
+    
+    status->uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    status->sample_ms = reading.timestamp_ms;
+    status->battery_mv = clamp_u16(reading.battery_voltage_mv);
+    status->temp_raw = clamp_u16(reading.temperature_raw);
+    status->temperature_dc = clamp_i16((int32_t)(temp_c * 10.0f));
+    status->flags = fresh ? 0 : TELEMETRY_FLAG_STALE;
+    
+    status->channel_count = CHANNEL_COUNT;
+    status->channel_states = 0;
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        channel_state_t state;
+        channel_get_snapshot(ch, &state);
+        status->filtered_mv[ch] = clamp_i16(state.filtered_voltage);
+        if (state.output_state) {
+            status->channel_states |= 1U << ch;
+        }
+    }
+    
+    if (!hw_fresh) {
+        status->flags |= TELEMETRY_FLAG_HW_STALE;
+    }
+    status->output_states = 0;
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        if (hw->ch_state[ch]) {
+            status->output_states |= 1U << ch;
+        }
+    }
+    status->pwm_duty = hw->pwm_duty;
+    if (hw->motion_detected) {
+        status->flags |= TELEMETRY_FLAG_MOTION;
+    }
+    if (control_get_charger_status()) {
+        status->flags |= TELEMETRY_FLAG_CHARGING;
+    }
+    
+    verification_data_t verification;
+    nvs_load_verification(&verification);
+    status->boot_count = verification.total_cycles;
+    
+    status->ring_overruns = 0;
+    for (int i = 0; i < sample_ring_reader_count(); i++) {
+        sample_ring_reader_info_t info;
+        if (sample_ring_get_reader_info(i, &info)) {
+            status->ring_overruns += info.overruns;
+        }
+    }
+    
+    status->drops = 0;
+    for (int drop = 0; drop < PERF_DROP_COUNT; drop++) {
+        status->drops += perf_get_drops((perf_drop_t)drop, NULL);
+    }
+    
+    status->config_generation = nvs_config_generation();
+}
+
+/**
+ * @brief Snapshot the current status record
+ */
+void telemetry_get_status(telemetry_status_t *status)
+{
+    // Zero output fields, flagged HW_STALE, if hw_mutex stays busy
+    hw_control_t hw = {0};
+    bool hw_fresh = control_get_state(&hw);
+    
+    memset(status, 0, sizeof(*status));
+    telemetry_build_status(status, &hw, hw_fresh);
+}
+
+/**
+ * @brief Initialize telemetry
+ */
+void telemetry_init(void)
+{
+    memset(&status, 0, sizeof(status));
+    memset(&last_hw_state, 0, sizeof(last_hw_state));
+    stream_rate_hz = 0;
+    
+    ESP_LOGI(TAG, "Telemetry ready: %u-byte status frames, up to %d Hz",
+             (unsigned int)TELEMETRY_STATUS_FRAME_SIZE, TELEMETRY_RATE_MAX_HZ);
+}
+
+/**
+ * @brief Telemetry task
+ */
+void telemetry_task(void *pvParameters)
+{
+    telemetry_task_handle = xTaskGetCurrentTaskHandle();
+    
+    // Rate is runtime-configurable, so only execution time is tracked
+    task_stats_t *stats = task_stats_register(pcTaskGetName(NULL), 0);
+    TickType_t last_wake_time = xTaskGetTickCount();
+    
+    ESP_LOGI(TAG, "Telemetry task started");
+    
+    while (1) {
+        uint32_t rate_hz = stream_rate_hz;
+        if (rate_hz == 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            last_wake_time = xTaskGetTickCount();
+            continue;
+        }
+        
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(1000 / rate_hz));
+        if (stream_rate_hz == 0) {
+            continue;
+        }
+        task_stats_begin(stats);
+        
+        // hw_mutex is only tried: if control_task holds it the previous
+        // frame's output fields are repeated and flagged
+        bool hw_fresh = control_try_get_state(&last_hw_state);
+        if (!hw_fresh) {
+            hw_stale_count++;
+        }
+        status.sequence++;
+        telemetry_build_status(&status, &last_hw_state, hw_fresh);
+        size_t size = telemetry_frame_encode(frame_buffer, TELEMETRY_TYPE_STATUS,
+                                             &status, sizeof(status));
+        
+        // One driver call per frame: console text can only land between frames
+        int written = uart_write_bytes(CONFIG_ESP_CONSOLE_UART_NUM, frame_buffer, size);
+        if (written > 0) {
+            frames_sent++;
+            bytes_sent += (uint32_t)written;
+        }
+        
+        task_stats_end(stats);
+    }
+}
+
+/**
+ * @brief Start streaming or change the rate
+ */
+esp_err_t telemetry_stream_start(uint32_t rate_hz)
+{
+    if (rate_hz == 0 || rate_hz > TELEMETRY_RATE_MAX_HZ) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (telemetry_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    stream_rate_hz = rate_hz;
+    xTaskNotifyGive(telemetry_task_handle);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Stop streaming
+ */
+void telemetry_stream_stop(void)
+{
+    stream_rate_hz = 0;
+}
+
+/**
+ * @brief Get streaming status
+ */
+void telemetry_get_info(telemetry_info_t *info)
+{
+    if (info == NULL) {
+        return;
+    }
+    
+    uint32_t rate_hz = stream_rate_hz;
+    info->streaming = rate_hz != 0;
+    info->rate_hz = rate_hz;
+    info->frames_sent = frames_sent;
+    info->bytes_sent = bytes_sent;
+    info->hw_stale = hw_stale_count;
+}
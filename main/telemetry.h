@@ -0,0 +1,75 @@
+/**
+ * @file telemetry.h
+ * @brief Binary status streaming on the console UART
+ *
+ * When streaming is enabled a low-priority task serializes one status frame
+ * per period (see telemetry_format.h) from the lock-free snapshots of the
+ * other modules and writes it to the UART in a single call. Nothing is
+ * formatted per field, so 10 Hz costs about 480 B/s of a 115200 baud link and
+ * frames never interleave with console text.
+ *
+ * The task sleeps on a notification while streaming is off.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "telemetry_format.h"
+
+// Highest rate: one frame per published ADC reading
+#define TELEMETRY_RATE_MAX_HZ   10
+
+/**
+ * @struct telemetry_info_t
+ * @brief Streaming status for the CLI
+ */
+typedef struct {
+    bool streaming;
+    uint32_t rate_hz;
+    uint32_t frames_sent;       // Since boot
+    uint32_t bytes_sent;
+    uint32_t hw_stale;          // Frames that reused the previous output state
+} telemetry_info_t;
+
+/**
+ * @brief Initialize telemetry (streaming off)
+ */
+void telemetry_init(void);
+
+/**
+ * @brief Telemetry task
+ * @param pvParameters Task parameters (unused)
+ */
+void telemetry_task(void *pvParameters);
+
+/**
+ * @brief Start streaming, or change the rate of a running stream
+ * @param rate_hz Frames per second (1 to TELEMETRY_RATE_MAX_HZ)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a bad rate, or
+ *         ESP_ERR_INVALID_STATE before the task has started
+ */
+esp_err_t telemetry_stream_start(uint32_t rate_hz);
+
+/**
+ * @brief Stop streaming (takes effect before the next frame)
+ */
+void telemetry_stream_stop(void);
+
+/**
+ * @brief Build a status record now, as a stream frame would carry it
+ * @param status Filled with the record (sequence 0)
+ *
+ * Waits up to 100 ms for the output state, then reports zeros flagged
+ * TELEMETRY_FLAG_HW_STALE; for callers other than control_task.
+ */
+void telemetry_get_status(telemetry_status_t *status);
+
+/**
+ * @brief Get streaming status
+ */
+void telemetry_get_info(telemetry_info_t *info);
+
+#endif
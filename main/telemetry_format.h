@@ -0,0 +1,134 @@
+/**
+ * @file telemetry_format.h
+ * @brief Binary telemetry frame format, shared with host decoders
+ *
+ * Every frame on the console UART is:
+ *
+ *   0xA5 0x5A | type (1) | length (1) | payload (length) | CRC-16 (2, LE)
+ *
+ * The CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over type, length
+ * and payload. A receiver hunts for the sync bytes and drops any candidate
+ * whose CRC fails, so log or prompt text between frames is harmless. All
+ * multi-byte fields are little-endian.
+ *
+ * Header-only and free of ESP-IDF dependencies.
+ */
+
+#ifndef TELEMETRY_FORMAT_H
+#define TELEMETRY_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TELEMETRY_SYNC0         0xA5
+#define TELEMETRY_SYNC1         0x5A
+#define TELEMETRY_CHANNELS      8       // Channel slots in a status record (LEDC channels per speed mode)
+
+// Frame types
+#define TELEMETRY_TYPE_STATUS   0x01
+
+// telemetry_status_t.flags
+#define TELEMETRY_FLAG_MOTION       0x01    // Motion override active
+#define TELEMETRY_FLAG_CHARGING     0x02    // Charger status input high
+#define TELEMETRY_FLAG_STALE        0x04    // Reading older than ADC_READING_MAX_AGE_MS
+#define TELEMETRY_FLAG_HW_STALE     0x08    // Output fields repeat the previous frame
+
+/**
+ * @struct telemetry_frame_header_t
+ * @brief Bytes preceding the payload
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t sync[2];
+    uint8_t type;
+    uint8_t length;
+} telemetry_frame_header_t;
+
+/**
+ * @struct telemetry_status_t
+ * @brief TELEMETRY_TYPE_STATUS payload
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t sequence;                      // Frame counter since boot; gaps mean lost frames
+    uint32_t uptime_ms;
+    uint32_t sample_ms;                     // Timestamp of the reading below
+    uint16_t battery_mv;
+    uint16_t temp_raw;                      // Temperature sensor output (mV)
+    int16_t temperature_dc;                 // Temperature, 0.1 °C
+    int16_t filtered_mv[TELEMETRY_CHANNELS];    // channel_count valid, rest zero
+    uint8_t channel_count;                  // Channels in this build
+    uint8_t channel_states;                 // Decision state, bit n = channel n
+    uint8_t output_states;                  // Hardware output, bit n = channel n
+    uint8_t pwm_duty;                       // 0-100 %
+    uint8_t flags;                          // TELEMETRY_FLAG_*
+    uint32_t boot_count;
+    uint32_t ring_overruns;                 // Sum over all sample ring readers
+    uint32_t drops;                         // Sum of all pipeline drop counters
+    uint32_t config_generation;             // Changes whenever the configuration does
+} telemetry_status_t;
+
+#define TELEMETRY_FRAME_OVERHEAD    (sizeof(telemetry_frame_header_t) + sizeof(uint16_t))
+#define TELEMETRY_STATUS_FRAME_SIZE (sizeof(telemetry_status_t) + TELEMETRY_FRAME_OVERHEAD)
+
+_Static_assert(sizeof(telemetry_status_t) <= UINT8_MAX, "telemetry payload exceeds the length field");
+
+/**
+ * @brief CRC-16/CCITT-FALSE, continuing from crc (start with 0xFFFF)
+ */
+static inline uint16_t telemetry_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Frame a payload into buf
+ * @param buf Output, at least length + TELEMETRY_FRAME_OVERHEAD bytes
+ * @return Frame size in bytes
+ */
+static inline size_t telemetry_frame_encode(uint8_t *buf, uint8_t type, const void *payload, uint8_t length)
+{
+    telemetry_frame_header_t *header = (telemetry_frame_header_t *)buf;
+    header->sync[0] = TELEMETRY_SYNC0;
+    header->sync[1] = TELEMETRY_SYNC1;
+    header->type = type;
+    header->length = length;
+    
+    uint8_t *body = buf + sizeof(*header);
+    memcpy(body, payload, length);
+    
+    uint16_t crc = telemetry_crc16(0xFFFF, &header->type, 2 + (size_t)length);
+    body[length] = (uint8_t)(crc & 0xFF);
+    body[length + 1] = (uint8_t)(crc >> 8);
+    
+    return sizeof(*header) + length + sizeof(crc);
+}
+
+/**
+ * @brief Check a complete frame starting at buf
+ * @return Payload pointer, or NULL if the sync bytes, size or CRC are wrong
+ */
+static inline const uint8_t *telemetry_frame_check(const uint8_t *buf, size_t size)
+{
+    if (size < TELEMETRY_FRAME_OVERHEAD ||
+        buf[0] != TELEMETRY_SYNC0 || buf[1] != TELEMETRY_SYNC1 ||
+        size < TELEMETRY_FRAME_OVERHEAD + buf[3]) {
+        return NULL;
+    }
+    
+    size_t length = buf[3];
+    const uint8_t *body = buf + sizeof(telemetry_frame_header_t);
+    uint16_t crc = (uint16_t)(body[length] | (body[length + 1] << 8));
+    if (telemetry_crc16(0xFFFF, buf + 2, 2 + length) != crc) {
+        return NULL;
+    }
+    
+    return body;
+}
+
+#endif